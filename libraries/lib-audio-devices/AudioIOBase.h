@@ -247,8 +247,9 @@ protected:
    /// True if audio playback is paused
    std::atomic<bool>   mPaused{ false };
 
-   /*! Read by worker threads but unchanging during playback */
-   int                 mStreamToken{ 0 };
+   /*! Atomic because IsBusy() and IsStreamActive() may be called from
+    any thread, such as the database checkpoint thread */
+   std::atomic<int>    mStreamToken{ 0 };
 
    /// Audio playback rate in samples per second
    /*! Read by worker threads but unchanging during playback */
@@ -110,6 +110,7 @@ time warp info and AudioIOListener and whether the playback is looped.
 #include "BasicUI.h"
 
 #include "Gain.h"
+#include "Tracing.h"
 
 #ifdef EXPERIMENTAL_AUTOMATED_INPUT_LEVEL_ADJUSTMENT
    #define LOWER_BOUND 0.0
@@ -763,6 +764,7 @@ void AudioIO::StartMonitoring( const AudioIOStartStreamOptions &options )
    // Now start the PortAudio stream!
    // TODO: ? Factor out and reuse error reporting code from end of
    // AudioIO::StartStream?
+   mCallbackThreadNamed = false;
    mLastPaError = Pa_StartStream( mPortStreamV19 );
 
    // Update UI display only now, after all possibilities for error are past.
@@ -788,6 +790,9 @@ int AudioIO::StartStream(const TransportSequences &sequences,
 
    mLostSamples = 0;
    mLostCaptureIntervals.clear();
+   mDeviceUnderruns.store(0, std::memory_order_relaxed);
+   mStarvedBuffers.store(0, std::memory_order_relaxed);
+   mCallbackThreadNamed = false;
    mDetectDropouts =
       gPrefs->Read( WarningDialogKey(wxT("DropoutDetected")), true ) != 0;
    auto cleanup = finally ( [this] { ClearRecordingException(); } );
@@ -1213,6 +1218,12 @@ bool AudioIO::AllocateBuffers(
                   std::make_unique<RingBuffer>(floatSample, playbackBufferSize);
 
             mOldChannelGains.resize(mPlaybackSequences.size());
+            mSequenceMeterTaps.resize(mPlaybackSequences.size());
+            for (auto &pTap : mSequenceMeterTaps) {
+               if (!pTap)
+                  pTap = std::make_unique<SequenceMeterTap>();
+               pTap->Reset();
+            }
             size_t iBuffer = 0;
             for (unsigned int i = 0; i < mPlaybackSequences.size(); i++) {
                const auto &pSequence = mPlaybackSequences[i];
@@ -1362,6 +1373,28 @@ void AudioIO::SetMeters()
       pInputMeter->Reset(mRate, true);
    if (auto pOutputMeter = mOutputMeter.lock())
       pOutputMeter->Reset(mRate, true);
+   MakeMeterTransfers(true);
+}
+
+void AudioIO::MakeMeterTransfers(bool make)
+{
+   // Half a second is many passes of the audio thread
+   const auto frames = make ? std::max<size_t>(1, lrint(mRate / 2)) : 0;
+   const auto reset = [&](MeterTransfer &transfer, unsigned nChannels) {
+      transfer.nChannels = nChannels;
+      const auto size = frames * nChannels;
+      if (size > 0) {
+         transfer.buffer = std::make_unique<RingBuffer>(floatSample, size);
+         transfer.scratch.resize(size);
+      }
+      else {
+         transfer.buffer.reset();
+         transfer.scratch.clear();
+      }
+   };
+   std::lock_guard<std::mutex> lock{ mMeterTransferMutex };
+   reset(mInputMeterTransfer, mNumCaptureChannels);
+   reset(mOutputMeterTransfer, mNumPlaybackChannels);
 }
 
 void AudioIO::StopStream()
@@ -1568,6 +1601,9 @@ void AudioIO::StopStream()
 
 
 
+   // Samples not yet analyzed would otherwise show after the reset
+   MakeMeterTransfers(false);
+
    if (auto pInputMeter = mInputMeter.lock())
       pInputMeter->Reset(mRate, false);
 
@@ -1618,6 +1654,7 @@ void AudioIO::StopStream()
    mNumPlaybackChannels = 0;
 
    mPlaybackSequences.clear();
+   mSequenceMeterTaps.clear();
    mCaptureSequences.clear();
 
    mPlaybackSchedule.GetPolicy().Finalize( mPlaybackSchedule );
@@ -1734,6 +1771,17 @@ double AudioIO::GetStreamTime()
    return mPlaybackSchedule.GetSequenceTime();
 }
 
+std::optional<SequenceMeterTap::Levels>
+AudioIO::GetSequenceLevels(const WideSampleSequence &sequence)
+{
+   if (!IsStreamActive())
+      return {};
+   const auto ii = FindSource(mPlaybackSequences, sequence);
+   if (ii < mSequenceMeterTaps.size())
+      return mSequenceMeterTaps[ii]->Read();
+   return {};
+}
+
 
 //////////////////////////////////////////////////////////////////////
 //
@@ -1746,6 +1794,7 @@ void AudioIO::AudioThread(std::atomic<bool> &finish)
 {
    enum class State { eUndefined, eOnce, eLoopRunning, eDoNothing, eMonitoring } lastState = State::eUndefined;
    AudioIO *const gAudioIO = AudioIO::Get();
+   Tracing::SetThreadName("Audio thread");
    while (!finish.load(std::memory_order_acquire)) {
       using Clock = std::chrono::steady_clock;
       auto loopPassStart = Clock::now();
@@ -1804,10 +1853,42 @@ void AudioIO::AudioThread(std::atomic<bool> &finish)
       gAudioIO->mAudioThreadSequenceBufferExchangeLoopActive
          .store(false, std::memory_order_relaxed);
 
+      gAudioIO->DrainMeterTransfers();
+
       std::this_thread::sleep_until( loopPassStart + interval );
    }
 }
 
+namespace {
+void DrainMeterTransfer(
+   AudioIoCallback::MeterTransfer &transfer, const std::weak_ptr<Meter> &wMeter)
+{
+   const auto &pBuffer = transfer.buffer;
+   if (!pBuffer)
+      return;
+   const auto nChannels = transfer.nChannels;
+   // The callback flushes whole frames only
+   const auto frames = pBuffer->AvailForGet() / nChannels;
+   if (frames == 0)
+      return;
+   const auto pMeter = wMeter.lock();
+   if (!pMeter || pMeter->IsMeterDisabled()) {
+      pBuffer->Discard(frames * nChannels);
+      return;
+   }
+   pBuffer->Get(reinterpret_cast<samplePtr>(transfer.scratch.data()),
+      floatSample, frames * nChannels);
+   pMeter->UpdateDisplay(nChannels, frames, transfer.scratch.data());
+}
+}
+
+void AudioIO::DrainMeterTransfers()
+{
+   std::lock_guard<std::mutex> lock{ mMeterTransferMutex };
+   DrainMeterTransfer(mInputMeterTransfer, mInputMeter);
+   DrainMeterTransfer(mOutputMeterTransfer, mOutputMeter);
+}
+
 size_t AudioIoCallback::MinValue(
    const RingBuffers &buffers, size_t (RingBuffer::*pmf)() const)
 {
@@ -1845,12 +1926,14 @@ size_t AudioIO::GetCommonlyAvailCapture()
 // (which communicates with the audio device).
 void AudioIO::SequenceBufferExchange()
 {
+   TRACE_ZONE("audio", "SequenceBufferExchange");
    FillPlayBuffers();
    DrainRecordBuffers();
 }
 
 void AudioIO::FillPlayBuffers()
 {
+   TRACE_ZONE("audio", "FillPlayBuffers");
    std::optional<RealtimeEffects::ProcessingScope> pScope;
    if (mpTransportState && mpTransportState->mpRealtimeInitialization)
       pScope.emplace(
@@ -2062,6 +2145,7 @@ void AudioIO::TransformPlayBuffers(
 
 void AudioIO::DrainRecordBuffers()
 {
+   TRACE_ZONE("audio", "DrainRecordBuffers");
    if (mRecordingException || mCaptureSequences.empty())
       return;
 
@@ -2504,7 +2588,7 @@ void AudioIoCallback::CheckSoundActivatedRecordingLevel(
 
 // A function to apply the requested gain, fading up or down from the
 // most recently applied gain.
-void AudioIoCallback::AddToOutputChannel(unsigned int chan,
+float AudioIoCallback::AddToOutputChannel(unsigned int chan,
    float * outputMeterFloats,
    float * outputFloats,
    const float * tempBuf,
@@ -2526,6 +2610,8 @@ void AudioIoCallback::AddToOutputChannel(unsigned int chan,
          outputMeterFloats[numPlaybackChannels*i+chan] +=
             gain*tempBuf[i];
 
+   const auto sequenceGain = gain;
+
    // DV: We use gain to emulate panning.
    // Let's keep the old behavior for panning.
    gain *= ExpGain(GetMixerOutputVol());
@@ -2544,6 +2630,7 @@ void AudioIoCallback::AddToOutputChannel(unsigned int chan,
    float deltaGain = (gain - oldGain) / len;
    for (unsigned i = 0; i < len; i++)
       outputFloats[numPlaybackChannels*i+chan] += (oldGain + deltaGain * i) *tempBuf[i];
+   return sequenceGain;
 };
 
 // Limit values to -1.0..+1.0
@@ -2683,14 +2770,20 @@ bool AudioIoCallback::FillOutputBuffers(
       // output channels.
       if (len > 0) {
          auto &gains = mOldChannelGains[tt];
-         AddToOutputChannel(0, outputMeterFloats, outputFloats,
+         float tapGains[SequenceMeterTap::MaxChannels];
+         tapGains[0] = AddToOutputChannel(0, outputMeterFloats, outputFloats,
             tempBufs[0], drop, len, *vt, gains[0]);
 
          // If one of mPlaybackSequences is mono, this replicates it in both
          // device channels
          const auto iBuffer = std::min<size_t>(1, width - 1);
-         AddToOutputChannel(1, outputMeterFloats, outputFloats,
+         tapGains[1] = AddToOutputChannel(1, outputMeterFloats, outputFloats,
             tempBufs[iBuffer], drop, len, *vt, gains[1]);
+
+         // Measure what this sequence adds, for meters of the sequence
+         const float *const tapChannels[SequenceMeterTap::MaxChannels]{
+            tempBufs[0], tempBufs[iBuffer] };
+         mSequenceMeterTaps[tt]->Accumulate(tapChannels, tapGains, len);
       }
 
       CallbackCheckCompletion(mCallbackReturn, len);
@@ -2707,6 +2800,12 @@ bool AudioIoCallback::FillOutputBuffers(
       CallbackCheckCompletion(mCallbackReturn, 0);
    }
 
+   // A short supply that is not the end of play means the audio thread
+   // fell behind
+   if (toGet < framesPerBuffer && numPlaybackSequences > 0 &&
+       mCallbackReturn == paContinue && !IsPaused())
+      mStarvedBuffers.fetch_add(1, std::memory_order_relaxed);
+
    // wxASSERT( maxLen == toGet );
 
    mLastPlaybackTimeMillis = ::wxGetUTCTimeMillis();
@@ -2925,21 +3024,36 @@ void AudioIoCallback::DoPlaythrough(
    }
 }
 
+namespace {
+//! Called in the audio callback, which must not wait for analysis of the
+//! samples; drops all of them if the audio thread falls behind
+void PutMeterSamples(AudioIoCallback::MeterTransfer &transfer,
+   const float *samples, unsigned long frames)
+{
+   const auto &pBuffer = transfer.buffer;
+   if (!pBuffer)
+      return;
+   const auto len = frames * transfer.nChannels;
+   if (pBuffer->AvailForPut() < len)
+      return;
+   pBuffer->Put(reinterpret_cast<constSamplePtr>(samples), floatSample, len);
+   pBuffer->Flush();
+}
+}
+
 /* Send data to recording VU meter if applicable */
-// Also computes rms
+// The meter computes levels later, in the audio thread
 void AudioIoCallback::SendVuInputMeterData(
    const float *inputSamples,
    unsigned long framesPerBuffer
    )
 {
-   const auto numCaptureChannels = mNumCaptureChannels;
    auto pInputMeter = mInputMeter.lock();
    if ( !pInputMeter )
       return;
    if( pInputMeter->IsMeterDisabled())
       return;
-   pInputMeter->UpdateDisplay(
-      numCaptureChannels, framesPerBuffer, inputSamples);
+   PutMeterSamples(mInputMeterTransfer, inputSamples, framesPerBuffer);
 }
 
 /* Send data to playback VU meter if applicable */
@@ -2947,8 +3061,6 @@ void AudioIoCallback::SendVuOutputMeterData(
    const float *outputMeterFloats,
    unsigned long framesPerBuffer)
 {
-   const auto numPlaybackChannels = mNumPlaybackChannels;
-
    auto pOutputMeter = mOutputMeter.lock();
    if (!pOutputMeter)
       return;
@@ -2956,8 +3068,7 @@ void AudioIoCallback::SendVuOutputMeterData(
       return;
    if( !outputMeterFloats)
       return;
-   pOutputMeter->UpdateDisplay(
-      numPlaybackChannels, framesPerBuffer, outputMeterFloats);
+   PutMeterSamples(mOutputMeterTransfer, outputMeterFloats, framesPerBuffer);
 
       //v Vaughan, 2011-02-25: Moved this update back to TrackPanel::OnTimer()
       //    as it helps with playback issues reported by Bill and noted on Bug 258.
@@ -3039,11 +3150,20 @@ int AudioIoCallback::AudioCallback(
    const PaStreamCallbackTimeInfo *timeInfo,
    const PaStreamCallbackFlags statusFlags, void * WXUNUSED(userData) )
 {
+   if (!mCallbackThreadNamed) {
+      Tracing::SetThreadName("PortAudio callback");
+      mCallbackThreadNamed = true;
+   }
+   TRACE_ZONE("audio", "AudioCallback");
+
    // Poll sequences for change of state.
    // (User might click mute and solo buttons.)
    mbHasSoloSequences = CountSoloingSequences() > 0 ;
    mCallbackReturn = paContinue;
 
+   if (statusFlags & paOutputUnderflow)
+      mDeviceUnderruns.fetch_add(1, std::memory_order_relaxed);
+
    if (IsPaused()
        // PRL:  Why was this added?  Was it only because of the mysterious
        // initial leading zeroes, now solved by setting mStreamToken early?
@@ -16,10 +16,12 @@
 #include "AudioIOBase.h" // to inherit
 #include "AudioIOSequences.h"
 #include "PlaybackSchedule.h" // member variable
+#include "SequenceMeterTap.h" // member variable
 
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <utility>
 #include <wx/atomic.h> // member variable
@@ -195,8 +197,9 @@ public:
 
    /*!
     @param[in,out] channelGain
+    @return the gain applied before the output volume
     */
-   void AddToOutputChannel( unsigned int chan, // index into gains
+   float AddToOutputChannel( unsigned int chan, // index into gains
       float * outputMeterFloats,
       float * outputFloats,
       const float * tempBuf,
@@ -277,6 +280,23 @@ public:
    // Old gain is used in playback in linearly interpolating
    // the gain.
    std::vector<OldChannelGains> mOldChannelGains;
+   //! Levels of each of mPlaybackSequences, for per-sequence meters
+   std::vector<std::unique_ptr<SequenceMeterTap>> mSequenceMeterTaps;
+
+   //! Carries samples from the audio callback to a meter, so that the meter
+   //! analyzes them in the audio thread instead
+   struct MeterTransfer {
+      //! Interleaved samples, put and flushed only in whole buffers
+      std::unique_ptr<RingBuffer> buffer;
+      unsigned nChannels{ 0 };
+      //! Used by the audio thread only
+      std::vector<float> scratch;
+   };
+   MeterTransfer mInputMeterTransfer;
+   MeterTransfer mOutputMeterTransfer;
+   //! Held by the main thread to replace the transfers and by the audio
+   //! thread to drain them, but never by the audio callback
+   std::mutex mMeterTransferMutex;
    // Temporary buffers, each as large as the playback buffers
    std::vector<SampleBuffer> mScratchBuffers;
    std::vector<float *> mScratchPointers; //!< pointing into mScratchBuffers
@@ -383,6 +403,12 @@ protected:
       { if (mRecordingException) wxAtomicDec( mRecordingException ); }
 
    std::vector< std::pair<double, double> > mLostCaptureIntervals;
+   //! Written by the PortAudio thread
+   std::atomic<unsigned long long> mDeviceUnderruns{ 0 };
+   std::atomic<unsigned long long> mStarvedBuffers{ 0 };
+   //! Written by the PortAudio thread, and reset before each stream starts,
+   //! because PortAudio may call back in another thread then
+   bool mCallbackThreadNamed{ false };
    /*! Read by a worker thread but unchanging during playback */
    bool mDetectDropouts{ true };
 
@@ -394,6 +420,20 @@ public:
    // Used only for testing purposes in alpha builds
    bool mSimulateRecordingErrors{ false };
 
+   struct PlaybackUnderruns {
+      //! Buffers that PortAudio reports the device ran out of
+      unsigned long long device{};
+      //! Buffers padded with silence, because the audio thread did not
+      //! keep up with mixing and realtime effects
+      unsigned long long starved{};
+   };
+   //! Counts since the start of the last stream; may be called in any thread
+   PlaybackUnderruns GetPlaybackUnderruns() const
+   {
+      return { mDeviceUnderruns.load(std::memory_order_relaxed),
+         mStarvedBuffers.load(std::memory_order_relaxed) };
+   }
+
    // Whether to check the error code passed to audacityAudioCallback to
    // detect more dropouts
    std::atomic<bool> mDetectUpstreamDropouts{ true };
@@ -572,8 +612,23 @@ public:
     */
    double GetStreamTime();
 
+   //! Levels that a sequence contributed to the output since the previous
+   //! call for it, after realtime effects, gain and pan but before the output
+   //! volume
+   /*!
+    There should be only one caller for each sequence.
+    @param sequence compared with the sources of playing sequences
+    @return nothing if the sequence is not playing, or played no samples since
+    */
+   std::optional<SequenceMeterTap::Levels>
+   GetSequenceLevels(const WideSampleSequence &sequence);
+
    static void AudioThread(std::atomic<bool> &finish);
 
+   //! Pass samples that the callback put in the meter transfers to the
+   //! meters; called in the audio thread
+   void DrainMeterTransfers();
+
    static void Init();
    static void Deinit();
 
@@ -588,6 +643,9 @@ private:
    /** \brief Set the current VU meters - this should be done once after
     * each call to StartStream currently */
    void SetMeters();
+   //! Replace or remove the meter transfers, which must not be in use by
+   //! the audio callback
+   void MakeMeterTransfers(bool make);
 
    /** \brief Opens the portaudio stream(s) used to do playback or recording
     * (or both) through.
@@ -0,0 +1,68 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SequenceMeterTap.cpp
+
+**********************************************************************/
+
+#include "SequenceMeterTap.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SequenceMeterTap::Reset()
+{
+   mMessage.Initialize();
+   mGeneration.store(0, std::memory_order_relaxed);
+   mAccumulated = {};
+   std::fill(std::begin(mRun), std::end(mRun), 0);
+}
+
+void SequenceMeterTap::Accumulate(const float *const channels[MaxChannels],
+   const float gains[MaxChannels], size_t len)
+{
+   // Start over once the reader has taken the previous levels
+   const auto generation = mGeneration.load(std::memory_order_acquire);
+   if (generation != mAccumulated.generation) {
+      mAccumulated = {};
+      mAccumulated.generation = generation;
+   }
+
+   for (unsigned chan = 0; chan < MaxChannels; ++chan) {
+      const auto buffer = channels[chan];
+      const auto gain = gains[chan];
+      auto peak = mAccumulated.peak[chan];
+      auto longest = mAccumulated.fullScaleRun[chan];
+      auto run = mRun[chan];
+      // Single precision accumulation of one callback is enough
+      float sumSquares = 0;
+      for (size_t ii = 0; ii < len; ++ii) {
+         const auto value = std::fabs(gain * buffer[ii]);
+         peak = std::max(peak, value);
+         sumSquares += value * value;
+         if (value >= 1.0f)
+            longest = std::max(longest, ++run);
+         else
+            run = 0;
+      }
+      mAccumulated.peak[chan] = peak;
+      mAccumulated.sumSquares[chan] += sumSquares;
+      mAccumulated.fullScaleRun[chan] = longest;
+      mRun[chan] = run;
+   }
+   mAccumulated.frames += len;
+
+   mMessage.Write(mAccumulated);
+}
+
+auto SequenceMeterTap::Read() -> std::optional<Levels>
+{
+   auto levels = mMessage.Read();
+   const auto generation = mGeneration.load(std::memory_order_relaxed);
+   // A message of an earlier generation was already reported
+   if (levels.frames == 0 || levels.generation != generation)
+      return {};
+   mGeneration.store(generation + 1, std::memory_order_release);
+   return levels;
+}
@@ -0,0 +1,73 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SequenceMeterTap.h
+  @brief Levels of one playback sequence, measured in the audio callback
+  for meters that the main thread polls
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SEQUENCE_METER_TAP__
+#define __AUDACITY_SEQUENCE_METER_TAP__
+
+#include "MemoryX.h"
+#include "MessageBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+//! Accumulates peak and power of the samples that one sequence contributes
+//! to each device channel, without allocating or locking
+/*!
+ One thread (the audio callback) calls Accumulate() and one other thread
+ calls Read().  Each result of Read() covers the samples accumulated since
+ the previous result, except that samples of a callback that overlaps a read
+ may go unreported.
+ */
+class AUDIO_IO_API SequenceMeterTap final
+{
+public:
+   static constexpr unsigned MaxChannels = 2;
+
+   struct Levels {
+      size_t frames{ 0 };
+      float peak[MaxChannels]{};
+      double sumSquares[MaxChannels]{};
+      //! Longest run of consecutive samples at or beyond full scale
+      size_t fullScaleRun[MaxChannels]{};
+      //! Identifies the read that these levels are for
+      unsigned generation{ 0 };
+   };
+
+   //! Reinitialize for another stream; not concurrent with the other functions
+   void Reset();
+
+   //! For the writer only
+   /*!
+    @param channels one buffer of `len` samples for each device channel
+    @param gains applied to `channels` before measurement
+    */
+   void Accumulate(const float *const channels[MaxChannels],
+      const float gains[MaxChannels], size_t len);
+
+   //! For the reader only
+   /*!
+    @return nothing if no samples were accumulated since the previous call
+    */
+   std::optional<Levels> Read();
+
+private:
+   MessageBuffer<Levels> mMessage;
+   //! Incremented by the reader after each successful read
+   std::atomic<unsigned> mGeneration{ 0 };
+
+   // Used by the writer only
+   Levels mAccumulated;
+   //! Length of the current run of full scale samples, which may continue
+   //! from one read into the next
+   size_t mRun[MaxChannels]{};
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SequenceMeterTapTest.cpp
+
+**********************************************************************/
+#include "SequenceMeterTap.h"
+#include "AudioIOSequences.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+class TestSequence : public PlayableSequence
+{
+public:
+   bool Get(
+      size_t, size_t, const samplePtr[], sampleFormat, sampleCount, size_t,
+      bool, fillFormat, bool, sampleCount*) const override
+   {
+      return true;
+   }
+   size_t NChannels() const override { return 1; }
+   float GetChannelGain(int) const override { return 1.f; }
+   double GetStartTime() const override { return 0.; }
+   double GetEndTime() const override { return 0.; }
+   double GetRate() const override { return 44100.; }
+   sampleFormat WidestEffectiveFormat() const override { return floatSample; }
+   bool HasTrivialEnvelope() const override { return true; }
+   void GetEnvelopeValues(double*, size_t, double, bool) const override {}
+   AudioGraph::ChannelType GetChannelType() const override
+   {
+      return AudioGraph::MonoChannel;
+   }
+   bool IsLeader() const override { return true; }
+   bool GetSolo() const override { return false; }
+   bool GetMute() const override { return false; }
+};
+
+//! A sequence that only decorates another
+class Decorator final : public TestSequence
+{
+public:
+   explicit Decorator(const PlayableSequence &decorated)
+      : mDecorated{ decorated }
+   {}
+private:
+   const WideSampleSequence *DoGetDecorated() const override
+   {
+      return &mDecorated;
+   }
+   const PlayableSequence &mDecorated;
+};
+
+//! Like a stretching sequence, which forwards the source of the decorated
+class SourceDecorator final : public TestSequence
+{
+public:
+   explicit SourceDecorator(const PlayableSequence &decorated)
+      : mDecorated{ decorated }
+   {}
+private:
+   const WideSampleSequence *DoGetDecorated() const override
+   {
+      return &mDecorated;
+   }
+   const WideSampleSequence *DoGetSource() const override
+   {
+      return &mDecorated.GetSource();
+   }
+   const PlayableSequence &mDecorated;
+};
+
+//! Like the render of a frozen track, which plays other samples than the
+//! track's but stands for it
+class Render final : public TestSequence
+{
+public:
+   explicit Render(const PlayableSequence &source)
+      : mSource{ source }
+   {}
+private:
+   const WideSampleSequence *DoGetSource() const override
+   {
+      return &mSource;
+   }
+   const PlayableSequence &mSource;
+};
+
+using Levels = SequenceMeterTap::Levels;
+
+void Accumulate(SequenceMeterTap &tap,
+   std::vector<float> left, std::vector<float> right,
+   float leftGain = 1.0f, float rightGain = 1.0f)
+{
+   REQUIRE(left.size() == right.size());
+   const float *const channels[]{ left.data(), right.data() };
+   const float gains[]{ leftGain, rightGain };
+   tap.Accumulate(channels, gains, left.size());
+}
+}
+
+TEST_CASE("SequenceMeterTap")
+{
+   SequenceMeterTap tap;
+   tap.Reset();
+
+   SECTION("Nothing is read before samples are accumulated")
+   {
+      REQUIRE(!tap.Read());
+   }
+
+   SECTION("Levels cover the callbacks since the previous read")
+   {
+      Accumulate(tap, { 0.5f, -0.25f }, { 0.0f, 0.0f });
+      Accumulate(tap, { 0.125f }, { -0.75f }, 1.0f, 0.5f);
+      const auto levels = tap.Read();
+      REQUIRE(levels);
+      REQUIRE(levels->frames == 3);
+      REQUIRE(levels->peak[0] == 0.5f);
+      REQUIRE(levels->peak[1] == 0.375f);
+      REQUIRE(levels->sumSquares[0] ==
+         Approx(0.5 * 0.5 + 0.25 * 0.25 + 0.125 * 0.125));
+      REQUIRE(levels->sumSquares[1] == Approx(0.375 * 0.375));
+
+      // Each level is reported once
+      REQUIRE(!tap.Read());
+
+      // The next read starts over
+      Accumulate(tap, { 0.0625f }, { 0.0f });
+      const auto next = tap.Read();
+      REQUIRE(next);
+      REQUIRE(next->frames == 1);
+      REQUIRE(next->peak[0] == 0.0625f);
+      REQUIRE(next->generation != levels->generation);
+   }
+
+   SECTION("Runs of full scale samples continue across callbacks")
+   {
+      Accumulate(tap, { 0.0f, 1.0f, -1.0f }, { 1.0f, 0.0f, 0.0f });
+      Accumulate(tap, { 1.0f, 0.5f }, { 0.0f, 0.0f });
+      auto levels = tap.Read();
+      REQUIRE(levels);
+      REQUIRE(levels->fullScaleRun[0] == 3);
+      REQUIRE(levels->fullScaleRun[1] == 1);
+
+
+      // A run in progress at a read continues into the next
+      Accumulate(tap, { 0.0f, 1.0f }, { 0.0f, 0.0f });
+      REQUIRE(tap.Read()->fullScaleRun[0] == 1);
+      Accumulate(tap, { 1.0f, 0.0f }, { 0.0f, 0.0f });
+      levels = tap.Read();
+      REQUIRE(levels);
+      REQUIRE(levels->fullScaleRun[0] == 2);
+   }
+
+   SECTION("Reset discards accumulated levels")
+   {
+      Accumulate(tap, { 0.5f }, { 0.5f });
+      tap.Reset();
+      REQUIRE(!tap.Read());
+   }
+}
+
+TEST_CASE("FindSource")
+{
+   const auto track = std::make_shared<TestSequence>();
+   const auto otherTrack = std::make_shared<TestSequence>();
+   const ConstPlayableSequences sequences{
+      std::make_shared<Decorator>(*otherTrack),
+      std::make_shared<Render>(*track),
+   };
+
+   SECTION("Decorated sequences are found")
+   {
+      REQUIRE(FindSource(sequences, *otherTrack) == 0);
+   }
+
+   SECTION("Sequences standing for another sequence are found")
+   {
+      REQUIRE(FindSource(sequences, *track) == 1);
+      REQUIRE(&sequences[1]->GetSource() == track.get());
+      // The render decorates nothing
+      REQUIRE(&sequences[1]->GetDecorated() == sequences[1].get());
+   }
+
+   SECTION("Decorators that forward the source find it")
+   {
+      const Render render{ *track };
+      const ConstPlayableSequences decorated{
+         std::make_shared<Decorator>(render),
+         std::make_shared<SourceDecorator>(render),
+      };
+      REQUIRE(FindSource(decorated, *track) == 1);
+   }
+
+   SECTION("Other sequences are not found")
+   {
+      const TestSequence stranger;
+      REQUIRE(FindSource(sequences, stranger) == sequences.size());
+   }
+}
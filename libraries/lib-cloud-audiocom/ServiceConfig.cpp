@@ -12,13 +12,26 @@
 #include "Languages.h"
 
 #include <rapidjson/document.h>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace cloud::audiocom
 {
 std::string_view ServiceConfig::GetAPIEndpoint() const
 {
-   return "https://api.audio.com";
+   // The environment variable allows pointing Audacity to a local
+   // stand-in of the service, i.e. for measuring upload performance
+   static const std::string endpoint = []
+   {
+      const auto overridden = std::getenv("AUDACITY_AUDIOCOM_API_ENDPOINT");
+
+      return std::string(
+         overridden != nullptr && *overridden != '\0' ?
+            overridden :
+            "https://api.audio.com");
+   }();
+
+   return endpoint;
 }
 
 std::string_view ServiceConfig::GetOAuthLoginPage() const
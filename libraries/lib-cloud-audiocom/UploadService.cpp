@@ -29,6 +29,7 @@
 #include "Request.h"
 #include "IResponse.h"
 #include "MultipartData.h"
+#include "StreamingPayload.h"
 
 #include "CodeConversions.h"
 
@@ -52,7 +53,8 @@ std::string_view DeduceMimeType(const wxString& ext)
 }
 
 std::string GetUploadRequestPayload(
-   const wxString& filePath, const wxString& projectName, bool isPublic)
+   const wxString& filePath, const wxString& projectName, bool isPublic,
+   bool isStreamed)
 {
    rapidjson::Document document;
    document.SetObject();
@@ -85,10 +87,14 @@ std::string GetUploadRequestPayload(
       rapidjson::Value(name.data(), name.length(), document.GetAllocator()),
       document.GetAllocator());
 
-   document.AddMember(
-      "size",
-      rapidjson::Value(static_cast<int64_t>(fileName.GetSize().GetValue())),
-      document.GetAllocator());
+   // Size of the streamed data is not known until the upload is finished
+   if (!isStreamed)
+   {
+      document.AddMember(
+         "size",
+         rapidjson::Value(static_cast<int64_t>(fileName.GetSize().GetValue())),
+         document.GetAllocator());
+   }
 
    document.AddMember(
       "public", rapidjson::Value(isPublic), document.GetAllocator());
@@ -178,14 +184,23 @@ struct AudiocomUploadOperation final :
       const ServiceConfig& serviceConfig, wxString fileName,
       wxString projectName, bool isPublic,
       UploadService::CompletedCallback completedCallback,
-      UploadService::ProgressCallback progressCallback)
+      UploadService::ProgressCallback progressCallback,
+      std::shared_ptr<audacity::network_manager::StreamingPayload> payload = {})
        : mServiceConfig(serviceConfig)
        , mFileName(std::move(fileName))
        , mProjectName(std::move(projectName))
        , mIsPublic(isPublic)
        , mCompletedCallback(std::move(completedCallback))
        , mProgressCallback(std::move(progressCallback))
+       , mPayload(std::move(payload))
+   {
+   }
+
+   ~AudiocomUploadOperation() override
    {
+      // Never leave the producer blocked
+      if (mPayload)
+         mPayload->Abort();
    }
 
    const ServiceConfig& mServiceConfig;
@@ -198,6 +213,9 @@ struct AudiocomUploadOperation final :
    UploadService::CompletedCallback mCompletedCallback;
    UploadService::ProgressCallback mProgressCallback;
 
+   //! Data source for the streamed uploads, mFileName is not read in this case
+   const std::shared_ptr<audacity::network_manager::StreamingPayload> mPayload;
+
    std::string mAuthToken;
 
    std::string mSuccessUrl;
@@ -237,6 +255,9 @@ struct AudiocomUploadOperation final :
 
    void FailPromise(UploadOperationCompleted::Result result, std::string errorMessage)
    {
+      if (mPayload)
+         mPayload->Abort();
+
       {
          std::lock_guard<std::mutex> lock(mStatusMutex);
          mCompleted = true;
@@ -294,7 +315,8 @@ struct AudiocomUploadOperation final :
       mAuthToken = std::string(authToken);
       SetRequiredHeaders(request);
 
-      const auto payload = GetUploadRequestPayload(mFileName, mProjectName, mIsPublic);
+      const auto payload = GetUploadRequestPayload(
+         mFileName, mProjectName, mIsPublic, mPayload != nullptr);
 
       std::lock_guard<std::mutex> lock(mStatusMutex);
 
@@ -374,7 +396,12 @@ struct AudiocomUploadOperation final :
          // We have checked for the file existence on the main thread
          // already. For safety sake check for any exception thrown by AddFile
          // anyway
-         form->AddFile(fileField, DeduceMimeType(name.GetExt()), name);
+         if (mPayload)
+            form->AddStream(
+               fileField, DeduceMimeType(name.GetExt()),
+               audacity::ToUTF8(name.GetFullName()), mPayload);
+         else
+            form->AddFile(fileField, DeduceMimeType(name.GetExt()), name);
       }
       catch (...)
       {
@@ -446,6 +473,10 @@ struct AudiocomUploadOperation final :
             mProgressCallback(current, total);
       }
       
+      // Progress can't be reported to audio.com when the size is unknown
+      if (total == 0)
+         return;
+
       const auto now = Clock::now();
 
       if ((now - mLastProgressReportTime) > mServiceConfig.GetProgressCallbackTimeout())
@@ -529,6 +560,11 @@ struct AudiocomUploadOperation final :
          mCompleted = true;
          mAborted = true;
 
+         // Only now, so that the request failing on the aborted payload
+         // finds mAborted set and does not report the failure
+         if (mPayload)
+            mPayload->Abort();
+
          if (auto activeResponse = mActiveResponse.lock())
             activeResponse->abort();
       } 
@@ -592,6 +628,22 @@ UploadOperationHandle UploadService::Upload(
    return UploadOperationHandle { operation };
 }
 
+UploadOperationHandle UploadService::UploadStream(
+   std::shared_ptr<audacity::network_manager::StreamingPayload> payload,
+   const wxString& fileName, const wxString& projectName, bool isPublic,
+   CompletedCallback completedCallback, ProgressCallback progressCallback)
+{
+   auto operation = std::make_shared<AudiocomUploadOperation>(
+      mServiceConfig, fileName, projectName, isPublic,
+      std::move(completedCallback), std::move(progressCallback),
+      std::move(payload));
+
+   mOAuthService.ValidateAuth([operation, this](std::string_view authToken)
+                              { operation->InitiateUpload(authToken); });
+
+   return UploadOperationHandle { operation };
+}
+
 UploadOperation::~UploadOperation() = default;
 
 UploadOperationHandle::UploadOperationHandle(
@@ -636,6 +688,23 @@ wxString GetUploadTempPath()
    return tempPath + "/cloud/";
 }
 
+bool MayRetryWithFile(const UploadOperationCompleted& result)
+{
+   using Result = UploadOperationCompleted::Result;
+
+   switch (result.result)
+   {
+   case Result::InvalidData:
+   case Result::UnexpectedResponse:
+   case Result::UploadFailed:
+      return true;
+   default:
+      // Retrying can't help with authorization, and the user may have
+      // aborted
+      return false;
+   }
+}
+
 namespace
 {
 const auto tempChangedSubscription = TempDirectory::GetTempPathObserver().Subscribe([](const auto&) {
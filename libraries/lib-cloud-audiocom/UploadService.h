@@ -18,6 +18,11 @@
 
 #include <wx/string.h>
 
+namespace audacity::network_manager
+{
+class StreamingPayload;
+}
+
 namespace cloud::audiocom
 {
 class ServiceConfig;
@@ -143,10 +148,31 @@ public:
       const wxString& fileName, const wxString& projectName, bool isPublic,
       CompletedCallback completedCallback, ProgressCallback progressCallback);
 
+   //! Uploads the data to audio.com while it is being produced
+   /*
+      Both callbacks are invoked from the network thread. The total value
+      passed to the progress callback is 0, as the size is not known in advance.
+
+      The producer is expected to call Finish on the payload once all the data
+      is written, or Abort if it has failed. The payload is aborted if the upload
+      fails or is aborted, so the producer blocked on the full payload is released.
+
+      fileName is only used to deduce the MIME type and,
+      if projectName is empty, the name of the uploaded file.
+   */
+   UploadOperationHandle UploadStream(
+      std::shared_ptr<audacity::network_manager::StreamingPayload> payload,
+      const wxString& fileName, const wxString& projectName, bool isPublic,
+      CompletedCallback completedCallback, ProgressCallback progressCallback);
+
 private:
    const ServiceConfig& mServiceConfig;
    OAuthService& mOAuthService;
 };
 
 CLOUD_AUDIOCOM_API wxString GetUploadTempPath();
+
+//! Whether a streamed upload failed in a way that uploading a file, whose
+//! size is known, might avoid: audio.com or the storage refused the request
+CLOUD_AUDIOCOM_API bool MayRetryWithFile(const UploadOperationCompleted& result);
 } // namespace cloud::audiocom
@@ -0,0 +1,254 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  UploadStreamTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "LocalHttpServer.h"
+#include "MemoryX.h"
+#include "MockedPrefs.h"
+
+#include "OAuthService.h"
+#include "ServiceConfig.h"
+#include "StreamingPayload.h"
+#include "UploadService.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+
+using namespace cloud::audiocom;
+using namespace audacity::network_manager;
+using namespace std::chrono_literals;
+
+namespace
+{
+//! Stands in for audio.com and for the storage the audio is posted to
+struct StandIn final
+{
+   //! Response code for the upload request to audio.com
+   std::atomic<unsigned> audioCode { 201 };
+   //! Response code for the post to the storage
+   std::atomic<unsigned> storageCode { 204 };
+
+   test::LocalHttpServer server { [this](const auto& request)
+                                  { return Handle(request); } };
+
+   test::LocalHttpServer::Response
+   Handle(const test::LocalHttpServer::Request& request)
+   {
+      const auto base = server.GetUrl();
+
+      if (request.target == "/audio")
+      {
+         if (audioCode != 201)
+            return { audioCode.load(), R"({"code":422,"status":422})" };
+
+         return { 201,
+                  R"({"url":")" + base + R"(/storage",)" +
+                     R"("success":")" + base + R"(/success",)" +
+                     R"("fail":")" + base + R"(/fail",)" +
+                     R"("progress":")" + base + R"(/progress",)" +
+                     R"("extra":{"audio":{"id":"1","slug":"slug",)" +
+                     R"("username":"user"},"token":"token"}})" };
+      }
+
+      if (request.target == "/storage")
+         return { storageCode.load() };
+
+      return { 200, "{}" };
+   }
+};
+
+StandIn& GetStandIn()
+{
+   static StandIn standIn;
+   return standIn;
+}
+
+//! Points the service to the stand-in, before its endpoint is first read
+const ServiceConfig& GetConfig()
+{
+   static const bool endpointSet = []
+   {
+      const auto url = GetStandIn().server.GetUrl();
+#ifdef _WIN32
+      return _putenv_s("AUDACITY_AUDIOCOM_API_ENDPOINT", url.c_str()) == 0;
+#else
+      return setenv("AUDACITY_AUDIOCOM_API_ENDPOINT", url.c_str(), 1) == 0;
+#endif
+   }();
+
+   REQUIRE(endpointSet);
+   REQUIRE(GetServiceConfig().GetAPIEndpoint() == GetStandIn().server.GetUrl());
+
+   return GetServiceConfig();
+}
+
+//! Requests to the stand-in, from the given one on
+std::vector<test::LocalHttpServer::Request> RequestsFrom(size_t first)
+{
+   auto requests = GetStandIn().server.GetRequests();
+   requests.erase(requests.begin(), requests.begin() + first);
+   return requests;
+}
+} // namespace
+
+TEST_CASE("UploadService::UploadStream", "[UploadService]")
+{
+   MockedPrefs prefs;
+
+   auto& standIn = GetStandIn();
+   standIn.storageCode = 204;
+   UploadService service { GetConfig(), GetOAuthService() };
+
+   const auto first = standIn.server.GetRequests().size();
+
+   // Much smaller than the data, so that the producer must wait for the
+   // network to read
+   auto payload = std::make_shared<StreamingPayload>(64 * 1024);
+   const std::string data(1024 * 1024, 'a');
+
+   std::promise<UploadOperationCompleted> completed;
+   std::atomic<bool> progressTotalsZero { true };
+
+   const auto upload = [&]
+   {
+      return service.UploadStream(
+         payload, "upload.wv", "Project", false,
+         [&](const auto& result) { completed.set_value(result); },
+         [&](auto, auto total)
+         {
+            if (total != 0)
+               progressTotalsZero = false;
+         });
+   };
+
+   // Catch2 assertions are not thread safe
+   std::atomic<bool> writesSucceeded { false };
+   std::thread producer(
+      [&]
+      {
+         writesSucceeded = payload->Write(data.data(), data.size());
+         payload->Finish();
+      });
+   // Don't leave the producer running when an assertion fails
+   auto joinProducer = finally(
+      [&]
+      {
+         if (producer.joinable())
+         {
+            payload->Abort();
+            producer.join();
+         }
+      });
+
+   SECTION("The data is posted to the storage while it is written")
+   {
+      standIn.audioCode = 201;
+
+      auto handle = upload();
+      auto result = completed.get_future();
+      REQUIRE(result.wait_for(30s) == std::future_status::ready);
+      producer.join();
+
+      REQUIRE(result.get().result == UploadOperationCompleted::Result::Success);
+      REQUIRE(writesSucceeded);
+      REQUIRE(progressTotalsZero);
+
+      const auto requests = RequestsFrom(first);
+      REQUIRE(requests.size() == 3);
+
+      // The size is not known when the upload starts
+      REQUIRE(requests[0].target == "/audio");
+      REQUIRE(requests[0].body.find("\"size\"") == std::string::npos);
+
+      REQUIRE(requests[1].target == "/storage");
+      REQUIRE(requests[1].headers.at("transfer-encoding") == "chunked");
+      REQUIRE(requests[1].chunks > 1);
+      REQUIRE(requests[1].body.find(data) != std::string::npos);
+
+      // Progress is not reported to audio.com without the total
+      REQUIRE(requests[2].method == "POST");
+      REQUIRE(requests[2].target == "/success");
+   }
+
+   SECTION("A failed upload releases the producer")
+   {
+      standIn.audioCode = 422;
+
+      auto handle = upload();
+      auto result = completed.get_future();
+      REQUIRE(result.wait_for(30s) == std::future_status::ready);
+      producer.join();
+
+      const auto completion = result.get();
+      REQUIRE(completion.result == UploadOperationCompleted::Result::InvalidData);
+      REQUIRE(!writesSucceeded);
+      REQUIRE(RequestsFrom(first).size() == 1);
+      // Perhaps audio.com wants the size
+      REQUIRE(MayRetryWithFile(completion));
+   }
+
+   SECTION("Storage that refuses the stream fails the upload")
+   {
+      standIn.audioCode = 201;
+      // As for a body without Content-Length
+      standIn.storageCode = 411;
+
+      auto handle = upload();
+      auto result = completed.get_future();
+      REQUIRE(result.wait_for(30s) == std::future_status::ready);
+      producer.join();
+
+      const auto completion = result.get();
+      REQUIRE(completion.result == UploadOperationCompleted::Result::UploadFailed);
+      REQUIRE(MayRetryWithFile(completion));
+
+      // audio.com is told of the failure
+      const auto requests = RequestsFrom(first);
+      REQUIRE(requests.size() == 3);
+      REQUIRE(requests[2].method == "DELETE");
+      REQUIRE(requests[2].target == "/fail");
+   }
+
+   SECTION("Abort cancels the transfer and releases the producer")
+   {
+      standIn.audioCode = 201;
+
+      auto handle = upload();
+
+      // Abort only after the transfer has begun
+      const auto deadline = std::chrono::steady_clock::now() + 30s;
+      while (payload->GetBytesRead() == 0 &&
+             std::chrono::steady_clock::now() < deadline)
+         std::this_thread::sleep_for(1ms);
+      REQUIRE(payload->GetBytesRead() > 0);
+
+      handle->Abort();
+
+      auto result = completed.get_future();
+      REQUIRE(result.wait_for(5s) == std::future_status::ready);
+      producer.join();
+
+      const auto completion = result.get();
+      REQUIRE(completion.result == UploadOperationCompleted::Result::Aborted);
+      REQUIRE(!MayRetryWithFile(completion));
+      REQUIRE(!writesSucceeded);
+
+      // The storage saw a body that never ended, and nothing followed
+      REQUIRE(standIn.server.WaitForRequests(first + 2, 5s));
+      std::this_thread::sleep_for(200ms);
+      const auto requests = RequestsFrom(first);
+      REQUIRE(requests.size() == 2);
+      REQUIRE(requests[1].target == "/storage");
+      REQUIRE(!requests[1].complete);
+   }
+}
@@ -0,0 +1,541 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file RealtimeEffectFreeze.cpp
+
+**********************************************************************/
+
+#include "RealtimeEffectFreeze.h"
+
+#include "EffectAutomationParameters.h"
+#include "Envelope.h"
+#include "Mix.h"
+#include "MixAndRender.h"
+#include "RealtimeEffectList.h"
+#include "RealtimeEffectState.h"
+#include "StretchingSequence.h"
+#include "WaveClip.h"
+#include "WaveTrack.h"
+#include "XMLWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+//! Reverberation and delays ring on after the last clip of the track
+constexpr double TailDuration = 2.0;
+
+void AppendDouble(std::vector<long long> &key, double value)
+{
+   long long bits;
+   static_assert(sizeof(bits) == sizeof(value));
+   memcpy(&bits, &value, sizeof(bits));
+   key.push_back(bits);
+}
+}
+
+//! What the render depends on, besides the settings of the playback
+struct RealtimeEffectFreeze::Fingerprint final {
+   std::vector<long long> content;
+   std::vector<wxString> effects;
+
+   bool operator ==(const Fingerprint &other) const
+   {
+      return content == other.content && effects == other.effects;
+   }
+   bool operator !=(const Fingerprint &other) const
+   {
+      return !(*this == other);
+   }
+
+   //! Null if the track or an effect can't be identified, as when recording
+   //! is not yet flushed, or an effect can't save its settings
+   static std::optional<Fingerprint> Make(const WaveTrack &track);
+};
+
+auto RealtimeEffectFreeze::Fingerprint::Make(const WaveTrack &track)
+   -> std::optional<Fingerprint>
+{
+   Fingerprint result;
+
+   // Same choice of states as GetEffectStages()
+   auto &effects = RealtimeEffectList::Get(track);
+   if (effects.IsActive())
+      for (size_t i = 0, count = effects.GetStatesCount(); i < count; ++i) {
+         const auto pState = effects.GetStateAt(i);
+         if (!pState->IsEnabled())
+            continue;
+         const auto pEffect = pState->GetEffect();
+         if (!pEffect)
+            continue;
+         const auto &settings = pState->GetSettings();
+         if (!settings.has_value())
+            continue;
+         CommandParameters parms;
+         wxString parameters;
+         if (!pEffect->SaveSettings(settings, parms) ||
+             !parms.GetParameters(parameters))
+            return {};
+         result.effects.push_back(pState->GetID() + '\n' + parameters);
+      }
+
+   auto &content = result.content;
+   AppendDouble(content, track.GetRate());
+   for (const auto pChannel : TrackList::Channels(&track)) {
+      const auto &clips = pChannel->GetClips();
+      content.push_back(clips.size());
+      for (const auto &pClip : clips) {
+         const auto key = pClip->GetContentKey();
+         if (key.empty())
+            return {};
+         content.push_back(key.size());
+         content.insert(content.end(), key.begin(), key.end());
+         AppendDouble(content, pClip->GetPlayStartTime());
+         AppendDouble(content, pClip->GetStretchRatio());
+         const auto &envelope = *pClip->GetEnvelope();
+         const int nPoints = envelope.GetNumberOfPoints();
+         content.push_back(nPoints);
+         for (int iPoint = 0; iPoint < nPoints; ++iPoint) {
+            AppendDouble(content, envelope[iPoint].GetT());
+            AppendDouble(content, envelope[iPoint].GetVal());
+         }
+      }
+   }
+   return result;
+}
+
+struct RealtimeEffectFreeze::Job final {
+   Job(const AudacityProject *pProject, Fingerprint fingerprint)
+      : pProject{ pProject }, fingerprint{ std::move(fingerprint) }
+   {}
+
+   const AudacityProject *const pProject;
+   const Fingerprint fingerprint;
+
+   //! Copy of the track, read by the worker thread
+   TrackListHolder pSource;
+   //! Made in the main thread, where the effect instances are made
+   std::unique_ptr<Mixer> pMixer;
+   //! Receives the render
+   TrackListHolder pOutput;
+   std::vector<WaveTrack *> outputChannels;
+
+   std::atomic<bool> cancelled{ false };
+   //! Set by the worker thread after all else it writes
+   std::atomic<bool> done{ false };
+   bool succeeded{ false };
+};
+
+namespace {
+using Job = RealtimeEffectFreeze::Job;
+
+//! Runs render jobs, one at a time, in a worker thread
+/*!
+ The worker never destroys a job, which may release effect instances or the
+ last references to sample blocks; finished jobs are released by the next
+ call from the main thread
+ */
+class Renderer final {
+public:
+   static Renderer &Get()
+   {
+      static Renderer renderer;
+      return renderer;
+   }
+
+   ~Renderer()
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mStopping = true;
+         if (mpRunning)
+            mpRunning->cancelled = true;
+      }
+      mCondition.notify_all();
+      if (mThread.joinable())
+         mThread.join();
+   }
+
+   void Schedule(std::shared_ptr<Job> pJob)
+   {
+      ReleaseSpent();
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mJobs.push_back(move(pJob));
+      if (!mThread.joinable())
+         mThread = std::thread{ [this]{ Work(); } };
+      mCondition.notify_all();
+   }
+
+   void Cancel(const AudacityProject *pProject)
+   {
+      // Destroyed after the mutex is released
+      std::vector<std::shared_ptr<Job>> cancelled;
+      std::unique_lock<std::mutex> lock{ mMutex };
+      for (auto iter = mJobs.begin(); iter != mJobs.end();) {
+         if ((*iter)->pProject == pProject) {
+            (*iter)->cancelled = true;
+            cancelled.push_back(move(*iter));
+            iter = mJobs.erase(iter);
+         }
+         else
+            ++iter;
+      }
+      if (mpRunning && mpRunning->pProject == pProject) {
+         mpRunning->cancelled = true;
+         mCondition.wait(lock, [&]{
+            return !mpRunning || mpRunning->pProject != pProject; });
+      }
+      move(mSpent.begin(), mSpent.end(), back_inserter(cancelled));
+      mSpent.clear();
+   }
+
+   void ReleaseSpent()
+   {
+      std::vector<std::shared_ptr<Job>> spent;
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         spent.swap(mSpent);
+      }
+   }
+
+private:
+   Renderer() = default;
+
+   void Work()
+   {
+      std::unique_lock<std::mutex> lock{ mMutex };
+      while (true) {
+         mCondition.wait(lock, [this]{ return mStopping || !mJobs.empty(); });
+         if (mStopping)
+            return;
+         mpRunning = move(mJobs.front());
+         mJobs.pop_front();
+         lock.unlock();
+
+         Render(*mpRunning);
+
+         lock.lock();
+         mSpent.push_back(move(mpRunning));
+         mCondition.notify_all();
+      }
+   }
+
+   static void Render(Job &job)
+   {
+      try {
+         auto &mixer = *job.pMixer;
+         while (!job.cancelled.load(std::memory_order_relaxed)) {
+            const auto blockLen = mixer.Process();
+            if (blockLen == 0)
+               break;
+            const auto effectiveFormat = mixer.EffectiveFormat();
+            for (size_t iChannel = 0; iChannel < job.outputChannels.size();
+               ++iChannel)
+               job.outputChannels[iChannel]->Append(mixer.GetBuffer(iChannel),
+                  floatSample, blockLen, 1, effectiveFormat);
+         }
+         for (const auto pChannel : job.outputChannels)
+            pChannel->Flush();
+         job.succeeded = !job.cancelled.load(std::memory_order_relaxed);
+      }
+      catch (...) {
+         // Such as failure to read or write sample blocks; the track is
+         // played live instead
+      }
+      job.done.store(true, std::memory_order_release);
+   }
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque<std::shared_ptr<Job>> mJobs;
+   std::shared_ptr<Job> mpRunning;
+   std::vector<std::shared_ptr<Job>> mSpent;
+   bool mStopping{ false };
+   std::thread mThread;
+};
+
+const AudacityProject *FindProject(const WaveTrack &track)
+{
+   const auto pList = track.GetOwner();
+   return pList ? pList->GetOwner() : nullptr;
+}
+
+static const SequenceAttachments::RegisteredFactory sFreezeKey{
+   [](WideSampleSequence &) {
+      return std::make_unique<RealtimeEffectFreeze>();
+   }
+};
+}
+
+RealtimeEffectFreeze &RealtimeEffectFreeze::Get(WaveTrack &track)
+{
+   assert(track.IsLeader());
+   return static_cast<WideSampleSequence&>(track)
+      .Attachments::Get<RealtimeEffectFreeze>(sFreezeKey);
+}
+
+const RealtimeEffectFreeze &RealtimeEffectFreeze::Get(const WaveTrack &track)
+{
+   return Get(const_cast<WaveTrack &>(track));
+}
+
+void RealtimeEffectFreeze::CancelRenders(const AudacityProject &project)
+{
+   Renderer::Get().Cancel(&project);
+}
+
+RealtimeEffectFreeze::RealtimeEffectFreeze() = default;
+
+RealtimeEffectFreeze::~RealtimeEffectFreeze() = default;
+
+std::unique_ptr<ClientData::Cloneable<>> RealtimeEffectFreeze::Clone() const
+{
+   auto result = std::make_unique<RealtimeEffectFreeze>();
+   result->mFrozen = mFrozen;
+   result->mpJob = mpJob;
+   return result;
+}
+
+void RealtimeEffectFreeze::SetFrozen(const WaveTrack &track, bool frozen)
+{
+   if (frozen) {
+      mFrozen = true;
+      GetPlayableSequence(track);
+   }
+   else {
+      if (mpJob && !mpJob->done.load(std::memory_order_acquire))
+         mpJob->cancelled = true;
+      Reset();
+   }
+}
+
+bool RealtimeEffectFreeze::IsRendering() const
+{
+   return mpJob && !mpJob->cancelled &&
+      !mpJob->done.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const PlayableSequence>
+RealtimeEffectFreeze::GetPlayableSequence(const WaveTrack &track)
+{
+   assert(track.IsLeader());
+   if (!mFrozen)
+      return nullptr;
+   Renderer::Get().ReleaseSpent();
+
+   auto fingerprint = Fingerprint::Make(track);
+   // Nothing to gain from a render of a track without effects
+   if (!fingerprint || fingerprint->effects.empty()) {
+      if (mpJob && !mpJob->done.load(std::memory_order_acquire))
+         mpJob->cancelled = true;
+      mpJob.reset();
+      return nullptr;
+   }
+
+   const auto done = mpJob && mpJob->done.load(std::memory_order_acquire);
+   if (!mpJob || mpJob->fingerprint != *fingerprint ||
+       (mpJob->cancelled && !done)) {
+      Schedule(track, std::move(*fingerprint));
+      return nullptr;
+   }
+   if (!done || !mpJob->succeeded)
+      return nullptr;
+
+   // The worker is finished with these
+   mpJob->pMixer.reset();
+   mpJob->pSource.reset();
+   return std::make_shared<FrozenTrackSequence>(
+      track.SharedPointer<const WaveTrack>(), mpJob->pOutput);
+}
+
+void RealtimeEffectFreeze::Schedule(
+   const WaveTrack &track, Fingerprint fingerprint)
+{
+   if (mpJob && !mpJob->done.load(std::memory_order_acquire))
+      mpJob->cancelled = true;
+   mpJob.reset();
+   if (track.GetStartTime() >= track.GetEndTime())
+      return;
+
+   auto pJob = std::make_shared<Job>(FindProject(track), std::move(fingerprint));
+
+   // Copy the track so that the worker doesn't race with editing.  The copy
+   // shares the sample blocks.
+   pJob->pSource = track.Duplicate();
+   const auto pSource = *pJob->pSource->Any<WaveTrack>().begin();
+   // Copies of this attachment would make cycles of ownership
+   Get(*pSource).Reset();
+
+   pJob->pOutput = pSource->WideEmptyCopy();
+   const auto pOutput = *pJob->pOutput->Any<WaveTrack>().begin();
+   Get(*pOutput).Reset();
+   pOutput->ConvertToSampleFormat(floatSample);
+   const auto t0 = pSource->GetStartTime();
+   const auto t1 = pSource->GetEndTime() + TailDuration;
+   pOutput->MoveTo(t0);
+   for (const auto pChannel : TrackList::Channels(pOutput))
+      pJob->outputChannels.push_back(pChannel);
+
+   // Gain and pan are applied in playback, after the effects; and so is any
+   // time warp
+   Mixer::Inputs inputs;
+   inputs.emplace_back(
+      StretchingSequence::Create(*pSource, pSource->GetClipInterfaces()),
+      GetEffectStages(*pSource));
+   const auto nChannels = pJob->outputChannels.size();
+   pJob->pMixer = std::make_unique<Mixer>(move(inputs),
+      // Throw to abandon the render if read fails:
+      true,
+      Mixer::WarpOptions{ 1.0, 1.0 }, t0, t1, nChannels,
+      pOutput->GetIdealBlockSize(), false,
+      pSource->GetRate(), floatSample, false, nullptr, false);
+
+   mpJob = pJob;
+   Renderer::Get().Schedule(move(pJob));
+}
+
+void RealtimeEffectFreeze::Reset()
+{
+   mFrozen = false;
+   mpJob.reset();
+}
+
+const std::string &RealtimeEffectFreeze::XMLTag()
+{
+   static const std::string result{ "realtimefreeze" };
+   return result;
+}
+
+bool RealtimeEffectFreeze::HandleXMLTag(
+   const std::string_view &tag, const AttributesList &)
+{
+   if (tag != XMLTag())
+      return false;
+   // The render is not saved, but made again when needed
+   mFrozen = true;
+   return true;
+}
+
+XMLTagHandler *RealtimeEffectFreeze::HandleXMLChild(const std::string_view &)
+{
+   return nullptr;
+}
+
+void RealtimeEffectFreeze::WriteXML(XMLWriter &xmlFile) const
+{
+   if (!mFrozen)
+      return;
+   xmlFile.StartTag(XMLTag());
+   xmlFile.EndTag(XMLTag());
+}
+
+static WaveTrackIORegistry::ObjectReaderEntry waveTrackAccessor {
+   RealtimeEffectFreeze::XMLTag(),
+   [](WaveTrack &track) { return &RealtimeEffectFreeze::Get(track); }
+};
+
+static WaveTrackIORegistry::ObjectWriterEntry waveTrackWriter {
+[](const WaveTrack &track, auto &xmlFile) {
+   if (track.IsLeader())
+      RealtimeEffectFreeze::Get(track).WriteXML(xmlFile);
+} };
+
+FrozenTrackSequence::FrozenTrackSequence(
+   std::shared_ptr<const WaveTrack> pTrack,
+   std::shared_ptr<const TrackList> pRender
+)  : mpTrack{ move(pTrack) }
+   , mpRender{ move(pRender) }
+{
+   assert(mpTrack && mpTrack->IsLeader());
+   assert(mpRender);
+}
+
+FrozenTrackSequence::~FrozenTrackSequence() = default;
+
+const WideSampleSequence *FrozenTrackSequence::DoGetSource() const
+{
+   return mpTrack.get();
+}
+
+const WaveTrack &FrozenTrackSequence::GetRender() const
+{
+   return **mpRender->Any<const WaveTrack>().begin();
+}
+
+size_t FrozenTrackSequence::NChannels() const
+{
+   return GetRender().NChannels();
+}
+
+float FrozenTrackSequence::GetChannelGain(int channel) const
+{
+   return mpTrack->GetChannelGain(channel);
+}
+
+bool FrozenTrackSequence::Get(size_t iChannel, size_t nBuffers,
+   const samplePtr buffers[], sampleFormat format, sampleCount start,
+   size_t len, bool backwards, fillFormat fill, bool mayThrow,
+   sampleCount* pNumWithinClips) const
+{
+   return GetRender().Get(iChannel, nBuffers, buffers, format, start, len,
+      backwards, fill, mayThrow, pNumWithinClips);
+}
+
+double FrozenTrackSequence::GetStartTime() const
+{
+   return GetRender().GetStartTime();
+}
+
+double FrozenTrackSequence::GetEndTime() const
+{
+   return GetRender().GetEndTime();
+}
+
+double FrozenTrackSequence::GetRate() const
+{
+   return GetRender().GetRate();
+}
+
+sampleFormat FrozenTrackSequence::WidestEffectiveFormat() const
+{
+   return GetRender().WidestEffectiveFormat();
+}
+
+bool FrozenTrackSequence::HasTrivialEnvelope() const
+{
+   // Clip envelopes were applied in the render
+   return true;
+}
+
+void FrozenTrackSequence::GetEnvelopeValues(
+   double* buffer, size_t bufferLen, double, bool) const
+{
+   std::fill(buffer, buffer + bufferLen, 1.0);
+}
+
+AudioGraph::ChannelType FrozenTrackSequence::GetChannelType() const
+{
+   return mpTrack->GetChannelType();
+}
+
+bool FrozenTrackSequence::IsLeader() const
+{
+   return true;
+}
+
+bool FrozenTrackSequence::GetSolo() const
+{
+   return mpTrack->GetSolo();
+}
+
+bool FrozenTrackSequence::GetMute() const
+{
+   return mpTrack->GetMute();
+}
@@ -0,0 +1,143 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file RealtimeEffectFreeze.h
+  @brief Per-track rendering of realtime effect stacks, played instead of
+  processing the stack live
+
+**********************************************************************/
+
+#ifndef __AUDACITY_REALTIME_EFFECT_FREEZE__
+#define __AUDACITY_REALTIME_EFFECT_FREEZE__
+
+#include "AudioIOSequences.h"
+#include "ClientData.h"
+#include "XMLTagHandler.h"
+
+#include <memory>
+#include <vector>
+
+class AudacityProject;
+class TrackList;
+class WaveTrack;
+class XMLWriter;
+
+//! Freeze mode of a wave track
+/*!
+ When frozen, the track is rendered through its realtime effect stack in a
+ worker thread, into sample blocks of the project, and playback uses the
+ render instead of running the stack.
+
+ The render is valid only for the clips, envelopes and effect settings that
+ it was made from.  Whenever these change, playback processes the effects
+ live again, until the new render completes.
+
+ Gain, pan, mute and solo of the track, time warping, and the master effect
+ stack still apply live to the frozen track.
+
+ Use only in the main thread.
+ */
+class EFFECTS_API RealtimeEffectFreeze final
+   : public ClientData::Cloneable<>
+   , public XMLTagHandler
+{
+public:
+   struct Job;
+
+   //! @pre `track.IsLeader()`
+   static RealtimeEffectFreeze &Get(WaveTrack &track);
+   //! @pre `track.IsLeader()`
+   static const RealtimeEffectFreeze &Get(const WaveTrack &track);
+
+   //! Cancel the renders of tracks of the project, waiting for the one in
+   //! progress to stop
+   /*!
+    Call before the storage of the project's sample blocks goes away
+    */
+   static void CancelRenders(const AudacityProject &project);
+
+   RealtimeEffectFreeze();
+   ~RealtimeEffectFreeze() override;
+
+   //! Shares the render, which is immutable
+   std::unique_ptr<ClientData::Cloneable<>> Clone() const override;
+
+   bool IsFrozen() const { return mFrozen; }
+
+   //! Turn freezing on, starting a render, or off, discarding it
+   /*! @pre `track.IsLeader()` */
+   void SetFrozen(const WaveTrack &track, bool frozen);
+
+   //! Whether the last scheduled render is still in progress
+   bool IsRendering() const;
+
+   //! The sequence to play instead of the track, or null
+   /*!
+    Null if not frozen, or if the render is not complete and up to date, in
+    which case rendering of the current contents is scheduled.
+    @pre `track.IsLeader()`
+    */
+   std::shared_ptr<const PlayableSequence>
+   GetPlayableSequence(const WaveTrack &track);
+
+   static const std::string &XMLTag();
+   bool HandleXMLTag(
+      const std::string_view &tag, const AttributesList &attrs) override;
+   XMLTagHandler *HandleXMLChild(const std::string_view &tag) override;
+   void WriteXML(XMLWriter &xmlFile) const;
+
+private:
+   struct Fingerprint;
+
+   void Schedule(const WaveTrack &track, Fingerprint fingerprint);
+   void Reset();
+
+   bool mFrozen{ false };
+   //! The render in progress or complete; shared with copies of the track
+   std::shared_ptr<Job> mpJob;
+};
+
+//! Plays the render of a frozen track, with the track's gain, mute and solo
+class EFFECTS_API FrozenTrackSequence final : public PlayableSequence
+{
+public:
+   FrozenTrackSequence(std::shared_ptr<const WaveTrack> pTrack,
+      std::shared_ptr<const TrackList> pRender);
+   ~FrozenTrackSequence() override;
+
+   // WideSampleSequence
+   size_t NChannels() const override;
+   float GetChannelGain(int channel) const override;
+   bool Get(size_t iChannel, size_t nBuffers, const samplePtr buffers[],
+      sampleFormat format, sampleCount start, size_t len, bool backwards,
+      fillFormat fill = FillFormat::fillZero, bool mayThrow = true,
+      sampleCount* pNumWithinClips = nullptr) const override;
+   double GetStartTime() const override;
+   double GetEndTime() const override;
+   double GetRate() const override;
+   sampleFormat WidestEffectiveFormat() const override;
+   bool HasTrivialEnvelope() const override;
+   void GetEnvelopeValues(double* buffer, size_t bufferLen, double t0,
+      bool backwards) const override;
+
+   // AudioGraph::Channel
+   AudioGraph::ChannelType GetChannelType() const override;
+
+   // PlayableSequence
+   bool IsLeader() const override;
+   bool GetSolo() const override;
+   bool GetMute() const override;
+
+private:
+   //! The track that was rendered, not the render, so that the track's
+   //! meters and the like find this sequence
+   const WideSampleSequence *DoGetSource() const override;
+
+   const WaveTrack &GetRender() const;
+
+   const std::shared_ptr<const WaveTrack> mpTrack;
+   const std::shared_ptr<const TrackList> mpRender;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealtimeEffectFreezeTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "RealtimeEffectFreeze.h"
+
+#include "Mix.h"
+#include "MockedPrefs.h"
+#include "PerTrackEffect.h"
+#include "Project.h"
+#include "ProjectFileIO.h"
+#include "RealtimeEffectList.h"
+#include "RealtimeEffectState.h"
+#include "WaveTrack.h"
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr double Rate = 44100;
+constexpr size_t Length = 44100;
+constexpr float Value = 0.25f;
+constexpr float Gain = 2.0f;
+//! Length of the ringing that a render adds after the track
+constexpr double TailDuration = 2.0;
+
+struct GainSettings {
+   float gain{ Gain };
+};
+
+//! Multiplies by a constant, in playback and in renders
+class TestGain final : public EffectWithSettings<GainSettings, PerTrackEffect>
+{
+public:
+   static const PluginID &ID()
+   {
+      static const PluginID id{ wxT("TestGain") };
+      return id;
+   }
+
+   struct Instance final
+      : PerTrackEffect::Instance
+      , EffectInstanceWithBlockSize
+   {
+      explicit Instance(const PerTrackEffect &effect)
+         : PerTrackEffect::Instance{ effect }
+      {}
+      size_t ProcessBlock(EffectSettings &settings,
+         const float *const *inBlock, float *const *outBlock, size_t blockLen)
+      override
+      {
+         const auto gain = GetSettings(settings).gain;
+         for (size_t ii = 0; ii < blockLen; ++ii)
+            outBlock[0][ii] = gain * inBlock[0][ii];
+         return blockLen;
+      }
+      unsigned GetAudioInCount() const override { return 1; }
+      unsigned GetAudioOutCount() const override { return 1; }
+   };
+
+   std::shared_ptr<EffectInstance> MakeInstance() const override
+   {
+      return std::make_shared<Instance>(*this);
+   }
+};
+
+bool WaitForRender(const RealtimeEffectFreeze &freeze)
+{
+   using namespace std::chrono;
+   const auto deadline = steady_clock::now() + seconds(30);
+   while (freeze.IsRendering()) {
+      if (steady_clock::now() > deadline)
+         return false;
+      std::this_thread::sleep_for(milliseconds(10));
+   }
+   return true;
+}
+
+std::vector<float> GetSamples(
+   const WideSampleSequence &sequence, sampleCount start, size_t len)
+{
+   std::vector<float> result(len);
+   const samplePtr buffers[]{ reinterpret_cast<samplePtr>(result.data()) };
+   REQUIRE(sequence.Get(0, 1, buffers, floatSample, start, len, false));
+   return result;
+}
+
+//! Mix as the audio engine does, without the track's gains
+std::vector<float> Play(std::shared_ptr<const PlayableSequence> pSequence)
+{
+   const auto t0 = pSequence->GetStartTime();
+   const auto t1 = pSequence->GetEndTime();
+   Mixer::Inputs inputs;
+   inputs.emplace_back(move(pSequence));
+   Mixer mixer{ move(inputs), true, Mixer::WarpOptions{ 1.0, 1.0 },
+      t0, t1, 1, 1024, false, Rate, floatSample, false, nullptr, false };
+   std::vector<float> result;
+   while (const auto blockLen = mixer.Process()) {
+      const auto buffer =
+         reinterpret_cast<const float *>(mixer.GetBuffer());
+      result.insert(result.end(), buffer, buffer + blockLen);
+   }
+   return result;
+}
+}
+
+TEST_CASE("RealtimeEffectFreeze")
+{
+   MockedPrefs prefs;
+   REQUIRE(ProjectFileIO::InitializeSQL());
+
+   const TestGain effect;
+   RealtimeEffectState::EffectFactory::Scope effectScope{
+      [&](const PluginID &id) -> const EffectInstanceFactory * {
+         return id == TestGain::ID() ? &effect : nullptr;
+      }
+   };
+
+   const auto fileName =
+      wxFileName{ wxFileName::GetTempDir(), wxT("FreezeTest.aup3") }
+         .GetFullPath();
+   if (wxFileExists(fileName))
+      wxRemoveFile(fileName);
+
+   const auto project = AudacityProject::Create();
+   auto &projectFileIO = ProjectFileIO::Get(*project);
+   projectFileIO.SetFileName(fileName);
+   REQUIRE(projectFileIO.OpenProject());
+
+   {
+      const auto pTrack =
+         WaveTrackFactory::Get(*project).Create(floatSample, Rate);
+      const std::vector<float> samples(Length, Value);
+      pTrack->Append(reinterpret_cast<constSamplePtr>(samples.data()),
+         floatSample, Length);
+      pTrack->Flush();
+      TrackList::Get(*project).Add(pTrack);
+   }
+   // Owned only by the list, so that its sample blocks go away before the
+   // database is closed
+   auto &track = **TrackList::Get(*project).Any<WaveTrack>().begin();
+   REQUIRE(RealtimeEffectList::Get(track).AddState(
+      std::make_shared<RealtimeEffectState>(TestGain::ID())));
+
+   auto &freeze = RealtimeEffectFreeze::Get(track);
+
+   SECTION("Unfrozen tracks play live")
+   {
+      REQUIRE(!freeze.IsFrozen());
+      REQUIRE(!freeze.GetPlayableSequence(track));
+   }
+
+   SECTION("Frozen tracks play their renders")
+   {
+      freeze.SetFrozen(track, true);
+      REQUIRE(freeze.IsFrozen());
+      REQUIRE(WaitForRender(freeze));
+
+      const auto pFrozen = freeze.GetPlayableSequence(track);
+      REQUIRE(pFrozen);
+      REQUIRE(&pFrozen->GetSource() == &track);
+      REQUIRE(pFrozen->GetStartTime() == track.GetStartTime());
+      REQUIRE(pFrozen->GetEndTime() ==
+         Approx(track.GetEndTime() + TailDuration));
+
+      const auto rendered = GetSamples(*pFrozen, 0, Length);
+      REQUIRE(rendered == std::vector<float>(Length, Gain * Value));
+
+      // Gain, mute and solo of the track still apply live
+      track.SetGain(0.5f);
+      track.SetMute(true);
+      REQUIRE(pFrozen->GetChannelGain(0) == track.GetChannelGain(0));
+      REQUIRE(pFrozen->GetMute());
+
+      const auto played = Play(pFrozen);
+      REQUIRE(played.size() > Length);
+      REQUIRE(std::vector<float>(played.begin(), played.begin() + Length)
+         == rendered);
+      REQUIRE(std::all_of(played.begin() + Length, played.end(),
+         [](float value){ return value == 0.0f; }));
+   }
+
+   SECTION("Edits of frozen tracks are rendered again")
+   {
+      freeze.SetFrozen(track, true);
+      REQUIRE(WaitForRender(freeze));
+      REQUIRE(freeze.GetPlayableSequence(track));
+
+      const auto oldEnd = track.GetEndTime();
+      track.Clear(0.25, 0.5);
+      // The stale render is not played
+      REQUIRE(!freeze.GetPlayableSequence(track));
+      REQUIRE(WaitForRender(freeze));
+
+      const auto pFrozen = freeze.GetPlayableSequence(track);
+      REQUIRE(pFrozen);
+      REQUIRE(pFrozen->GetEndTime() ==
+         Approx(oldEnd - 0.25 + TailDuration));
+   }
+
+   SECTION("Unfreezing discards the render")
+   {
+      freeze.SetFrozen(track, true);
+      REQUIRE(WaitForRender(freeze));
+      REQUIRE(freeze.GetPlayableSequence(track));
+
+      freeze.SetFrozen(track, false);
+      REQUIRE(!freeze.IsFrozen());
+      REQUIRE(!freeze.IsRendering());
+      REQUIRE(!freeze.GetPlayableSequence(track));
+   }
+
+   SECTION("Unfreezing cancels a render in progress")
+   {
+      freeze.SetFrozen(track, true);
+      freeze.SetFrozen(track, false);
+      REQUIRE(!freeze.IsRendering());
+      REQUIRE(!freeze.GetPlayableSequence(track));
+   }
+
+   RealtimeEffectFreeze::CancelRenders(*project);
+   projectFileIO.SetBypass();
+   TrackList::Get(*project).Clear();
+   REQUIRE(projectFileIO.CloseProject());
+   wxRemoveFile(fileName);
+}
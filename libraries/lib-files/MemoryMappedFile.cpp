@@ -0,0 +1,169 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MemoryMappedFile.cpp
+
+**********************************************************************/
+
+#include "MemoryMappedFile.h"
+#include "MemoryX.h"
+
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+struct MemoryMappedFile::Handles {
+   ~Handles()
+   {
+      if (mapping)
+         CloseHandle(mapping);
+      if (file != INVALID_HANDLE_VALUE)
+         CloseHandle(file);
+   }
+   HANDLE file{ INVALID_HANDLE_VALUE };
+   HANDLE mapping{ nullptr };
+};
+
+std::unique_ptr<MemoryMappedFile> MemoryMappedFile::Open(const FilePath &path)
+{
+   auto pHandles = std::make_unique<Handles>();
+   pHandles->file = CreateFileW(path.wc_str(), GENERIC_READ,
+      FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+   if (pHandles->file == INVALID_HANDLE_VALUE)
+      return {};
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(pHandles->file, &size) || size.QuadPart <= 0 ||
+       uint64_t(size.QuadPart) > std::numeric_limits<size_t>::max())
+      return {};
+   pHandles->mapping = CreateFileMappingW(
+      pHandles->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (!pHandles->mapping)
+      return {};
+   const auto data = MapViewOfFile(pHandles->mapping, FILE_MAP_READ, 0, 0, 0);
+   if (!data)
+      return {};
+   return std::unique_ptr<MemoryMappedFile>{ safenew MemoryMappedFile{
+      std::move(pHandles), static_cast<const uint8_t*>(data),
+      uint64_t(size.QuadPart) } };
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+   UnmapViewOfFile(mData);
+}
+
+uint64_t MemoryMappedFile::GetCurrentSize() const
+{
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(mpHandles->file, &size) || size.QuadPart < 0)
+      return 0;
+   return uint64_t(size.QuadPart);
+}
+
+void MemoryMappedFile::WillNeed(uint64_t, uint64_t) const
+{
+   // FILE_FLAG_SEQUENTIAL_SCAN already makes the system read ahead
+}
+
+void MemoryMappedFile::DontNeed(uint64_t, uint64_t) const
+{
+   // The system trims the working set of the process when memory is short
+}
+
+#else
+
+struct MemoryMappedFile::Handles {
+   ~Handles()
+   {
+      if (fd >= 0)
+         close(fd);
+   }
+   //! Kept open to ask for the current size cheaply
+   int fd{ -1 };
+};
+
+namespace {
+// madvise() requires an address aligned to a page
+void Advise(const uint8_t *data, uint64_t size,
+   uint64_t offset, uint64_t length, int advice)
+{
+   static const auto pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+   if (offset >= size)
+      return;
+   length = std::min(length, size - offset);
+   const auto begin = offset - offset % pageSize;
+   madvise(const_cast<uint8_t*>(data + begin),
+      size_t(offset + length - begin), advice);
+}
+}
+
+std::unique_ptr<MemoryMappedFile> MemoryMappedFile::Open(const FilePath &path)
+{
+   auto pHandles = std::make_unique<Handles>();
+   pHandles->fd = open(path.fn_str(), O_RDONLY);
+   if (pHandles->fd < 0)
+      return {};
+   struct stat info;
+   void *data = MAP_FAILED;
+   if (fstat(pHandles->fd, &info) == 0 && info.st_size > 0 &&
+       uint64_t(info.st_size) <= std::numeric_limits<size_t>::max())
+      data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED,
+         pHandles->fd, 0);
+   if (data == MAP_FAILED)
+      return {};
+   madvise(data, size_t(info.st_size), MADV_SEQUENTIAL);
+   return std::unique_ptr<MemoryMappedFile>{ safenew MemoryMappedFile{
+      std::move(pHandles), static_cast<const uint8_t*>(data),
+      uint64_t(info.st_size) } };
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+   munmap(const_cast<uint8_t*>(mData), size_t(mSize));
+}
+
+uint64_t MemoryMappedFile::GetCurrentSize() const
+{
+   struct stat info;
+   if (fstat(mpHandles->fd, &info) != 0 || info.st_size < 0)
+      return 0;
+   return uint64_t(info.st_size);
+}
+
+void MemoryMappedFile::WillNeed(uint64_t offset, uint64_t length) const
+{
+   Advise(mData, mSize, offset, length, MADV_WILLNEED);
+}
+
+void MemoryMappedFile::DontNeed(uint64_t offset, uint64_t length) const
+{
+   Advise(mData, mSize, offset, length, MADV_DONTNEED);
+}
+
+#endif
+
+bool MemoryMappedFile::IsReadable(uint64_t offset, uint64_t length) const
+{
+   const auto size = std::min(mSize, GetCurrentSize());
+   return offset <= size && length <= size - offset;
+}
+
+MemoryMappedFile::MemoryMappedFile(
+   std::unique_ptr<Handles> pHandles, const uint8_t *data, uint64_t size)
+   : mpHandles{ std::move(pHandles) }
+   , mData{ data }
+   , mSize{ size }
+{
+}
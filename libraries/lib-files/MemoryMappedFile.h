@@ -0,0 +1,63 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MemoryMappedFile.h
+  @brief Read-only mapping of a whole file into memory
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MEMORY_MAPPED_FILE__
+#define __AUDACITY_MEMORY_MAPPED_FILE__
+
+#include "Identifier.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//! Read-only view of the contents of a file, paged in by the system on demand
+/*!
+ Reading the view reads the file without copying it into buffers of the
+ program first.  If another process truncates the file while it is mapped,
+ reading the lost part crashes; so check ranges against GetCurrentSize()
+ just before reading them.
+ */
+class FILES_API MemoryMappedFile final
+{
+public:
+   //! @return null if the file can't be opened or mapped, or is empty
+   static std::unique_ptr<MemoryMappedFile> Open(const FilePath &path);
+
+   MemoryMappedFile(const MemoryMappedFile&) = delete;
+   MemoryMappedFile &operator=(const MemoryMappedFile&) = delete;
+   ~MemoryMappedFile();
+
+   const uint8_t *GetData() const { return mData; }
+   uint64_t GetSize() const { return mSize; }
+
+   //! Size of the file now, which is less than GetSize() if it was truncated
+   //! since it was mapped
+   /*! Asks the system about the open file, without looking up its path */
+   uint64_t GetCurrentSize() const;
+
+   //! Whether the range is within the file as it is now
+   bool IsReadable(uint64_t offset, uint64_t length) const;
+
+   //! Hint that the range will soon be read
+   void WillNeed(uint64_t offset, uint64_t length) const;
+   //! Hint that the range will not be read again soon, so that its pages
+   //! need not stay in memory
+   void DontNeed(uint64_t offset, uint64_t length) const;
+
+private:
+   struct Handles;
+   MemoryMappedFile(
+      std::unique_ptr<Handles> pHandles, const uint8_t *data, uint64_t size);
+
+   std::unique_ptr<Handles> mpHandles;
+   const uint8_t *const mData;
+   const uint64_t mSize;
+};
+
+#endif
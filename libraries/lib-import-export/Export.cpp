@@ -81,8 +81,39 @@ ExportTaskBuilder& ExportTaskBuilder::SetTags(const Tags *tags) noexcept
    return *this;
 }
 
+ExportTaskBuilder& ExportTaskBuilder::SetOutputStream(std::shared_ptr<ExportOutputStream> stream) noexcept
+{
+   mOutputStream = std::move(stream);
+   return *this;
+}
+
 ExportTask ExportTaskBuilder::Build(AudacityProject& project)
 {
+   if(mOutputStream)
+   {
+      auto processor = mPlugin->CreateProcessor(mFormat);
+      if(!processor->SetOutputStream(mOutputStream))
+         return ExportTask([](ExportProcessorDelegate&){ return ExportResult::Error; });
+
+      if(!processor->Initialize(project,
+         mParameters,
+         mFileName.GetFullPath(),
+         mT0, mT1, mSelectedOnly,
+         mSampleRate, mMixerSpec ? mMixerSpec->GetNumChannels() : mNumChannels,
+         mMixerSpec,
+         mTags))
+      {
+         return ExportTask([](ExportProcessorDelegate&){ return ExportResult::Cancelled; });
+      }
+
+      //No files to clean up
+      return ExportTask([processor = std::shared_ptr<ExportProcessor>(processor.release())]
+         (ExportProcessorDelegate& delegate)
+         {
+            return processor->Process(delegate);
+         });
+   }
+
    //File rename stuff should be moved out to somewhere else...
    auto filename = mFileName;
 
@@ -44,6 +44,9 @@ public:
    ExportTaskBuilder& SetTags(const Tags* tags) noexcept;
    ExportTaskBuilder& SetSampleRate(double sampleRate) noexcept;
    ExportTaskBuilder& SetMixerSpec(MixerOptions::Downmix* mixerSpec) noexcept;
+   //! Encoded data is written to the stream, file name is only used for metadata.
+   //! The plugin should support output streams for the selected format.
+   ExportTaskBuilder& SetOutputStream(std::shared_ptr<ExportOutputStream> stream) noexcept;
    
    ExportTask Build(AudacityProject& project);
    
@@ -59,6 +62,7 @@ private:
    int mFormat{};
    MixerOptions::Downmix* mMixerSpec{};//Should be const
    const Tags* mTags{};
+   std::shared_ptr<ExportOutputStream> mOutputStream;
 };
 
 void IMPORT_EXPORT_API ShowExportErrorDialog(const TranslatableString& message,
@@ -64,8 +64,15 @@ const TranslatableString& ExportErrorException::GetMessage() const noexcept
 
 ExportProcessorDelegate::~ExportProcessorDelegate() = default;
 
+ExportOutputStream::~ExportOutputStream() = default;
+
 ExportProcessor::~ExportProcessor() = default;
 
+bool ExportProcessor::SetOutputStream(std::shared_ptr<ExportOutputStream>)
+{
+   return false;
+}
+
 ExportPlugin::ExportPlugin() = default;
 ExportPlugin::~ExportPlugin() = default;
 
@@ -83,3 +90,8 @@ bool ExportPlugin::CheckFileName(wxFileName&, int) const
 {
   return true;
 }
+
+bool ExportPlugin::SupportsOutputStream(int) const
+{
+   return false;
+}
@@ -87,6 +87,19 @@ public:
    virtual void OnProgress(double progress) = 0;
 };
 
+//! Destination for the encoded data, used instead of a file
+/*!
+   Implementations may block in Write() to apply back-pressure to the encoder.
+ */
+class IMPORT_EXPORT_API ExportOutputStream
+{
+public:
+   virtual ~ExportOutputStream();
+
+   //! @return false if the data could not be accepted, which fails the export
+   virtual bool Write(const void* data, size_t size) = 0;
+};
+
 class IMPORT_EXPORT_API ExportProcessor
 {
 public:
@@ -119,6 +132,15 @@ public:
       MixerOptions::Downmix* mixerSpec = nullptr,
       const Tags* tags = nullptr) = 0;
    
+   /**
+    * @brief Redirects the encoded data to the stream instead of the file.
+    * Should be called before Initialize. The file name passed to Initialize
+    * is then only used for metadata.
+    *
+    * @return false if the processor can only write to files
+    */
+   virtual bool SetOutputStream(std::shared_ptr<ExportOutputStream> stream);
+
    virtual ExportResult Process(ExportProcessorDelegate& delegate) = 0;
 };
 
@@ -168,6 +190,10 @@ public:
 
    virtual bool CheckFileName(wxFileName &filename, int format = 0) const;
 
+   /// \return Whether processors of the format accept ExportOutputStream,
+   /// which requires the format to be written sequentially
+   virtual bool SupportsOutputStream(int formatIndex) const;
+
    /**
     * @param format Control which of the multiple formats this exporter is
     * capable of exporting should be used. Used where a single export plug-in
@@ -38,6 +38,9 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "ImportPlugin.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_set>
 
 #include <wx/log.h>
@@ -48,6 +51,8 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "Prefs.h"
 
 #include "ImportProgressListener.h"
+#include "ImportUtils.h"
+#include "Tags.h"
 
 namespace {
 
@@ -91,6 +96,38 @@ public:
    }
 };
 
+//Listener given to a file handle that imports on a worker thread
+class ConcurrentImportListener final : public ImportProgressListener
+{
+   std::atomic<double> mProgress{ 0.0 };
+   std::atomic<ImportResult> mResult { ImportResult::Error };
+public:
+   bool OnImportFileOpened(ImportFileHandle&) override
+   {
+      return true;
+   }
+
+   void OnImportProgress(double progress) override
+   {
+      mProgress.store(progress, std::memory_order_relaxed);
+   }
+
+   void OnImportResult(ImportResult result) override
+   {
+      mResult.store(result);
+   }
+
+   double GetProgress() const noexcept
+   {
+      return mProgress.load(std::memory_order_relaxed);
+   }
+
+   ImportResult GetResult() const noexcept
+   {
+      return mResult.load();
+   }
+};
+
 }
 
 // ============================================================================
@@ -488,46 +525,13 @@ std::unique_ptr<ExtImportItem> Importer::CreateDefaultImportItem()
    return new_item;
 }
 
-// returns number of tracks imported
-bool Importer::Import( AudacityProject &project,
-                     const FilePath &fName,
-                     ImportProgressListener* importProgressListener,
-                     WaveTrackFactory *trackFactory,
-                     TrackHolders &tracks,
-                     Tags *tags,
-                     TranslatableString &errorMessage)
+std::vector<ImportPlugin*>
+Importer::GetImportPlugins(const FilePath &fName) const
 {
-   AudacityProject *pProj = &project;
-   auto cleanup = valueRestorer( pProj->mbBusyImporting, true );
-
    const FileExtension extension{ fName.AfterLast(wxT('.')) };
 
-   // Always refuse to import MIDI, even though the FFmpeg plugin pretends to know how (but makes very bad renderings)
-#ifdef USE_MIDI
-   // MIDI files must be imported, not opened
-   if (FileNames::IsMidi(fName)) {
-      errorMessage = XO(
-"\"%s\" \nis a MIDI file, not an audio file. \nAudacity cannot open this type of file for playing, but you can\nedit it by clicking File > Import > MIDI.")
-         .Format( fName );
-      return false;
-   }
-#endif
-
-   // Bug #2647: Peter has a Word 2000 .doc file that is recognized and imported by FFmpeg.
-   if (wxFileName(fName).GetExt() == wxT("doc")) {
-      errorMessage =
-         XO("\"%s\" \nis a not an audio file. \nAudacity cannot open this type of file.")
-         .Format( fName );
-      return false;
-   }
-
-   using ImportPluginPtrs = std::vector< ImportPlugin* >;
-
    // This list is used to call plugins in correct order
-   ImportPluginPtrs importPlugins;
-
-   // This list is used to remember plugins that should have been compatible with the file.
-   ImportPluginPtrs compatiblePlugins;
+   std::vector<ImportPlugin*> importPlugins;
 
    // Not implemented (yet?)
    wxString mime_type = wxT("*");
@@ -640,11 +644,76 @@ bool Importer::Import( AudacityProject &project,
       }
    }
 
+   return importPlugins;
+}
+
+// returns number of tracks imported
+bool Importer::Import( AudacityProject &project,
+                     const FilePath &fName,
+                     ImportProgressListener* importProgressListener,
+                     WaveTrackFactory *trackFactory,
+                     TrackHolders &tracks,
+                     Tags *tags,
+                     TranslatableString &errorMessage)
+{
+   return Import(project, fName, importProgressListener, trackFactory,
+      tracks, tags, errorMessage, {});
+}
+
+bool Importer::Import( AudacityProject &project,
+                     const FilePath &fName,
+                     ImportProgressListener* importProgressListener,
+                     WaveTrackFactory *trackFactory,
+                     TrackHolders &tracks,
+                     Tags *tags,
+                     TranslatableString &errorMessage,
+                     const std::vector<ImportPlugin*> &failedPlugins)
+{
+   AudacityProject *pProj = &project;
+   auto cleanup = valueRestorer( pProj->mbBusyImporting, true );
+
+   const FileExtension extension{ fName.AfterLast(wxT('.')) };
+
+   // Always refuse to import MIDI, even though the FFmpeg plugin pretends to know how (but makes very bad renderings)
+#ifdef USE_MIDI
+   // MIDI files must be imported, not opened
+   if (FileNames::IsMidi(fName)) {
+      errorMessage = XO(
+"\"%s\" \nis a MIDI file, not an audio file. \nAudacity cannot open this type of file for playing, but you can\nedit it by clicking File > Import > MIDI.")
+         .Format( fName );
+      return false;
+   }
+#endif
+
+   // Bug #2647: Peter has a Word 2000 .doc file that is recognized and imported by FFmpeg.
+   if (wxFileName(fName).GetExt() == wxT("doc")) {
+      errorMessage =
+         XO("\"%s\" \nis a not an audio file. \nAudacity cannot open this type of file.")
+         .Format( fName );
+      return false;
+   }
+
+   using ImportPluginPtrs = std::vector< ImportPlugin* >;
+
+   // This list is used to call plugins in correct order
+   ImportPluginPtrs importPlugins = GetImportPlugins(fName);
+
+   // This list is used to remember plugins that should have been compatible with the file.
+   ImportPluginPtrs compatiblePlugins;
+
    ImportProgressResultProxy importResultProxy(importProgressListener);
    
    // Try the import plugins, in the permuted sequences just determined
    for (const auto plugin : importPlugins)
    {
+      // It recognized the file already, and failed to import it, and has
+      // reported that
+      if (std::find(failedPlugins.begin(), failedPlugins.end(), plugin) !=
+          failedPlugins.end()) {
+         compatiblePlugins.push_back(plugin);
+         continue;
+      }
+
       // Try to open the file with this plugin (probe it)
       wxLogMessage(wxT("Opening with %s"),plugin->GetPluginStringID());
       auto inFile = plugin->Open(fName, pProj);
@@ -860,4 +929,194 @@ bool Importer::Import( AudacityProject &project,
    return false;
 }
 
+Importer::BatchItems Importer::ImportBatch( AudacityProject &project,
+                     const FilePaths &fileNames,
+                     ImportProgressListener* importProgressListener,
+                     WaveTrackFactory *trackFactory,
+                     const Tags &tags,
+                     const BatchProgressPoll &poll,
+                     size_t nThreads)
+{
+   using ImportResult = ImportProgressListener::ImportResult;
+
+   BatchItems items(fileNames.size());
+
+   struct Job {
+      size_t index;
+      ImportPlugin *plugin;
+      std::unique_ptr<ImportFileHandle> handle;
+      double weight;
+      ConcurrentImportListener listener;
+      std::exception_ptr exception;
+   };
+   std::vector<std::unique_ptr<Job>> jobs;
+   std::vector<size_t> sequential;
+   //! Plug-ins that failed to decode a file concurrently, by index of file
+   std::vector<std::vector<ImportPlugin*>> failedPlugins(fileNames.size());
+
+   auto cleanup = valueRestorer( project.mbBusyImporting, true );
+
+   // Probe each file on this thread, because opening and stream selection
+   // may interact with the user
+   for (size_t ii = 0; ii < fileNames.size(); ++ii) {
+      auto &item = items[ii];
+      item.fileName = fileNames[ii];
+      item.tags = tags.Duplicate();
+
+      // Stop probing at the first plug-in that can't import concurrently;
+      // Import() will open the file again with it, and it might have side
+      // effects
+      std::unique_ptr<ImportFileHandle> inFile;
+      ImportPlugin *pPlugin{};
+      for (const auto plugin : GetImportPlugins(item.fileName)) {
+         if (!plugin->SupportsConcurrentImport())
+            break;
+         inFile = plugin->Open(item.fileName, &project);
+         if (inFile && inFile->GetStreamCount() > 0) {
+            pPlugin = plugin;
+            break;
+         }
+         inFile.reset();
+      }
+      if (!inFile) {
+         // Let Import() try all plug-ins and describe any failure
+         sequential.push_back(ii);
+         continue;
+      }
+
+      if (importProgressListener &&
+          !importProgressListener->OnImportFileOpened(*inFile)) {
+         item.result = ImportResult::Cancelled;
+         continue;
+      }
+
+      auto pJob = std::make_unique<Job>();
+      pJob->index = ii;
+      pJob->plugin = pPlugin;
+      pJob->weight =
+         std::max<double>(1.0, inFile->GetFileUncompressedBytes());
+      pJob->handle = std::move(inFile);
+      jobs.push_back(std::move(pJob));
+   }
+
+   // Workers may cancel only after they begin; remember the request for the
+   // jobs not yet started
+   std::atomic<ImportResult> request{ ImportResult::Success };
+
+   if (!jobs.empty()) {
+      // ChooseFormat() must not read preferences on the worker threads
+      ImportUtils::PreferredFormatSnapshot snapshot;
+
+      if (nThreads == 0)
+         nThreads = std::max(1u, std::thread::hardware_concurrency());
+      nThreads = std::min(nThreads, jobs.size());
+
+      std::atomic<size_t> next{ 0 };
+      std::atomic<size_t> finished{ 0 };
+      const auto work = [&]{
+         for (size_t jj; (jj = next++) < jobs.size(); ++finished) {
+            auto &job = *jobs[jj];
+            auto &item = items[job.index];
+            if (const auto stop = request.load();
+                stop != ImportResult::Success) {
+               job.listener.OnImportResult(stop);
+               continue;
+            }
+            try {
+               job.handle->Import(
+                  job.listener, trackFactory, item.tracks, item.tags.get());
+            }
+            catch (...) {
+               job.exception = std::current_exception();
+            }
+         }
+      };
+
+      std::vector<std::thread> workers;
+      for (size_t ii = 0; ii < nThreads; ++ii)
+         workers.emplace_back(work);
+
+      double totalWeight = 0;
+      for (const auto &pJob : jobs)
+         totalWeight += pJob->weight;
+
+      using namespace std::chrono_literals;
+      while (finished < jobs.size()) {
+         std::this_thread::sleep_for(50ms);
+         if (const auto stop = request.load(); stop != ImportResult::Success) {
+            // Repeat, in case a worker began its file since the last time
+            for (const auto &pJob : jobs)
+               stop == ImportResult::Cancelled
+                  ? pJob->handle->Cancel() : pJob->handle->Stop();
+            continue;
+         }
+         if (!poll)
+            continue;
+         double done = 0;
+         for (const auto &pJob : jobs)
+            done += pJob->weight * pJob->listener.GetProgress();
+         switch (poll(done / totalWeight)) {
+         case BasicUI::ProgressResult::Cancelled:
+            request = ImportResult::Cancelled;
+            break;
+         case BasicUI::ProgressResult::Stopped:
+            request = ImportResult::Stopped;
+            break;
+         default:
+            break;
+         }
+      }
+
+      for (auto &worker : workers)
+         worker.join();
+   }
+
+   for (const auto &pJob : jobs) {
+      if (pJob->exception)
+         std::rethrow_exception(pJob->exception);
+
+      auto &item = items[pJob->index];
+      auto &tracks = item.tracks;
+      item.result = pJob->listener.GetResult();
+      if (importProgressListener)
+         importProgressListener->OnImportResult(item.result);
+
+      tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
+         [](auto &pList){ return pList->empty(); }), tracks.end());
+      if ((item.result == ImportResult::Success ||
+           item.result == ImportResult::Stopped) && tracks.empty())
+         item.result = ImportResult::Error;
+      if (item.result == ImportResult::Error) {
+         // Another plug-in may yet understand the file.  This one has
+         // reported its failure, so don't have it fail and report again.
+         tracks.clear();
+         item.tags = tags.Duplicate();
+         failedPlugins[pJob->index].push_back(pJob->plugin);
+         sequential.push_back(pJob->index);
+      }
+   }
+   // Free the file handles of the concurrent jobs
+   jobs.clear();
+
+   std::sort(sequential.begin(), sequential.end());
+   for (auto ii : sequential) {
+      auto &item = items[ii];
+      if (request.load() != ImportResult::Success) {
+         item.result = ImportResult::Cancelled;
+         continue;
+      }
+      if (Import(project, item.fileName, importProgressListener, trackFactory,
+            item.tracks, item.tags.get(), item.errorMessage, failedPlugins[ii]))
+         item.result = ImportResult::Success;
+      else if (item.errorMessage.empty())
+         item.result = ImportResult::Cancelled;
+      else
+         item.result = ImportResult::Error;
+   }
+
+   return items;
+}
+
 BoolSetting NewImportingSession{ L"/NewImportingSession", false };
+
+BoolSetting OnDemandImport{ L"/FileFormats/OnDemandImport", false };
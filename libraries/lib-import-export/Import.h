@@ -13,6 +13,7 @@
 
 #include "ImportForwards.h"
 #include "Identifier.h"
+#include <functional>
 #include <vector>
 #include <wx/tokenzr.h> // for enum wxStringTokenizerMode
 
@@ -20,6 +21,9 @@
 
 #include "Registry.h"
 
+#include "BasicUI.h" // for ProgressResult
+#include "ImportProgressListener.h" // for ImportResult
+
 class wxArrayString;
 class AudacityProject;
 class Tags;
@@ -178,7 +182,65 @@ public:
               Tags *tags,
               TranslatableString &errorMessage);
 
+   //! Outcome of importing one file of a batch
+   struct BatchItem {
+      FilePath fileName;
+      TrackHolders tracks;
+      //! Copy of the given tags, as modified by this file only
+      std::shared_ptr<Tags> tags;
+      TranslatableString errorMessage;
+      ImportProgressListener::ImportResult result{
+         ImportProgressListener::ImportResult::Error };
+   };
+   using BatchItems = std::vector<BatchItem>;
+
+   //! Called periodically on the calling thread of ImportBatch
+   /*!
+    @param progress aggregated progress of the concurrent decoding in [0, 1]
+    */
+   using BatchProgressPoll = std::function<BasicUI::ProgressResult(double)>;
+
+   /*!
+    Import several files, decoding concurrently those that are recognized by
+    plug-ins whose SupportsConcurrentImport() is true.
+
+    Probing of files and stream selection (through
+    importProgressListener->OnImportFileOpened) happen on the calling thread.
+    Other files, and files whose concurrent decoding failed, are then imported
+    one at a time on the calling thread as by Import(), reporting through
+    importProgressListener.  A plug-in that failed to decode a file
+    concurrently is not tried again for it, so that importProgressListener
+    hears of its failure once, and the errorMessage of the item describes
+    the outcome of all plug-ins.
+
+    @param tags copied for each file, to be modified by the import
+    @param nThreads maximum number of worker threads; 0 for the hardware
+    concurrency
+    @return one item for each of fileNames, in the same order
+    */
+   BatchItems ImportBatch( AudacityProject &project,
+              const FilePaths &fileNames,
+              ImportProgressListener* importProgressListener,
+              WaveTrackFactory *trackFactory,
+              const Tags &tags,
+              const BatchProgressPoll &poll,
+              size_t nThreads = 0);
+
 private:
+   //! Import, but don't try again the plug-ins that failed for the file
+   bool Import( AudacityProject &project,
+              const FilePath &fName,
+              ImportProgressListener* importProgressListener,
+              WaveTrackFactory *trackFactory,
+              TrackHolders &tracks,
+              Tags *tags,
+              TranslatableString &errorMessage,
+              const std::vector<ImportPlugin*> &failedPlugins);
+
+   //! Plug-ins in the order in which they should be tried for the file
+   std::vector<ImportPlugin*> GetImportPlugins(const FilePath &fName) const;
+
+
    struct IMPORT_EXPORT_API ImporterItem final : Registry::SingleItem {
       static Registry::GroupItemBase &Registry();
 
@@ -196,4 +258,8 @@ private:
 
 extern IMPORT_EXPORT_API BoolSetting NewImportingSession;
 
+//! Whether importers that can do so leave samples in the imported files,
+//! copying them into the project in the background
+extern IMPORT_EXPORT_API BoolSetting OnDemandImport;
+
 #endif
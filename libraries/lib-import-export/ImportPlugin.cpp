@@ -35,6 +35,11 @@ TranslatableString ImportPlugin::FailureHint() const
    return {};
 }
 
+bool ImportPlugin::SupportsConcurrentImport() const
+{
+   return false;
+}
+
 
 ImportFileHandle::~ImportFileHandle() = default;
 
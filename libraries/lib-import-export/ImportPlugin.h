@@ -47,6 +47,7 @@ but little else.
 
 
 
+#include <atomic>
 #include <memory>
 #include "Identifier.h"
 #include "Internat.h"
@@ -86,6 +87,11 @@ public:
    /*! Should end with one newline if not empty */
    virtual TranslatableString FailureHint() const;
 
+   //! Whether Import() of handles opened by this plug-in may run on a worker
+   //! thread, concurrently with other handles; default false
+   /*! Such an Import() may not interact with the user or read preferences */
+   virtual bool SupportsConcurrentImport() const;
+
    bool SupportsExtension(const FileExtension &extension);
 
    // Open the given file, returning true if it is in a recognized
@@ -159,8 +165,8 @@ public:
 class IMPORT_EXPORT_API ImportFileHandleEx : public ImportFileHandle
 {
    FilePath mFilename;
-   bool mCancelled{false};
-   bool mStopped{false};
+   std::atomic<bool> mCancelled{false};
+   std::atomic<bool> mStopped{false};
 public:
    ImportFileHandleEx(const FilePath& filename);
    
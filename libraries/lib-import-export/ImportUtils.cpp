@@ -18,10 +18,31 @@
 
 #include <wx/filename.h>
 
+#include <atomic>
+
+namespace {
+//! Nonzero while a PreferredFormatSnapshot exists
+std::atomic<unsigned> sPreferredFormat{ 0 };
+}
+
+ImportUtils::PreferredFormatSnapshot::PreferredFormatSnapshot()
+   : mPrevious{ sPreferredFormat.exchange(
+      static_cast<unsigned>(QualitySettings::SampleFormatChoice())) }
+{
+}
+
+ImportUtils::PreferredFormatSnapshot::~PreferredFormatSnapshot()
+{
+   sPreferredFormat.store(mPrevious);
+}
+
 sampleFormat ImportUtils::ChooseFormat(sampleFormat effectiveFormat)
 {
    // Consult user preference
-   auto defaultFormat = QualitySettings::SampleFormatChoice();
+   const auto snapshot = sPreferredFormat.load();
+   auto defaultFormat = snapshot
+      ? static_cast<sampleFormat>(snapshot)
+      : QualitySettings::SampleFormatChoice();
 
    // Don't choose format narrower than effective or default
    auto format = std::max(effectiveFormat, defaultFormat);
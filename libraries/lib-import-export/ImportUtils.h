@@ -33,5 +33,18 @@ public:
       sampleFormat effectiveFormat, double rate);
    
    static void ShowMessageBox(const TranslatableString& message, const TranslatableString& caption = XO("Import Project"));
+
+   //! While it exists, ChooseFormat() uses the preference as read at its
+   //! construction, and so may be called from worker threads
+   class IMPORT_EXPORT_API PreferredFormatSnapshot final
+   {
+   public:
+      PreferredFormatSnapshot();
+      ~PreferredFormatSnapshot();
+      PreferredFormatSnapshot(const PreferredFormatSnapshot&) = delete;
+      PreferredFormatSnapshot &operator=(const PreferredFormatSnapshot&) = delete;
+   private:
+      unsigned mPrevious;
+   };
    
 };
@@ -27,6 +27,11 @@
   - Triangle dithering
   - Noise-shaped dithering
 
+  All but noise-shaped dithering, and all conversions that need no dither,
+  are done by the vectorized kernels of SampleConversion.h.  Noise shaping
+  feeds the error of each sample back into the next ones, so it remains a
+  loop over single samples.
+
 Dither class. You must construct an instance because it keeps
 state. Call Dither::Apply() to apply the dither. You can call
 Reset() between subsequent dithers to reset the dither state
@@ -36,6 +41,7 @@ and get deterministic behaviour.
 
 
 #include "Dither.h"
+#include "SampleConversion.h"
 
 #include "Internat.h"
 #include "Prefs.h"
@@ -65,17 +71,30 @@ const float SHAPED_BS[] = { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f };
 
 // Dither state
 struct State {
+    State() : mPhase{ 0 }, mBuffer{}, mNoise{ 0x2545f491u }
+    { mConversion.Reset(); }
+
     int mPhase;
-    float mTriangleState;
     float mBuffer[8 /* = BUF_SIZE */];
-} mState;
+    // Noise for rectangle and triangle dither, and the triangle filter
+    SampleConversion::DitherState mConversion;
+    // Noise for shaped dither
+    uint32_t mNoise;
+};
+// One for each thread, so that samples may be converted on several at once
+static thread_local State mState;
 
 using Ditherer = float (*)(State &, float);
 
 // This is supposed to produce white noise and no dc
-static inline float DITHER_NOISE()
+// Xorshift, because rand() takes a lock shared by all threads
+static inline float DITHER_NOISE(State &state)
 {
-    return rand() / (float)RAND_MAX - 0.5f;
+    auto &x = state.mNoise;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x / 4294967296.0f - 0.5f;
 }
 
 // Defines for sample conversion
@@ -83,11 +102,6 @@ constexpr auto CONVERT_DIV16 = float(1<<15);
 constexpr auto CONVERT_DIV24 = float(1<<23);
 
 // Dereference sample pointer and convert to float sample
-static inline float FROM_INT16(const short *ptr)
-{
-    return *ptr / CONVERT_DIV16;
-}
-
 static inline float FROM_INT24(const int *ptr)
 {
     return *ptr / CONVERT_DIV24;
@@ -179,9 +193,6 @@ static inline void DITHER( Ditherer dither, State &state,
 }
 
 
-static inline float NoDither(State &, float sample);
-static inline float RectangleDither(State &, float sample);
-static inline float TriangleDither(State &state, float sample);
 static inline float ShapedDither(State &state, float sample);
 
 Dither::Dither()
@@ -190,11 +201,19 @@ Dither::Dither()
     Reset();
 }
 
+// Reset the filters, but not the noise, which should not repeat itself in
+// every buffer
+static void ResetFilters(State &state)
+{
+    state.mConversion.ResetFilter();
+    state.mPhase = 0;
+    memset(state.mBuffer, 0, sizeof(float) * BUF_SIZE);
+}
+
 void Dither::Reset()
 {
-    mState.mTriangleState = 0;
-    mState.mPhase = 0;
-    memset(mState.mBuffer, 0, sizeof(float) * BUF_SIZE);
+    ResetFilters(mState);
+    mState.mConversion.Reset();
 }
 
 // This only decides if we must dither at all, the dithers
@@ -279,44 +298,54 @@ void Dither::Apply(enum DitherType ditherType,
         auto d = (float*)dest;
 
         if (sourceFormat == int16Sample)
-        {
-            auto s = (const short*)source;
-            for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-                *d = FROM_INT16(s);
-        } else
+            SampleConversion::Int16ToFloat((const short*)source, sourceStride,
+                d, destStride, len);
+        else
         if (sourceFormat == int24Sample)
-        {
-            auto s = (const int*)source;
-            for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-                *d = FROM_INT24(s);
-        } else {
+            SampleConversion::Int24ToFloat((const int*)source, sourceStride,
+                d, destStride, len);
+        else {
             wxASSERT(false); // source format unknown
         }
     } else
     if (destFormat == int24Sample && sourceFormat == int16Sample)
     {
         // Special case when promoting 16 bit to 24 bit
-        auto d = (int*)dest;
-        auto s = (const short*)source;
-        for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-            *d = ((int)*s) << 8;
+        SampleConversion::Int16ToInt24((const short*)source, sourceStride,
+            (int*)dest, destStride, len);
+    } else
+    if (ditherType == DitherType::none
+        || ditherType == DitherType::rectangle
+        || ditherType == DitherType::triangle)
+    {
+        using SampleConversion::DitherKind;
+        const auto kind = ditherType == DitherType::rectangle
+            ? DitherKind::rectangle
+            : ditherType == DitherType::triangle
+                ? DitherKind::triangle
+                : DitherKind::none;
+        if (ditherType == DitherType::triangle)
+            // reset dither filter for this NEW conversion
+            ResetFilters(mState);
+
+        auto &state = mState.mConversion;
+        if (sourceFormat == int24Sample && destFormat == int16Sample)
+            SampleConversion::Int24ToInt16((const int*)source, sourceStride,
+                (short*)dest, destStride, len, kind, state);
+        else if (sourceFormat == floatSample && destFormat == int16Sample)
+            SampleConversion::FloatToInt16((const float*)source, sourceStride,
+                (short*)dest, destStride, len, kind, state);
+        else if (sourceFormat == floatSample && destFormat == int24Sample)
+            SampleConversion::FloatToInt24((const float*)source, sourceStride,
+                (int*)dest, destStride, len, kind, state);
+        else { wxASSERT(false); }
     } else
     {
-        // We must do dithering
+        // We must do noise-shaped dithering
         switch (ditherType)
         {
-        case DitherType::none:
-            DITHER(NoDither, mState, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
-            break;
-        case DitherType::rectangle:
-            DITHER(RectangleDither, mState, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
-            break;
-        case DitherType::triangle:
-            Reset(); // reset dither filter for this NEW conversion
-            DITHER(TriangleDither, mState, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
-            break;
         case DitherType::shaped:
-            Reset(); // reset dither filter for this NEW conversion
+            ResetFilters(mState); // reset dither filter for this NEW conversion
             DITHER(ShapedDither, mState, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
             break;
         default:
@@ -327,33 +356,11 @@ void Dither::Apply(enum DitherType ditherType,
 
 // Dither implementations
 
-// No dither, just return sample
-inline float NoDither(State &, float sample)
-{
-    return sample;
-}
-
-// Rectangle dithering, apply one-step noise
-inline float RectangleDither(State &, float sample)
-{
-    return sample - DITHER_NOISE();
-}
-
-// Triangle dither - high pass filtered
-inline float TriangleDither(State &state, float sample)
-{
-    float r = DITHER_NOISE();
-    float result = sample + r - state.mTriangleState;
-    state.mTriangleState = r;
-
-    return result;
-}
-
 // Shaped dither
 inline float ShapedDither(State &state, float sample)
 {
     // Generate triangular dither, +-1 LSB, flat psd
-    float r = DITHER_NOISE() + DITHER_NOISE();
+    float r = DITHER_NOISE(state) + DITHER_NOISE(state);
     if(sample != sample)  // test for NaN
        sample = 0; // and do the best we can with it
 
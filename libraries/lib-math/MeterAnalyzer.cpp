@@ -0,0 +1,433 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MeterAnalyzer.cpp
+
+**********************************************************************/
+
+#include "MeterAnalyzer.h"
+#include "MemoryX.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// SSE2 is part of every x86-64 processor, so needs no run-time check
+#define METER_ANALYZER_SSE2 1
+#include <emmintrin.h>
+#else
+#define METER_ANALYZER_SSE2 0
+#endif
+
+namespace {
+
+// Frames analyzed at once, bounding the scratch space
+constexpr size_t ChunkFrames = 1024;
+
+// Polyphase interpolation filter for true peak, of 48 taps in all
+constexpr size_t Phases = 4;
+constexpr size_t TapsPerPhase = 12;
+constexpr size_t History = TapsPerPhase - 1;
+constexpr size_t ScratchStride = History + ChunkFrames;
+
+// Steps of 100 ms in momentary and short-term loudness
+constexpr size_t MomentarySteps = 4;
+constexpr size_t ShortTermSteps = 30;
+
+//! Taps of each phase, each phase normalized to unit gain at DC
+/*!
+ Phase p makes the output between input samples k-1 and k from
+ the sum over j of tap j of phase p times input sample k - j
+ */
+const float (&InterpolationTaps())[Phases][TapsPerPhase]
+{
+   static const auto taps = []{
+      struct Taps { float values[Phases][TapsPerPhase]; } result;
+      constexpr auto length = Phases * TapsPerPhase;
+      constexpr auto center = (length - 1) / 2.0;
+      for (size_t pp = 0; pp < Phases; ++pp) {
+         double sum = 0;
+         double values[TapsPerPhase];
+         for (size_t jj = 0; jj < TapsPerPhase; ++jj) {
+            // Blackman windowed sinc, cut off at the original Nyquist
+            // frequency
+            const auto t = (Phases * jj + pp) - center;
+            const auto x = M_PI * t / Phases;
+            const auto sinc = t == 0 ? 1.0 : sin(x) / x;
+            const auto w = 2 * M_PI * t / length;
+            const auto window = 0.42 + 0.5 * cos(w) + 0.08 * cos(2 * w);
+            sum += (values[jj] = sinc * window);
+         }
+         for (size_t jj = 0; jj < TapsPerPhase; ++jj)
+            result.values[pp][jj] = values[jj] / sum;
+      }
+      return result;
+   }();
+   return taps.values;
+}
+
+//! Filter one channel, updating its state, and return the sum of squares
+//! of the weighted samples
+double FilterOne(const double c[10], double state[6],
+   const float *x, size_t len)
+{
+   // The input of the second stage is the output of the first
+   auto x1 = state[0], x2 = state[1];
+   auto y1 = state[2], y2 = state[3];
+   auto z1 = state[4], z2 = state[5];
+   double power = 0;
+   for (size_t ii = 0; ii < len; ++ii) {
+      const double x0 = x[ii];
+      const auto y0 = x0 * c[0] + x1 * c[1] + x2 * c[2] - y1 * c[3] - y2 * c[4];
+      const auto z0 = y0 * c[5] + y1 * c[6] + y2 * c[7] - z1 * c[8] - z2 * c[9];
+      power += z0 * z0;
+      x2 = x1, x1 = x0;
+      y2 = y1, y1 = y0;
+      z2 = z1, z1 = z0;
+   }
+   state[0] = x1, state[1] = x2;
+   state[2] = y1, state[3] = y2;
+   state[4] = z1, state[5] = z2;
+   return power;
+}
+
+#if METER_ANALYZER_SSE2
+//! Filter two channels at once, one in each lane; the recursion allows no
+//! parallelism along the samples of one channel
+double FilterTwo(const double c[10], double stateA[6], double stateB[6],
+   const float *a, const float *b, size_t len)
+{
+   __m128d coefficients[10];
+   for (size_t ii = 0; ii < 10; ++ii)
+      coefficients[ii] = _mm_set1_pd(c[ii]);
+   const auto load = [&](size_t ii){ return _mm_set_pd(stateB[ii], stateA[ii]); };
+   auto x1 = load(0), x2 = load(1);
+   auto y1 = load(2), y2 = load(3);
+   auto z1 = load(4), z2 = load(5);
+   auto power = _mm_setzero_pd();
+   for (size_t ii = 0; ii < len; ++ii) {
+      const auto x0 = _mm_set_pd(b[ii], a[ii]);
+      const auto y0 = _mm_sub_pd(
+         _mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(x0, coefficients[0]), _mm_mul_pd(x1, coefficients[1])),
+            _mm_mul_pd(x2, coefficients[2])),
+         _mm_add_pd(
+            _mm_mul_pd(y1, coefficients[3]), _mm_mul_pd(y2, coefficients[4])));
+      const auto z0 = _mm_sub_pd(
+         _mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(y0, coefficients[5]), _mm_mul_pd(y1, coefficients[6])),
+            _mm_mul_pd(y2, coefficients[7])),
+         _mm_add_pd(
+            _mm_mul_pd(z1, coefficients[8]), _mm_mul_pd(z2, coefficients[9])));
+      power = _mm_add_pd(power, _mm_mul_pd(z0, z0));
+      x2 = x1, x1 = x0;
+      y2 = y1, y1 = y0;
+      z2 = z1, z1 = z0;
+   }
+   const auto store = [&](size_t ii, __m128d value){
+      _mm_storel_pd(&stateA[ii], value);
+      _mm_storeh_pd(&stateB[ii], value);
+   };
+   store(0, x1), store(1, x2);
+   store(2, y1), store(3, y2);
+   store(4, z1), store(5, z2);
+   double sums[2];
+   _mm_storeu_pd(sums, power);
+   return sums[0] + sums[1];
+}
+
+inline __m128 Abs(__m128 value)
+{
+   return _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+#endif
+
+}
+
+// Coefficients of K-weighting adapted to the sampling rate, as in EBUR128.cpp
+MeterAnalyzer::MeterAnalyzer(
+   double rate, size_t nChannels, int numPeakSamplesToClip)
+   : mRate{ rate }
+   , mNChannels{ nChannels }
+   , mNumPeakSamplesToClip{ numPeakSamplesToClip }
+   , mStepFrames{ std::max<size_t>(1, lrint(rate / 10)) }
+   , mPeak(nChannels)
+   , mSumSquares(nChannels)
+   , mTruePeak(nChannels)
+   , mHeadOpen(nChannels)
+   , mScratch(nChannels * ScratchStride)
+   , mFilterState(nChannels * 6)
+   , mSteps(ShortTermSteps)
+{
+   // Shelving pre-filter
+   auto db = 3.999843853973347;
+   auto f0 = 1681.974450955533;
+   auto Q = 0.7071752369554196;
+   auto K = tan(M_PI * f0 / rate);
+   const auto Vh = pow(10.0, db / 20.0);
+   const auto Vb = pow(Vh, 0.4996667741545416);
+   auto a0 = 1.0 + K / Q + K * K;
+   mWeighting[0] = (Vh + Vb * K / Q + K * K) / a0;
+   mWeighting[1] = 2.0 * (K * K - Vh) / a0;
+   mWeighting[2] = (Vh - Vb * K / Q + K * K) / a0;
+   mWeighting[3] = 2.0 * (K * K - 1.0) / a0;
+   mWeighting[4] = (1.0 - K / Q + K * K) / a0;
+
+   // High-pass weighting filter
+   f0 = 38.13547087602444;
+   Q = 0.5003270373238773;
+   K = tan(M_PI * f0 / rate);
+   a0 = 1.0 + K / Q + K * K;
+   mWeighting[5] = 1.0;
+   mWeighting[6] = -2.0;
+   mWeighting[7] = 1.0;
+   mWeighting[8] = 2.0 * (K * K - 1.0) / a0;
+   mWeighting[9] = (1.0 - K / Q + K * K) / a0;
+}
+
+MeterAnalyzer::~MeterAnalyzer() = default;
+
+void MeterAnalyzer::Reset()
+{
+   std::fill(mScratch.begin(), mScratch.end(), 0.0f);
+   std::fill(mFilterState.begin(), mFilterState.end(), 0.0);
+   std::fill(mSteps.begin(), mSteps.end(), 0.0);
+   mStepPower = 0;
+   mStepFill = 0;
+   mNextStep = 0;
+   mStepCount = 0;
+}
+
+void MeterAnalyzer::Process(const float *interleaved, size_t numFrames,
+   ChannelLevels levels[])
+{
+   std::fill(mPeak.begin(), mPeak.end(), 0.0f);
+   std::fill(mSumSquares.begin(), mSumSquares.end(), 0.0);
+   std::fill(mTruePeak.begin(), mTruePeak.end(), 0.0f);
+   std::fill(mHeadOpen.begin(), mHeadOpen.end(), 1);
+   std::fill(levels, levels + mNChannels, ChannelLevels{});
+
+   for (size_t done = 0; done < numFrames;) {
+      const auto len = std::min(ChunkFrames, numFrames - done);
+      ProcessChunk(interleaved + done * mNChannels, len, levels);
+      done += len;
+   }
+
+   if (numFrames == 0)
+      return;
+   for (size_t cc = 0; cc < mNChannels; ++cc) {
+      auto &level = levels[cc];
+      level.peak = mPeak[cc];
+      level.rms = sqrt(mSumSquares[cc] / numFrames);
+      level.truePeak = std::max(mTruePeak[cc], mPeak[cc]);
+   }
+}
+
+void MeterAnalyzer::ProcessChunk(const float *interleaved, size_t numFrames,
+   ChannelLevels levels[])
+{
+   FindPeakAndPower(interleaved, numFrames);
+   FindClipping(interleaved, numFrames, levels);
+
+   // Deinterleave after the history of each channel
+   for (size_t cc = 0; cc < mNChannels; ++cc) {
+      const auto dst = &mScratch[cc * ScratchStride + History];
+      auto src = interleaved + cc;
+      for (size_t ii = 0; ii < numFrames; ++ii, src += mNChannels)
+         dst[ii] = *src;
+   }
+
+   FindTruePeak(numFrames);
+   Weight(History, numFrames);
+
+   // Keep the last samples of each channel as history for the next chunk
+   for (size_t cc = 0; cc < mNChannels; ++cc) {
+      const auto buffer = &mScratch[cc * ScratchStride];
+      memmove(buffer, buffer + numFrames, History * sizeof(float));
+   }
+}
+
+void MeterAnalyzer::FindPeakAndPower(
+   const float *interleaved, size_t numFrames)
+{
+   const auto nChannels = mNChannels;
+   size_t firstScalar = 0;
+#if METER_ANALYZER_SSE2
+   // Sums of squares accumulate in single precision over one chunk only
+   float maxes[4], sums[4];
+   if (4 % nChannels == 0) {
+      // Each vector holds whole frames; lane l belongs to channel
+      // l % nChannels
+      const auto total = numFrames * nChannels;
+      auto vMax = _mm_setzero_ps(), vSum = _mm_setzero_ps();
+      size_t ii = 0;
+      for (; ii + 4 <= total; ii += 4) {
+         const auto value = Abs(_mm_loadu_ps(interleaved + ii));
+         vMax = _mm_max_ps(vMax, value);
+         vSum = _mm_add_ps(vSum, _mm_mul_ps(value, value));
+      }
+      _mm_storeu_ps(maxes, vMax);
+      _mm_storeu_ps(sums, vSum);
+      for (size_t ll = 0; ll < 4; ++ll) {
+         const auto cc = ll % nChannels;
+         mPeak[cc] = std::max(mPeak[cc], maxes[ll]);
+         mSumSquares[cc] += sums[ll];
+      }
+      for (; ii < total; ++ii) {
+         const auto cc = ii % nChannels;
+         const auto value = std::fabs(interleaved[ii]);
+         mPeak[cc] = std::max(mPeak[cc], value);
+         mSumSquares[cc] += value * value;
+      }
+      return;
+   }
+
+   // Each vector holds four adjacent channels of one frame
+   for (; firstScalar + 4 <= nChannels; firstScalar += 4) {
+      auto vMax = _mm_setzero_ps(), vSum = _mm_setzero_ps();
+      auto src = interleaved + firstScalar;
+      for (size_t ii = 0; ii < numFrames; ++ii, src += nChannels) {
+         const auto value = Abs(_mm_loadu_ps(src));
+         vMax = _mm_max_ps(vMax, value);
+         vSum = _mm_add_ps(vSum, _mm_mul_ps(value, value));
+      }
+      _mm_storeu_ps(maxes, vMax);
+      _mm_storeu_ps(sums, vSum);
+      for (size_t ll = 0; ll < 4; ++ll) {
+         const auto cc = firstScalar + ll;
+         mPeak[cc] = std::max(mPeak[cc], maxes[ll]);
+         mSumSquares[cc] += sums[ll];
+      }
+   }
+#endif
+
+   for (auto cc = firstScalar; cc < nChannels; ++cc) {
+      auto peak = mPeak[cc];
+      float sum = 0;
+      auto src = interleaved + cc;
+      for (size_t ii = 0; ii < numFrames; ++ii, src += nChannels) {
+         const auto value = std::fabs(*src);
+         peak = std::max(peak, value);
+         sum += value * value;
+      }
+      mPeak[cc] = peak;
+      mSumSquares[cc] += sum;
+   }
+}
+
+void MeterAnalyzer::FindClipping(const float *interleaved, size_t numFrames,
+   ChannelLevels levels[])
+{
+   for (size_t cc = 0; cc < mNChannels; ++cc) {
+      auto &level = levels[cc];
+      // Most buffers have no samples at full scale, and need no scan
+      if (mPeak[cc] < MAX_AUDIO) {
+         mHeadOpen[cc] = 0;
+         level.tailPeakCount = 0;
+         continue;
+      }
+      auto src = interleaved + cc;
+      for (size_t ii = 0; ii < numFrames; ++ii, src += mNChannels) {
+         if (std::fabs(*src) >= MAX_AUDIO) {
+            if (mHeadOpen[cc])
+               ++level.headPeakCount;
+            if (++level.tailPeakCount > mNumPeakSamplesToClip)
+               level.clipping = true;
+         }
+         else {
+            mHeadOpen[cc] = 0;
+            level.tailPeakCount = 0;
+         }
+      }
+   }
+}
+
+void MeterAnalyzer::FindTruePeak(size_t numFrames)
+{
+   const auto &taps = InterpolationTaps();
+   for (size_t cc = 0; cc < mNChannels; ++cc) {
+      // x[k - j] for j up to History is defined
+      const auto x = &mScratch[cc * ScratchStride + History];
+      auto truePeak = mTruePeak[cc];
+      for (size_t pp = 0; pp < Phases; ++pp) {
+         const auto &h = taps[pp];
+         size_t kk = 0;
+#if METER_ANALYZER_SSE2
+         // Four outputs at once
+         auto vMax = _mm_setzero_ps();
+         for (; kk + 4 <= numFrames; kk += 4) {
+            auto sum = _mm_setzero_ps();
+            for (size_t jj = 0; jj < TapsPerPhase; ++jj)
+               sum = _mm_add_ps(sum, _mm_mul_ps(
+                  _mm_set1_ps(h[jj]), _mm_loadu_ps(x + kk - jj)));
+            vMax = _mm_max_ps(vMax, Abs(sum));
+         }
+         float maxes[4];
+         _mm_storeu_ps(maxes, vMax);
+         truePeak = std::max({ truePeak, maxes[0], maxes[1], maxes[2], maxes[3] });
+#endif
+         for (; kk < numFrames; ++kk) {
+            float sum = 0;
+            for (size_t jj = 0; jj < TapsPerPhase; ++jj)
+               sum += h[jj] * x[kk - jj];
+            truePeak = std::max(truePeak, std::fabs(sum));
+         }
+      }
+      mTruePeak[cc] = truePeak;
+   }
+}
+
+void MeterAnalyzer::Weight(size_t offset, size_t numFrames)
+{
+   // Split at the ends of steps, so that steps are measured exactly
+   for (size_t done = 0; done < numFrames;) {
+      const auto len = std::min(numFrames - done, mStepFrames - mStepFill);
+      const auto start = offset + done;
+      size_t cc = 0;
+#if METER_ANALYZER_SSE2
+      for (; cc + 2 <= mNChannels; cc += 2)
+         mStepPower += FilterTwo(mWeighting,
+            &mFilterState[cc * 6], &mFilterState[(cc + 1) * 6],
+            &mScratch[cc * ScratchStride + start],
+            &mScratch[(cc + 1) * ScratchStride + start], len);
+#endif
+      for (; cc < mNChannels; ++cc)
+         mStepPower += FilterOne(mWeighting, &mFilterState[cc * 6],
+            &mScratch[cc * ScratchStride + start], len);
+
+      done += len;
+      if ((mStepFill += len) == mStepFrames) {
+         mSteps[mNextStep] = mStepPower;
+         mNextStep = (mNextStep + 1) % ShortTermSteps;
+         mStepCount = std::min(mStepCount + 1, ShortTermSteps);
+         mStepPower = 0;
+         mStepFill = 0;
+      }
+   }
+}
+
+double MeterAnalyzer::Loudness(size_t nSteps) const
+{
+   nSteps = std::min(nSteps, mStepCount);
+   double sum = 0;
+   for (size_t ii = 1; ii <= nSteps; ++ii)
+      sum += mSteps[(mNextStep + ShortTermSteps - ii) % ShortTermSteps];
+   const auto meanSquare = nSteps ? sum / (nSteps * mStepFrames) : 0;
+   if (meanSquare <= 0)
+      return -std::numeric_limits<double>::infinity();
+   return -0.691 + 10 * log10(meanSquare);
+}
+
+double MeterAnalyzer::GetMomentaryLoudness() const
+{
+   return Loudness(MomentarySteps);
+}
+
+double MeterAnalyzer::GetShortTermLoudness() const
+{
+   return Loudness(ShortTermSteps);
+}
@@ -0,0 +1,116 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MeterAnalyzer.h
+  @brief Levels of interleaved samples of any number of channels, for meters
+
+**********************************************************************/
+
+#ifndef __AUDACITY_METER_ANALYZER__
+#define __AUDACITY_METER_ANALYZER__
+
+#include <cstddef>
+#include <vector>
+
+//! Computes peak, rms, true peak and loudness of successive buffers
+/*!
+ Where SSE2 is available, peak and power are found for four samples at once,
+ interpolation for true peak computes four outputs at once, and the
+ weighting filters for loudness run two channels at once.
+
+ True peak is found by oversampling four times, as in ITU-R BS.1770, Annex 2.
+ Loudness is K-weighted, with all channels weighted equally, because channel
+ positions are not known.  Momentary loudness covers the last 400 ms and
+ short-term loudness the last 3 s, both updated in steps of 100 ms.
+
+ Not thread-safe:  one thread should use each object.
+ */
+class MATH_API MeterAnalyzer final
+{
+public:
+   struct ChannelLevels {
+      float peak{ 0 };
+      float rms{ 0 };
+      //! Peak of the signal reconstructed between samples; not less than peak
+      float truePeak{ 0 };
+      //! Count of consecutive samples at full scale at the start of the buffer
+      int headPeakCount{ 0 };
+      //! Count of consecutive samples at full scale at the end of the buffer
+      int tailPeakCount{ 0 };
+      //! Whether the buffer has more than numPeakSamplesToClip consecutive
+      //! samples at full scale
+      bool clipping{ false };
+   };
+
+   /*!
+    @pre `rate > 0`
+    @pre `nChannels > 0`
+    */
+   MeterAnalyzer(double rate, size_t nChannels, int numPeakSamplesToClip);
+   ~MeterAnalyzer();
+
+   double GetRate() const { return mRate; }
+   size_t NumChannels() const { return mNChannels; }
+
+   //! Forget previous buffers
+   void Reset();
+
+   //! Analyze one buffer, continuing from the previous buffers
+   /*!
+    @param interleaved `numFrames` frames of `NumChannels()` samples
+    @param[out] levels `NumChannels()` results for this buffer only
+    */
+   void Process(const float *interleaved, size_t numFrames,
+      ChannelLevels levels[]);
+
+   //! Loudness of the last 400 ms in LUFS, or negative infinity before a
+   //! whole step is measured, or for silence
+   double GetMomentaryLoudness() const;
+   //! Loudness of the last 3 s in LUFS, or negative infinity before a
+   //! whole step is measured, or for silence
+   double GetShortTermLoudness() const;
+
+private:
+   void ProcessChunk(const float *interleaved, size_t numFrames,
+      ChannelLevels levels[]);
+   void FindPeakAndPower(const float *interleaved, size_t numFrames);
+   void FindClipping(const float *interleaved, size_t numFrames,
+      ChannelLevels levels[]);
+   void FindTruePeak(size_t numFrames);
+   void Weight(size_t offset, size_t numFrames);
+   double Loudness(size_t nSteps) const;
+
+   const double mRate;
+   const size_t mNChannels;
+   const int mNumPeakSamplesToClip;
+   const size_t mStepFrames;
+   //! Coefficients b0, b1, b2, a1, a2 of the shelving filter, then of the
+   //! high-pass filter, of the K-weighting
+   double mWeighting[10];
+
+   // Per channel, for the current call of Process
+   std::vector<float> mPeak;
+   std::vector<double> mSumSquares;
+   std::vector<float> mTruePeak;
+   //! Whether the buffer so far is all at full scale
+   std::vector<char> mHeadOpen;
+
+   //! Each channel, deinterleaved after the history the interpolation
+   //! filter needs
+   std::vector<float> mScratch;
+
+   //! Per channel, states of the shelving and high-pass weighting filters:
+   //! x1, x2, y1, y2, z1, z2
+   std::vector<double> mFilterState;
+
+   //! Weighted power of the current 100 ms step, summed over channels
+   double mStepPower{ 0 };
+   size_t mStepFill{ 0 };
+   //! Powers of the most recent complete steps, oldest overwritten first
+   std::vector<double> mSteps;
+   size_t mNextStep{ 0 };
+   size_t mStepCount{ 0 };
+};
+
+#endif
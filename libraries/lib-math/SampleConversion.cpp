@@ -0,0 +1,394 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SampleConversion.cpp
+
+**********************************************************************/
+
+#include "SampleConversion.h"
+
+// Erik de Castro Lopo's header file that
+// makes sure that we have lrint and lrintf
+// (Note: this file should be included first)
+#include "float_cast.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// SSE2 is part of every x86-64 processor, so needs no run-time check
+#define SAMPLE_CONVERSION_SSE2 1
+#include <emmintrin.h>
+#else
+#define SAMPLE_CONVERSION_SSE2 0
+#endif
+
+namespace SampleConversion {
+
+namespace {
+
+// Scale factors are powers of two, so that multiplying by them is exact and
+// agrees with the division done by the scalar code elsewhere
+constexpr auto FROM_INT16 = 1.0f / (1 << 15);
+constexpr auto FROM_INT24 = 1.0f / (1 << 23);
+constexpr auto TO_INT16 = float(1 << 15);
+constexpr auto TO_INT24 = float(1 << 23);
+constexpr auto INT24_TO_INT16 = 1.0f / (1 << 8);
+constexpr auto INT16_TO_INT24 = float(1 << 8);
+
+constexpr int INT24_MIN = -8388608;
+constexpr int INT24_MAX = 8388607;
+
+// Xorshift; the 23 high bits become the mantissa of a float in [1, 2), which
+// is then moved to [-0.5, 0.5)
+inline float NextNoise(uint32_t &x)
+{
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   const uint32_t bits = (x >> 9) | 0x3f800000u;
+   float result;
+   memcpy(&result, &bits, sizeof(result));
+   return result - 1.5f;
+}
+
+inline float Clip(float sample)
+{
+   return sample > 1.0f ? 1.0f : sample < -1.0f ? -1.0f : sample;
+}
+
+inline short StoreInt16(float sample)
+{
+   const auto x = lrintf(sample);
+   return x > 32767 ? 32767 : x < -32768 ? -32768 : static_cast<short>(x);
+}
+
+inline int StoreInt24(float sample)
+{
+   const auto x = lrintf(sample);
+   return x > INT24_MAX ? INT24_MAX
+      : x < INT24_MIN ? INT24_MIN : static_cast<int>(x);
+}
+
+#if SAMPLE_CONVERSION_SSE2
+
+inline __m128 NextNoise(__m128i &x)
+{
+   x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+   x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+   x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+   const auto bits =
+      _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3f800000));
+   return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.5f));
+}
+
+//! { last[3], r[0], r[1], r[2] }
+inline __m128 Previous(__m128 r, __m128 last)
+{
+   return _mm_castsi128_ps(_mm_or_si128(
+      _mm_slli_si128(_mm_castps_si128(r), 4),
+      _mm_srli_si128(_mm_castps_si128(last), 12)));
+}
+
+template<bool contiguous>
+inline __m128 Load4(const float *src, size_t stride)
+{
+   if (contiguous)
+      return _mm_loadu_ps(src);
+   return _mm_setr_ps(src[0], src[stride], src[2 * stride], src[3 * stride]);
+}
+
+template<bool contiguous>
+inline __m128 Load4(const int *src, size_t stride)
+{
+   if (contiguous)
+      return _mm_cvtepi32_ps(
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+   return _mm_cvtepi32_ps(
+      _mm_setr_epi32(src[0], src[stride], src[2 * stride], src[3 * stride]));
+}
+
+template<bool contiguous>
+inline __m128 Load4(const short *src, size_t stride)
+{
+   if (contiguous) {
+      const auto x =
+         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+      // Sign extend to 32 bits
+      return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+   }
+   return _mm_cvtepi32_ps(
+      _mm_setr_epi32(src[0], src[stride], src[2 * stride], src[3 * stride]));
+}
+
+template<bool contiguous>
+inline void Store4(__m128 x, float *dst, size_t stride)
+{
+   if (contiguous)
+      _mm_storeu_ps(dst, x);
+   else {
+      alignas(16) float values[4];
+      _mm_store_ps(values, x);
+      for (size_t j = 0; j < 4; ++j)
+         dst[j * stride] = values[j];
+   }
+}
+
+//! Rounds to nearest, and clips
+template<bool contiguous>
+inline void Store4(__m128 x, int *dst, size_t stride)
+{
+   // Clip before conversion, as SSE2 has no 32 bit integer min and max.
+   // Floats of this size are whole numbers, so the result is the same.
+   // max first, so that NaN becomes the minimum, as lrintf makes it
+   x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(float(INT24_MIN))),
+      _mm_set1_ps(float(INT24_MAX)));
+   const auto result = _mm_cvtps_epi32(x);
+   if (contiguous)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+   else {
+      alignas(16) int values[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(values), result);
+      for (size_t j = 0; j < 4; ++j)
+         dst[j * stride] = values[j];
+   }
+}
+
+//! Rounds to nearest, and clips
+template<bool contiguous>
+inline void Store4(__m128 x, short *dst, size_t stride)
+{
+   // Saturating pack does the clipping
+   const auto x32 = _mm_cvtps_epi32(x);
+   const auto result = _mm_packs_epi32(x32, x32);
+   if (contiguous)
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), result);
+   else {
+      short values[4];
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(values), result);
+      for (size_t j = 0; j < 4; ++j)
+         dst[j * stride] = values[j];
+   }
+}
+
+#endif
+
+// Each conversion describes how to load one sample as a float in the
+// units of the destination, and how to store such a float.  The vectorized
+// loop does the same with clipping to [-1, 1] if `clip`, then multiplication
+// by `scale`.
+
+struct Int16ToFloatConversion {
+   using Src = short;
+   using Dst = float;
+   static constexpr bool clip = false;
+   static constexpr float scale = FROM_INT16;
+   static float Load(short x) { return x * scale; }
+   static float Store(float x) { return x; }
+};
+
+struct Int24ToFloatConversion {
+   using Src = int;
+   using Dst = float;
+   static constexpr bool clip = false;
+   static constexpr float scale = FROM_INT24;
+   static float Load(int x) { return x * scale; }
+   static float Store(float x) { return x; }
+};
+
+struct Int16ToInt24Conversion {
+   using Src = short;
+   using Dst = int;
+   static constexpr bool clip = false;
+   static constexpr float scale = INT16_TO_INT24;
+   static float Load(short x) { return x * scale; }
+   static int Store(float x) { return StoreInt24(x); }
+};
+
+struct FloatToInt16Conversion {
+   using Src = float;
+   using Dst = short;
+   static constexpr bool clip = true;
+   static constexpr float scale = TO_INT16;
+   static float Load(float x) { return Clip(x) * scale; }
+   static short Store(float x) { return StoreInt16(x); }
+};
+
+struct FloatToInt24Conversion {
+   using Src = float;
+   using Dst = int;
+   static constexpr bool clip = true;
+   static constexpr float scale = TO_INT24;
+   static float Load(float x) { return Clip(x) * scale; }
+   static int Store(float x) { return StoreInt24(x); }
+};
+
+struct Int24ToInt16Conversion {
+   using Src = int;
+   using Dst = short;
+   static constexpr bool clip = false;
+   static constexpr float scale = INT24_TO_INT16;
+   static float Load(int x) { return x * scale; }
+   static short Store(float x) { return StoreInt16(x); }
+};
+
+template<typename Conversion, DitherKind kind, bool contiguous>
+void Convert(const typename Conversion::Src *src, size_t srcStride,
+   typename Conversion::Dst *dst, size_t dstStride, size_t len,
+   DitherState &state)
+{
+   size_t ii = 0;
+#if SAMPLE_CONVERSION_SSE2
+   {
+      const auto scale = _mm_set1_ps(Conversion::scale);
+      auto noise =
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.noise));
+      auto last = _mm_setr_ps(0, 0, 0, state.triangle);
+      for (; ii + 4 <= len; ii += 4) {
+         auto x = Load4<contiguous>(src + ii * srcStride, srcStride);
+         // Same order of operations as the scalar code, so that results agree
+         if (Conversion::clip)
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)),
+               _mm_set1_ps(1.0f));
+         x = _mm_mul_ps(x, scale);
+         if (kind == DitherKind::rectangle)
+            x = _mm_sub_ps(x, NextNoise(noise));
+         else if (kind == DitherKind::triangle) {
+            const auto r = NextNoise(noise);
+            x = _mm_sub_ps(_mm_add_ps(x, r), Previous(r, last));
+            last = r;
+         }
+         Store4<contiguous>(x, dst + ii * dstStride, dstStride);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(state.noise), noise);
+      state.triangle =
+         _mm_cvtss_f32(_mm_shuffle_ps(last, last, _MM_SHUFFLE(3, 3, 3, 3)));
+   }
+#endif
+   // Draw noise from the lanes as the vectorized loop would
+   for (; ii < len; ii += 4) {
+      const auto count = std::min<size_t>(4, len - ii);
+      for (size_t jj = 0; jj < count; ++jj) {
+         auto x = Conversion::Load(src[(ii + jj) * srcStride]);
+         if (kind == DitherKind::rectangle)
+            x = x - NextNoise(state.noise[jj]);
+         else if (kind == DitherKind::triangle) {
+            const auto r = NextNoise(state.noise[jj]);
+            x = x + r - state.triangle;
+            state.triangle = r;
+         }
+         dst[(ii + jj) * dstStride] = Conversion::Store(x);
+      }
+   }
+}
+
+template<typename Conversion, DitherKind kind>
+void Convert(const typename Conversion::Src *src, size_t srcStride,
+   typename Conversion::Dst *dst, size_t dstStride, size_t len,
+   DitherState &state)
+{
+   if (srcStride == 1 && dstStride == 1)
+      Convert<Conversion, kind, true>(src, 1, dst, 1, len, state);
+   else
+      Convert<Conversion, kind, false>(
+         src, srcStride, dst, dstStride, len, state);
+}
+
+template<typename Conversion>
+void Convert(const typename Conversion::Src *src, size_t srcStride,
+   typename Conversion::Dst *dst, size_t dstStride, size_t len)
+{
+   // Not dithering, so the state is not used; the shared one is not touched,
+   // so that conversions without dither may run in several threads
+   DitherState state{};
+   Convert<Conversion, DitherKind::none>(
+      src, srcStride, dst, dstStride, len, state);
+}
+
+template<typename Conversion>
+void Convert(const typename Conversion::Src *src, size_t srcStride,
+   typename Conversion::Dst *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state)
+{
+   switch (kind) {
+   case DitherKind::none:
+      Convert<Conversion>(src, srcStride, dst, dstStride, len);
+      break;
+   case DitherKind::rectangle:
+      Convert<Conversion, DitherKind::rectangle>(
+         src, srcStride, dst, dstStride, len, state);
+      break;
+   case DitherKind::triangle:
+      Convert<Conversion, DitherKind::triangle>(
+         src, srcStride, dst, dstStride, len, state);
+      break;
+   }
+}
+
+}
+
+void DitherState::Reset()
+{
+   // Any nonzero seeds will do
+   noise[0] = 0x9e3779b9u;
+   noise[1] = 0x7f4a7c15u;
+   noise[2] = 0x94d049bbu;
+   noise[3] = 0xbf58476du;
+   ResetFilter();
+}
+
+void DitherState::ResetFilter()
+{
+   triangle = 0;
+}
+
+bool IsVectorized()
+{
+   return SAMPLE_CONVERSION_SSE2;
+}
+
+void Int16ToFloat(const short *src, size_t srcStride,
+   float *dst, size_t dstStride, size_t len)
+{
+   Convert<Int16ToFloatConversion>(src, srcStride, dst, dstStride, len);
+}
+
+void Int24ToFloat(const int *src, size_t srcStride,
+   float *dst, size_t dstStride, size_t len)
+{
+   Convert<Int24ToFloatConversion>(src, srcStride, dst, dstStride, len);
+}
+
+void Int16ToInt24(const short *src, size_t srcStride,
+   int *dst, size_t dstStride, size_t len)
+{
+   Convert<Int16ToInt24Conversion>(src, srcStride, dst, dstStride, len);
+}
+
+void FloatToInt16(const float *src, size_t srcStride,
+   short *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state)
+{
+   Convert<FloatToInt16Conversion>(
+      src, srcStride, dst, dstStride, len, kind, state);
+}
+
+void FloatToInt24(const float *src, size_t srcStride,
+   int *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state)
+{
+   Convert<FloatToInt24Conversion>(
+      src, srcStride, dst, dstStride, len, kind, state);
+}
+
+void Int24ToInt16(const int *src, size_t srcStride,
+   short *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state)
+{
+   Convert<Int24ToInt16Conversion>(
+      src, srcStride, dst, dstStride, len, kind, state);
+}
+
+}
@@ -0,0 +1,68 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SampleConversion.h
+  @brief Conversions between sample formats, several samples at a time
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_CONVERSION__
+#define __AUDACITY_SAMPLE_CONVERSION__
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ Kernels behind Dither::Apply for all but noise-shaped dither.
+
+ Where SSE2 is available, four samples are loaded, converted, dithered and
+ stored at once.  Strides are in samples, and 1 means contiguous; other
+ strides gather and scatter, but still convert four samples at a time.
+
+ Rectangle and triangle dither draw their noise from four xorshift
+ generators, one per lane, so that the noise too is computed four values at a
+ time.  The scalar fallback draws the same values in the same order, so the
+ output does not depend on the instruction set.
+ */
+namespace SampleConversion {
+
+enum class DitherKind { none, rectangle, triangle };
+
+//! State carried from one call to the next
+struct MATH_API DitherState {
+   //! Restart the noise and the triangle filter
+   void Reset();
+   //! Restart only the triangle filter, keeping the noise going
+   void ResetFilter();
+
+   uint32_t noise[4];
+   //! Noise value of the last sample, subtracted from the next one
+   float triangle;
+};
+
+//! Whether the kernels use SIMD instructions on this build and processor
+MATH_API bool IsVectorized();
+
+MATH_API void Int16ToFloat(const short *src, size_t srcStride,
+   float *dst, size_t dstStride, size_t len);
+MATH_API void Int24ToFloat(const int *src, size_t srcStride,
+   float *dst, size_t dstStride, size_t len);
+MATH_API void Int16ToInt24(const short *src, size_t srcStride,
+   int *dst, size_t dstStride, size_t len);
+
+//! Clips the source to [-1, 1] first
+MATH_API void FloatToInt16(const float *src, size_t srcStride,
+   short *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state);
+//! Clips the source to [-1, 1] first
+MATH_API void FloatToInt24(const float *src, size_t srcStride,
+   int *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state);
+MATH_API void Int24ToInt16(const int *src, size_t srcStride,
+   short *dst, size_t dstStride, size_t len,
+   DitherKind kind, DitherState &state);
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MeterAnalyzerTest.cpp
+
+**********************************************************************/
+#include "MeterAnalyzer.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Not a multiple of 4, to exercise the tails of the vectorized loops
+constexpr size_t numFrames = 1001;
+constexpr double rate = 48000;
+
+std::vector<float> MakeNoise(size_t nChannels, size_t nFrames)
+{
+   std::mt19937 engine { 42 };
+   std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+   std::vector<float> result(nChannels * nFrames);
+   for (auto& value : result)
+      value = dist(engine);
+   return result;
+}
+
+std::vector<float> MakeSine(
+   size_t nChannels, size_t nFrames, double frequency, double amplitude,
+   double phase = 0)
+{
+   std::vector<float> result(nChannels * nFrames);
+   for (size_t i = 0; i < nFrames; ++i)
+   {
+      const auto value =
+         amplitude * std::sin(2 * M_PI * frequency * i / rate + phase);
+      for (size_t c = 0; c < nChannels; ++c)
+         result[i * nChannels + c] = value;
+   }
+   return result;
+}
+
+std::vector<MeterAnalyzer::ChannelLevels>
+Process(MeterAnalyzer& analyzer, const std::vector<float>& samples)
+{
+   const auto nChannels = analyzer.NumChannels();
+   std::vector<MeterAnalyzer::ChannelLevels> levels(nChannels);
+   analyzer.Process(samples.data(), samples.size() / nChannels, levels.data());
+   return levels;
+}
+} // namespace
+
+TEST_CASE("MeterAnalyzer peak and rms")
+{
+   const size_t nChannels = GENERATE(1, 2, 3, 4, 5, 8, 16);
+   const auto samples = MakeNoise(nChannels, numFrames);
+
+   MeterAnalyzer analyzer { rate, nChannels, 3 };
+   const auto levels = Process(analyzer, samples);
+
+   for (size_t c = 0; c < nChannels; ++c)
+   {
+      float peak = 0;
+      double sum = 0;
+      for (size_t i = 0; i < numFrames; ++i)
+      {
+         const auto value = samples[i * nChannels + c];
+         peak = std::max(peak, std::fabs(value));
+         sum += value * value;
+      }
+      REQUIRE(levels[c].peak == peak);
+      REQUIRE(levels[c].rms == Approx(std::sqrt(sum / numFrames)));
+      REQUIRE(levels[c].truePeak >= levels[c].peak);
+      REQUIRE(!levels[c].clipping);
+   }
+}
+
+TEST_CASE("MeterAnalyzer true peak exceeds sample peak")
+{
+   // A quarter of the rate, sampled 45 degrees away from its peaks
+   const auto samples = MakeSine(2, 4800, rate / 4, 1.0, M_PI / 4);
+   MeterAnalyzer analyzer { rate, 2, 3 };
+   const auto levels = Process(analyzer, samples);
+   for (const auto& level : levels)
+   {
+      REQUIRE(level.peak == Approx(std::sqrt(0.5)).margin(0.001));
+      REQUIRE(level.truePeak > 0.95f);
+      REQUIRE(level.truePeak < 1.05f);
+   }
+}
+
+TEST_CASE("MeterAnalyzer loudness")
+{
+   MeterAnalyzer analyzer { rate, 2, 3 };
+   REQUIRE(std::isinf(analyzer.GetMomentaryLoudness()));
+
+   // A sine of 1 kHz at -20 dBFS in each of two channels reads -20 LUFS,
+   // because the K-weighting has about unit gain at 1 kHz and each channel
+   // contributes half of a full scale sine's mean square
+   const auto samples = MakeSine(2, 3 * rate, 1000, 0.1);
+   Process(analyzer, samples);
+   REQUIRE(analyzer.GetMomentaryLoudness() == Approx(-20.0).margin(0.2));
+   REQUIRE(analyzer.GetShortTermLoudness() == Approx(-20.0).margin(0.2));
+
+   analyzer.Reset();
+   REQUIRE(std::isinf(analyzer.GetShortTermLoudness()));
+}
+
+TEST_CASE("MeterAnalyzer clipping")
+{
+   std::vector<float> samples(20, 0.5f);
+   // Two at the start, five in the middle, three at the end
+   for (auto i : { 0, 1, 8, 9, 10, 11, 12, 17, 18, 19 })
+      samples[i] = 1.0f;
+
+   MeterAnalyzer analyzer { rate, 1, 3 };
+   auto levels = Process(analyzer, samples);
+   REQUIRE(levels[0].headPeakCount == 2);
+   REQUIRE(levels[0].tailPeakCount == 3);
+   REQUIRE(levels[0].clipping);
+
+   samples[10] = 0.5f;
+   levels = Process(analyzer, samples);
+   REQUIRE(!levels[0].clipping);
+}
+
+TEST_CASE("MeterAnalyzer results do not depend on buffer sizes")
+{
+   const size_t nChannels = 3;
+   const auto samples = MakeNoise(nChannels, 10 * numFrames);
+
+   MeterAnalyzer whole { rate, nChannels, 3 };
+   const auto levels = Process(whole, samples);
+
+   MeterAnalyzer pieces { rate, nChannels, 3 };
+   std::vector<MeterAnalyzer::ChannelLevels> pieceLevels(nChannels);
+   std::vector<float> truePeaks(nChannels);
+   for (size_t done = 0, len = 1; done < 10 * numFrames;
+        done += len, len = len * 3 % 2000 + 1)
+   {
+      len = std::min(len, 10 * numFrames - done);
+      pieces.Process(
+         samples.data() + done * nChannels, len, pieceLevels.data());
+      for (size_t c = 0; c < nChannels; ++c)
+         truePeaks[c] = std::max(truePeaks[c], pieceLevels[c].truePeak);
+   }
+
+   for (size_t c = 0; c < nChannels; ++c)
+      REQUIRE(truePeaks[c] == Approx(levels[c].truePeak));
+   REQUIRE(
+      pieces.GetMomentaryLoudness() ==
+      Approx(whole.GetMomentaryLoudness()).epsilon(1e-6));
+   REQUIRE(
+      pieces.GetShortTermLoudness() ==
+      Approx(whole.GetShortTermLoudness()).epsilon(1e-6));
+}
@@ -0,0 +1,268 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleConversionTest.cpp
+
+**********************************************************************/
+#include "Dither.h"
+#include "SampleConversion.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Not a multiple of 4, to exercise the tails of the vectorized loops
+constexpr size_t numSamples = 1001;
+
+std::vector<float> MakeFloats(size_t n)
+{
+   std::mt19937 engine { 42 };
+   // Somewhat beyond full scale, to exercise clipping
+   std::uniform_real_distribution<float> dist { -1.2f, 1.2f };
+   std::vector<float> result(n);
+   for (auto& value : result)
+      value = dist(engine);
+   result[0] = 1.0f;
+   result[1] = -1.0f;
+   result[2] = 0.0f;
+   // Halfway between two steps of 16 bits
+   result[3] = 0.5f / (1 << 15);
+   return result;
+}
+
+std::vector<short> MakeInt16s(size_t n)
+{
+   std::mt19937 engine { 43 };
+   std::uniform_int_distribution<int> dist { -32768, 32767 };
+   std::vector<short> result(n);
+   for (auto& value : result)
+      value = dist(engine);
+   result[0] = -32768;
+   result[1] = 32767;
+   return result;
+}
+
+std::vector<int> MakeInt24s(size_t n)
+{
+   std::mt19937 engine { 44 };
+   std::uniform_int_distribution<int> dist { -8388608, 8388607 };
+   std::vector<int> result(n);
+   for (auto& value : result)
+      value = dist(engine);
+   result[0] = -8388608;
+   result[1] = 8388607;
+   // Halfway between two steps of 16 bits
+   result[2] = 128;
+   return result;
+}
+
+// The conversions as Dither did them one sample at a time
+short ExpectedInt16(float x)
+{
+   const auto clipped = x > 1.0f ? 1.0f : x < -1.0f ? -1.0f : x;
+   return std::clamp<long>(std::lrint(clipped * 32768.0f), -32768, 32767);
+}
+
+int ExpectedInt24(float x)
+{
+   const auto clipped = x > 1.0f ? 1.0f : x < -1.0f ? -1.0f : x;
+   return std::clamp<long>(
+      std::lrint(clipped * 8388608.0f), -8388608, 8388607);
+}
+
+short ExpectedInt16(int x)
+{
+   return std::clamp<long>(
+      std::lrint(x / 8388608.0f * 32768.0f), -32768, 32767);
+}
+
+template <typename Src, typename Dst>
+std::vector<Dst> Copy(
+   const std::vector<Src>& src, sampleFormat srcFormat, sampleFormat dstFormat,
+   DitherType ditherType, unsigned srcStride = 1, unsigned dstStride = 1)
+{
+   const auto len = src.size() / srcStride;
+   std::vector<Dst> dst(len * dstStride);
+   CopySamples(
+      reinterpret_cast<constSamplePtr>(src.data()), srcFormat,
+      reinterpret_cast<samplePtr>(dst.data()), dstFormat, len, ditherType,
+      srcStride, dstStride);
+   return dst;
+}
+
+template <typename T>
+std::vector<T> Strided(const std::vector<T>& v, size_t stride)
+{
+   std::vector<T> result(v.size() * stride);
+   for (size_t i = 0; i < v.size(); ++i)
+      result[i * stride] = v[i];
+   return result;
+}
+
+template <typename T>
+std::vector<T> Unstrided(const std::vector<T>& v, size_t stride)
+{
+   std::vector<T> result(v.size() / stride);
+   for (size_t i = 0; i < result.size(); ++i)
+      result[i] = v[i * stride];
+   return result;
+}
+} // namespace
+
+TEST_CASE("Sample conversions without dither")
+{
+   const auto floats = MakeFloats(numSamples);
+   const auto int16s = MakeInt16s(numSamples);
+   const auto int24s = MakeInt24s(numSamples);
+
+   for (const auto& [srcStride, dstStride] :
+        { std::pair { 1u, 1u }, { 2u, 1u }, { 1u, 3u }, { 2u, 3u } })
+   {
+      const auto copy = [&, srcStride = srcStride, dstStride = dstStride](
+                           const auto& src, auto dst, sampleFormat srcFormat,
+                           sampleFormat dstFormat) {
+         using Dst = decltype(dst);
+         return Unstrided(
+            Copy<typename std::decay_t<decltype(src)>::value_type, Dst>(
+               Strided(src, srcStride), srcFormat, dstFormat,
+               DitherType::none, srcStride, dstStride),
+            dstStride);
+      };
+
+      const auto fromInt16 = copy(int16s, float {}, int16Sample, floatSample);
+      const auto fromInt24 = copy(int24s, float {}, int24Sample, floatSample);
+      const auto int16ToInt24 = copy(int16s, int {}, int16Sample, int24Sample);
+      const auto toInt16 = copy(floats, short {}, floatSample, int16Sample);
+      const auto toInt24 = copy(floats, int {}, floatSample, int24Sample);
+      const auto int24ToInt16 = copy(int24s, short {}, int24Sample, int16Sample);
+
+      for (size_t i = 0; i < numSamples; ++i)
+      {
+         REQUIRE(fromInt16[i] == int16s[i] / 32768.0f);
+         REQUIRE(fromInt24[i] == int24s[i] / 8388608.0f);
+         REQUIRE(int16ToInt24[i] == int16s[i] * 256);
+         REQUIRE(toInt16[i] == ExpectedInt16(floats[i]));
+         REQUIRE(toInt24[i] == ExpectedInt24(floats[i]));
+         REQUIRE(int24ToInt16[i] == ExpectedInt16(int24s[i]));
+      }
+   }
+}
+
+TEST_CASE("Sample conversions with dither")
+{
+   const auto floats = MakeFloats(numSamples);
+   const auto ditherType =
+      GENERATE(DitherType::rectangle, DitherType::triangle);
+
+   SECTION("Dither changes samples by at most one step")
+   {
+      const auto result =
+         Copy<float, short>(floats, floatSample, int16Sample, ditherType);
+      for (size_t i = 0; i < numSamples; ++i)
+         REQUIRE(std::abs(result[i] - ExpectedInt16(floats[i])) <= 1);
+   }
+
+   SECTION("Dither makes the mean follow steps smaller than one")
+   {
+      // A quarter of a step of 16 bits
+      const std::vector<float> quarter(100000, 0.25f / (1 << 15));
+      const auto result =
+         Copy<float, short>(quarter, floatSample, int16Sample, ditherType);
+      double sum = 0;
+      for (const auto value : result)
+         sum += value;
+      REQUIRE(sum / result.size() == Approx(0.25).margin(0.01));
+   }
+
+   SECTION("Dither after reset does not depend on the strides")
+   {
+      Dither dither;
+      std::vector<short> contiguous(numSamples);
+      dither.Apply(
+         ditherType, reinterpret_cast<constSamplePtr>(floats.data()),
+         floatSample, reinterpret_cast<samplePtr>(contiguous.data()),
+         int16Sample, numSamples);
+
+      const auto interleaved = Strided(floats, 2);
+      std::vector<short> strided(numSamples * 3);
+      dither.Reset();
+      dither.Apply(
+         ditherType, reinterpret_cast<constSamplePtr>(interleaved.data()),
+         floatSample, reinterpret_cast<samplePtr>(strided.data()),
+         int16Sample, numSamples, 2, 3);
+      REQUIRE(Unstrided(strided, 3) == contiguous);
+   }
+}
+
+// Hidden: run explicitly with the "[benchmark]" tag
+TEST_CASE("Sample conversion throughput", "[.][benchmark]")
+{
+   constexpr size_t len = 1 << 16;
+   constexpr auto numCalls = 200;
+   const auto floats = MakeFloats(2 * len);
+   // Room for two interleaved channels of the widest format
+   std::vector<float> src(2 * len);
+   std::vector<float> dst(2 * len);
+
+   const auto run = [&](
+                       sampleFormat srcFormat, sampleFormat dstFormat,
+                       DitherType ditherType, unsigned stride) {
+      // Source samples in the proper format, whatever their values
+      CopySamples(
+         reinterpret_cast<constSamplePtr>(floats.data()), floatSample,
+         reinterpret_cast<samplePtr>(src.data()), srcFormat, 2 * len,
+         DitherType::none);
+      using namespace std::chrono;
+      const auto start = steady_clock::now();
+      for (auto i = 0; i < numCalls; ++i)
+         CopySamples(
+            reinterpret_cast<constSamplePtr>(src.data()), srcFormat,
+            reinterpret_cast<samplePtr>(dst.data()), dstFormat, len,
+            ditherType, stride, stride);
+      return numCalls * len /
+             duration<double>(steady_clock::now() - start).count() / 1e6;
+   };
+
+   const auto name = [](sampleFormat format) {
+      return format == int16Sample ? "int16" :
+             format == int24Sample ? "int24" :
+                                     "float";
+   };
+   const char* const ditherNames[] = { "none", "rectangle", "triangle",
+                                       "shaped" };
+
+   std::cout << "Vectorized: "
+             << (SampleConversion::IsVectorized() ? "yes" : "no") << "\n";
+   const std::pair<sampleFormat, sampleFormat> pairs[] = {
+      { int16Sample, floatSample }, { int24Sample, floatSample },
+      { int16Sample, int24Sample }, { floatSample, int16Sample },
+      { floatSample, int24Sample }, { int24Sample, int16Sample },
+   };
+   for (const auto& [srcFormat, dstFormat] : pairs)
+   {
+      // Widening needs no dither
+      const auto narrowing = dstFormat < srcFormat;
+      for (const auto ditherType :
+           { DitherType::none, DitherType::rectangle, DitherType::triangle,
+             DitherType::shaped })
+      {
+         if (!narrowing && ditherType != DitherType::none)
+            continue;
+         for (const auto stride : { 1u, 2u })
+            std::cout << name(srcFormat) << " to " << name(dstFormat)
+                      << ", dither " << ditherNames[ditherType]
+                      << ", stride " << stride << ": "
+                      << run(srcFormat, dstFormat, ditherType, stride)
+                      << " Msamples/s\n";
+      }
+   }
+}
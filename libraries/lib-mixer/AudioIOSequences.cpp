@@ -11,6 +11,28 @@
 
 PlayableSequence::~PlayableSequence() = default;
 
+const WideSampleSequence &PlayableSequence::GetSource() const
+{
+   if (const auto pSource = DoGetSource())
+      return *pSource;
+   return GetDecorated();
+}
+
+const WideSampleSequence *PlayableSequence::DoGetSource() const
+{
+   return nullptr;
+}
+
+size_t FindSource(
+   const ConstPlayableSequences &sequences, const WideSampleSequence &source)
+{
+   size_t ii = 0;
+   for (const auto nn = sequences.size(); ii < nn; ++ii)
+      if (&sequences[ii]->GetSource() == &source)
+         break;
+   return ii;
+}
+
 RecordableSequence::~RecordableSequence() = default;
 
 OtherPlayableSequence::~OtherPlayableSequence() = default;
@@ -28,11 +28,26 @@ struct MIXER_API PlayableSequence : WideSampleSequence {
 
    //! May vary asynchronously
    virtual bool GetMute() const = 0;
+
+   //! The sequence, such as a track, that this plays, possibly transformed
+   /*!
+    By default, the innermost decorated sequence
+    */
+   const WideSampleSequence &GetSource() const;
+
+private:
+   //! Override when the source is not the decorated sequence
+   virtual const WideSampleSequence *DoGetSource() const;
 };
 
 using ConstPlayableSequences =
    std::vector<std::shared_ptr<const PlayableSequence>>;
 
+//! Index of the first of `sequences` whose source is `source`, or the size
+//! of `sequences` if there is none
+MIXER_API size_t FindSource(
+   const ConstPlayableSequences &sequences, const WideSampleSequence &source);
+
 /*!
  An interface for recording, by appending sequentially
  (but it also requires random access for insertion of silence)
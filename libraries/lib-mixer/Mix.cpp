@@ -23,6 +23,7 @@
 #include "Resample.h"
 #include "WideSampleSequence.h"
 #include "float_cast.h"
+#include "Tracing.h"
 #include <numeric>
 
 namespace {
@@ -270,6 +271,7 @@ static void MixBuffers(unsigned numChannels,
 
 size_t Mixer::Process(const size_t maxToProcess)
 {
+   TRACE_ZONE("mixer", "Mixer::Process");
    assert(maxToProcess <= BufferSize());
 
    // MB: this is wrong! mT represented warped time, and mTime is too inaccurate to use
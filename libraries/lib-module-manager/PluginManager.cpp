@@ -24,6 +24,8 @@ for shared and private configs - which need to move out.
 
 
 #include <algorithm>
+#include <chrono>
+#include <set>
 
 #include <wx/log.h>
 #include <wx/tokenzr.h>
@@ -36,6 +38,7 @@ for shared and private configs - which need to move out.
 #include "MemoryX.h"
 #include "ModuleManager.h"
 #include "PlatformCompatibility.h"
+#include "PluginRegistryCache.h"
 #include "Base64.h"
 #include "Variant.h"
 
@@ -328,6 +331,7 @@ std::unique_ptr<PluginManager> PluginManager::mInstance{};
 // ----------------------------------------------------------------------------
 
 PluginManager::PluginManager()
+   : mRegistryCache{ std::make_unique<PluginRegistryCache>() }
 {
    mSettings = NULL;
 }
@@ -344,6 +348,10 @@ void PluginManager::InitializePlugins()
    //ModuleManager::DiscoverProviders was called earlier, so we
    //can be sure that providers are already loaded
 
+   std::set<PluginID> providers;
+   for (auto& [id, module] : moduleManager.Providers())
+      providers.insert(id);
+
    //Check all known plugins to ensure they are still valid.
    for (auto it = mRegisteredPlugins.begin(); it != mRegisteredPlugins.end();) {
       auto &pluginDesc = it->second;
@@ -354,6 +362,15 @@ void PluginManager::InitializePlugins()
          continue;
       }
 
+      // Asking the provider may be expensive; a module file that did not
+      // change since the registry was saved is still there
+      if(providers.count(pluginDesc.GetProviderID()) &&
+         mRegistryCache->IsModuleUnchanged(pluginDesc.GetPath()))
+      {
+         ++it;
+         continue;
+      }
+
       if(!moduleManager.CheckPluginExist(pluginDesc.GetProviderID(), pluginDesc.GetPath()))
          it = mRegisteredPlugins.erase(it);
       else
@@ -537,8 +554,107 @@ bool PluginManager::DropFile(const wxString &fileName)
    return false;
 }
 
+namespace {
+#ifdef __WXMAC__
+bool AcceptPath(const wxString &path)
+{
+   // Bug 1590: On Mac, we should purge the registry of Nyquist plug-ins
+   // bundled with other versions of Audacity, assuming both versions
+   // were properly installed in /Applications (or whatever it is called in
+   // your locale)
+   static const auto paths = []{
+      const auto fullExePath = PlatformCompatibility::GetExecutablePath();
+
+      // Strip rightmost path components up to *.app
+      wxFileName exeFn{ fullExePath };
+      exeFn.SetEmptyExt();
+      exeFn.SetName(wxString{});
+      while(exeFn.GetDirCount() && !exeFn.GetDirs().back().EndsWith(".app"))
+         exeFn.RemoveLastDir();
+
+      const auto goodPath = exeFn.GetPath();
+
+      if(exeFn.GetDirCount())
+         exeFn.RemoveLastDir();
+      const auto possiblyBadPath = exeFn.GetPath();
+      return std::make_pair(goodPath, possiblyBadPath);
+   }();
+   const auto &[goodPath, possiblyBadPath] = paths;
+
+   if (!path.StartsWith(possiblyBadPath))
+      // Assume it's not under /Applications
+      return true;
+   if (path.StartsWith(goodPath))
+      // It's bundled with this executable
+      return true;
+   return false;
+}
+#else
+bool AcceptPath(const wxString&) { return true; }
+#endif
+}
+
+bool PluginManager::IsProviderRegistered(
+   const PluginID &ID, const PluginID &providerID) const
+{
+   // Plug-ins without a provider, such as the providers themselves, are valid
+   if (providerID.empty() || mRegisteredPlugins.count(providerID) > 0)
+      return true;
+   // The next save drops it from the registry, so say why
+   wxLogMessage("Skipped plug-in '%s', whose provider '%s' is not registered",
+      ID, providerID);
+   return false;
+}
+
+bool PluginManager::LoadCached()
+{
+   auto &cache = *mRegistryCache;
+   if (!cache.Load(FileNames::PluginRegistry()))
+      return false;
+
+   // Let the text registry be converted
+   if (Regver_lt(cache.GetRegistryVersion(), "1.1"))
+      return false;
+
+   mRegver = cache.GetRegistryVersion();
+   auto descriptors = cache.TakeDescriptors();
+   // As in Load, providers first, so that their plug-ins can be checked
+   std::stable_partition(descriptors.begin(), descriptors.end(),
+      [](const PluginDescriptor &plug){
+         return plug.GetPluginType() == PluginTypeModule; });
+   for (auto &plug : descriptors) {
+      // See comments in LoadGroup
+      if (!IsProviderRegistered(plug.GetID(), plug.GetProviderID()))
+         continue;
+      if (!AcceptPath(plug.GetPath()))
+         continue;
+      const auto id = plug.GetID();
+      // Bypass the plugin if the ID is already in use
+      mRegisteredPlugins.emplace(id, std::move(plug));
+   }
+   return true;
+}
+
 void PluginManager::Load()
 {
+   // Log the time taken, so that startup with large registries can be
+   // measured in the field
+   const auto start = std::chrono::steady_clock::now();
+   bool cached = false;
+   auto logTime = finally([&]{
+      const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::steady_clock::now() - start);
+      wxLogMessage("Loaded %lu plug-in descriptors from the %s in %ld ms",
+         static_cast<unsigned long>(mRegisteredPlugins.size()),
+         cached ? "binary cache" : "text registry",
+         static_cast<long>(elapsed.count()));
+   });
+
+   // The binary cache is up to date unless the text registry was changed
+   // since the last save
+   if ((cached = LoadCached()))
+      return;
+
    // Create/Open the registry
    auto pRegistry = sFactory(FileNames::PluginRegistry());
    auto &registry = *pRegistry;
@@ -624,39 +740,6 @@ void PluginManager::Load()
 
 void PluginManager::LoadGroup(FileConfig *pRegistry, PluginType type)
 {
-#ifdef __WXMAC__
-   // Bug 1590: On Mac, we should purge the registry of Nyquist plug-ins
-   // bundled with other versions of Audacity, assuming both versions
-   // were properly installed in /Applications (or whatever it is called in
-   // your locale)
-
-   const auto fullExePath = PlatformCompatibility::GetExecutablePath();
-
-   // Strip rightmost path components up to *.app
-   wxFileName exeFn{ fullExePath };
-   exeFn.SetEmptyExt();
-   exeFn.SetName(wxString{});
-   while(exeFn.GetDirCount() && !exeFn.GetDirs().back().EndsWith(".app"))
-      exeFn.RemoveLastDir();
-
-   const auto goodPath = exeFn.GetPath();
-
-   if(exeFn.GetDirCount())
-      exeFn.RemoveLastDir();
-   const auto possiblyBadPath = exeFn.GetPath();
-
-   auto AcceptPath = [&](const wxString &path) {
-      if (!path.StartsWith(possiblyBadPath))
-         // Assume it's not under /Applications
-         return true;
-      if (path.StartsWith(goodPath))
-         // It's bundled with this executable
-         return true;
-      return false;
-   };
-#else
-   auto AcceptPath = [](const wxString&){ return true; };
-#endif
 
    wxString strVal;
    bool boolVal;
@@ -685,13 +768,10 @@ void PluginManager::LoadGroup(FileConfig *pRegistry, PluginType type)
       plug.SetID(groupName);
       plug.SetPluginType(type);
 
-      // Get the provider ID and bypass group if not found
-      if (!pRegistry->Read(KEY_PROVIDERID, &strVal, wxEmptyString))
-      {
-         // Bypass group if the provider isn't valid
-         if (!strVal.empty() && !mRegisteredPlugins.count(strVal))
-            continue;
-      }
+      // Get the provider ID and bypass group if the provider isn't valid
+      pRegistry->Read(KEY_PROVIDERID, &strVal, wxEmptyString);
+      if (!IsProviderRegistered(groupName, strVal))
+         continue;
       plug.SetProviderID(PluginID(strVal));
 
       // Get the path (optional)
@@ -909,6 +989,9 @@ void PluginManager::Save()
    registry.Flush();
 
    mRegver = REGVERCUR;
+
+   mRegistryCache->Save(
+      FileNames::PluginRegistry(), mRegver, mRegisteredPlugins);
 }
 
 void PluginManager::NotifyPluginsChanged()
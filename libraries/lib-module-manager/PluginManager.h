@@ -26,6 +26,7 @@
 
 class wxArrayString;
 class FileConfig;
+class PluginRegistryCache;
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -193,6 +194,12 @@ private:
 
    void InitializePlugins();
 
+   //! Restores the registry from its binary cache, if it is up to date
+   bool LoadCached();
+   //! Whether the provider is empty or among the plug-ins loaded so far
+   /*! Logs the plug-in as skipped if not */
+   bool IsProviderRegistered(
+      const PluginID &ID, const PluginID &providerID) const;
    void LoadGroup(FileConfig *pRegistry, PluginType type);
    void SaveGroup(FileConfig *pRegistry, PluginType type);
 
@@ -235,6 +242,10 @@ private:
    std::vector<PluginDescriptor> mEffectPluginsCleared;
 
    PluginRegistryVersion mRegver;
+
+   //! Binary copy of the registry, also telling which plug-in modules are
+   //! unchanged since the last save
+   std::unique_ptr<PluginRegistryCache> mRegistryCache;
 };
 
 // Defining these special names in the low-level PluginManager.h
@@ -0,0 +1,383 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PluginRegistryCache.cpp
+
+  Part of lib-module-manager library
+
+**********************************************************************/
+
+#include "PluginRegistryCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+namespace
+{
+//Changes whenever layout of the file changes
+constexpr char CacheMagic[8] = { 'A', 'U', 'D', 'P', 'R', 'C', '0', '1' };
+
+constexpr uint8_t FlagEnabled = 1 << 0;
+constexpr uint8_t FlagValid = 1 << 1;
+constexpr uint8_t FlagEffectDefault = 1 << 2;
+constexpr uint8_t FlagEffectInteractive = 1 << 3;
+constexpr uint8_t FlagEffectAutomatable = 1 << 4;
+
+//Module path without provider specific suffix
+wxString ModulePath(const PluginPath& path)
+{
+   return path.BeforeFirst(wxT(';'));
+}
+
+class Writer final
+{
+   std::vector<char> mBuffer;
+public:
+   template<typename T>
+   void Write(T value)
+   {
+      const auto offset = mBuffer.size();
+      mBuffer.resize(offset + sizeof(T));
+      std::memcpy(mBuffer.data() + offset, &value, sizeof(T));
+   }
+
+   void WriteBytes(const void* data, size_t size)
+   {
+      const auto bytes = static_cast<const char*>(data);
+      mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+   }
+
+   void WriteString(const wxString& str)
+   {
+      const auto utf8 = str.utf8_str();
+      const auto length = static_cast<uint32_t>(utf8.length());
+      Write(length);
+      WriteBytes(utf8.data(), length);
+   }
+
+   const std::vector<char>& GetBuffer() const noexcept { return mBuffer; }
+};
+
+//Reads from the buffer, turning into failed state on out of range access
+class Reader final
+{
+   const char* mData;
+   size_t mSize;
+   size_t mOffset { 0 };
+   bool mFailed { false };
+public:
+   Reader(const char* data, size_t size) : mData(data), mSize(size) { }
+
+   bool Failed() const noexcept { return mFailed; }
+
+   bool Skip(size_t size)
+   {
+      if(mFailed || mSize - mOffset < size)
+         return !(mFailed = true);
+      mOffset += size;
+      return true;
+   }
+
+   template<typename T>
+   T Read()
+   {
+      T value {};
+      const auto offset = mOffset;
+      if(Skip(sizeof(T)))
+         std::memcpy(&value, mData + offset, sizeof(T));
+      return value;
+   }
+
+   wxString ReadString()
+   {
+      const auto length = Read<uint32_t>();
+      const auto offset = mOffset;
+      if(!Skip(length))
+         return {};
+      return wxString::FromUTF8(mData + offset, length);
+   }
+
+   bool Compare(const void* data, size_t size)
+   {
+      const auto offset = mOffset;
+      return Skip(size) && std::memcmp(mData + offset, data, size) == 0;
+   }
+};
+
+bool IsCached(PluginType type)
+{
+   // The same types that PluginManager::LoadGroup restores
+   switch(type)
+   {
+   case PluginTypeModule:
+   case PluginTypeEffect:
+   case PluginTypeImporter:
+   case PluginTypeStub:
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool ReadDescriptor(Reader& reader, PluginDescriptor& plug)
+{
+   const auto type = static_cast<PluginType>(reader.Read<uint32_t>());
+   if(!IsCached(type))
+      return false;
+   plug.SetPluginType(type);
+   plug.SetID(reader.ReadString());
+   plug.SetProviderID(reader.ReadString());
+   plug.SetPath(reader.ReadString());
+   // As in LoadGroup, only the internal name is remembered
+   plug.SetSymbol(reader.ReadString());
+   plug.SetVersion(reader.ReadString());
+   plug.SetVendor(reader.ReadString());
+
+   const auto flags = reader.Read<uint8_t>();
+   plug.SetEnabled(flags & FlagEnabled);
+   plug.SetValid(flags & FlagValid);
+
+   if(type == PluginTypeEffect)
+   {
+      const auto effectType = reader.Read<int32_t>();
+      if(effectType < EffectTypeNone || effectType > EffectTypeTool)
+         return false;
+      plug.SetEffectType(static_cast<EffectType>(effectType));
+      plug.SetEffectFamily(reader.ReadString());
+      plug.SetEffectDefault(flags & FlagEffectDefault);
+      plug.SetEffectInteractive(flags & FlagEffectInteractive);
+      plug.SetEffectAutomatable(flags & FlagEffectAutomatable);
+      plug.DeserializeRealtimeSupport(reader.ReadString());
+   }
+   else if(type == PluginTypeImporter)
+   {
+      plug.SetImporterIdentifier(reader.ReadString());
+      FileExtensions extensions;
+      const auto count = reader.Read<uint32_t>();
+      for(uint32_t i = 0; i < count && !reader.Failed(); ++i)
+         extensions.push_back(reader.ReadString());
+      plug.SetImporterExtensions(std::move(extensions));
+   }
+   return !reader.Failed();
+}
+
+void WriteDescriptor(Writer& writer, const PluginDescriptor& plug)
+{
+   const auto type = plug.GetPluginType();
+   writer.Write(static_cast<uint32_t>(type));
+   writer.WriteString(plug.GetID());
+   writer.WriteString(plug.GetProviderID());
+   writer.WriteString(plug.GetPath());
+   writer.WriteString(plug.GetSymbol().Internal());
+   writer.WriteString(plug.GetUntranslatedVersion());
+   writer.WriteString(plug.GetVendor());
+
+   uint8_t flags = 0;
+   if(plug.IsEnabled())
+      flags |= FlagEnabled;
+   if(plug.IsValid())
+      flags |= FlagValid;
+   if(type == PluginTypeEffect)
+   {
+      if(plug.IsEffectDefault())
+         flags |= FlagEffectDefault;
+      if(plug.IsEffectInteractive())
+         flags |= FlagEffectInteractive;
+      if(plug.IsEffectAutomatable())
+         flags |= FlagEffectAutomatable;
+   }
+   writer.Write(flags);
+
+   if(type == PluginTypeEffect)
+   {
+      writer.Write(static_cast<int32_t>(plug.GetEffectType()));
+      writer.WriteString(plug.GetEffectFamily());
+      writer.WriteString(plug.SerializeRealtimeSupport());
+   }
+   else if(type == PluginTypeImporter)
+   {
+      writer.WriteString(plug.GetImporterIdentifier());
+      const auto& extensions = plug.GetImporterExtensions();
+      writer.Write(static_cast<uint32_t>(extensions.size()));
+      for(const auto& extension : extensions)
+         writer.WriteString(extension);
+   }
+}
+}
+
+PluginRegistryCache::FileStamp PluginRegistryCache::GetStamp(const wxString& path)
+{
+   FileStamp stamp;
+   if(path.empty())
+      return stamp;
+   if(wxFileName::FileExists(path))
+   {
+      const wxFileName fn { path };
+      const auto size = fn.GetSize();
+      const auto modified = fn.GetModificationTime();
+      if(size == wxInvalidSize || !modified.IsValid())
+         return stamp;
+      stamp.size = size.GetValue();
+      stamp.modified = modified.GetValue().GetValue();
+   }
+   else if(wxFileName::DirExists(path))
+   {
+      // Bundles: size is not meaningful
+      const auto modified = wxFileName::DirName(path).GetModificationTime();
+      if(!modified.IsValid())
+         return stamp;
+      stamp.size = 0;
+      stamp.modified = modified.GetValue().GetValue();
+   }
+   return stamp;
+}
+
+wxString PluginRegistryCache::GetCachePath(const wxString& registryPath)
+{
+   wxFileName fn { registryPath };
+   fn.SetExt(wxT("cache"));
+   return fn.GetFullPath();
+}
+
+bool PluginRegistryCache::Load(const wxString& registryPath)
+{
+   mVersion.clear();
+   mDescriptors.clear();
+   mModuleStamps.clear();
+
+   const auto registryStamp = GetStamp(registryPath);
+   if(!registryStamp.IsValid())
+      return false;
+
+   std::vector<char> buffer;
+   {
+      wxFFile file;
+      const auto cachePath = GetCachePath(registryPath);
+      if(!wxFileName::FileExists(cachePath) || !file.Open(cachePath, wxT("rb")))
+         return false;
+      const auto length = file.Length();
+      if(length <= 0)
+         return false;
+      buffer.resize(static_cast<size_t>(length));
+      if(file.Read(buffer.data(), buffer.size()) != buffer.size())
+         return false;
+   }
+
+   Reader reader { buffer.data(), buffer.size() };
+   if(!reader.Compare(CacheMagic, sizeof(CacheMagic)))
+      return false;
+   // Written for another state of the registry file
+   if(reader.Read<FileStamp>() != registryStamp || reader.Failed())
+      return false;
+
+   auto version = reader.ReadString();
+   const auto count = reader.Read<uint32_t>();
+   if(reader.Failed())
+      return false;
+
+   std::vector<PluginDescriptor> descriptors;
+   std::unordered_map<wxString, FileStamp> moduleStamps;
+   descriptors.reserve(std::min<size_t>(count, buffer.size()));
+   for(uint32_t i = 0; i < count; ++i)
+   {
+      PluginDescriptor plug;
+      if(!ReadDescriptor(reader, plug))
+         return false;
+      const auto stamp = reader.Read<FileStamp>();
+      if(reader.Failed())
+         return false;
+      if(stamp.IsValid())
+         moduleStamps.emplace(ModulePath(plug.GetPath()), stamp);
+      descriptors.push_back(std::move(plug));
+   }
+
+   mVersion = std::move(version);
+   mDescriptors = std::move(descriptors);
+   mModuleStamps = std::move(moduleStamps);
+   return true;
+}
+
+void PluginRegistryCache::Save(const wxString& registryPath,
+   const PluginRegistryVersion& version,
+   const std::map<PluginID, PluginDescriptor>& plugins)
+{
+   mModuleStamps.clear();
+
+   const auto cachePath = GetCachePath(registryPath);
+   const auto registryStamp = GetStamp(registryPath);
+   if(!registryStamp.IsValid())
+   {
+      // Don't leave a cache for a previous registry behind
+      if(wxFileName::FileExists(cachePath))
+         wxRemoveFile(cachePath);
+      return;
+   }
+
+   Writer writer;
+   writer.WriteBytes(CacheMagic, sizeof(CacheMagic));
+   writer.Write(registryStamp);
+   writer.WriteString(version);
+
+   uint32_t count = 0;
+   for(const auto& [id, plug] : plugins)
+      if(IsCached(plug.GetPluginType()))
+         ++count;
+   writer.Write(count);
+
+   for(const auto& [id, plug] : plugins)
+   {
+      if(!IsCached(plug.GetPluginType()))
+         continue;
+      WriteDescriptor(writer, plug);
+
+      // Several plugins may share one module
+      const auto modulePath = ModulePath(plug.GetPath());
+      auto it = mModuleStamps.find(modulePath);
+      if(it == mModuleStamps.end())
+         it = mModuleStamps.emplace(modulePath, GetStamp(modulePath)).first;
+      writer.Write(it->second);
+   }
+
+   // Write aside and then replace, so that a partially written cache
+   // is never read
+   const auto tempPath = cachePath + wxT(".tmp");
+   const auto& buffer = writer.GetBuffer();
+   {
+      wxFFile file;
+      if(!file.Open(tempPath, wxT("wb")))
+         return;
+      if(file.Write(buffer.data(), buffer.size()) != buffer.size() ||
+         !file.Close())
+      {
+         wxRemoveFile(tempPath);
+         return;
+      }
+   }
+   if(!wxRenameFile(tempPath, cachePath, true))
+      wxRemoveFile(tempPath);
+}
+
+const PluginRegistryVersion& PluginRegistryCache::GetRegistryVersion() const noexcept
+{
+   return mVersion;
+}
+
+std::vector<PluginDescriptor> PluginRegistryCache::TakeDescriptors()
+{
+   return std::move(mDescriptors);
+}
+
+bool PluginRegistryCache::IsModuleUnchanged(const PluginPath& path) const
+{
+   const auto modulePath = ModulePath(path);
+   const auto it = mModuleStamps.find(modulePath);
+   if(it == mModuleStamps.end())
+      return false;
+   const auto stamp = GetStamp(modulePath);
+   return stamp.IsValid() && stamp == it->second;
+}
@@ -0,0 +1,88 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PluginRegistryCache.h
+
+  Part of lib-module-manager library
+
+**********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <wx/string.h>
+
+#include "PluginDescriptor.h"
+
+/**
+ * \brief Binary copy of the plugin registry, written next to it
+ * each time the registry is saved.
+ *
+ * The text registry remains the source of truth: the cache is only used
+ * when the registry file has the same size and modification time as when
+ * the cache was written. The cache is a single flat buffer that is read in
+ * one go, instead of parsing the text file group by group.
+ *
+ * It also remembers the size and modification time of each plugin module,
+ * so that the existence of unchanged modules need not be verified by
+ * their providers again.
+ */
+class MODULE_MANAGER_API PluginRegistryCache final
+{
+public:
+   struct FileStamp final
+   {
+      //! Negative if the file does not exist
+      int64_t size { -1 };
+      int64_t modified { 0 };
+
+      bool IsValid() const noexcept { return size >= 0; }
+
+      bool operator==(const FileStamp& other) const noexcept
+      {
+         return size == other.size && modified == other.modified;
+      }
+      bool operator!=(const FileStamp& other) const noexcept
+      {
+         return !(*this == other);
+      }
+   };
+
+   //! Stamp of a file or directory
+   static FileStamp GetStamp(const wxString& path);
+
+   static wxString GetCachePath(const wxString& registryPath);
+
+   //! Reads the cache, if it was written for the current registry file
+   /*!
+    * @return false if there is no cache or it is out of date
+    */
+   bool Load(const wxString& registryPath);
+
+   //! Writes the cache for the registry file that was just saved
+   /*!
+    * Only the plugin types restored from the text registry are written
+    */
+   void Save(const wxString& registryPath,
+      const PluginRegistryVersion& version,
+      const std::map<PluginID, PluginDescriptor>& plugins);
+
+   const PluginRegistryVersion& GetRegistryVersion() const noexcept;
+
+   //! Moves out descriptors read by Load
+   std::vector<PluginDescriptor> TakeDescriptors();
+
+   //! Whether the module was there and is unchanged since the cache was
+   //! written
+   bool IsModuleUnchanged(const PluginPath& path) const;
+
+private:
+   PluginRegistryVersion mVersion;
+   std::vector<PluginDescriptor> mDescriptors;
+   std::unordered_map<wxString, FileStamp> mModuleStamps;
+};
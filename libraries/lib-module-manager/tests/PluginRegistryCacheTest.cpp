@@ -0,0 +1,237 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PluginRegistryCacheTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "PluginRegistryCache.h"
+
+#include <chrono>
+#include <iostream>
+
+#include <wx/fileconf.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/utils.h>
+
+namespace
+{
+//! A registry file in the temporary directory, removed with its cache
+struct TempRegistry final
+{
+   TempRegistry()
+       : path { wxFileName(
+                   wxFileName::GetTempDir(),
+                   wxString::Format("pluginregistry-%lu.cfg", wxGetProcessId()))
+                   .GetFullPath() }
+   {
+      Remove();
+   }
+
+   ~TempRegistry()
+   {
+      Remove();
+   }
+
+   void Remove() const
+   {
+      for (const auto& file : { path, PluginRegistryCache::GetCachePath(path) })
+         if (wxFileExists(file))
+            wxRemoveFile(file);
+   }
+
+   const wxString path;
+};
+
+const wxString Provider = "Module_test";
+
+std::map<PluginID, PluginDescriptor> MakeEffects(size_t count)
+{
+   std::map<PluginID, PluginDescriptor> plugins;
+
+   for (size_t ii = 0; ii < count; ++ii)
+   {
+      PluginDescriptor plug;
+      const auto number = static_cast<unsigned long>(ii);
+      const auto id = wxString::Format("Effect_test_%lu", number);
+      plug.SetPluginType(PluginTypeEffect);
+      plug.SetID(id);
+      plug.SetProviderID(Provider);
+      plug.SetPath(wxString::Format("/plug-ins/effect%lu.so", number));
+      plug.SetSymbol(wxString::Format("Effect %lu", number));
+      plug.SetVersion("1.0");
+      plug.SetVendor("Vendor");
+      plug.SetEnabled(ii % 3 != 0);
+      plug.SetValid(true);
+      plug.SetEffectType(EffectTypeProcess);
+      plug.SetEffectFamily("LV2");
+      plug.SetEffectDefault(false);
+      plug.SetEffectInteractive(ii % 2 == 0);
+      plug.SetEffectAutomatable(true);
+      plugins.emplace(id, std::move(plug));
+   }
+
+   return plugins;
+}
+
+//! Writes the groups that PluginManager::SaveGroup writes for effects
+void WriteTextRegistry(
+   const wxString& path, const std::map<PluginID, PluginDescriptor>& plugins)
+{
+   wxFileConfig config { wxEmptyString, wxEmptyString, path, wxEmptyString,
+                         wxCONFIG_USE_LOCAL_FILE };
+
+   for (const auto& [id, plug] : plugins)
+   {
+      config.SetPath("/pluginregistry/Effect/" + id);
+      config.Write("ProviderID", plug.GetProviderID());
+      config.Write("Path", plug.GetPath());
+      config.Write("Symbol", plug.GetSymbol().Internal());
+      config.Write("Name", plug.GetSymbol().Internal());
+      config.Write("Version", plug.GetUntranslatedVersion());
+      config.Write("Vendor", plug.GetVendor());
+      config.Write("Description", wxString {});
+      config.Write("LastUpdated", wxString {});
+      config.Write("Enabled", plug.IsEnabled());
+      config.Write("Valid", plug.IsValid());
+      config.Write("EffectType", "Process");
+      config.Write("EffectFamily", plug.GetEffectFamily());
+      config.Write("EffectDefault", plug.IsEffectDefault());
+      config.Write("EffectInteractive", plug.IsEffectInteractive());
+      config.Write("EffectRealtime", plug.SerializeRealtimeSupport());
+      config.Write("EffectAutomatable", plug.IsEffectAutomatable());
+   }
+   config.SetPath("/");
+   config.Write("/pluginregistryversion", "1.3");
+   config.Flush();
+}
+
+//! Reads the keys that PluginManager::LoadGroup reads for effects
+size_t ReadTextRegistry(const wxString& path)
+{
+   wxFileConfig config { wxEmptyString, wxEmptyString, path, wxEmptyString,
+                         wxCONFIG_USE_LOCAL_FILE };
+
+   size_t count = 0;
+   const wxString cfgPath = "/pluginregistry/Effect/";
+   wxString groupName;
+   long groupIndex;
+   config.SetPath(cfgPath);
+   for (bool cont = config.GetFirstGroup(groupName, groupIndex); cont;
+        config.SetPath(cfgPath),
+             cont = config.GetNextGroup(groupName, groupIndex))
+   {
+      config.SetPath(groupName);
+      PluginDescriptor plug;
+      wxString strVal;
+      bool boolVal;
+      plug.SetID(groupName);
+      plug.SetPluginType(PluginTypeEffect);
+      config.Read("ProviderID", &strVal);
+      plug.SetProviderID(strVal);
+      config.Read("Path", &strVal);
+      plug.SetPath(strVal);
+      config.Read("Symbol", &strVal);
+      plug.SetSymbol(strVal);
+      config.Read("Version", &strVal);
+      plug.SetVersion(strVal);
+      config.Read("Vendor", &strVal);
+      plug.SetVendor(strVal);
+      config.Read("Enabled", &boolVal);
+      plug.SetEnabled(boolVal);
+      config.Read("Valid", &boolVal);
+      plug.SetValid(boolVal);
+      config.Read("EffectType", &strVal);
+      plug.SetEffectType(EffectTypeProcess);
+      config.Read("EffectFamily", &strVal);
+      plug.SetEffectFamily(strVal);
+      config.Read("EffectDefault", &boolVal);
+      plug.SetEffectDefault(boolVal);
+      config.Read("EffectInteractive", &boolVal);
+      plug.SetEffectInteractive(boolVal);
+      config.Read("EffectRealtime", &strVal);
+      plug.DeserializeRealtimeSupport(strVal);
+      config.Read("EffectAutomatable", &boolVal);
+      plug.SetEffectAutomatable(boolVal);
+      ++count;
+   }
+
+   return count;
+}
+} // namespace
+
+TEST_CASE("PluginRegistryCache", "[PluginRegistryCache]")
+{
+   TempRegistry registry;
+   const auto plugins = MakeEffects(100);
+   WriteTextRegistry(registry.path, plugins);
+
+   PluginRegistryCache cache;
+   cache.Save(registry.path, "1.3", plugins);
+
+   SECTION("Descriptors are restored as saved")
+   {
+      PluginRegistryCache loaded;
+      REQUIRE(loaded.Load(registry.path));
+      REQUIRE(loaded.GetRegistryVersion() == "1.3");
+
+      const auto descriptors = loaded.TakeDescriptors();
+      REQUIRE(descriptors.size() == plugins.size());
+      for (const auto& plug : descriptors)
+      {
+         const auto& saved = plugins.at(plug.GetID());
+         REQUIRE(plug.GetPluginType() == PluginTypeEffect);
+         REQUIRE(plug.GetProviderID() == Provider);
+         REQUIRE(plug.GetPath() == saved.GetPath());
+         REQUIRE(plug.GetSymbol() == saved.GetSymbol());
+         REQUIRE(plug.IsEnabled() == saved.IsEnabled());
+         REQUIRE(plug.IsEffectInteractive() == saved.IsEffectInteractive());
+      }
+   }
+
+   SECTION("A cache for another state of the registry is not used")
+   {
+      {
+         wxFileConfig config { wxEmptyString, wxEmptyString, registry.path,
+                               wxEmptyString, wxCONFIG_USE_LOCAL_FILE };
+         config.Write("/pluginregistry/Effect/Added/Path", "/added.so");
+         config.Flush();
+      }
+
+      PluginRegistryCache loaded;
+      REQUIRE(!loaded.Load(registry.path));
+      REQUIRE(loaded.TakeDescriptors().empty());
+   }
+}
+
+// Hidden: run explicitly with the "[benchmark]" tag
+TEST_CASE("Restore 5,000 plug-ins", "[.][benchmark]")
+{
+   using Clock = std::chrono::steady_clock;
+   constexpr size_t numPlugins = 5000;
+
+   TempRegistry registry;
+   const auto plugins = MakeEffects(numPlugins);
+   WriteTextRegistry(registry.path, plugins);
+   PluginRegistryCache {}.Save(registry.path, "1.3", plugins);
+
+   auto start = Clock::now();
+   REQUIRE(ReadTextRegistry(registry.path) == numPlugins);
+   const auto textTime = Clock::now() - start;
+
+   start = Clock::now();
+   PluginRegistryCache cache;
+   REQUIRE(cache.Load(registry.path));
+   REQUIRE(cache.TakeDescriptors().size() == numPlugins);
+   const auto cacheTime = Clock::now() - start;
+
+   using namespace std::chrono;
+   std::cout << "Restore " << numPlugins << " plug-ins from the text registry: "
+             << duration_cast<milliseconds>(textTime).count() << " ms\n"
+             << "From the binary cache: "
+             << duration_cast<milliseconds>(cacheTime).count() << " ms\n";
+}
@@ -154,6 +154,55 @@ private:
    wxFile mFile;
    wxFileName mFileName;
 };
+
+class StreamPart final : public MultipartData::Part
+{
+public:
+   explicit StreamPart(std::shared_ptr<StreamingPayload> payload)
+       : mPayload(std::move(payload))
+   {
+   }
+
+   int64_t GetSize() const override
+   {
+      // Size is unknown
+      return -1;
+   }
+
+   size_t GetOffset() const override
+   {
+      return mOffset;
+   }
+
+   size_t Read(void* buffer, size_t maxBytes) override
+   {
+      const auto bytesRead = mPayload->Read(buffer, maxBytes);
+      mOffset += bytesRead;
+      return bytesRead;
+   }
+
+   bool Seek(int64_t offset, int origin) override
+   {
+      // The data is consumed on read, so only a no-op rewind
+      // of the part that was not read yet is possible
+      return offset == 0 && mOffset == 0 &&
+             (origin == SEEK_SET || origin == SEEK_CUR);
+   }
+
+   bool IsAborted() const override
+   {
+      return mPayload->IsAborted();
+   }
+
+private:
+   std::shared_ptr<StreamingPayload> mPayload;
+   size_t mOffset { 0 };
+};
+}
+
+bool MultipartData::Part::IsAborted() const
+{
+   return false;
 }
 
 void MultipartData::Part::SetHeader(
@@ -208,6 +257,20 @@ void MultipartData::AddFile(
       mParts.back()->SetContentType(std::string(contentType));
 }
 
+void MultipartData::AddStream(
+   std::string_view name, std::string_view contentType,
+   std::string_view fileName, std::shared_ptr<StreamingPayload> payload)
+{
+   mParts.emplace_back(std::make_unique<StreamPart>(std::move(payload)));
+
+   mParts.back()->SetContentDisposition(
+      "form-data; name=\"" + std::string(name) + "\"; filename=\"" +
+      std::string(fileName) + "\"");
+
+   if (!contentType.empty())
+      mParts.back()->SetContentType(std::string(contentType));
+}
+
 size_t MultipartData::GetPartsCount() const
 {
    return mParts.size();
@@ -18,6 +18,7 @@
 #include <wx/filename.h>
 
 #include "HeadersList.h"
+#include "StreamingPayload.h"
 
 namespace audacity
 {
@@ -45,6 +46,10 @@ public:
       virtual size_t Read(void* buffer, size_t maxBytes) = 0;
       virtual bool Seek(int64_t offset, int origin = SEEK_SET) = 0;
 
+      //! Returns true if the part can no longer provide data
+      //! and the transfer must be cancelled
+      virtual bool IsAborted() const;
+
       const HeadersList& GetHeaders() const;
    private:
       HeadersList mHeaders;
@@ -57,6 +62,15 @@ public:
 
    void AddFile(std::string_view name, std::string_view contentType, const wxFileName& fileName);
 
+   //! Adds a part of unknown size, which is read while it is being produced
+   /*!
+      The request is sent using the chunked transfer encoding.
+      The part can only be read once.
+    */
+   void AddStream(
+      std::string_view name, std::string_view contentType,
+      std::string_view fileName, std::shared_ptr<StreamingPayload> payload);
+
    size_t GetPartsCount() const;
 
    Part* GetPart(size_t idx);
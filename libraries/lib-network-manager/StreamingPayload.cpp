@@ -0,0 +1,130 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file StreamingPayload.cpp
+ @brief Define a bounded byte pipe used to upload data while it is produced.
+
+ **********************************************************************/
+
+#include "StreamingPayload.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace audacity
+{
+namespace network_manager
+{
+StreamingPayload::StreamingPayload(size_t capacity)
+    : mBuffer(std::max<size_t>(capacity, 1))
+{
+}
+
+bool StreamingPayload::Write(const void* data, size_t size)
+{
+   auto bytes = static_cast<const uint8_t*>(data);
+
+   std::unique_lock<std::mutex> lock(mMutex);
+
+   while (size > 0)
+   {
+      mCanWrite.wait(
+         lock, [this] { return mAborted || mAvailable < mBuffer.size(); });
+
+      if (mAborted || mFinished)
+         return false;
+
+      const auto capacity = mBuffer.size();
+      const auto writePosition = (mReadPosition + mAvailable) % capacity;
+      const auto chunk = std::min(
+         { size, capacity - mAvailable, capacity - writePosition });
+
+      std::memcpy(mBuffer.data() + writePosition, bytes, chunk);
+
+      mAvailable += chunk;
+      mBytesWritten += chunk;
+      bytes += chunk;
+      size -= chunk;
+
+      mCanRead.notify_one();
+   }
+
+   return true;
+}
+
+void StreamingPayload::Finish()
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFinished = true;
+   }
+
+   mCanRead.notify_all();
+}
+
+void StreamingPayload::Abort()
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mAborted = true;
+   }
+
+   mCanRead.notify_all();
+   mCanWrite.notify_all();
+}
+
+size_t StreamingPayload::Read(void* buffer, size_t maxBytes)
+{
+   auto bytes = static_cast<uint8_t*>(buffer);
+
+   std::unique_lock<std::mutex> lock(mMutex);
+
+   mCanRead.wait(
+      lock, [this] { return mAborted || mFinished || mAvailable > 0; });
+
+   if (mAborted)
+      return 0;
+
+   const auto capacity = mBuffer.size();
+   size_t bytesRead = 0;
+
+   // Drain up to two contiguous regions of the ring buffer
+   while (bytesRead < maxBytes && mAvailable > 0)
+   {
+      const auto chunk = std::min(
+         { maxBytes - bytesRead, mAvailable, capacity - mReadPosition });
+
+      std::memcpy(bytes + bytesRead, mBuffer.data() + mReadPosition, chunk);
+
+      mReadPosition = (mReadPosition + chunk) % capacity;
+      mAvailable -= chunk;
+      bytesRead += chunk;
+   }
+
+   mBytesRead += bytesRead;
+
+   mCanWrite.notify_one();
+
+   return bytesRead;
+}
+
+bool StreamingPayload::IsAborted() const
+{
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mAborted;
+}
+
+uint64_t StreamingPayload::GetBytesWritten() const
+{
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mBytesWritten;
+}
+
+uint64_t StreamingPayload::GetBytesRead() const
+{
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mBytesRead;
+}
+}
+}
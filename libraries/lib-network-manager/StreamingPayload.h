@@ -0,0 +1,79 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file StreamingPayload.h
+ @brief Declare a bounded byte pipe used to upload data while it is produced.
+
+ **********************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "NetworkManagerApi.h"
+
+namespace audacity
+{
+namespace network_manager
+{
+//! A single producer, single consumer bounded byte pipe
+/*!
+   The producer (for example an encoder) calls Write() and blocks while
+   the buffer is full, so the pace of the producer follows the pace of the
+   network. The consumer (the network thread) calls Read(), which blocks
+   until data is available and returns 0 once the producer has called
+   Finish() and the buffer is drained.
+
+   Either side may call Abort(): pending and future calls on both ends
+   return immediately.
+ */
+class NETWORK_MANAGER_API StreamingPayload final
+{
+public:
+   static constexpr size_t DefaultCapacity = 4 * 1024 * 1024;
+
+   explicit StreamingPayload(size_t capacity = DefaultCapacity);
+
+   StreamingPayload(const StreamingPayload&) = delete;
+   StreamingPayload& operator=(const StreamingPayload&) = delete;
+
+   //! Appends data, blocking while the buffer is full
+   //! @return false if the payload was aborted
+   bool Write(const void* data, size_t size);
+   //! Signals that no more data will be written
+   void Finish();
+   //! Signals that the transfer must be cancelled
+   void Abort();
+
+   //! Reads up to maxBytes, blocking until some data is available
+   //! @return 0 when the payload is finished or aborted
+   size_t Read(void* buffer, size_t maxBytes);
+
+   bool IsAborted() const;
+   //! Total number of bytes accepted by Write()
+   uint64_t GetBytesWritten() const;
+   //! Total number of bytes returned by Read()
+   uint64_t GetBytesRead() const;
+
+private:
+   mutable std::mutex mMutex;
+   std::condition_variable mCanRead;
+   std::condition_variable mCanWrite;
+
+   std::vector<uint8_t> mBuffer;
+   size_t mReadPosition { 0 };
+   size_t mAvailable { 0 };
+
+   uint64_t mBytesWritten { 0 };
+   uint64_t mBytesRead { 0 };
+
+   bool mFinished { false };
+   bool mAborted { false };
+};
+}
+}
@@ -107,7 +107,12 @@ int DataStreamSeek (DataStream* stream, curl_off_t offs, int origin) noexcept
 
 size_t MimePartRead(char* ptr, size_t size, size_t nmemb, MultipartData::Part* stream)
 {
-   return stream->Read(ptr, size * nmemb);
+   const auto bytesRead = stream->Read(ptr, size * nmemb);
+
+   if (bytesRead == 0 && stream->IsAborted())
+      return CURL_READFUNC_ABORT;
+
+   return bytesRead;
 }
 
 int MimePartSeek(MultipartData::Part* stream, curl_off_t offs, int origin) noexcept
@@ -0,0 +1,401 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file LocalHttpServer.cpp
+ @brief Define a minimal HTTP server, standing in for remote services in tests.
+
+ **********************************************************************/
+
+#include "LocalHttpServer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+#ifdef _WIN32
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#else
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+namespace audacity::network_manager::test
+{
+namespace
+{
+#ifdef _WIN32
+using Socket = SOCKET;
+
+struct WinsockInit final
+{
+   WinsockInit()
+   {
+      WSADATA data;
+      WSAStartup(MAKEWORD(2, 2), &data);
+   }
+
+   ~WinsockInit()
+   {
+      WSACleanup();
+   }
+};
+#else
+using Socket = int;
+constexpr Socket INVALID_SOCKET = -1;
+
+int closesocket(Socket socket)
+{
+   return close(socket);
+}
+#endif
+
+Socket ToSocket(intptr_t socket)
+{
+   return static_cast<Socket>(socket);
+}
+
+bool SendAll(Socket socket, const std::string& data)
+{
+   size_t sent = 0;
+
+   while (sent < data.size())
+   {
+      const auto result = send(
+         socket, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+
+      if (result <= 0)
+         return false;
+
+      sent += result;
+   }
+
+   return true;
+}
+
+//! Buffered reading from a connection
+class Reader final
+{
+public:
+   explicit Reader(Socket socket)
+       : mSocket(socket)
+   {
+   }
+
+   //! Reads a line and removes its CRLF
+   bool ReadLine(std::string& line)
+   {
+      while (true)
+      {
+         const auto end = mBuffer.find("\r\n");
+
+         if (end != std::string::npos)
+         {
+            line = mBuffer.substr(0, end);
+            mBuffer.erase(0, end + 2);
+            return true;
+         }
+
+         if (!Fill())
+            return false;
+      }
+   }
+
+   bool ReadBytes(size_t count, std::string& result)
+   {
+      while (mBuffer.size() < count)
+         if (!Fill())
+            return false;
+
+      result.append(mBuffer, 0, count);
+      mBuffer.erase(0, count);
+      return true;
+   }
+
+private:
+   bool Fill()
+   {
+      char buffer[16384];
+      const auto result = recv(mSocket, buffer, sizeof(buffer), 0);
+
+      if (result <= 0)
+         return false;
+
+      mBuffer.append(buffer, result);
+      return true;
+   }
+
+   const Socket mSocket;
+   std::string mBuffer;
+};
+
+std::string ToLower(std::string value)
+{
+   std::transform(
+      value.begin(), value.end(), value.begin(),
+      [](unsigned char c) { return std::tolower(c); });
+   return value;
+}
+
+std::string Trim(const std::string& value)
+{
+   const auto first = value.find_first_not_of(" \t");
+
+   if (first == std::string::npos)
+      return {};
+
+   return value.substr(first, value.find_last_not_of(" \t") - first + 1);
+}
+
+bool ReadBody(Reader& reader, LocalHttpServer::Request& request)
+{
+   const auto encoding = request.headers.find("transfer-encoding");
+
+   if (
+      encoding != request.headers.end() &&
+      ToLower(encoding->second).find("chunked") != std::string::npos)
+   {
+      while (true)
+      {
+         std::string line;
+
+         if (!reader.ReadLine(line))
+            return false;
+
+         // Chunk extensions are ignored
+         const auto size = std::strtoull(line.c_str(), nullptr, 16);
+
+         if (size == 0)
+            break;
+
+         std::string crlf;
+
+         if (
+            !reader.ReadBytes(size, request.body) ||
+            !reader.ReadBytes(2, crlf))
+            return false;
+
+         ++request.chunks;
+      }
+
+      // Skip the trailer
+      std::string line;
+
+      do
+      {
+         if (!reader.ReadLine(line))
+            return false;
+      } while (!line.empty());
+
+      return true;
+   }
+
+   const auto length = request.headers.find("content-length");
+
+   if (length == request.headers.end())
+      return true;
+
+   return reader.ReadBytes(
+      std::strtoull(length->second.c_str(), nullptr, 10), request.body);
+}
+
+const char* ReasonPhrase(unsigned code)
+{
+   switch (code)
+   {
+   case 200:
+      return "OK";
+   case 201:
+      return "Created";
+   case 204:
+      return "No Content";
+   case 400:
+      return "Bad Request";
+   case 401:
+      return "Unauthorized";
+   case 404:
+      return "Not Found";
+   case 422:
+      return "Unprocessable Entity";
+   default:
+      return "Status";
+   }
+}
+} // namespace
+
+LocalHttpServer::LocalHttpServer(Handler handler)
+    : mHandler(std::move(handler))
+{
+#ifdef _WIN32
+   static WinsockInit winsockInit;
+#endif
+
+   const auto listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+   if (listener == INVALID_SOCKET)
+      throw std::runtime_error("Failed to create a socket");
+
+   mListener = static_cast<intptr_t>(listener);
+
+   sockaddr_in address {};
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   // Let the system choose a free port
+   address.sin_port = 0;
+
+   socklen_t addressLength = sizeof(address);
+
+   if (
+      bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+         0 ||
+      listen(listener, 8) != 0 ||
+      getsockname(
+         listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0)
+   {
+      closesocket(listener);
+      throw std::runtime_error("Failed to listen on the loopback interface");
+   }
+
+   mPort = ntohs(address.sin_port);
+
+   mThread = std::thread([this] { Run(); });
+}
+
+LocalHttpServer::~LocalHttpServer()
+{
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+   }
+
+   // Wake the pending accept() with a connection of our own
+   const auto waker = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+   if (waker != INVALID_SOCKET)
+   {
+      sockaddr_in address {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = htons(mPort);
+
+      connect(waker, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+      closesocket(waker);
+   }
+
+   mThread.join();
+   closesocket(ToSocket(mListener));
+}
+
+std::string LocalHttpServer::GetUrl() const
+{
+   return "http://127.0.0.1:" + std::to_string(mPort);
+}
+
+std::vector<LocalHttpServer::Request> LocalHttpServer::GetRequests() const
+{
+   std::lock_guard<std::mutex> lock(mMutex);
+   return mRequests;
+}
+
+bool LocalHttpServer::WaitForRequests(
+   size_t count, std::chrono::milliseconds timeout) const
+{
+   std::unique_lock<std::mutex> lock(mMutex);
+   return mRequestReceived.wait_for(
+      lock, timeout, [&] { return mRequests.size() >= count; });
+}
+
+void LocalHttpServer::Run()
+{
+   while (true)
+   {
+      const auto connection = accept(ToSocket(mListener), nullptr, nullptr);
+
+      {
+         std::lock_guard<std::mutex> lock(mMutex);
+
+         if (mStop)
+         {
+            if (connection != INVALID_SOCKET)
+               closesocket(connection);
+            return;
+         }
+      }
+
+      if (connection == INVALID_SOCKET)
+         continue;
+
+      Serve(static_cast<intptr_t>(connection));
+      closesocket(connection);
+   }
+}
+
+void LocalHttpServer::Serve(intptr_t connection)
+{
+   const auto client = ToSocket(connection);
+   Reader reader(client);
+   Request request;
+
+   std::string line;
+
+   if (!reader.ReadLine(line) || line.empty())
+      return;
+
+   {
+      const auto methodEnd = line.find(' ');
+      const auto targetEnd = line.find(' ', methodEnd + 1);
+
+      if (methodEnd == std::string::npos || targetEnd == std::string::npos)
+         return;
+
+      request.method = line.substr(0, methodEnd);
+      request.target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+   }
+
+   while (reader.ReadLine(line) && !line.empty())
+   {
+      const auto colon = line.find(':');
+
+      if (colon != std::string::npos)
+         request.headers[ToLower(line.substr(0, colon))] =
+            Trim(line.substr(colon + 1));
+   }
+
+   // curl waits a while for this before sending large or chunked bodies
+   if (const auto expect = request.headers.find("expect");
+       expect != request.headers.end() &&
+       ToLower(expect->second) == "100-continue")
+      SendAll(client, "HTTP/1.1 100 Continue\r\n\r\n");
+
+   request.complete = ReadBody(reader, request);
+
+   Response response;
+
+   if (request.complete)
+      response = mHandler(request);
+
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRequests.push_back(request);
+   }
+   mRequestReceived.notify_all();
+
+   if (!request.complete)
+      return;
+
+   std::string head = "HTTP/1.1 " + std::to_string(response.code) + " " +
+                      ReasonPhrase(response.code) + "\r\n";
+
+   if (!response.body.empty())
+      head += "Content-Type: " + response.contentType + "\r\n";
+
+   head += "Content-Length: " + std::to_string(response.body.size()) +
+           "\r\nConnection: close\r\n\r\n";
+
+   SendAll(client, head + response.body);
+}
+} // namespace audacity::network_manager::test
@@ -0,0 +1,87 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file LocalHttpServer.h
+ @brief Declare a minimal HTTP server, standing in for remote services in tests.
+
+ **********************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace audacity::network_manager::test
+{
+//! An HTTP/1.1 server on the loopback interface
+/*!
+   Connections are served one at a time, on a thread of the server, and each
+   is closed after one request.
+ */
+class LocalHttpServer final
+{
+public:
+   struct Request
+   {
+      std::string method;
+      std::string target;
+      //! Names are in lower case
+      std::map<std::string, std::string> headers;
+      //! With the chunked transfer encoding removed
+      std::string body;
+      //! Number of chunks, not counting the last one, if the body was chunked
+      size_t chunks { 0 };
+      //! False if the client closed the connection before the body ended
+      bool complete { false };
+   };
+
+   struct Response
+   {
+      unsigned code { 200 };
+      std::string body;
+      std::string contentType { "application/json" };
+   };
+
+   //! Called on the thread of the server, for each complete request
+   using Handler = std::function<Response(const Request&)>;
+
+   explicit LocalHttpServer(Handler handler);
+   ~LocalHttpServer();
+
+   LocalHttpServer(const LocalHttpServer&) = delete;
+   LocalHttpServer& operator=(const LocalHttpServer&) = delete;
+
+   //! URL of the server, such as "http://127.0.0.1:40000", without a slash
+   std::string GetUrl() const;
+
+   //! Requests received so far, complete or not, in order
+   std::vector<Request> GetRequests() const;
+
+   //! @return false if fewer than count requests came within the timeout
+   bool WaitForRequests(size_t count, std::chrono::milliseconds timeout) const;
+
+private:
+   void Run();
+   void Serve(intptr_t connection);
+
+   const Handler mHandler;
+
+   intptr_t mListener;
+   uint16_t mPort { 0 };
+
+   mutable std::mutex mMutex;
+   mutable std::condition_variable mRequestReceived;
+   std::vector<Request> mRequests;
+   bool mStop { false };
+
+   std::thread mThread;
+};
+}
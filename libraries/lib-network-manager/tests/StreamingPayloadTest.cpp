@@ -0,0 +1,156 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file StreamingPayloadTest.cpp
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include "StreamingPayload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace audacity::network_manager;
+
+namespace
+{
+std::vector<uint8_t> MakeData(size_t size)
+{
+   std::vector<uint8_t> data(size);
+
+   for (size_t i = 0; i < size; ++i)
+      data[i] = static_cast<uint8_t>(i * 7 + i / 251);
+
+   return data;
+}
+} // namespace
+
+TEST_CASE("StreamingPayload", "[StreamingPayload]")
+{
+   using namespace std::chrono_literals;
+
+   SECTION("Bytes pass in order through a buffer smaller than the writes")
+   {
+      // An odd capacity, so that reads and writes wrap around in many ways
+      StreamingPayload payload(97);
+      const auto data = MakeData(1 << 20);
+
+      // Catch2 assertions are not thread safe
+      bool writesSucceeded = true;
+      std::thread producer(
+         [&]
+         {
+            size_t written = 0;
+
+            for (size_t size = 1; written < data.size(); size = size % 1000 + 13)
+            {
+               const auto chunk = std::min(size, data.size() - written);
+               writesSucceeded =
+                  payload.Write(data.data() + written, chunk) && writesSucceeded;
+               written += chunk;
+            }
+
+            payload.Finish();
+         });
+
+      std::vector<uint8_t> received;
+      std::vector<uint8_t> buffer(300);
+
+      for (size_t size = 1;; size = size % 300 + 1)
+      {
+         const auto bytesRead = payload.Read(buffer.data(), size);
+
+         if (bytesRead == 0)
+            break;
+
+         REQUIRE(bytesRead <= size);
+         received.insert(
+            received.end(), buffer.begin(), buffer.begin() + bytesRead);
+      }
+
+      producer.join();
+
+      REQUIRE(writesSucceeded);
+      REQUIRE(received == data);
+      REQUIRE(payload.GetBytesWritten() == data.size());
+      REQUIRE(payload.GetBytesRead() == data.size());
+      REQUIRE(!payload.IsAborted());
+   }
+
+   SECTION("Reads drain the buffer after Finish, then return 0")
+   {
+      StreamingPayload payload(16);
+      const auto data = MakeData(10);
+
+      REQUIRE(payload.Write(data.data(), data.size()));
+      payload.Finish();
+
+      std::vector<uint8_t> buffer(4);
+      REQUIRE(payload.Read(buffer.data(), buffer.size()) == 4);
+      REQUIRE(payload.Read(buffer.data(), buffer.size()) == 4);
+      REQUIRE(payload.Read(buffer.data(), buffer.size()) == 2);
+      REQUIRE(payload.Read(buffer.data(), buffer.size()) == 0);
+
+      // Nothing can be added any more
+      REQUIRE(!payload.Write(data.data(), 1));
+   }
+
+   SECTION("Abort releases a writer blocked on the full buffer")
+   {
+      StreamingPayload payload(16);
+      const auto data = MakeData(64);
+
+      auto writer = std::async(
+         std::launch::async,
+         [&] { return payload.Write(data.data(), data.size()); });
+
+      // The writer fills the buffer and waits
+      REQUIRE(writer.wait_for(200ms) == std::future_status::timeout);
+      REQUIRE(payload.GetBytesWritten() == 16);
+
+      payload.Abort();
+
+      REQUIRE(writer.wait_for(5s) == std::future_status::ready);
+      REQUIRE(!writer.get());
+      REQUIRE(payload.IsAborted());
+   }
+
+   SECTION("Abort releases a reader waiting for data")
+   {
+      StreamingPayload payload(16);
+
+      auto reader = std::async(
+         std::launch::async,
+         [&]
+         {
+            uint8_t buffer[8];
+            return payload.Read(buffer, sizeof(buffer));
+         });
+
+      REQUIRE(reader.wait_for(200ms) == std::future_status::timeout);
+
+      payload.Abort();
+
+      REQUIRE(reader.wait_for(5s) == std::future_status::ready);
+      REQUIRE(reader.get() == 0);
+   }
+
+   SECTION("Data not read is dropped on Abort")
+   {
+      StreamingPayload payload(16);
+      const auto data = MakeData(8);
+
+      REQUIRE(payload.Write(data.data(), data.size()));
+      payload.Abort();
+
+      uint8_t buffer[8];
+      REQUIRE(payload.Read(buffer, sizeof(buffer)) == 0);
+      REQUIRE(!payload.Write(data.data(), data.size()));
+   }
+}
@@ -0,0 +1,150 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file StreamingUploadTest.cpp
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include "LocalHttpServer.h"
+
+#include "IResponse.h"
+#include "MultipartData.h"
+#include "NetworkManager.h"
+#include "Request.h"
+#include "StreamingPayload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace audacity::network_manager;
+using namespace std::chrono_literals;
+
+namespace
+{
+std::string MakeData(size_t size)
+{
+   std::string data(size, '\0');
+
+   for (size_t i = 0; i < size; ++i)
+      data[i] = static_cast<char>(i * 7 + i / 251);
+
+   return data;
+}
+
+//! Post a form with a field and the payload, and wait for the response
+ResponsePtr PostStream(
+   const test::LocalHttpServer& server,
+   std::shared_ptr<StreamingPayload> payload)
+{
+   auto form = std::make_unique<MultipartData>();
+   form->Add("field", "value");
+   form->AddStream("file", "audio/x-wavpack", "upload.wv", std::move(payload));
+
+   auto response = NetworkManager::GetInstance().doPost(
+      Request(server.GetUrl() + "/upload"), std::move(form));
+
+   std::promise<void> finished;
+   response->setRequestFinishedCallback(
+      [&finished](auto) { finished.set_value(); });
+
+   REQUIRE(finished.get_future().wait_for(30s) == std::future_status::ready);
+   // Don't call back into the destroyed promise
+   response->setRequestFinishedCallback({});
+
+   return response;
+}
+} // namespace
+
+TEST_CASE("Streamed form parts are uploaded while written", "[StreamingPayload]")
+{
+   test::LocalHttpServer server(
+      [](const test::LocalHttpServer::Request&)
+      { return test::LocalHttpServer::Response { 204 }; });
+
+   // Much smaller than the data, so that the producer must wait for the
+   // network to read
+   auto payload = std::make_shared<StreamingPayload>(64 * 1024);
+
+   SECTION("All data is sent, in chunks")
+   {
+      const auto data = MakeData(3 * 1024 * 1024);
+
+      bool writesSucceeded = true;
+      std::thread producer(
+         [&]
+         {
+            constexpr size_t writeSize = 10000;
+
+            for (size_t written = 0; written < data.size(); written += writeSize)
+               writesSucceeded = payload->Write(
+                  data.data() + written,
+                  std::min(writeSize, data.size() - written)) && writesSucceeded;
+
+            payload->Finish();
+         });
+
+      const auto response = PostStream(server, payload);
+      producer.join();
+
+      REQUIRE(writesSucceeded);
+      REQUIRE(response->getError() == NetworkError::NoError);
+      REQUIRE(response->getHTTPCode() == 204);
+      REQUIRE(payload->GetBytesRead() == data.size());
+
+      const auto requests = server.GetRequests();
+      REQUIRE(requests.size() == 1);
+
+      const auto& request = requests[0];
+      REQUIRE(request.complete);
+      REQUIRE(request.method == "POST");
+      REQUIRE(request.headers.at("transfer-encoding") == "chunked");
+      REQUIRE(request.headers.count("content-length") == 0);
+      REQUIRE(request.chunks > 1);
+
+      // The part holds exactly the written bytes
+      const auto& body = request.body;
+      const auto disposition = body.find("filename=\"upload.wv\"");
+      REQUIRE(disposition != std::string::npos);
+      const auto start = body.find("\r\n\r\n", disposition) + 4;
+      REQUIRE(body.compare(start, data.size(), data) == 0);
+      REQUIRE(body.compare(start + data.size(), 4, "\r\n--") == 0);
+
+      REQUIRE(body.find("value") < disposition);
+   }
+
+   SECTION("Aborting the payload cancels the transfer")
+   {
+      const auto data = MakeData(100000);
+
+      std::thread producer(
+         [&]
+         {
+            payload->Write(data.data(), data.size());
+
+            // Abort only after the transfer has begun
+            while (payload->GetBytesRead() == 0)
+               std::this_thread::sleep_for(1ms);
+
+            payload->Abort();
+         });
+
+      const auto response = PostStream(server, payload);
+      producer.join();
+
+      REQUIRE(response->getError() == NetworkError::OperationCancelled);
+      REQUIRE(payload->GetBytesRead() <= data.size());
+
+      // The server saw a body that never ended
+      REQUIRE(server.WaitForRequests(1, 5s));
+      const auto requests = server.GetRequests();
+      REQUIRE(requests.size() == 1);
+      REQUIRE(!requests[0].complete);
+   }
+}
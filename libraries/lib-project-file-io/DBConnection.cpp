@@ -15,6 +15,8 @@ Paul Licameli -- split from ProjectFileIO.cpp
 
 #include <wx/string.h>
 
+#include <algorithm>
+
 #include "AudacityLogger.h"
 #include "BasicUI.h"
 #include "FileNames.h"
@@ -23,6 +25,7 @@ Paul Licameli -- split from ProjectFileIO.cpp
 #include "FileException.h"
 #include "wxFileNameWrapper.h"
 #include "SentryHelper.h"
+#include "Tracing.h"
 
 #define AUDACITY_PROJECT_PAGE_SIZE 65536
 
@@ -148,6 +151,8 @@ int DBConnection::Open(const FilePath fileName)
    mCheckpointStop = false;
    mCheckpointPending = false;
    mCheckpointActive = false;
+   mCheckpointFlush = false;
+   mCheckpointStatistics = {};
    rc = OpenStepByStep( fileName );
    if ( rc != SQLITE_OK)
    {
@@ -245,6 +250,13 @@ bool DBConnection::Close()
    // are sent our way.  (Though this shouldn't really happen.)
    sqlite3_wal_hook(mDB, nullptr, nullptr);
 
+   // Don't wait for audio to stop, to do the last checkpoint
+   {
+      std::lock_guard<std::mutex> guard(mCheckpointMutex);
+      mCheckpointFlush = true;
+      mCheckpointCondition.notify_one();
+   }
+
    // Display a progress dialog if there's active or pending checkpoints
    if (mCheckpointPending || mCheckpointActive)
    {
@@ -285,6 +297,19 @@ bool DBConnection::Close()
       mCheckpointThread.join();
    }
 
+   if (const auto stats = GetCheckpointStatistics(); stats.count > 0)
+   {
+      using namespace std::chrono;
+      wxLogInfo("Checkpoints of %s: %llu, %llu put off while audio streamed, "
+                "longest %lld ms, at most %d pages in the log",
+                sqlite3_db_filename(mDB, nullptr),
+                static_cast<unsigned long long>(stats.count),
+                static_cast<unsigned long long>(stats.deferred),
+                static_cast<long long>(
+                   duration_cast<milliseconds>(stats.maxDuration).count()),
+                stats.maxWalPages);
+   }
+
    // We're done with the prepared statements
    {
       std::lock_guard<std::mutex> guard(mStatementMutex);
@@ -484,6 +509,9 @@ void DBConnection::CheckpointThread(sqlite3 *db, const FilePath &fileName)
    int rc = SQLITE_OK;
    bool giveUp = false;
 
+   Tracing::SetThreadName("Checkpoint thread");
+
+   using namespace std::chrono;
    while (true)
    {
       {
@@ -501,6 +529,25 @@ void DBConnection::CheckpointThread(sqlite3 *db, const FilePath &fileName)
             break;
          }
 
+         // While audio streams, let the log grow for a while, so that
+         // checkpoints are fewer and compete less with recording for the
+         // disk.  The log must not grow without bound in a long recording.
+         if (!mCheckpointFlush && RealtimeIOActive::Call())
+         {
+            ++mCheckpointStatistics.deferred;
+            const auto deadline = steady_clock::now() + MaxCheckpointDelay;
+            while (!(mCheckpointStop || mCheckpointFlush ||
+                     mCheckpointStatistics.walPages >= MaxDeferredWalPages ||
+                     steady_clock::now() >= deadline ||
+                     !RealtimeIOActive::Call()))
+               mCheckpointCondition.wait_for(lock, 100ms);
+
+            if (mCheckpointStop)
+            {
+               break;
+            }
+         }
+
          // Capture the number of pages that need checkpointing and reset
          mCheckpointActive = true;
          mCheckpointPending = false;
@@ -508,7 +555,8 @@ void DBConnection::CheckpointThread(sqlite3 *db, const FilePath &fileName)
 
       // And kick off the checkpoint. This may not checkpoint ALL frames
       // in the WAL.  They'll be gotten the next time around.
-      using namespace std::chrono;
+      TRACE_ZONE("database", "Checkpoint");
+      const auto start = steady_clock::now();
       do {
          rc = giveUp ? SQLITE_OK :
             sqlite3_wal_checkpoint_v2(
@@ -519,6 +567,17 @@ void DBConnection::CheckpointThread(sqlite3 *db, const FilePath &fileName)
       // may perform reads
       while (rc == SQLITE_BUSY && (std::this_thread::sleep_for(1ms), true));
 
+      if (!giveUp)
+      {
+         const auto duration =
+            duration_cast<microseconds>(steady_clock::now() - start);
+         std::lock_guard<std::mutex> guard(mCheckpointMutex);
+         auto &stats = mCheckpointStatistics;
+         ++stats.count;
+         stats.lastDuration = duration;
+         stats.maxDuration = std::max(stats.maxDuration, duration);
+      }
+
       // Reset
       mCheckpointActive = false;
 
@@ -582,11 +641,20 @@ int DBConnection::CheckpointHook(void *data, sqlite3 *db, const char *schema, in
    // Queue the database pointer for our checkpoint thread to process
    std::lock_guard<std::mutex> guard(that->mCheckpointMutex);
    that->mCheckpointPending = true;
+   auto &stats = that->mCheckpointStatistics;
+   stats.walPages = pages;
+   stats.maxWalPages = std::max(stats.maxWalPages, pages);
    that->mCheckpointCondition.notify_one();
 
    return SQLITE_OK;
 }
 
+DBConnection::CheckpointStatistics DBConnection::GetCheckpointStatistics()
+{
+   std::lock_guard<std::mutex> guard(mCheckpointMutex);
+   return mCheckpointStatistics;
+}
+
 // Install an implementation of TransactionScope
 #include "TransactionScope.h"
 
@@ -13,6 +13,7 @@ Paul Licameli -- split from ProjectFileIO.h
 #define __AUDACITY_DB_CONNECTION__
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <map>
@@ -21,6 +22,7 @@ Paul Licameli -- split from ProjectFileIO.h
 #include <thread>
 
 #include "ClientData.h"
+#include "GlobalVariable.h"
 #include "Identifier.h"
 
 struct sqlite3;
@@ -36,11 +38,35 @@ struct DBConnectionErrors
    wxString mLog;
 };
 
-class DBConnection
+class PROJECT_FILE_IO_API DBConnection
 {
 public:
    using CheckpointFailureCallback = std::function<void()>;
 
+   //! Type of function that tells whether audio streams to or from devices
+   /*!
+    Called in the checkpoint thread.  Checkpoints are then put off, so that
+    they compete less with recording for the disk.
+    */
+   struct PROJECT_FILE_IO_API RealtimeIOActive : GlobalHook<RealtimeIOActive,
+      bool()
+   >{};
+
+   //! While audio streams, checkpoints wait at most this long...
+   static constexpr std::chrono::seconds MaxCheckpointDelay{ 10 };
+   //! ... or until the write-ahead log has this many pages (of 64 KiB)
+   static constexpr int MaxDeferredWalPages = 256;
+
+   //! Measures of the work of the checkpoint thread, for diagnosis
+   struct CheckpointStatistics {
+      size_t count{ 0 };    //!< Checkpoints done
+      size_t deferred{ 0 }; //!< Checkpoints put off while audio streamed
+      int walPages{ 0 };    //!< Pages in the write-ahead log at last commit
+      int maxWalPages{ 0 };
+      std::chrono::microseconds lastDuration{ 0 };
+      std::chrono::microseconds maxDuration{ 0 };
+   };
+
    DBConnection(
       const std::weak_ptr<AudacityProject> &pProject,
       const std::shared_ptr<DBConnectionErrors> &pErrors,
@@ -80,10 +106,14 @@ public:
       InsertSampleBlock,
       DeleteSampleBlock,
       GetSampleBlockSize,
-      GetAllSampleBlocksSize
+      GetAllSampleBlocksSize,
+      MaterializeSampleBlock
    };
    sqlite3_stmt *Prepare(enum StatementID id, const char *sql);
 
+   //! May be called from any thread
+   CheckpointStatistics GetCheckpointStatistics();
+
    void SetBypass( bool bypass );
    bool ShouldBypass();
 
@@ -117,6 +147,10 @@ private:
    std::atomic_bool mCheckpointStop{ false };
    std::atomic_bool mCheckpointPending{ false };
    std::atomic_bool mCheckpointActive{ false };
+   //! Set when closing, so that checkpoints are not put off any more
+   std::atomic_bool mCheckpointFlush{ false };
+   //! Guarded by mCheckpointMutex
+   CheckpointStatistics mCheckpointStatistics;
 
    std::mutex mStatementMutex;
    using StatementIndex = std::pair<enum StatementID, std::thread::id>;
@@ -29,8 +29,10 @@ Paul Licameli split from AudacityProject.cpp
 #include "ProjectSerializer.h"
 #include "FileNames.h"
 #include "SampleBlock.h"
+#include "StretchedClipCache.h"
 #include "TempDirectory.h"
 #include "TransactionScope.h"
+#include "UndoManager.h"
 #include "WaveTrack.h"
 #include "BasicUI.h"
 #include "wxFileNameWrapper.h"
@@ -585,6 +587,9 @@ bool ProjectFileIO::CloseConnection()
    if (!curConn)
       return false;
 
+   // Background renders may still hold sample blocks of this connection
+   StretchedClipCache::Get().Clear();
+
    if (!curConn->Close())
    {
       return false;
@@ -948,6 +953,9 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
    if (!pConn)
       return false;
 
+   // The copy must not depend on files that audio was imported from on demand
+   WaveTrackFactory::Get(mProject).GetSampleBlockFactory()->MaterializeAll();
+
    // Get access to the active tracklist
    auto pProject = &mProject;
 
@@ -1561,6 +1569,69 @@ void ProjectFileIO::Compact(
    return;
 }
 
+bool ProjectFileIO::DiscardHistoryAndCompact()
+{
+   auto &undoManager = UndoManager::Get(mProject);
+   const auto savedState = undoManager.GetSavedState();
+   const auto currentState = undoManager.GetCurrentState();
+   wxASSERT(savedState >= 0);
+   const auto least = std::min<size_t>(std::max(savedState, 0), currentState);
+   const auto greatest = std::max<size_t>(std::max(savedState, 0), currentState);
+
+   // We can remove redo states, if they are after the saved state.
+   undoManager.RemoveStates(1 + greatest, undoManager.GetNumStates());
+
+   // We can remove all states between the current and the last saved.
+   if (least < greatest)
+      undoManager.RemoveStates(least + 1, greatest);
+
+   // We can remove all states before the current and the last saved.
+   undoManager.RemoveStates(0, least);
+
+   // If the current state is also the saved one, the saved document refers to
+   // the blocks that coalescing replaces.  Hold them, in case that document
+   // can't be rewritten.
+   auto &tracks = TrackList::Get(mProject);
+   std::shared_ptr<TrackList> pSavedTracks;
+   if (!undoManager.UnsavedChanges()) {
+      pSavedTracks = TrackList::Create(nullptr);
+      for (auto pTrack : tracks)
+         pSavedTracks->Append(std::move(*pTrack->Duplicate()));
+   }
+
+   // Editing leaves small blocks behind; store the same samples in fewer
+   // blocks, so that the file has fewer rows to read and write
+   bool coalesced = false;
+   for (auto pTrack : tracks.Any<WaveTrack>())
+      coalesced = pTrack->Coalesce() || coalesced;
+   if (coalesced)
+      ProjectHistory::Get(mProject).ModifyState(true);
+
+   // Keep the blocks of all states that remain, which are the saved and the
+   // current; their indices changed above
+   std::vector<const TrackList*> trackLists;
+   undoManager.VisitStates([&](const UndoStackElem& elem) {
+      if (auto pTracks = TrackList::FindUndoTracks(elem))
+         trackLists.push_back(pTracks);
+   }, true);
+
+   bool rewritten = false;
+   if (coalesced && pSavedTracks) {
+      // Still no unsaved changes, so closing won't ask to save; make the
+      // saved document agree with the current state
+      rewritten = UpdateSaved();
+      if (!rewritten) {
+         // Coalescing changed no samples, so the old document is still
+         // right, if its blocks are kept and the autosave doesn't replace it
+         trackLists.push_back(pSavedTracks.get());
+         (void) AutoSaveDelete();
+      }
+   }
+
+   Compact(trackLists, true);
+   return rewritten;
+}
+
 bool ProjectFileIO::WasCompacted()
 {
    return mWasCompacted;
@@ -2163,6 +2234,12 @@ bool ProjectFileIO::UpdateSaved(const TrackList *tracks)
 bool ProjectFileIO::SaveProject(
    const FilePath &fileName, const TrackList *lastSaved)
 {
+   // A saved project must not depend on files that audio was imported from
+   // on demand.  Saving may only rename the file, or write the document, and
+   // not reach CopyTo(), so copy the samples first.
+   if (HasConnection())
+      WaveTrackFactory::Get(mProject).GetSampleBlockFactory()->MaterializeAll();
+
    // In the case where we're saving a temporary project to a permanent project,
    // we'll try to simply rename the project to save a bit of time. We then fall
    // through to the normal Save (not SaveAs) processing.
@@ -202,6 +202,17 @@ public:
    void Compact(
       const std::vector<const TrackList *> &tracks, bool force = false);
 
+   //! Discard all undo states but the current and the last saved, coalesce
+   //! small blocks of the current wave tracks, then compact the file,
+   //! keeping the blocks of the states that remain
+   /*!
+    @pre `UndoManager::GetSavedState() >= 0`
+    @return whether the saved document was rewritten with the current tracks,
+    which happens when the saved state was the current one; the caller must
+    then treat the current tracks as the last saved
+    */
+   bool DiscardHistoryAndCompact();
+
    // The last compact check did actually compact the project file if true
    bool WasCompacted();
 
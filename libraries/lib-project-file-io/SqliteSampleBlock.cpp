@@ -19,16 +19,38 @@ Paul Licameli -- split from SampleBlock.cpp and SampleBlock.h
 #include "XMLTagHandler.h"
 
 #include "SampleBlock.h" // to inherit
+#include "Tracing.h"
+#include "UndoBlockUsage.h"
 #include "UndoManager.h"
 #include "WaveTrack.h"
 
 #include "SentryHelper.h"
 #include <wx/log.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 class SqliteSampleBlockFactory;
 
+//! Columns of a row of the sampleblocks table, other than the samples and
+//! the summaries
+struct SqliteSampleBlockRow {
+   //! May include DeferredFormatFlag
+   int sampleFormat;
+   double sumMin;
+   double sumMax;
+   double sumRms;
+   size_t sampleBytes;
+};
+
 ///\brief Implementation of @ref SampleBlock using Sqlite database
 class SqliteSampleBlock final : public SampleBlock
 {
@@ -49,9 +71,21 @@ public:
    void SetSamples(
       constSamplePtr src, size_t numsamples, sampleFormat srcformat);
 
+   //! Summarize the samples of the source, and store a reference to them
+   //! instead of the samples
+   void SetDeferred(std::shared_ptr<const SampleBlockSource> pSource);
+
+   //! Replace the stored reference with the samples it refers to
+   /*! @return false if the source can't be read */
+   bool Materialize();
+
+   //! Whether the stored row holds a reference instead of samples
+   bool IsDeferred() const;
+
    //! Numbers of bytes needed for 256 and for 64k summaries
    using Sizes = std::pair< size_t, size_t >;
-   void Commit(Sizes sizes);
+   //! Insert a row with mSamples, or else with the given reference
+   void Commit(Sizes sizes, const std::string *pReference = nullptr);
 
    void Delete();
 
@@ -82,6 +116,15 @@ public:
 private:
    bool IsSilent() const { return mBlockID <= 0; }
    void Load(SampleBlockID sbid);
+   //! Initialize from a row that was already fetched
+   void Load(SampleBlockID sbid, const SqliteSampleBlockRow &row);
+   //! Fetch the stored reference, and restore the source if possible
+   void LoadReference();
+   size_t ReadDeferred(const SampleBlockSource *pSource,
+                       samplePtr dest,
+                       sampleFormat destformat,
+                       size_t sampleoffset,
+                       size_t numsamples) const;
    bool GetSummary(float *dest,
                    size_t frameoffset,
                    size_t numframes,
@@ -129,11 +172,34 @@ private:
    double mSumMax;
    double mSumRms;
 
+   //! Guards mDeferred and mpSource, which change on the main thread while
+   //! other threads may be reading samples
+   mutable std::mutex mSourceMutex;
+   //! Whether the row holds a reference instead of samples
+   bool mDeferred{ false };
+   //! Where the samples are read from while deferred; null if the source
+   //! could not be restored when the project was reopened
+   std::shared_ptr<const SampleBlockSource> mpSource;
+
 #if defined(WORDS_BIGENDIAN)
 #error All sample block data is little endian...big endian not yet supported
 #endif
 };
 
+// Rows of deferred blocks store this flag with the sample format, and in place
+// of samples, their count and a serialized SampleBlockSource
+static constexpr int DeferredFormatFlag = 0x40000000;
+
+[[noreturn]] static void ThrowMissingSource()
+{
+   throw SimpleMessageBoxException{
+      ExceptionType::BadEnvironment,
+      XO("Some audio could not be read, because the file it was imported from "
+         "is missing or was changed since."),
+      XO("Warning")
+   };
+}
+
 // Silent blocks use nonpositive id values to encode a length
 // and don't occupy any rows in the database; share blocks for repeatedly
 // used length values
@@ -164,10 +230,48 @@ public:
       sampleFormat srcformat,
       const AttributesList &attrs) override;
 
+   SampleBlockPtr DoCreateDeferred(
+      std::shared_ptr<const SampleBlockSource> pSource) override;
+
+   SampleBlockPtr DoCreateCopy(
+      const SampleBlockPtr &pBlock, sampleFormat format) override;
+
+   void MaterializeAll() override;
+
 private:
+   //! Copy the row of a block of another project with INSERT ... SELECT,
+   //! not decoding the samples nor summarizing them again
+   /*! @return null if the other database can't be attached, or has no row */
+   std::shared_ptr<SqliteSampleBlock> CopyRow(const SqliteSampleBlock &block);
+   //! @return the schema name of the attached database, or empty
+   std::string Attach(sqlite3 *otherDB);
+   //! Runs at idle time after pasting, so that other project files are not
+   //! held open
+   void DetachAll();
+
+   //! Start reading the rows of all blocks in a worker thread, so that the
+   //! rest of the project document is decoded meanwhile
+   void StartPrefetch();
+   //! Wait until the worker thread has read past the id
+   /*! @return empty if there is no such row, or prefetch was not started */
+   std::optional<SqliteSampleBlockRow> TakePrefetched(SampleBlockID sbid);
+   //! Runs in idle time after loading
+   void StopPrefetch();
+   //! Runs on a worker thread, with its own connection
+   void Prefetch(const std::string &path);
+
    void OnBeginPurge(size_t begin, size_t end);
    void OnEndPurge();
 
+   //! Queue a block for copying of its samples in the background
+   void AddDeferred(const std::shared_ptr<SqliteSampleBlock> &pBlock);
+   //! @return null if no deferred blocks remain
+   std::shared_ptr<SqliteSampleBlock> NextDeferred();
+   //! Runs on the main thread, copying samples of some deferred blocks
+   void MaterializeSome();
+   //! Runs on a worker thread, scheduling MaterializeSome() at intervals
+   void PaceMaterialization();
+
    friend SqliteSampleBlock;
 
    AudacityProject &mProject;
@@ -182,6 +286,47 @@ private:
    using AllBlocksMap =
       std::map< SampleBlockID, std::weak_ptr< SqliteSampleBlock > >;
    AllBlocksMap mAllBlocks;
+   //! Guards mAllBlocks, because blocks may be created on worker threads,
+   //! as during concurrent import
+   std::mutex mAllBlocksMutex;
+
+   //! Makes the insertion of a row and the fetch of its id atomic,
+   //! because sqlite3_last_insert_rowid() is per connection, not per thread
+   std::mutex mInsertMutex;
+
+   //! Guards the members that follow
+   std::mutex mDeferredMutex;
+   std::condition_variable mDeferredCondition;
+   //! Blocks that may still read their samples from elsewhere
+   std::deque<std::weak_ptr<SqliteSampleBlock>> mDeferredBlocks;
+   //! Whether MaterializeSome() is scheduled and not yet finished
+   bool mSlicePending{ false };
+   bool mStopPacing{ false };
+   //! Started with the first deferred block
+   std::thread mPacingThread;
+
+   //! Schema names of the databases of other projects, attached on the main
+   //! thread while pasting from them, by their paths
+   std::map<std::string, std::string> mAttached;
+   unsigned mAttachedCount{ 0 };
+   bool mDetachPending{ false };
+
+   //! Statistics of one prefetch, logged when it stops; used on the main
+   //! thread only
+   size_t mPrefetchHits{ 0 };
+   size_t mPrefetchMisses{ 0 };
+   std::chrono::steady_clock::duration mPrefetchWait{};
+
+   //! Guards the members that follow
+   std::mutex mPrefetchMutex;
+   std::condition_variable mPrefetchCondition;
+   //! Rows read ahead of the document, until they are taken, by block id
+   std::unordered_map<SampleBlockID, SqliteSampleBlockRow> mPrefetched;
+   //! Rows are read in increasing order of id, up to this one
+   SampleBlockID mPrefetchedThrough{ 0 };
+   bool mPrefetchDone{ false };
+   bool mStopPrefetch{ false };
+   std::thread mPrefetchThread;
 };
 
 SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
@@ -201,7 +346,17 @@ SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
       });
 }
 
-SqliteSampleBlockFactory::~SqliteSampleBlockFactory() = default;
+SqliteSampleBlockFactory::~SqliteSampleBlockFactory()
+{
+   {
+      std::lock_guard<std::mutex> lock(mDeferredMutex);
+      mStopPacing = true;
+      mDeferredCondition.notify_one();
+   }
+   if (mPacingThread.joinable())
+      mPacingThread.join();
+   StopPrefetch();
+}
 
 SampleBlockPtr SqliteSampleBlockFactory::DoCreate(
    constSamplePtr src, size_t numsamples, sampleFormat srcformat )
@@ -209,6 +364,7 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreate(
    auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
    sb->SetSamples(src, numsamples, srcformat);
    // block id has now been assigned
+   std::lock_guard<std::mutex> lock(mAllBlocksMutex);
    mAllBlocks[ sb->GetBlockID() ] = sb;
    return sb;
 }
@@ -216,6 +372,7 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreate(
 auto SqliteSampleBlockFactory::GetActiveBlockIDs() -> SampleBlockIDs
 {
    SampleBlockIDs result;
+   std::lock_guard<std::mutex> lock(mAllBlocksMutex);
    for (auto end = mAllBlocks.end(), it = mAllBlocks.begin(); it != end;) {
       if (it->second.expired())
          // Tighten up the map
@@ -268,6 +425,7 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
          }
          else {
             // First see if this block id was previously loaded
+            std::lock_guard<std::mutex> lock(mAllBlocksMutex);
             auto &wb = mAllBlocks[ nValue ];
             auto pb = wb.lock();
             if (pb)
@@ -280,9 +438,17 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
                wb = ssb;
                sb = ssb;
                ssb->mSampleFormat = srcformat;
+               StartPrefetch();
                // This may throw database errors
                // It initializes the rest of the fields
-               ssb->Load((SampleBlockID) nValue);
+               if (auto row = TakePrefetched(nValue))
+                  ssb->Load((SampleBlockID) nValue, *row);
+               else
+                  // Fetch again, reporting a missing row as before
+                  ssb->Load((SampleBlockID) nValue);
+               // Resume copying of samples that was interrupted
+               if (ssb->IsDeferred())
+                  AddDeferred(ssb);
             }
          }
          found++;
@@ -298,6 +464,406 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
    return sb;
 }
 
+void SqliteSampleBlockFactory::StartPrefetch()
+{
+   if (mPrefetchThread.joinable())
+      return;
+   const auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection)
+      return;
+   const auto path = sqlite3_db_filename(pConnection->DB(), "main");
+   if (!path || !*path)
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(mPrefetchMutex);
+      mPrefetched.clear();
+      mPrefetchedThrough = 0;
+      mPrefetchDone = false;
+      mStopPrefetch = false;
+   }
+   mPrefetchThread = std::thread(
+      [this, path = std::string{ path }]{ Prefetch(path); });
+   // The document is decoded in one pass on the main thread; stop after it
+   BasicUI::CallAfter([wThis = weak_from_this()]{
+      if (auto pThis = wThis.lock())
+         pThis->StopPrefetch();
+   });
+}
+
+std::optional<SqliteSampleBlockRow>
+SqliteSampleBlockFactory::TakePrefetched(SampleBlockID sbid)
+{
+   if (!mPrefetchThread.joinable())
+      return {};
+   const auto start = std::chrono::steady_clock::now();
+   std::unique_lock<std::mutex> lock(mPrefetchMutex);
+   mPrefetchCondition.wait(lock, [&]{
+      return mPrefetchDone || mPrefetchedThrough >= sbid;
+   });
+   mPrefetchWait += std::chrono::steady_clock::now() - start;
+   auto iter = mPrefetched.find(sbid);
+   if (iter == mPrefetched.end()) {
+      ++mPrefetchMisses;
+      return {};
+   }
+   ++mPrefetchHits;
+   auto result = iter->second;
+   mPrefetched.erase(iter);
+   return result;
+}
+
+void SqliteSampleBlockFactory::StopPrefetch()
+{
+   {
+      std::lock_guard<std::mutex> lock(mPrefetchMutex);
+      mStopPrefetch = true;
+   }
+   if (mPrefetchThread.joinable())
+      mPrefetchThread.join();
+   std::lock_guard<std::mutex> lock(mPrefetchMutex);
+   mPrefetched.clear();
+
+   // Compare with "Project loaded in ... ms" to see what the prefetch saves
+   if (mPrefetchHits + mPrefetchMisses > 0)
+      wxLogInfo(
+         "Block rows: %lld prefetched, %lld fetched singly, %lld ms waited",
+         static_cast<long long>(mPrefetchHits),
+         static_cast<long long>(mPrefetchMisses),
+         static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+               mPrefetchWait).count()));
+   mPrefetchHits = mPrefetchMisses = 0;
+   mPrefetchWait = {};
+}
+
+void SqliteSampleBlockFactory::Prefetch(const std::string &path)
+{
+   TRACE_ZONE("blocks", "SqliteSampleBlockFactory::Prefetch");
+   // Rows are handed over in batches, to take the mutex less often
+   constexpr size_t BatchSize = 256;
+
+   sqlite3 *db = nullptr;
+   sqlite3_stmt *stmt = nullptr;
+   auto cleanup = finally([&]{
+      if (stmt)
+         sqlite3_finalize(stmt);
+      if (db)
+         sqlite3_close(db);
+      std::lock_guard<std::mutex> lock(mPrefetchMutex);
+      mPrefetchDone = true;
+      mPrefetchCondition.notify_all();
+   });
+
+   // The write-ahead log lets this connection read while the main one does
+   if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr)
+          != SQLITE_OK ||
+       sqlite3_prepare_v2(db,
+          "SELECT blockid, sampleformat, summin, summax, sumrms,"
+          "       length(samples)"
+          "  FROM sampleblocks ORDER BY blockid;",
+          -1, &stmt, nullptr) != SQLITE_OK)
+      return;
+
+   std::vector<std::pair<SampleBlockID, SqliteSampleBlockRow>> batch;
+   batch.reserve(BatchSize);
+   int rc;
+   do {
+      rc = sqlite3_step(stmt);
+      if (rc == SQLITE_ROW)
+         batch.push_back({ sqlite3_column_int64(stmt, 0), {
+            sqlite3_column_int(stmt, 1),
+            sqlite3_column_double(stmt, 2),
+            sqlite3_column_double(stmt, 3),
+            sqlite3_column_double(stmt, 4),
+            static_cast<size_t>(sqlite3_column_int(stmt, 5))
+         } });
+      if (batch.size() == BatchSize || (rc != SQLITE_ROW && !batch.empty())) {
+         std::lock_guard<std::mutex> lock(mPrefetchMutex);
+         if (mStopPrefetch)
+            return;
+         mPrefetchedThrough = batch.back().first;
+         mPrefetched.insert(batch.begin(), batch.end());
+         batch.clear();
+         mPrefetchCondition.notify_all();
+      }
+   } while (rc == SQLITE_ROW);
+
+   if (rc != SQLITE_DONE)
+      wxLogDebug(wxT("SqliteSampleBlockFactory::Prefetch - SQLITE error %s"),
+         sqlite3_errmsg(db));
+}
+
+SampleBlockPtr SqliteSampleBlockFactory::DoCreateDeferred(
+   std::shared_ptr<const SampleBlockSource> pSource)
+{
+   auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
+   sb->SetDeferred(std::move(pSource));
+   {
+      std::lock_guard<std::mutex> lock(mAllBlocksMutex);
+      mAllBlocks[ sb->GetBlockID() ] = sb;
+   }
+   AddDeferred(sb);
+   return sb;
+}
+
+SampleBlockPtr SqliteSampleBlockFactory::DoCreateCopy(
+   const SampleBlockPtr &pBlock, sampleFormat format)
+{
+   auto pOther = std::dynamic_pointer_cast<SqliteSampleBlock>(pBlock);
+   if (pOther && pOther->IsSilent())
+      return DoCreateSilent(pOther->GetSampleCount(), format);
+   if (pOther && pOther->mpFactory) {
+      if (!pOther->mValid)
+         pOther->Load(pOther->mBlockID);
+      if (pOther->mSampleFormat == format) {
+         std::shared_ptr<const SampleBlockSource> pSource;
+         bool deferred = false;
+         {
+            std::lock_guard<std::mutex> lock(pOther->mSourceMutex);
+            deferred = pOther->mDeferred;
+            pSource = pOther->mpSource;
+         }
+         if (deferred) {
+            // Read from the same source, until this project copies it too
+            if (pSource)
+               return DoCreateDeferred(std::move(pSource));
+         }
+         else if (auto result = CopyRow(*pOther))
+            return result;
+      }
+   }
+   return SampleBlockFactory::DoCreateCopy(pBlock, format);
+}
+
+std::shared_ptr<SqliteSampleBlock>
+SqliteSampleBlockFactory::CopyRow(const SqliteSampleBlock &block)
+{
+   TRACE_ZONE("blocks", "SqliteSampleBlockFactory::CopyRow");
+   const auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection)
+      return nullptr;
+   const auto &pOtherConnection =
+      block.mpFactory->mppConnection->mpConnection;
+   if (!pOtherConnection)
+      return nullptr;
+   const auto schema = Attach(pOtherConnection->DB());
+   if (schema.empty())
+      return nullptr;
+
+   auto db = pConnection->DB();
+   const auto sql =
+      "INSERT INTO main.sampleblocks (sampleformat, summin, summax, sumrms,"
+      "                               summary256, summary64k, samples)"
+      "  SELECT sampleformat, summin, summax, sumrms,"
+      "         summary256, summary64k, samples"
+      "  FROM " + schema + ".sampleblocks WHERE blockid = ?1;";
+   sqlite3_stmt *stmt = nullptr;
+   auto cleanup = finally([&]{
+      if (stmt)
+         sqlite3_finalize(stmt);
+   });
+   if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK ||
+       sqlite3_bind_int64(stmt, 1, block.mBlockID) != SQLITE_OK)
+      return nullptr;
+
+   std::unique_lock<std::mutex> insertLock(mInsertMutex);
+   if (sqlite3_step(stmt) != SQLITE_DONE || sqlite3_changes(db) != 1) {
+      // Perhaps the other project has not committed the row; the caller
+      // can still copy the samples
+      wxLogDebug(wxT("SqliteSampleBlockFactory::CopyRow - SQLITE error %s"),
+         sqlite3_errmsg(db));
+      return nullptr;
+   }
+   const auto id = sqlite3_last_insert_rowid(db);
+   insertLock.unlock();
+
+   auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
+   sb->mBlockID = id;
+   sb->mSampleFormat = block.mSampleFormat;
+   sb->mSampleCount = block.mSampleCount;
+   sb->mSampleBytes = block.mSampleBytes;
+   sb->mSumMin = block.mSumMin;
+   sb->mSumMax = block.mSumMax;
+   sb->mSumRms = block.mSumRms;
+   sb->mValid = true;
+
+   std::lock_guard<std::mutex> lock(mAllBlocksMutex);
+   mAllBlocks[ id ] = sb;
+   return sb;
+}
+
+std::string SqliteSampleBlockFactory::Attach(sqlite3 *otherDB)
+{
+   const auto path = sqlite3_db_filename(otherDB, "main");
+   if (!path || !*path)
+      return {};
+   if (auto iter = mAttached.find(path); iter != mAttached.end())
+      return iter->second;
+
+   auto db = mppConnection->mpConnection->DB();
+   if (const auto ownPath = sqlite3_db_filename(db, "main");
+       ownPath && strcmp(ownPath, path) == 0)
+      return "main";
+
+   // ATTACH fails in a transaction, as while an effect runs, and at the
+   // limit of attached databases; then samples are copied the slow way
+   if (!sqlite3_get_autocommit(db) ||
+       mAttached.size() >= 4)
+      return {};
+
+   auto schema = "pasted" + std::to_string(++mAttachedCount);
+   const auto sql = "ATTACH DATABASE ?1 AS " + schema + ";";
+   sqlite3_stmt *stmt = nullptr;
+   int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+   if (rc == SQLITE_OK)
+      rc = sqlite3_bind_text(stmt, 1, path, -1, SQLITE_TRANSIENT);
+   if (rc == SQLITE_OK)
+      rc = sqlite3_step(stmt);
+   sqlite3_finalize(stmt);
+   if (rc != SQLITE_DONE) {
+      wxLogDebug(wxT("SqliteSampleBlockFactory::Attach - SQLITE error %s"),
+         sqlite3_errmsg(db));
+      return {};
+   }
+   mAttached.emplace(path, schema);
+
+   if (!mDetachPending) {
+      mDetachPending = true;
+      BasicUI::CallAfter([wThis = weak_from_this()]{
+         if (auto pThis = wThis.lock())
+            pThis->DetachAll();
+      });
+   }
+   return schema;
+}
+
+void SqliteSampleBlockFactory::DetachAll()
+{
+   mDetachPending = false;
+   const auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection) {
+      mAttached.clear();
+      return;
+   }
+   auto db = pConnection->DB();
+   for (auto iter = mAttached.begin(); iter != mAttached.end();) {
+      const auto sql = "DETACH DATABASE " + iter->second + ";";
+      if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr)
+          == SQLITE_OK)
+         iter = mAttached.erase(iter);
+      else
+         ++iter;
+   }
+   if (!mAttached.empty() && !mDetachPending) {
+      // Perhaps a transaction is open; try again later
+      mDetachPending = true;
+      BasicUI::CallAfter([wThis = weak_from_this()]{
+         if (auto pThis = wThis.lock())
+            pThis->DetachAll();
+      });
+   }
+}
+
+void SqliteSampleBlockFactory::AddDeferred(
+   const std::shared_ptr<SqliteSampleBlock> &pBlock)
+{
+   std::lock_guard<std::mutex> lock(mDeferredMutex);
+   mDeferredBlocks.push_back(pBlock);
+   if (!mPacingThread.joinable())
+      mPacingThread = std::thread([this]{ PaceMaterialization(); });
+   mDeferredCondition.notify_one();
+}
+
+std::shared_ptr<SqliteSampleBlock> SqliteSampleBlockFactory::NextDeferred()
+{
+   std::lock_guard<std::mutex> lock(mDeferredMutex);
+   while (!mDeferredBlocks.empty()) {
+      auto pBlock = mDeferredBlocks.front().lock();
+      mDeferredBlocks.pop_front();
+      // Skip blocks already deleted, or materialized before their turn
+      if (pBlock && pBlock->IsDeferred())
+         return pBlock;
+   }
+   return nullptr;
+}
+
+void SqliteSampleBlockFactory::PaceMaterialization()
+{
+   using namespace std::chrono;
+   // Each slice of work on the main thread is short, and followed by a pause,
+   // so that copying does not make the program less responsive
+   constexpr auto PauseBetweenSlices = 100ms;
+
+   std::unique_lock<std::mutex> lock(mDeferredMutex);
+   while (true) {
+      mDeferredCondition.wait(lock, [this]{
+         return mStopPacing || (!mSlicePending && !mDeferredBlocks.empty());
+      });
+      if (mStopPacing)
+         return;
+      mSlicePending = true;
+      BasicUI::CallAfter([wThis = weak_from_this()]{
+         if (auto pThis = wThis.lock())
+            pThis->MaterializeSome();
+      });
+      mDeferredCondition.wait_for(lock, PauseBetweenSlices,
+         [this]{ return mStopPacing; });
+   }
+}
+
+void SqliteSampleBlockFactory::MaterializeSome()
+{
+   using namespace std::chrono;
+   constexpr auto SliceDuration = 20ms;
+
+   auto cleanup = finally([this]{
+      std::lock_guard<std::mutex> lock(mDeferredMutex);
+      mSlicePending = false;
+      mDeferredCondition.notify_one();
+   });
+
+   // Don't write while a transaction is open, as while an effect yields to
+   // its progress dialog:  a rollback would lose the samples but not the
+   // block's belief that it has stored them
+   const auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection || !sqlite3_get_autocommit(pConnection->DB()))
+      return;
+
+   GuardedCall([this]{
+      const auto deadline = steady_clock::now() + SliceDuration;
+      do {
+         const auto pBlock = NextDeferred();
+         if (!pBlock)
+            break;
+         // A block whose source was lost is not retried; reading it reports
+         // the error
+         pBlock->Materialize();
+      } while (steady_clock::now() < deadline);
+   });
+}
+
+void SqliteSampleBlockFactory::MaterializeAll()
+{
+   size_t total = 0;
+   {
+      std::lock_guard<std::mutex> lock(mDeferredMutex);
+      total = mDeferredBlocks.size();
+   }
+   if (total == 0)
+      return;
+
+   using namespace BasicUI;
+   auto progress = MakeProgress(XO("Progress"),
+      XO("Copying audio imported on demand into the project"), 0);
+   size_t count = 0;
+   while (const auto pBlock = NextDeferred()) {
+      pBlock->Materialize();
+      if (progress)
+         progress->Poll(std::min(++count, total), total);
+   }
+}
+
 BlockSampleView SqliteSampleBlock::GetFloatSampleView()
 {
    assert(mSampleCount > 0);
@@ -413,6 +979,21 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
       return numsamples;
    }
 
+   if (!mValid)
+   {
+      Load(mBlockID);
+   }
+
+   {
+      std::unique_lock<std::mutex> lock(mSourceMutex);
+      if (mDeferred) {
+         const auto pSource = mpSource;
+         lock.unlock();
+         return ReadDeferred(
+            pSource.get(), dest, destformat, sampleoffset, numsamples);
+      }
+   }
+
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
       "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
@@ -425,6 +1006,35 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
                   numsamples * SAMPLE_SIZE(mSampleFormat)) / SAMPLE_SIZE(mSampleFormat);
 }
 
+size_t SqliteSampleBlock::ReadDeferred(const SampleBlockSource *pSource,
+                                      samplePtr dest,
+                                      sampleFormat destformat,
+                                      size_t sampleoffset,
+                                      size_t numsamples) const
+{
+   TRACE_ZONE("blocks", "SqliteSampleBlock::ReadDeferred");
+   // Like GetBlob, pad with zeroes beyond the end of the block
+   const auto offset = std::min(sampleoffset, mSampleCount);
+   const auto len = std::min(numsamples, mSampleCount - offset);
+
+   bool ok = pSource != nullptr;
+   if (ok) {
+      if (destformat == mSampleFormat)
+         ok = pSource->Read(dest, offset, len);
+      else {
+         SampleBuffer buffer(len, mSampleFormat);
+         ok = pSource->Read(buffer.ptr(), offset, len);
+         if (ok)
+            CopySamples(buffer.ptr(), mSampleFormat, dest, destformat, len);
+      }
+   }
+   if (!ok)
+      ThrowMissingSource();
+
+   ClearSamples(dest, destformat, len, numsamples - len);
+   return numsamples;
+}
+
 void SqliteSampleBlock::SetSamples(constSamplePtr src,
                                    size_t numsamples,
                                    sampleFormat srcformat)
@@ -438,6 +1048,103 @@ void SqliteSampleBlock::SetSamples(constSamplePtr src,
    Commit( sizes );
 }
 
+void SqliteSampleBlock::SetDeferred(
+   std::shared_ptr<const SampleBlockSource> pSource)
+{
+   auto sizes =
+      SetSizes(pSource->GetSampleCount(), pSource->GetSampleFormat());
+
+   // The samples are read once, only to summarize them
+   mSamples.reinit(mSampleBytes);
+   if (!pSource->Read(mSamples.get(), 0, mSampleCount))
+      ThrowMissingSource();
+   CalcSummary( sizes );
+
+   const auto reference =
+      std::to_string(mSampleCount) + '\n' + pSource->Serialize();
+   Commit( sizes, &reference );
+
+   std::lock_guard<std::mutex> lock(mSourceMutex);
+   mDeferred = true;
+   mpSource = std::move(pSource);
+}
+
+bool SqliteSampleBlock::IsDeferred() const
+{
+   std::lock_guard<std::mutex> lock(mSourceMutex);
+   return mDeferred;
+}
+
+bool SqliteSampleBlock::Materialize()
+{
+   TRACE_ZONE("blocks", "SqliteSampleBlock::Materialize");
+   std::shared_ptr<const SampleBlockSource> pSource;
+   {
+      std::lock_guard<std::mutex> lock(mSourceMutex);
+      if (!mDeferred)
+         return true;
+      pSource = mpSource;
+   }
+   if (!pSource)
+      return false;
+
+   SampleBuffer buffer(mSampleCount, mSampleFormat);
+   if (!pSource->Read(buffer.ptr(), 0, mSampleCount))
+      return false;
+
+   auto db = DB();
+   int rc;
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::MaterializeSampleBlock,
+      "UPDATE sampleblocks SET sampleformat = ?1, samples = ?2"
+      "  WHERE blockid = ?3;");
+
+   // Bind statement parameters
+   // Might return SQLITE_MISUSE which means it's our mistake that we violated
+   // preconditions; should return SQL_OK which is 0
+   if (sqlite3_bind_int(stmt, 1, static_cast<int>(mSampleFormat)) ||
+       sqlite3_bind_blob(stmt, 2, buffer.ptr(), mSampleBytes, SQLITE_STATIC) ||
+       sqlite3_bind_int64(stmt, 3, mBlockID))
+   {
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.rc", std::to_string(sqlite3_errcode(Conn()->DB())));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "SqliteSampleBlock::Materialize::bind");
+
+      wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+   }
+
+   // Execute the statement
+   rc = sqlite3_step(stmt);
+   if (rc != SQLITE_DONE)
+   {
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "SqliteSampleBlock::Materialize::step");
+
+      wxLogDebug(wxT("SqliteSampleBlock::Materialize - SQLITE error %s"),
+         sqlite3_errmsg(db));
+
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+
+      // Just showing the user a simple message, not the library error too
+      // which isn't internationalized
+      Conn()->ThrowException( true );
+   }
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
+
+   std::lock_guard<std::mutex> lock(mSourceMutex);
+   mDeferred = false;
+   mpSource.reset();
+   return true;
+}
+
 bool SqliteSampleBlock::GetSummary256(float *dest,
                                       size_t frameoffset,
                                       size_t numframes)
@@ -572,6 +1279,7 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
                                   size_t srcoffset,
                                   size_t srcbytes)
 {
+   TRACE_ZONE("blocks", "SqliteSampleBlock::GetBlob");
    auto db = DB();
 
    wxASSERT(!IsSilent());
@@ -691,6 +1399,7 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
 
 void SqliteSampleBlock::Load(SampleBlockID sbid)
 {
+   TRACE_ZONE("blocks", "SqliteSampleBlock::Load");
    auto db = DB();
    int rc;
 
@@ -742,23 +1451,104 @@ void SqliteSampleBlock::Load(SampleBlockID sbid)
    }
 
    // Retrieve returned data
+   const SqliteSampleBlockRow row{
+      sqlite3_column_int(stmt, 0),
+      sqlite3_column_double(stmt, 1),
+      sqlite3_column_double(stmt, 2),
+      sqlite3_column_double(stmt, 3),
+      static_cast<size_t>(sqlite3_column_int(stmt, 4))
+   };
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
+
+   Load(sbid, row);
+}
+
+void SqliteSampleBlock::Load(SampleBlockID sbid, const SqliteSampleBlockRow &row)
+{
+   const bool deferred = (row.sampleFormat & DeferredFormatFlag) != 0;
    mBlockID = sbid;
-   mSampleFormat = (sampleFormat) sqlite3_column_int(stmt, 0);
-   mSumMin = sqlite3_column_double(stmt, 1);
-   mSumMax = sqlite3_column_double(stmt, 2);
-   mSumRms = sqlite3_column_double(stmt, 3);
-   mSampleBytes = sqlite3_column_int(stmt, 4);
+   mSampleFormat = (sampleFormat) (row.sampleFormat & ~DeferredFormatFlag);
+   mSumMin = row.sumMin;
+   mSumMax = row.sumMax;
+   mSumRms = row.sumRms;
+   mSampleBytes = row.sampleBytes;
    mSampleCount = mSampleBytes / SAMPLE_SIZE(mSampleFormat);
 
+   if (deferred)
+      LoadReference();
+
+   mValid = true;
+}
+
+void SqliteSampleBlock::LoadReference()
+{
+   auto db = DB();
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
+      "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
+
+   if (sqlite3_bind_int64(stmt, 1, mBlockID))
+   {
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.rc", std::to_string(sqlite3_errcode(Conn()->DB())));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "SqliteSampleBlock::LoadReference::bind");
+
+      wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+   }
+
+   auto rc = sqlite3_step(stmt);
+   if (rc != SQLITE_ROW)
+   {
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "SqliteSampleBlock::LoadReference::step");
+
+      wxLogDebug(wxT("SqliteSampleBlock::LoadReference - SQLITE error %s"),
+         sqlite3_errmsg(db));
+
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+
+      Conn()->ThrowException( false );
+   }
+
+   const auto blob =
+      static_cast<const char *>(sqlite3_column_blob(stmt, 0));
+   const std::string reference(blob ? blob : "",
+      blob ? sqlite3_column_bytes(stmt, 0) : 0);
+
    // Clear statement bindings and rewind statement
    sqlite3_clear_bindings(stmt);
    sqlite3_reset(stmt);
 
-   mValid = true;
+   // The count is known even if the source is not, so that the sequence
+   // stays consistent, and reading reports the missing file
+   const auto newline = reference.find('\n');
+   mSampleCount = std::strtoull(reference.c_str(), nullptr, 10);
+   mSampleBytes = mSampleCount * SAMPLE_SIZE(mSampleFormat);
+   auto pSource = (newline == std::string::npos)
+      ? nullptr
+      : SampleBlockSource::Restorer::Call(reference.substr(newline + 1));
+   if (pSource && (pSource->GetSampleFormat() != mSampleFormat ||
+                   pSource->GetSampleCount() != mSampleCount))
+      pSource.reset();
+   if (!pSource)
+      wxLogMessage("Source of deferred sample block %lld is missing",
+         mBlockID);
+
+   std::lock_guard<std::mutex> lock(mSourceMutex);
+   mDeferred = true;
+   mpSource = std::move(pSource);
 }
 
-void SqliteSampleBlock::Commit(Sizes sizes)
+void SqliteSampleBlock::Commit(Sizes sizes, const std::string *pReference)
 {
+   TRACE_ZONE("blocks", "SqliteSampleBlock::Commit");
    const auto mSummary256Bytes = sizes.first;
    const auto mSummary64kBytes = sizes.second;
 
@@ -774,13 +1564,18 @@ void SqliteSampleBlock::Commit(Sizes sizes)
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
    // preconditions; should return SQL_OK which is 0
-   if (sqlite3_bind_int(stmt, 1, static_cast<int>(mSampleFormat)) ||
+   const auto format = static_cast<int>(mSampleFormat) |
+      (pReference ? DeferredFormatFlag : 0);
+   const void *samples = pReference
+      ? static_cast<const void*>(pReference->data()) : mSamples.get();
+   const auto sampleBytes = pReference ? pReference->size() : mSampleBytes;
+   if (sqlite3_bind_int(stmt, 1, format) ||
        sqlite3_bind_double(stmt, 2, mSumMin) ||
        sqlite3_bind_double(stmt, 3, mSumMax) ||
        sqlite3_bind_double(stmt, 4, mSumRms) ||
        sqlite3_bind_blob(stmt, 5, mSummary256.get(), mSummary256Bytes, SQLITE_STATIC) ||
        sqlite3_bind_blob(stmt, 6, mSummary64k.get(), mSummary64kBytes, SQLITE_STATIC) ||
-       sqlite3_bind_blob(stmt, 7, mSamples.get(), mSampleBytes, SQLITE_STATIC))
+       sqlite3_bind_blob(stmt, 7, samples, sampleBytes, SQLITE_STATIC))
    {
 
       ADD_EXCEPTION_CONTEXT(
@@ -791,6 +1586,8 @@ void SqliteSampleBlock::Commit(Sizes sizes)
       wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
    }
 
+   std::unique_lock<std::mutex> insertLock(mpFactory->mInsertMutex);
+
    // Execute the statement
    rc = sqlite3_step(stmt);
    if (rc != SQLITE_DONE)
@@ -811,6 +1608,7 @@ void SqliteSampleBlock::Commit(Sizes sizes)
 
    // Retrieve returned data
    mBlockID = sqlite3_last_insert_rowid(db);
+   insertLock.unlock();
 
    // Reset local arrays
    mSamples.reset();
@@ -830,6 +1628,7 @@ void SqliteSampleBlock::Commit(Sizes sizes)
 
 void SqliteSampleBlock::Delete()
 {
+   TRACE_ZONE("blocks", "SqliteSampleBlock::Delete");
    auto db = DB();
    int rc;
 
@@ -1056,33 +1855,15 @@ static size_t EstimateRemovedBlocks(
 {
    auto &manager = UndoManager::Get(project);
 
-   // Collect ids that survive
+   // Blocks of the project that may be not yet captured by any undo state
+   // also survive
    SampleBlockIDSet wontDelete;
-   auto f = [&](const UndoStackElem &elem) {
-      if (auto pTracks = TrackList::FindUndoTracks(elem))
-         InspectBlocks(*pTracks, {}, &wontDelete);
-   };
-   manager.VisitStates(f, 0, begin);
-   manager.VisitStates(f, end, manager.GetNumStates());
-   if (const auto saved = manager.GetSavedState(); saved >= 0)
-      manager.VisitStates(f, saved, saved + 1);
    InspectBlocks(TrackList::Get(project), {}, &wontDelete);
 
-   // Collect ids that won't survive (and are not negative pseudo ids)
-   SampleBlockIDSet seen, mayDelete;
-   manager.VisitStates([&](const UndoStackElem &elem) {
-      if (auto pTracks = TrackList::FindUndoTracks(elem)) {
-         InspectBlocks(*pTracks,
-            [&](const SampleBlock &block){
-               auto id = block.GetBlockID();
-               if (id > 0 && !wontDelete.count(id))
-                  mayDelete.insert(id);
-            },
-            &seen
-         );
-      }
-   }, begin, end);
-   return mayDelete.size();
+   // Reference counts of blocks among the undo states are maintained,
+   // so there is no need to visit every state
+   return UndoBlockUsage::Get(project)
+      .CountBlocksOnlyIn(manager, begin, end, wontDelete);
 }
 
 void SqliteSampleBlockFactory::OnBeginPurge(size_t begin, size_t end)
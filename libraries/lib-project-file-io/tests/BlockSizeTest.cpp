@@ -0,0 +1,184 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BlockSizeTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "MockedPrefs.h"
+#include "Project.h"
+#include "ProjectFileIO.h"
+#include "ProjectHistory.h"
+#include "SampleBlock.h"
+#include "Sequence.h"
+#include "UndoManager.h"
+#include "WaveClip.h"
+#include "WaveTrack.h"
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace {
+constexpr double Rate = 44100;
+
+FilePath TempFileName()
+{
+   const auto fileName =
+      wxFileName{ wxFileName::GetTempDir(), wxT("BlockSizeTest.aup3") }
+         .GetFullPath();
+   if (wxFileExists(fileName))
+      wxRemoveFile(fileName);
+   return fileName;
+}
+
+WaveTrack &GetTrack(AudacityProject &project)
+{
+   return **TrackList::Get(project).Any<WaveTrack>().begin();
+}
+
+//! A new project with one track of `length` samples of noise, whose blocks
+//! hold up to `bytes`
+std::shared_ptr<AudacityProject> MakeProject(
+   const FilePath &fileName, size_t bytes, size_t length)
+{
+   auto project = AudacityProject::Create();
+   auto &projectFileIO = ProjectFileIO::Get(*project);
+   projectFileIO.SetFileName(fileName);
+   REQUIRE(projectFileIO.OpenProject());
+
+   auto &trackFactory = WaveTrackFactory::Get(*project);
+   trackFactory.GetSampleBlockFactory()->SetMaxDiskBlockSize(bytes);
+   auto track = trackFactory.Create(floatSample, Rate);
+   std::vector<float> noise(length);
+   for (size_t ii = 0; ii < length; ++ii)
+      noise[ii] = ((ii * 7919) % 65536) / 65536.0f - 0.5f;
+   track->Append(
+      reinterpret_cast<constSamplePtr>(noise.data()), floatSample, length);
+   track->Flush();
+   TrackList::Get(*project).Add(track);
+   ProjectHistory::Get(*project).InitialState();
+   return project;
+}
+
+void Close(AudacityProject &project)
+{
+   auto &projectFileIO = ProjectFileIO::Get(project);
+   projectFileIO.SetBypass();
+   UndoManager::Get(project).ClearStates();
+   TrackList::Get(project).Clear();
+   REQUIRE(projectFileIO.CloseProject());
+}
+}
+
+TEST_CASE("Projects save their sample block size")
+{
+   MockedPrefs prefs;
+   REQUIRE(ProjectFileIO::InitializeSQL());
+   const auto fileName = TempFileName();
+   constexpr size_t Bytes = 256 * 1024;
+   REQUIRE(Bytes != Sequence::GetMaxDiskBlockSize());
+
+   {
+      const auto project = MakeProject(fileName, Bytes, 10 * 44100);
+      REQUIRE(GetTrack(*project).GetMaxBlockSize() == Bytes / sizeof(float));
+      REQUIRE(ProjectFileIO::Get(*project).SaveProject(fileName, nullptr));
+      Close(*project);
+   }
+
+   {
+      const auto project = AudacityProject::Create();
+      auto &projectFileIO = ProjectFileIO::Get(*project);
+      auto connection = projectFileIO.LoadProject(fileName, false);
+      REQUIRE(connection.has_value());
+      connection->Commit();
+      CHECK(WaveTrackFactory::Get(*project).GetSampleBlockFactory()
+         ->GetMaxDiskBlockSize() == Bytes);
+      CHECK(GetTrack(*project).GetMaxBlockSize() == Bytes / sizeof(float));
+      // New tracks of the project have the same blocks
+      CHECK(WaveTrackFactory::Get(*project).Create(floatSample, Rate)
+         ->GetMaxBlockSize() == Bytes / sizeof(float));
+      Close(*project);
+   }
+
+   wxRemoveFile(fileName);
+}
+
+TEST_CASE("Save, open and playback times by sample block size",
+   "[.][benchmark]")
+{
+   MockedPrefs prefs;
+   REQUIRE(ProjectFileIO::InitializeSQL());
+   const auto fileName = TempFileName();
+   constexpr size_t Length = 5 * 60 * 44100;
+   // Reads of about the size that playback makes
+   constexpr size_t ChunkSize = 65536;
+
+   using namespace std::chrono;
+   const auto time = [](auto &&action){
+      const auto start = steady_clock::now();
+      action();
+      return duration_cast<milliseconds>(steady_clock::now() - start).count();
+   };
+
+   const auto measure = [&](AudacityProject &project, const char *when){
+      auto &projectFileIO = ProjectFileIO::Get(project);
+      const auto saveMs = time([&]{
+         REQUIRE(projectFileIO.SaveProject(fileName, nullptr));
+      });
+      UndoManager::Get(project).StateSaved();
+
+      const auto readMs = time([&]{
+         auto &track = GetTrack(project);
+         std::vector<float> buffer(ChunkSize);
+         const auto end = track.TimeToLongSamples(track.GetEndTime());
+         for (sampleCount start = 0; start < end; start += ChunkSize) {
+            const auto len =
+               std::min<sampleCount>(ChunkSize, end - start).as_size_t();
+            REQUIRE(track.GetFloats(buffer.data(), start, len));
+         }
+      });
+
+      // Another project reads the same file; the blocks of undo states
+      // that it deletes as orphans are not needed any more
+      const auto openMs = time([&]{
+         const auto other = AudacityProject::Create();
+         auto connection =
+            ProjectFileIO::Get(*other).LoadProject(fileName, true);
+         REQUIRE(connection.has_value());
+         connection->Commit();
+         Close(*other);
+      });
+
+      size_t nBlocks = 0;
+      for (const auto &pClip : GetTrack(project).GetClips())
+         nBlocks += pClip->GetSequence(0)->GetBlockArray().size();
+
+      std::cout << "  " << when << ": " << nBlocks << " blocks, save "
+         << saveMs << " ms, open " << openMs << " ms, read " << readMs
+         << " ms\n";
+   };
+
+   for (size_t bytes : { 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 }) {
+      std::cout << bytes / 1024 << " KiB blocks\n";
+      const auto project = MakeProject(fileName, bytes, Length);
+      auto &track = GetTrack(*project);
+      for (int ii = 0; ii < 100; ++ii) {
+         const double t = 1.0 + ii * 2.5;
+         track.Clear(t, t + 0.01);
+         ProjectHistory::Get(*project).PushState(XO("Edit"), XO("Edit"));
+      }
+      measure(*project, "fragmented");
+      ProjectFileIO::Get(*project).DiscardHistoryAndCompact();
+      measure(*project, "coalesced");
+      Close(*project);
+      wxRemoveFile(fileName);
+   }
+}
@@ -0,0 +1,168 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CompactTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "MockedPrefs.h"
+#include "Project.h"
+#include "ProjectFileIO.h"
+#include "ProjectHistory.h"
+#include "UndoManager.h"
+#include "WaveTrack.h"
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <vector>
+
+namespace {
+constexpr double Rate = 44100;
+constexpr size_t Length = 10 * 44100;
+
+std::vector<float> GetSamples(AudacityProject &project)
+{
+   auto &tracks = TrackList::Get(project);
+   REQUIRE(tracks.Size() == 1);
+   auto &track = **tracks.Any<WaveTrack>().begin();
+   const auto length = track.TimeToLongSamples(track.GetEndTime());
+   std::vector<float> result(length.as_size_t());
+   REQUIRE(track.GetFloats(result.data(), 0, result.size()));
+   return result;
+}
+
+//! Edit in ways that leave small blocks, pushing an undo state for each
+void Edit(AudacityProject &project, int nEdits)
+{
+   auto &track = **TrackList::Get(project).Any<WaveTrack>().begin();
+   for (int ii = 0; ii < nEdits; ++ii) {
+      const std::vector<float> noise(1000, 0.01f * (ii + 1));
+      track.Set(reinterpret_cast<constSamplePtr>(noise.data()), floatSample,
+         sampleCount(200000 + 30000 * ii), noise.size());
+      track.Clear(3.0 + ii * 0.5, 3.0 + ii * 0.5 + 0.01);
+      ProjectHistory::Get(project).PushState(XO("Edit"), XO("Edit"));
+   }
+}
+
+//! Close as ProjectManager does, releasing blocks before the connection
+void Close(AudacityProject &project)
+{
+   auto &projectFileIO = ProjectFileIO::Get(project);
+   projectFileIO.SetBypass();
+   UndoManager::Get(project).ClearStates();
+   TrackList::Get(project).Clear();
+   REQUIRE(projectFileIO.CloseProject());
+}
+
+//! Duplicates of the current tracks, sharing their blocks, as
+//! ProjectFileManager holds after saving
+std::shared_ptr<TrackList> DuplicateTracks(AudacityProject &project)
+{
+   auto result = TrackList::Create(nullptr);
+   for (auto pTrack : TrackList::Get(project))
+      result->Append(std::move(*pTrack->Duplicate()));
+   return result;
+}
+
+//! Close as ProjectFileManager::CompactProjectOnClose does when there are no
+//! unsaved changes, so that nobody is asked to save
+void CloseSaved(AudacityProject &project, TrackList &lastSaved)
+{
+   REQUIRE(!UndoManager::Get(project).UnsavedChanges());
+   auto &projectFileIO = ProjectFileIO::Get(project);
+   for (auto pTrack : lastSaved.Any<WaveTrack>())
+      pTrack->CloseLock();
+   projectFileIO.Compact({ &lastSaved });
+   // Whether or not that compacted, leave no autosave for reopening to
+   // recover from, so that the saved document is read
+   (void) projectFileIO.AutoSaveDelete();
+   Close(project);
+}
+
+//! Save a project with a ramp after `nSavedEdits` edits, make `nMoreEdits`
+//! more, compact, and compare the samples after reopening
+void TestCompact(int nSavedEdits, int nMoreEdits)
+{
+   const auto fileName =
+      wxFileName{ wxFileName::GetTempDir(), wxT("CompactTest.aup3") }
+         .GetFullPath();
+   if (wxFileExists(fileName))
+      wxRemoveFile(fileName);
+
+   std::vector<float> expected;
+   {
+      const auto project = AudacityProject::Create();
+      auto &projectFileIO = ProjectFileIO::Get(*project);
+      projectFileIO.SetFileName(fileName);
+      REQUIRE(projectFileIO.OpenProject());
+
+      auto track = WaveTrackFactory::Get(*project).Create(floatSample, Rate);
+      std::vector<float> ramp(Length);
+      for (size_t ii = 0; ii < Length; ++ii)
+         ramp[ii] = float(ii) / Length;
+      track->Append(
+         reinterpret_cast<constSamplePtr>(ramp.data()), floatSample, Length);
+      track->Flush();
+      TrackList::Get(*project).Add(track);
+      ProjectHistory::Get(*project).InitialState();
+
+      Edit(*project, nSavedEdits);
+      REQUIRE(projectFileIO.SaveProject(fileName, nullptr));
+      UndoManager::Get(*project).StateSaved();
+      auto lastSaved = DuplicateTracks(*project);
+
+      Edit(*project, nMoreEdits);
+      expected = GetSamples(*project);
+
+      if (projectFileIO.DiscardHistoryAndCompact())
+         lastSaved = DuplicateTracks(*project);
+      REQUIRE(GetSamples(*project) == expected);
+      if (nMoreEdits == 0)
+         CloseSaved(*project, *lastSaved);
+      else {
+         lastSaved.reset();
+         Close(*project);
+      }
+   }
+
+   {
+      const auto project = AudacityProject::Create();
+      auto &projectFileIO = ProjectFileIO::Get(*project);
+      auto connection = projectFileIO.LoadProject(fileName, false);
+      REQUIRE(connection.has_value());
+      connection->Commit();
+      // Unsaved edits are found in the autosave; else the saved document
+      // must have the same samples
+      REQUIRE(projectFileIO.IsRecovered() == (nMoreEdits > 0));
+      REQUIRE(GetSamples(*project) == expected);
+      Close(*project);
+   }
+
+   wxRemoveFile(fileName);
+}
+}
+
+TEST_CASE("Compact after edits keeps the current samples")
+{
+   MockedPrefs prefs;
+   REQUIRE(ProjectFileIO::InitializeSQL());
+
+   SECTION("Saved at the first state")
+   {
+      TestCompact(0, 5);
+   }
+
+   SECTION("Saved after some edits")
+   {
+      TestCompact(2, 3);
+   }
+
+   SECTION("Current state is the saved state")
+   {
+      TestCompact(3, 0);
+   }
+}
@@ -0,0 +1,126 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  DBConnectionTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "DBConnection.h"
+#include "MockedPrefs.h"
+
+#include <sqlite3.h>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace std::chrono_literals;
+
+//! Wait a few seconds at most for the checkpoint thread to do something
+template<typename Predicate> bool WaitFor(const Predicate &predicate)
+{
+   const auto deadline = std::chrono::steady_clock::now() + 5s;
+   while (!predicate()) {
+      if (std::chrono::steady_clock::now() >= deadline)
+         return false;
+      std::this_thread::sleep_for(10ms);
+   }
+   return true;
+}
+
+//! Insert one row in its own transaction, so that it commits to the log
+void Insert(sqlite3 *db, const std::vector<char> &data)
+{
+   sqlite3_stmt *stmt{};
+   REQUIRE(sqlite3_prepare_v2(db,
+      "INSERT INTO rows(data) VALUES(?1);", -1, &stmt, nullptr) == SQLITE_OK);
+   sqlite3_bind_blob(
+      stmt, 1, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+   const auto rc = sqlite3_step(stmt);
+   sqlite3_finalize(stmt);
+   REQUIRE(rc == SQLITE_DONE);
+}
+
+//! Pages added to the log by one commit of Insert are at most this many
+constexpr int MaxPagesPerCommit = 8;
+}
+
+TEST_CASE("DBConnection puts off checkpoints while audio streams")
+{
+   MockedPrefs prefs;
+
+   const auto fileName =
+      wxFileName{ wxFileName::GetTempDir(), wxT("DBConnectionTest.aup3") }
+         .GetFullPath();
+   const auto walName = fileName + wxT("-wal");
+   if (wxFileExists(fileName))
+      wxRemoveFile(fileName);
+
+   std::atomic<bool> streaming{ true };
+   DBConnection::RealtimeIOActive::Scope scope{
+      [&]{ return streaming.load(); } };
+
+   DBConnection connection{
+      {}, std::make_shared<DBConnectionErrors>(), []{} };
+   REQUIRE(connection.Open(fileName) == SQLITE_OK);
+   const auto db = connection.DB();
+   REQUIRE(sqlite3_exec(db, "CREATE TABLE rows(data BLOB);",
+      nullptr, nullptr, nullptr) == SQLITE_OK);
+
+   // Most of a 64 KiB page for each row
+   const std::vector<char> data(60000, 'x');
+
+   // While audio streams, a short log is not checkpointed
+   Insert(db, data);
+   REQUIRE(WaitFor([&]{
+      return connection.GetCheckpointStatistics().deferred > 0; }));
+   std::this_thread::sleep_for(300ms);
+   REQUIRE(connection.GetCheckpointStatistics().count == 0);
+
+   // The log is checkpointed when long enough, and then starts over
+   const auto maxWalBytes = wxULongLong(
+      DBConnection::MaxDeferredWalPages + MaxPagesPerCommit) * (65536 + 24)
+      + 32;
+   int nCommits = 1;
+   while (connection.GetCheckpointStatistics().count < 3) {
+      Insert(db, data);
+      ++nCommits;
+      REQUIRE(nCommits < 10000);
+      const auto stats = connection.GetCheckpointStatistics();
+      REQUIRE(stats.walPages <=
+         DBConnection::MaxDeferredWalPages + MaxPagesPerCommit);
+      REQUIRE(wxFileName::GetSize(walName) <= maxWalBytes);
+      if (stats.walPages >= DBConnection::MaxDeferredWalPages)
+         // Give the checkpoint thread its turn
+         REQUIRE(WaitFor([&]{
+            return connection.GetCheckpointStatistics().count > stats.count;
+         }));
+   }
+   {
+      // Each checkpoint was put off first
+      const auto stats = connection.GetCheckpointStatistics();
+      REQUIRE(stats.deferred >= stats.count);
+      REQUIRE(stats.maxWalPages <=
+         DBConnection::MaxDeferredWalPages + MaxPagesPerCommit);
+   }
+
+   // When audio stops, checkpoints are not put off
+   streaming = false;
+   std::this_thread::sleep_for(300ms);
+   const auto before = connection.GetCheckpointStatistics();
+   Insert(db, data);
+   REQUIRE(WaitFor([&]{
+      return connection.GetCheckpointStatistics().count > before.count; }));
+   REQUIRE(connection.GetCheckpointStatistics().deferred == before.deferred);
+
+   REQUIRE(connection.Close());
+   wxRemoveFile(fileName);
+}
@@ -0,0 +1,92 @@
+/**********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file RealtimeEffectLoad.cpp
+
+ *********************************************************************/
+
+#include "RealtimeEffectLoad.h"
+
+#include <algorithm>
+#include <cmath>
+
+double RealtimeEffectLoad::Snapshot::Mean(const Snapshot *pEarlier) const
+{
+   auto n = count;
+   auto sum = total;
+   if (pEarlier && pEarlier->count <= count) {
+      n -= pEarlier->count;
+      sum -= pEarlier->total;
+   }
+   return n > 0 ? sum / (10.0 * n) : 0.0;
+}
+
+double RealtimeEffectLoad::Snapshot::Peak() const
+{
+   return peak / 10.0;
+}
+
+double RealtimeEffectLoad::Snapshot::Percentile(double fraction) const
+{
+   unsigned long long counted = 0;
+   for (const auto bin : bins)
+      counted += bin;
+   if (counted == 0)
+      return 0.0;
+   const auto target = std::max<unsigned long long>(1,
+      std::ceil(std::clamp(fraction, 0.0, 1.0) * counted));
+   unsigned long long sum = 0;
+   for (size_t ii = 0; ii + 1 < NumBins; ++ii) {
+      sum += bins[ii];
+      if (sum >= target)
+         return (ii + 1) * BinWidth;
+   }
+   // Unbounded last bin
+   return Peak();
+}
+
+void RealtimeEffectLoad::Record(
+   std::chrono::steady_clock::duration elapsed, double deadline) noexcept
+{
+   if (!(deadline > 0))
+      return;
+
+   const auto seconds = std::chrono::duration<double>(elapsed).count();
+   const auto load = static_cast<unsigned>(
+      std::min(1000.0 * seconds / deadline, 1.0e9));
+
+   const auto bin = std::min<size_t>(load / (10 * BinWidth), NumBins - 1);
+
+   // There is only one writer, so relaxed order suffices; readers see
+   // consistent enough numbers for display
+   mBins[bin].fetch_add(1, std::memory_order_relaxed);
+   mTotal.fetch_add(load, std::memory_order_relaxed);
+   if (load > 1000)
+      mMisses.fetch_add(1, std::memory_order_relaxed);
+   if (load > mPeak.load(std::memory_order_relaxed))
+      mPeak.store(load, std::memory_order_relaxed);
+   mCount.fetch_add(1, std::memory_order_release);
+}
+
+auto RealtimeEffectLoad::GetSnapshot() const noexcept -> Snapshot
+{
+   Snapshot result;
+   result.count = mCount.load(std::memory_order_acquire);
+   for (size_t ii = 0; ii < NumBins; ++ii)
+      result.bins[ii] = mBins[ii].load(std::memory_order_relaxed);
+   result.misses = mMisses.load(std::memory_order_relaxed);
+   result.total = mTotal.load(std::memory_order_relaxed);
+   result.peak = mPeak.load(std::memory_order_relaxed);
+   return result;
+}
+
+void RealtimeEffectLoad::Reset() noexcept
+{
+   for (auto &bin : mBins)
+      bin.store(0, std::memory_order_relaxed);
+   mCount.store(0, std::memory_order_relaxed);
+   mMisses.store(0, std::memory_order_relaxed);
+   mTotal.store(0, std::memory_order_relaxed);
+   mPeak.store(0, std::memory_order_relaxed);
+}
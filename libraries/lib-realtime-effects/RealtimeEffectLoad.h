@@ -0,0 +1,70 @@
+/**********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file RealtimeEffectLoad.h
+
+ *********************************************************************/
+
+#ifndef __AUDACITY_REALTIMEEFFECTLOAD_H__
+#define __AUDACITY_REALTIMEEFFECTLOAD_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+//! Statistics of the time one realtime effect spends processing buffers,
+//! relative to the duration of the audio in the buffers
+/*!
+ A load of 100% means the effect alone used up the whole deadline of the
+ buffer.  Recording is lock-free and done by the worker thread; any thread
+ may take a snapshot.
+ */
+class REALTIME_EFFECTS_API RealtimeEffectLoad final
+{
+public:
+   //! Width of a histogram bin, in percent of the deadline
+   static constexpr unsigned BinWidth = 10;
+   //! The last bin also counts all loads above its lower limit
+   static constexpr size_t NumBins = 21;
+
+   struct REALTIME_EFFECTS_API Snapshot {
+      std::array<unsigned long long, NumBins> bins{};
+      //! Number of buffers processed
+      unsigned long long count{};
+      //! Number of buffers that took longer than their duration
+      unsigned long long misses{};
+      //! Sum of the loads, in tenths of percent
+      unsigned long long total{};
+      //! Greatest load, in tenths of percent
+      unsigned peak{};
+
+      //! Average load in percent, over the buffers counted since the
+      //! earlier snapshot, or over all if it is null
+      double Mean(const Snapshot *pEarlier = nullptr) const;
+      //! Peak load in percent
+      double Peak() const;
+      //! Upper limit, in percent, of the histogram bin reached by the given
+      //! fraction of the buffers
+      double Percentile(double fraction) const;
+   };
+
+   //! Called in the worker thread after processing one buffer
+   void Record(
+      std::chrono::steady_clock::duration elapsed, double deadline) noexcept;
+
+   Snapshot GetSnapshot() const noexcept;
+
+   //! Called in the main thread when there is no processing
+   void Reset() noexcept;
+
+private:
+   std::array<std::atomic<unsigned long long>, NumBins> mBins{};
+   std::atomic<unsigned long long> mCount{ 0 };
+   std::atomic<unsigned long long> mMisses{ 0 };
+   std::atomic<unsigned long long> mTotal{ 0 };
+   std::atomic<unsigned> mPeak{ 0 };
+};
+
+#endif
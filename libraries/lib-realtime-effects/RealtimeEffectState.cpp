@@ -422,6 +422,7 @@ RealtimeEffectState::Initialize(double sampleRate)
    mCurrentProcessor = 0;
    mGroups.clear();
    mLatency = {};
+   mLoad.Reset();
    return EnsureInstance(sampleRate);
 }
 
@@ -543,6 +544,7 @@ size_t RealtimeEffectState::Process(
          memcpy(outbuf[ii], inbuf[ii], numSamples * sizeof(float));
       return 0;
    }
+   const auto start = std::chrono::steady_clock::now();
    const auto numAudioIn = pInstance->GetAudioInCount();
    const auto numAudioOut = pInstance->GetAudioOutCount();
    const auto clientIn = stackAllocate(const float *, numAudioIn);
@@ -601,6 +603,11 @@ size_t RealtimeEffectState::Process(
       ++processor;
       return true;
    });
+   // Measure against the duration of the buffer, which is the most time
+   // the whole chain of effects may take
+   if (pair.second > 0)
+      mLoad.Record(std::chrono::steady_clock::now() - start,
+         numSamples / pair.second);
    // Report the number discardable during the processing scope
    // We are assuming len as calculated above is the same in case of multiple
    // processors
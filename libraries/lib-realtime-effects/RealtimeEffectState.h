@@ -22,6 +22,7 @@
 #include "MemoryX.h"
 #include "Observer.h"
 #include "PluginProvider.h" // for PluginID
+#include "RealtimeEffectLoad.h"
 #include "XMLTagHandler.h"
 
 class EffectSettingsAccess;
@@ -90,6 +91,9 @@ public:
 
    const EffectSettings &GetSettings() const { return mMainSettings.settings; }
 
+   //! Processing time statistics since the last Initialize
+   const RealtimeEffectLoad &GetLoad() const { return mLoad; }
+
    //! Test only in the main thread
    bool IsEnabled() const noexcept;
 
@@ -179,6 +183,9 @@ private:
    //! Assigned in the worker thread at the start of each processing scope
    bool mLastActive{};
 
+   //! Written in the worker thread, read anywhere
+   RealtimeEffectLoad mLoad;
+
    //! @}
 
    /*! @name Members that do not change during processing
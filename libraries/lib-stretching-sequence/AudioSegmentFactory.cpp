@@ -12,18 +12,25 @@
 #include "AudioSegmentFactory.h"
 #include "ClipInterface.h"
 #include "ClipSegment.h"
+#include "RenderedClipSegment.h"
 #include "SilenceSegment.h"
+#include "StretchedClipCache.h"
 
 #include <algorithm>
 
 using ClipConstHolder = std::shared_ptr<const ClipInterface>;
 
 AudioSegmentFactory::AudioSegmentFactory(
-   int sampleRate, int numChannels, const ClipConstHolders& clips)
+   int sampleRate, int numChannels, const ClipConstHolders& clips,
+   StretchedClipCache* pCache)
     : mClips { clips }
     , mSampleRate { sampleRate }
     , mNumChannels { numChannels }
 {
+   if (pCache)
+      for (const auto& clip : mClips)
+         if (auto render = pCache->Find(*clip))
+            mRenders.emplace(clip.get(), std::move(render));
 }
 
 std::vector<std::shared_ptr<AudioSegment>>
@@ -57,7 +64,7 @@ AudioSegmentFactory::CreateAudioSegmentSequenceForward(double t0) const
       }
       else if (clip->GetPlayEndTime() <= t0)
          continue;
-      segments.push_back(std::make_shared<ClipSegment>(
+      segments.push_back(CreateClipSegment(
          *clip, t0 - clip->GetPlayStartTime(), PlaybackDirection::forward));
       t0 = clip->GetPlayEndTime();
    }
@@ -86,9 +93,19 @@ AudioSegmentFactory::CreateAudioSegmentSequenceBackward(double t0) const
       }
       else if (clip->GetPlayStartTime() >= t0)
          continue;
-      segments.push_back(std::make_shared<ClipSegment>(
+      segments.push_back(CreateClipSegment(
          *clip, clip->GetPlayEndTime() - t0, PlaybackDirection::backward));
       t0 = clip->GetPlayStartTime();
    }
    return segments;
 }
+
+std::shared_ptr<AudioSegment> AudioSegmentFactory::CreateClipSegment(
+   const ClipInterface& clip, double durationToDiscard,
+   PlaybackDirection direction) const
+{
+   if (const auto it = mRenders.find(&clip); it != mRenders.end())
+      return std::make_shared<RenderedClipSegment>(
+         clip, it->second, durationToDiscard, direction);
+   return std::make_shared<ClipSegment>(clip, durationToDiscard, direction);
+}
@@ -13,15 +13,27 @@
 
 #include "AudioSegmentFactoryInterface.h"
 
+#include <unordered_map>
+
 class ClipInterface;
+class StretchedClipCache;
+class StretchedClipRender;
 using ClipConstHolders = std::vector<std::shared_ptr<const ClipInterface>>;
 
 class STRETCHING_SEQUENCE_API AudioSegmentFactory final :
     public AudioSegmentFactoryInterface
 {
 public:
+   /*!
+    * @param pCache if not null, stretched clips are played from their renders
+    * where complete, and rendering of the others is scheduled
+    *
+    * The cache is searched here, once, and not when segments are made, which
+    * may happen in the audio thread.
+    */
    AudioSegmentFactory(
-      int sampleRate, int numChannels, const ClipConstHolders& clips);
+      int sampleRate, int numChannels, const ClipConstHolders& clips,
+      StretchedClipCache* pCache = nullptr);
 
    std::vector<std::shared_ptr<AudioSegment>> CreateAudioSegmentSequence(
       double playbackStartTime, PlaybackDirection) const override;
@@ -33,8 +45,16 @@ private:
    std::vector<std::shared_ptr<AudioSegment>>
    CreateAudioSegmentSequenceBackward(double playbackStartTime) const;
 
+   std::shared_ptr<AudioSegment> CreateClipSegment(
+      const ClipInterface& clip, double durationToDiscard,
+      PlaybackDirection direction) const;
+
 private:
    const ClipConstHolders mClips;
    const int mSampleRate;
    const int mNumChannels;
+   //! Complete renders of the clips, found at construction
+   std::unordered_map<
+      const ClipInterface*, std::shared_ptr<const StretchedClipRender>>
+      mRenders;
 };
@@ -1,3 +1,13 @@
 #include "ClipInterface.h"
 
 ClipInterface::~ClipInterface() = default;
+
+ClipContentKey ClipInterface::GetContentKey() const
+{
+   return {};
+}
+
+std::shared_ptr<const ClipInterface> ClipInterface::GetSnapshot() const
+{
+   return nullptr;
+}
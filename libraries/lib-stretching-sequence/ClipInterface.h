@@ -14,6 +14,12 @@
 #include "SampleCount.h"
 #include "SampleFormat.h"
 
+#include <memory>
+#include <vector>
+
+//! Identifies the samples of a clip; empty if they cannot be identified
+using ClipContentKey = std::vector<long long>;
+
 class STRETCHING_SEQUENCE_API ClipInterface
 {
 public:
@@ -33,6 +39,24 @@ public:
    virtual double GetPlayEndTime() const = 0;
 
    virtual double GetStretchRatio() const = 0;
+
+   /*!
+    * @brief Clips with equal non-empty keys have the same samples between play
+    * start and play end.
+    *
+    * The default is empty, meaning the samples cannot be identified and so
+    * the stretched clip cannot be cached.
+    */
+   virtual ClipContentKey GetContentKey() const;
+
+   /*!
+    * @brief An immutable copy of the clip, safe to read in another thread
+    * while this clip is edited.
+    *
+    * The default is null, meaning the clip cannot be rendered in the
+    * background.
+    */
+   virtual std::shared_ptr<const ClipInterface> GetSnapshot() const;
 };
 
 using ClipHolders = std::vector<std::shared_ptr<ClipInterface>>;
@@ -0,0 +1,79 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RenderedClipSegment.cpp
+
+**********************************************************************/
+#include "RenderedClipSegment.h"
+#include "ClipInterface.h"
+#include "SampleFormat.h"
+#include "StretchedClipCache.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+sampleCount GetNumSamplesToDiscard(
+   const ClipInterface& clip, const StretchedClipRender& render,
+   double durationToDiscard)
+{
+   const auto numSamples =
+      sampleCount { clip.GetRate() * durationToDiscard + .5 };
+   return std::clamp<sampleCount>(numSamples, 0, render.GetSampleCount());
+}
+} // namespace
+
+RenderedClipSegment::RenderedClipSegment(
+   const ClipInterface& clip, std::shared_ptr<const StretchedClipRender> render,
+   double durationToDiscard, PlaybackDirection direction)
+    : mRender { std::move(render) }
+    , mPlaybackDirection { direction }
+{
+   assert(mRender);
+   assert(mRender->GetWidth() == clip.GetWidth());
+   const auto numToDiscard =
+      GetNumSamplesToDiscard(clip, *mRender, durationToDiscard);
+   mNumRemainingSamples = mRender->GetSampleCount() - numToDiscard;
+   mPosition = direction == PlaybackDirection::forward ? numToDiscard :
+                                                         mNumRemainingSamples;
+}
+
+size_t
+RenderedClipSegment::GetFloats(std::vector<float*>& buffers, size_t numSamples)
+{
+   assert(buffers.size() == GetWidth());
+   const auto forward = mPlaybackDirection == PlaybackDirection::forward;
+   const auto numSamplesToProduce =
+      limitSampleBufferSize(numSamples, mNumRemainingSamples);
+   const auto start = forward ? mPosition : mPosition - numSamplesToProduce;
+   for (auto i = 0u; i < buffers.size(); ++i)
+   {
+      const auto view =
+         mRender->GetSampleView(i, start, numSamplesToProduce);
+      const auto copied = view.Copy(buffers[i], numSamplesToProduce);
+      std::fill(buffers[i] + copied, buffers[i] + numSamplesToProduce, 0.f);
+      if (!forward)
+         ReverseSamples(
+            reinterpret_cast<samplePtr>(buffers[i]), floatSample, 0,
+            numSamplesToProduce);
+   }
+   if (forward)
+      mPosition += numSamplesToProduce;
+   else
+      mPosition -= numSamplesToProduce;
+   mNumRemainingSamples -= numSamplesToProduce;
+   return numSamplesToProduce;
+}
+
+bool RenderedClipSegment::Empty() const
+{
+   return mNumRemainingSamples == 0;
+}
+
+size_t RenderedClipSegment::GetWidth() const
+{
+   return mRender->GetWidth();
+}
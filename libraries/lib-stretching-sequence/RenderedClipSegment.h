@@ -0,0 +1,48 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RenderedClipSegment.h
+
+**********************************************************************/
+#pragma once
+
+#include "AudioSegment.h"
+#include "PlaybackDirection.h"
+
+#include <memory>
+
+class ClipInterface;
+class StretchedClipRender;
+
+/*!
+ * @brief Plays a clip from its stretched render, in place of a `ClipSegment`.
+ *
+ * The render allows random access at no cost, so reading may start anywhere
+ * and go in either direction.
+ */
+class STRETCHING_SEQUENCE_API RenderedClipSegment final : public AudioSegment
+{
+public:
+   /*!
+    * @pre `render != nullptr`
+    * @pre `render->GetWidth() == clip.GetWidth()`
+    */
+   RenderedClipSegment(
+      const ClipInterface& clip,
+      std::shared_ptr<const StretchedClipRender> render,
+      double durationToDiscard, PlaybackDirection);
+
+   // AudioSegment
+   size_t GetFloats(std::vector<float*>& buffers, size_t numSamples) override;
+   bool Empty() const override;
+   size_t GetWidth() const override;
+
+private:
+   const std::shared_ptr<const StretchedClipRender> mRender;
+   const PlaybackDirection mPlaybackDirection;
+   //! Index of the next sample if forward, one past it if backward
+   sampleCount mPosition;
+   sampleCount mNumRemainingSamples;
+};
@@ -0,0 +1,269 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  StretchedClipCache.cpp
+
+**********************************************************************/
+#include "StretchedClipCache.h"
+#include "ClipSegment.h"
+
+#include <algorithm>
+#include <cassert>
+
+StretchedClipRender::StretchedClipRender(
+   std::vector<std::vector<BlockSampleView>> channels, sampleCount length)
+    : mChannels { std::move(channels) }
+    , mLength { length }
+{
+}
+
+size_t StretchedClipRender::GetWidth() const
+{
+   return mChannels.size();
+}
+
+sampleCount StretchedClipRender::GetSampleCount() const
+{
+   return mLength;
+}
+
+size_t StretchedClipRender::GetBytes() const
+{
+   size_t bytes = 0;
+   for (const auto& channel : mChannels)
+      for (const auto& block : channel)
+         bytes += block->size() * sizeof(float);
+   return bytes;
+}
+
+AudioSegmentSampleView StretchedClipRender::GetSampleView(
+   size_t iChannel, sampleCount start, size_t length) const
+{
+   assert(iChannel < GetWidth());
+   if (start < 0 || start >= mLength)
+      return AudioSegmentSampleView { sampleCount { 0 } };
+   length = limitSampleBufferSize(length, mLength - start);
+   if (length == 0u)
+      return AudioSegmentSampleView { sampleCount { 0 } };
+   const auto first = start.as_long_long();
+   const auto last = first + static_cast<long long>(length) - 1;
+   const auto& channel = mChannels[iChannel];
+   std::vector<BlockSampleView> blockViews {
+      channel.begin() + first / BlockSize, channel.begin() + last / BlockSize + 1
+   };
+   return AudioSegmentSampleView(
+      std::move(blockViews), static_cast<size_t>(first % BlockSize),
+      sampleCount { length });
+}
+
+std::shared_ptr<const StretchedClipRender> StretchedClipRender::Render(
+   const ClipInterface& clip, const std::function<bool()>& cancel)
+{
+   const auto width = clip.GetWidth();
+   // As many samples as `ClipSegment` produces from play start
+   const auto length = sampleCount {
+      clip.GetPlaySamplesCount().as_double() * clip.GetStretchRatio() + .5
+   };
+   ClipSegment segment { clip, 0., PlaybackDirection::forward };
+   std::vector<std::vector<BlockSampleView>> channels(width);
+   std::vector<float*> buffers(width);
+   sampleCount rendered = 0;
+   while (rendered < length && !segment.Empty())
+   {
+      if (cancel && cancel())
+         return nullptr;
+      const auto blockSize = limitSampleBufferSize(BlockSize, length - rendered);
+      for (auto i = 0u; i < width; ++i)
+      {
+         channels[i].push_back(std::make_shared<std::vector<float>>(blockSize));
+         buffers[i] = channels[i].back()->data();
+      }
+      const auto produced = segment.GetFloats(buffers, blockSize);
+      if (produced < blockSize)
+         for (auto& channel : channels)
+         {
+            if (produced == 0u)
+               channel.pop_back();
+            else
+               channel.back()->resize(produced);
+         }
+      rendered += produced;
+      if (produced == 0u)
+         break;
+   }
+   return std::make_shared<StretchedClipRender>(std::move(channels), rendered);
+}
+
+bool StretchedClipCache::Key::operator==(const Key& other) const
+{
+   return content == other.content && ratio == other.ratio &&
+          rate == other.rate && width == other.width;
+}
+
+StretchedClipCache& StretchedClipCache::Get()
+{
+   static StretchedClipCache cache;
+   return cache;
+}
+
+StretchedClipCache::StretchedClipCache(size_t maxBytes)
+    : mMaxBytes { maxBytes }
+{
+}
+
+StretchedClipCache::~StretchedClipCache()
+{
+   {
+      std::lock_guard<std::mutex> lock { mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   if (mThread.joinable())
+      mThread.join();
+}
+
+bool StretchedClipCache::IsCacheable(const ClipInterface& clip)
+{
+   return clip.GetStretchRatio() != 1.0 && !clip.GetContentKey().empty();
+}
+
+auto StretchedClipCache::MakeKey(const ClipInterface& clip) -> Key
+{
+   return { clip.GetContentKey(), clip.GetStretchRatio(), clip.GetRate(),
+            clip.GetWidth() };
+}
+
+std::shared_ptr<const StretchedClipRender>
+StretchedClipCache::Find(const ClipInterface& clip)
+{
+   // Unstretched clips are read directly, at no cost
+   if (clip.GetStretchRatio() == 1.0)
+      return nullptr;
+   auto key = MakeKey(clip);
+   if (key.content.empty())
+      return nullptr;
+   // Don't render what could not be kept
+   const auto bytes = clip.GetPlaySamplesCount().as_double() *
+                      clip.GetStretchRatio() * clip.GetWidth() * sizeof(float);
+   if (bytes > mMaxBytes)
+      return nullptr;
+
+   // Destroyed after the mutex is released
+   std::vector<std::shared_ptr<const ClipInterface>> spent;
+   std::shared_ptr<const ClipInterface> snapshot;
+   std::unique_lock<std::mutex> lock { mMutex };
+   spent.swap(mSpent);
+   for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+      if (it->key == key)
+      {
+         mEntries.splice(mEntries.begin(), mEntries, it);
+         return it->render;
+      }
+   if (IsScheduled(key))
+      return nullptr;
+
+   lock.unlock();
+   snapshot = clip.GetSnapshot();
+   if (!snapshot)
+      return nullptr;
+   lock.lock();
+   if (IsScheduled(key) || mStopping)
+      return nullptr;
+   mJobs.push_back({ std::move(key), std::move(snapshot) });
+   if (!mThread.joinable())
+      mThread = std::thread { [this] { Work(); } };
+   mCondition.notify_all();
+   return nullptr;
+}
+
+void StretchedClipCache::WaitUntilIdle()
+{
+   std::unique_lock<std::mutex> lock { mMutex };
+   mCondition.wait(lock, [this] { return mJobs.empty() && !mRendering; });
+}
+
+void StretchedClipCache::Clear()
+{
+   // Destroyed after the mutex is released
+   std::deque<Job> jobs;
+   std::list<Entry> entries;
+   std::vector<std::shared_ptr<const ClipInterface>> spent;
+   std::unique_lock<std::mutex> lock { mMutex };
+   jobs.swap(mJobs);
+   entries.swap(mEntries);
+   mBytes = 0;
+   ++mGeneration;
+   mCondition.wait(lock, [this] { return !mRendering; });
+   spent.swap(mSpent);
+}
+
+size_t StretchedClipCache::GetBytes() const
+{
+   std::lock_guard<std::mutex> lock { mMutex };
+   return mBytes;
+}
+
+bool StretchedClipCache::IsScheduled(const Key& key) const
+{
+   if (mRendering && mRenderingKey == key)
+      return true;
+   return std::any_of(mJobs.begin(), mJobs.end(), [&](const Job& job) {
+      return job.key == key;
+   });
+}
+
+void StretchedClipCache::Trim()
+{
+   while (mBytes > mMaxBytes && !mEntries.empty())
+   {
+      mBytes -= mEntries.back().render->GetBytes();
+      mEntries.pop_back();
+   }
+}
+
+void StretchedClipCache::Work()
+{
+   std::unique_lock<std::mutex> lock { mMutex };
+   while (true)
+   {
+      mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+      if (mStopping)
+         return;
+      auto job = std::move(mJobs.front());
+      mJobs.pop_front();
+      mRenderingKey = job.key;
+      mRendering = true;
+      const auto generation = mGeneration;
+      lock.unlock();
+
+      std::shared_ptr<const StretchedClipRender> render;
+      try
+      {
+         render =
+            StretchedClipRender::Render(*job.snapshot, [this, generation] {
+               std::lock_guard<std::mutex> lock { mMutex };
+               return mStopping || mGeneration != generation;
+            });
+      }
+      catch (...)
+      {
+         // Such as failure to read the samples; the clip will be stretched
+         // live instead
+      }
+
+      lock.lock();
+      // Releasing the last reference to a sample block may delete it from
+      // its storage, which is left to the threads calling Find or Clear
+      mSpent.push_back(std::move(job.snapshot));
+      mRendering = false;
+      if (render && !mStopping && generation == mGeneration)
+      {
+         mBytes += render->GetBytes();
+         mEntries.push_front({ std::move(job.key), std::move(render) });
+         Trim();
+      }
+      mCondition.notify_all();
+   }
+}
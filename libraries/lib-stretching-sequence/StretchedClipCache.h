@@ -0,0 +1,171 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file StretchedClipCache.h
+  @brief Time-stretched clips rendered in the background, so that playback,
+  export and display need not stretch them again and again.
+
+**********************************************************************/
+#pragma once
+
+#include "AudioSegmentSampleView.h"
+#include "ClipInterface.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+//! The samples of a clip as played, i.e., after stretching
+class STRETCHING_SEQUENCE_API StretchedClipRender final
+{
+public:
+   //! Number of samples of each block of the render
+   static constexpr size_t BlockSize = 65536;
+
+   StretchedClipRender(
+      std::vector<std::vector<BlockSampleView>> channels, sampleCount length);
+
+   size_t GetWidth() const;
+
+   //! Number of samples per channel, at the rate of the clip
+   sampleCount GetSampleCount() const;
+
+   //! Memory used by the samples
+   size_t GetBytes() const;
+
+   /*!
+    * @brief Views up to `length` samples, fewer if the render ends before.
+    *
+    * @param start index of the first sample from play start
+    * @pre `iChannel < GetWidth()`
+    */
+   AudioSegmentSampleView
+   GetSampleView(size_t iChannel, sampleCount start, size_t length) const;
+
+   //! Stretches the whole clip, which is read only from this thread
+   /*!
+    * @param cancel polled between blocks; if it returns true, rendering stops
+    * and null is returned
+    */
+   static std::shared_ptr<const StretchedClipRender> Render(
+      const ClipInterface& clip, const std::function<bool()>& cancel = {});
+
+private:
+   const std::vector<std::vector<BlockSampleView>> mChannels;
+   const sampleCount mLength;
+};
+
+//! Complete renders of clips, looked up once when playback or drawing is set
+//! up, so that reading samples needs no more than a hash lookup
+using StretchedClipRenders = std::unordered_map<
+   const ClipInterface*, std::shared_ptr<const StretchedClipRender>>;
+
+/*!
+ * @brief Renders stretched clips with a worker thread, and keeps the results
+ * while they fit in a memory budget, dropping the least recently used first.
+ *
+ * Renders are identified by the content key of the clip together with its
+ * stretch ratio, rate and width, so that any edit of the samples, the trim or
+ * the stretch makes the old render unreachable. Only clips that are actually
+ * stretched, and that can make a key and a snapshot, are rendered.
+ *
+ * Methods may be called from any thread, except for audio threads in the case
+ * of `Find()` and `Clear()`: these copy the block arrays of clips, and release
+ * sample blocks, which may delete them from their storage.
+ */
+class STRETCHING_SEQUENCE_API StretchedClipCache final
+{
+public:
+   static constexpr size_t DefaultMaxBytes = 256 * 1024 * 1024;
+
+   //! The cache used by the application
+   static StretchedClipCache& Get();
+
+   explicit StretchedClipCache(size_t maxBytes = DefaultMaxBytes);
+   StretchedClipCache(const StretchedClipCache&) = delete;
+   StretchedClipCache& operator=(const StretchedClipCache&) = delete;
+   ~StretchedClipCache();
+
+   //! Whether the clip is one this cache would render
+   static bool IsCacheable(const ClipInterface& clip);
+
+   /*!
+    * @brief The render of the clip, if complete and up to date.
+    *
+    * Otherwise null, and if the clip is cacheable, rendering of its current
+    * content is scheduled, so that a later call may succeed.
+    */
+   std::shared_ptr<const StretchedClipRender> Find(const ClipInterface& clip);
+
+   //! Blocks until all scheduled renders are done
+   void WaitUntilIdle();
+
+   /*!
+    * @brief Drops all renders and scheduled jobs, waiting for the one in
+    * progress to stop.
+    *
+    * Call before the storage of the sample blocks of snapshots goes away.
+    */
+   void Clear();
+
+   //! Memory used by the complete renders
+   size_t GetBytes() const;
+
+private:
+   struct Key final
+   {
+      ClipContentKey content;
+      double ratio { 1.0 };
+      int rate { 0 };
+      size_t width { 0 };
+
+      bool operator==(const Key& other) const;
+   };
+
+   struct Entry final
+   {
+      Key key;
+      std::shared_ptr<const StretchedClipRender> render;
+   };
+
+   struct Job final
+   {
+      Key key;
+      std::shared_ptr<const ClipInterface> snapshot;
+   };
+
+   static Key MakeKey(const ClipInterface& clip);
+
+   //! @pre `mMutex` is locked
+   bool IsScheduled(const Key& key) const;
+
+   //! @pre `mMutex` is locked
+   void Trim();
+
+   void Work();
+
+   const size_t mMaxBytes;
+
+   mutable std::mutex mMutex;
+   std::condition_variable mCondition;
+   //! Most recently used first
+   std::list<Entry> mEntries;
+   std::deque<Job> mJobs;
+   //! Snapshots of rendered jobs, released outside of the worker thread
+   std::vector<std::shared_ptr<const ClipInterface>> mSpent;
+   //! Key of the job being rendered, meaningful while `mRendering`
+   Key mRenderingKey;
+   bool mRendering { false };
+   //! Incremented by `Clear()` to cancel the job being rendered
+   unsigned mGeneration { 0 };
+   bool mStopping { false };
+   size_t mBytes { 0 };
+   std::thread mThread;
+};
@@ -12,6 +12,7 @@
 #include "AudioSegment.h"
 #include "AudioSegmentFactory.h"
 #include "StaffPadTimeAndPitch.h"
+#include "StretchedClipCache.h"
 
 #include <cassert>
 
@@ -168,6 +169,11 @@ const WideSampleSequence* StretchingSequence::DoGetDecorated() const
    return &mSequence;
 }
 
+const WideSampleSequence* StretchingSequence::DoGetSource() const
+{
+   return &mSequence.GetSource();
+}
+
 bool StretchingSequence::MutableGet(
    size_t iChannel, size_t nBuffers, const samplePtr buffers[],
    sampleFormat format, sampleCount start, size_t len, bool backwards)
@@ -192,7 +198,8 @@ std::shared_ptr<StretchingSequence> StretchingSequence::Create(
    return std::make_shared<StretchingSequence>(
       sequence, sequence.GetRate(), sequence.NChannels(),
       std::make_unique<AudioSegmentFactory>(
-         sequence.GetRate(), sequence.NChannels(), clips));
+         sequence.GetRate(), sequence.NChannels(), clips,
+         &StretchedClipCache::Get()));
 }
 
 std::shared_ptr<StretchingSequence> StretchingSequence::Create(
@@ -69,6 +69,7 @@ private:
    using AudioSegments = std::vector<std::shared_ptr<AudioSegment>>;
 
    const WideSampleSequence* DoGetDecorated() const override;
+   const WideSampleSequence* DoGetSource() const override;
    void ResetCursor(double t, PlaybackDirection);
    bool GetNext(float *const buffers[], size_t numChannels, size_t numSamples);
    bool MutableGet(
@@ -47,6 +47,13 @@ AudioSegmentSampleView FloatVectorClip::GetSampleView(
       std::move(blockViews), start.as_size_t(), sampleCount { len });
 }
 
+std::shared_ptr<const ClipInterface> FloatVectorClip::GetSnapshot() const
+{
+   if (contentKey.empty())
+      return nullptr;
+   return std::make_shared<FloatVectorClip>(*this);
+}
+
 sampleCount FloatVectorClip::GetPlaySamplesCount() const
 {
    return mAudio[0].size();
@@ -46,9 +46,18 @@ public:
       return stretchRatio;
    }
 
+   ClipContentKey GetContentKey() const override
+   {
+      return contentKey;
+   }
+
+   std::shared_ptr<const ClipInterface> GetSnapshot() const override;
+
 public:
    double stretchRatio = 1.;
    double playStartTime = 0.;
+   //! Empty by default, as for clips that cannot be cached
+   ClipContentKey contentKey;
 
 private:
    double GetPlayDuration() const;
@@ -0,0 +1,190 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  StretchedClipCacheTest.cpp
+
+**********************************************************************/
+#include "StretchedClipCache.h"
+#include "AudioContainerHelper.h"
+#include "AudioSegmentFactory.h"
+#include "ClipSegment.h"
+#include "FloatVectorClip.h"
+#include "RenderedClipSegment.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+
+namespace
+{
+constexpr auto sampleRate = 44100;
+
+std::vector<float> MakeSine(size_t numSamples)
+{
+   std::vector<float> sine(numSamples);
+   for (auto i = 0u; i < numSamples; ++i)
+      sine[i] = std::sin(i * 0.05f);
+   return sine;
+}
+
+std::shared_ptr<FloatVectorClip> MakeStretchedClip(size_t numChannels)
+{
+   // Longer than one block of a render, after stretching
+   const auto clip = std::make_shared<FloatVectorClip>(
+      sampleRate, MakeSine(StretchedClipRender::BlockSize), numChannels);
+   clip->stretchRatio = 1.5;
+   clip->contentKey = { 1 };
+   return clip;
+}
+
+std::shared_ptr<const StretchedClipRender>
+RenderInBackground(StretchedClipCache& cache, const ClipInterface& clip)
+{
+   REQUIRE(cache.Find(clip) == nullptr);
+   cache.WaitUntilIdle();
+   return cache.Find(clip);
+}
+} // namespace
+
+TEST_CASE("StretchedClipCache")
+{
+   StretchedClipCache cache;
+
+   SECTION("ignores unstretched clips")
+   {
+      const auto clip = MakeStretchedClip(1u);
+      clip->stretchRatio = 1.;
+      REQUIRE(!StretchedClipCache::IsCacheable(*clip));
+      REQUIRE(RenderInBackground(cache, *clip) == nullptr);
+      REQUIRE(cache.GetBytes() == 0u);
+   }
+
+   SECTION("ignores clips without content key")
+   {
+      const auto clip = MakeStretchedClip(1u);
+      clip->contentKey.clear();
+      REQUIRE(!StretchedClipCache::IsCacheable(*clip));
+      REQUIRE(RenderInBackground(cache, *clip) == nullptr);
+   }
+
+   SECTION("renders as ClipSegment plays")
+   {
+      const auto numChannels = GENERATE(1u, 2u);
+      const auto clip = MakeStretchedClip(numChannels);
+      REQUIRE(StretchedClipCache::IsCacheable(*clip));
+      const auto render = RenderInBackground(cache, *clip);
+      REQUIRE(render != nullptr);
+      REQUIRE(render->GetWidth() == numChannels);
+      const auto numSamples = render->GetSampleCount().as_size_t();
+      REQUIRE(numSamples == StretchedClipRender::BlockSize * 3 / 2);
+      REQUIRE(cache.GetBytes() == numSamples * numChannels * sizeof(float));
+
+      // Stretch live in blocks of the same size as the render
+      ClipSegment live { *clip, 0., PlaybackDirection::forward };
+      AudioContainer expected(numSamples, numChannels);
+      for (size_t offset = 0; offset < numSamples;)
+      {
+         auto buffers = AudioContainerHelper::GetData<float>(
+            expected, offset);
+         offset += live.GetFloats(buffers, StretchedClipRender::BlockSize);
+      }
+      REQUIRE(live.Empty());
+
+      RenderedClipSegment sut { *clip, render, 0., PlaybackDirection::forward };
+      AudioContainer output(numSamples, numChannels);
+      REQUIRE(sut.GetFloats(output.channelPointers, numSamples) == numSamples);
+      REQUIRE(sut.Empty());
+      REQUIRE(output.channelVectors == expected.channelVectors);
+   }
+
+   SECTION("keeps a render until the content changes")
+   {
+      const auto clip = MakeStretchedClip(1u);
+      const auto render = RenderInBackground(cache, *clip);
+      REQUIRE(render != nullptr);
+      REQUIRE(cache.Find(*clip) == render);
+      clip->contentKey = { 2 };
+      REQUIRE(cache.Find(*clip) == nullptr);
+      clip->stretchRatio = 2.;
+      REQUIRE(RenderInBackground(cache, *clip) != render);
+   }
+
+   SECTION("does not render beyond its budget")
+   {
+      StretchedClipCache smallCache { StretchedClipRender::BlockSize };
+      const auto clip = MakeStretchedClip(1u);
+      REQUIRE(RenderInBackground(smallCache, *clip) == nullptr);
+      REQUIRE(smallCache.GetBytes() == 0u);
+   }
+
+   SECTION("Clear drops renders")
+   {
+      const auto clip = MakeStretchedClip(1u);
+      REQUIRE(RenderInBackground(cache, *clip) != nullptr);
+      cache.Clear();
+      REQUIRE(cache.GetBytes() == 0u);
+      REQUIRE(cache.Find(*clip) == nullptr);
+   }
+}
+
+TEST_CASE("AudioSegmentFactory searches the StretchedClipCache when made")
+{
+   StretchedClipCache cache;
+   const auto clip = MakeStretchedClip(1u);
+   const auto IsRendered = [](const AudioSegmentFactory& factory) {
+      const auto segments =
+         factory.CreateAudioSegmentSequence(0., PlaybackDirection::forward);
+      REQUIRE(segments.size() == 1u);
+      return dynamic_cast<RenderedClipSegment*>(segments[0].get()) != nullptr;
+   };
+
+   SECTION("and plays renders found then, even if dropped since")
+   {
+      REQUIRE(RenderInBackground(cache, *clip) != nullptr);
+      const AudioSegmentFactory factory { sampleRate, 1, { clip }, &cache };
+      cache.Clear();
+      REQUIRE(IsRendered(factory));
+   }
+
+   SECTION("but not renders completed since")
+   {
+      const AudioSegmentFactory factory { sampleRate, 1, { clip }, &cache };
+      // The factory scheduled the render
+      cache.WaitUntilIdle();
+      REQUIRE(cache.GetBytes() > 0u);
+      REQUIRE(!IsRendered(factory));
+   }
+}
+
+TEST_CASE("RenderedClipSegment")
+{
+   const auto numSamples = 5u;
+   const auto render = std::make_shared<StretchedClipRender>(
+      std::vector<std::vector<BlockSampleView>> { { std::make_shared<
+         std::vector<float>>(std::vector<float> { 1.f, 2.f, 3.f, 4.f, 5.f }) } },
+      numSamples);
+   const FloatVectorClip clip { 3, std::vector<float>(numSamples), 1u };
+   // Offset of two samples, in seconds.
+   constexpr auto playbackOffset = 2 / 3.;
+   const auto direction =
+      GENERATE(PlaybackDirection::forward, PlaybackDirection::backward);
+   RenderedClipSegment sut { clip, render, playbackOffset, direction };
+   AudioContainer first(2u, 1u);
+   REQUIRE(sut.GetFloats(first.channelPointers, 2u) == 2u);
+   REQUIRE(!sut.Empty());
+   AudioContainer second(2u, 1u);
+   REQUIRE(sut.GetFloats(second.channelPointers, 2u) == 1u);
+   REQUIRE(sut.Empty());
+   if (direction == PlaybackDirection::forward)
+   {
+      REQUIRE(first.channelVectors[0] == std::vector<float> { 3.f, 4.f });
+      REQUIRE(second.channelVectors[0][0] == 5.f);
+   }
+   else
+   {
+      REQUIRE(first.channelVectors[0] == std::vector<float> { 3.f, 2.f });
+      REQUIRE(second.channelVectors[0][0] == 1.f);
+   }
+}
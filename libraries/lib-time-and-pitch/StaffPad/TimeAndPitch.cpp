@@ -73,6 +73,7 @@ struct TimeAndPitch::impl
    SamplesReal sqWindow;
    SamplesReal last_mag;
    SamplesReal mag_flag;
+   SamplesReal normalizationGain;
 
    double exact_hop_a = 512.0, hop_a_err = 0.0;
    double exact_hop_s = 0.0;
@@ -108,6 +109,7 @@ void TimeAndPitch::setup(int numChannels, int maxBlockSize)
       d->outCircularBuffer[ch].setSize(outBufferSize);
    }
    d->normalizationBuffer.setSize(outBufferSize);
+   d->normalizationGain.setSize(1, _maxBlockSize);
 
    // fft coefficient buffers
    d->spectrum.setSize(_numChannels, _numBins);
@@ -166,6 +168,7 @@ void TimeAndPitch::reset()
       d->outCircularBuffer[ch].reset();
    }
    d->normalizationBuffer.reset();
+   d->last_mag.zeroOut();
    d->last_phase.zeroOut();
    d->phase_accum.zeroOut();
    _outBufferWriteOffset = 0;
@@ -362,14 +365,9 @@ void TimeAndPitch::_process_hop(int hop_a, int hop_s)
       // determine mag/phase
       d->fft.forwardReal(d->fft_timeseries, d->spectrum);
       for (int ch = 0; ch < _numChannels; ++ch)
-      {
-         vo::calcMagnitudes(
-            d->spectrum.getPtr(ch), d->mag.getPtr(ch),
-            d->spectrum.getNumSamples());
-         vo::calcPhases(
-            d->spectrum.getPtr(ch), d->phase.getPtr(ch),
+         vo::calcMagnitudesAndPhases(
+            d->spectrum.getPtr(ch), d->mag.getPtr(ch), d->phase.getPtr(ch),
             d->spectrum.getNumSamples());
-      }
 
       if (_numChannels == 1)
          _time_stretch<1>((float)hop_a, (float)hop_s);
@@ -511,20 +509,22 @@ void TimeAndPitch::feedAudio(const float* const* input_smp, int numSamples)
 void TimeAndPitch::retrieveAudio(float* const* out_smp, int numSamples)
 {
    assert(numSamples <= _maxBlockSize);
+   // The window normalization is the same for all channels
+   float* gain = d->normalizationGain.getPtr(0);
+   if (normalize_window)
+   {
+      constexpr float curve =
+         4.f * 4.f; // the curve approximates 1/x over 1 but fades to 0 near
+                    // 0 to avoid fade-in clicks
+      d->normalizationBuffer.readBlock(0, numSamples, gain);
+      for (int i = 0; i < numSamples; ++i)
+         gain[i] = gain[i] / (gain[i] * gain[i] + 1 / curve);
+   }
    for (int ch = 0; ch < _numChannels; ++ch)
    {
       d->outCircularBuffer[ch].readAndClearBlock(0, numSamples, out_smp[ch]);
       if (normalize_window)
-      {
-         constexpr float curve =
-            4.f * 4.f; // the curve approximates 1/x over 1 but fades to 0 near
-                       // 0 to avoid fade-in clicks
-         for (int i = 0; i < numSamples; ++i)
-         {
-            float x = d->normalizationBuffer.read(i);
-            out_smp[ch][i] *= x / (x * x + 1 / curve);
-         }
-      }
+         vo::multiply(out_smp[ch], gain, out_smp[ch], numSamples);
       d->outCircularBuffer[ch].advance(numSamples);
    }
 
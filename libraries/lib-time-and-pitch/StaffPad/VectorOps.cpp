@@ -0,0 +1,131 @@
+#include "VectorOps.h"
+
+namespace staffpad
+{
+namespace vo
+{
+
+namespace scalar
+{
+void multiply(const float* src1, const float* src2, float* dst, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+      dst[i] = src1[i] * src2[i];
+}
+
+void constantMultiply(const float* src, float constant, float* dst, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+      dst[i] = src[i] * constant;
+}
+
+void calcPhases(const std::complex<float>* src, float* dst, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+      dst[i] = std::arg(src[i]);
+}
+
+void calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+      dst[i] = std::abs(src[i]);
+}
+
+void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+   {
+      mag[i] = std::abs(src[i]);
+      ph[i] = std::arg(src[i]);
+   }
+}
+
+void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst, int32_t n)
+{
+   for (int32_t i = 0; i < n; i++)
+      dst[i] = std::polar<float>(srcMag[i], srcPh[i]);
+}
+} // namespace scalar
+
+namespace
+{
+struct Kernels
+{
+   decltype(&scalar::multiply) multiply = scalar::multiply;
+   decltype(&scalar::constantMultiply) constantMultiply =
+      scalar::constantMultiply;
+   decltype(&scalar::calcPhases) calcPhases = scalar::calcPhases;
+   decltype(&scalar::calcMagnitudes) calcMagnitudes = scalar::calcMagnitudes;
+   decltype(&scalar::calcMagnitudesAndPhases) calcMagnitudesAndPhases =
+      scalar::calcMagnitudesAndPhases;
+   decltype(&scalar::convertPolarToCartesian) convertPolarToCartesian =
+      scalar::convertPolarToCartesian;
+   bool avx2 = false;
+};
+
+Kernels selectKernels()
+{
+   Kernels kernels;
+#if STAFFPAD_HAS_AVX2_KERNELS
+   if (avx2::isSupported())
+   {
+      kernels.multiply = avx2::multiply;
+      kernels.constantMultiply = avx2::constantMultiply;
+      kernels.calcPhases = avx2::calcPhases;
+      kernels.calcMagnitudes = avx2::calcMagnitudes;
+      kernels.calcMagnitudesAndPhases = avx2::calcMagnitudesAndPhases;
+      kernels.convertPolarToCartesian = avx2::convertPolarToCartesian;
+      kernels.avx2 = true;
+   }
+#endif
+   return kernels;
+}
+
+const Kernels& getKernels()
+{
+   static const Kernels kernels = selectKernels();
+   return kernels;
+}
+} // namespace
+
+void multiply(const float* src1, const float* src2, float* dst, int32_t n)
+{
+   getKernels().multiply(src1, src2, dst, n);
+}
+
+void constantMultiply(const float* src, float constant, float* dst, int32_t n)
+{
+   getKernels().constantMultiply(src, constant, dst, n);
+}
+
+void calcPhases(const std::complex<float>* src, float* dst, int32_t n)
+{
+   getKernels().calcPhases(src, dst, n);
+}
+
+void calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n)
+{
+   getKernels().calcMagnitudes(src, dst, n);
+}
+
+void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n)
+{
+   getKernels().calcMagnitudesAndPhases(src, mag, ph, n);
+}
+
+void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst, int32_t n)
+{
+   getKernels().convertPolarToCartesian(srcMag, srcPh, dst, n);
+}
+
+bool usesAvx2()
+{
+   return getKernels().avx2;
+}
+
+} // namespace vo
+} // namespace staffpad
@@ -10,9 +10,11 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <complex>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 
 namespace staffpad
 {
@@ -91,25 +93,74 @@ findMaxElement(const T* src, int32_t n, int32_t& maxIndex, T& maxValue)
    }
 }
 
-inline void calcPhases(const std::complex<float>* src, float* dst, int32_t n)
-{
-   for (int32_t i = 0; i < n; i++)
-      dst[i] = std::arg(src[i]);
-}
+// Hot loops of the phase vocoder. These dispatch at run time to AVX2/FMA
+// kernels when the CPU supports them, and otherwise to the portable ones in
+// vo::scalar. The AVX2 versions of the transcendental functions use
+// polynomial approximations with errors below 1e-6.
 
-inline void
-calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n)
-{
-   for (int32_t i = 0; i < n; i++)
-      dst[i] = std::abs(src[i]);
-}
+TIME_AND_PITCH_API void
+multiply(const float* src1, const float* src2, float* dst, int32_t n);
+
+TIME_AND_PITCH_API void
+constantMultiply(const float* src, float constant, float* dst, int32_t n);
 
-inline void convertPolarToCartesian(
-   const float* srcMag, const float* srcPh, std::complex<float>* dst, int32_t n)
+TIME_AND_PITCH_API void
+calcPhases(const std::complex<float>* src, float* dst, int32_t n);
+
+TIME_AND_PITCH_API void
+calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n);
+
+/// Same as calcMagnitudes and calcPhases, in one pass over the spectrum
+TIME_AND_PITCH_API void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n);
+
+TIME_AND_PITCH_API void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst,
+   int32_t n);
+
+/// Whether the AVX2/FMA kernels are in use
+TIME_AND_PITCH_API bool usesAvx2();
+
+namespace scalar
 {
-   for (int32_t i = 0; i < n; i++)
-      dst[i] = std::polar<float>(srcMag[i], srcPh[i]);
-}
+TIME_AND_PITCH_API void
+multiply(const float* src1, const float* src2, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+constantMultiply(const float* src, float constant, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+calcPhases(const std::complex<float>* src, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n);
+TIME_AND_PITCH_API void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n);
+TIME_AND_PITCH_API void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst,
+   int32_t n);
+} // namespace scalar
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+   defined(_M_IX86)
+#   define STAFFPAD_HAS_AVX2_KERNELS 1
+namespace avx2
+{
+/// Whether the CPU and the OS support AVX2 and FMA
+TIME_AND_PITCH_API bool isSupported();
+
+TIME_AND_PITCH_API void
+multiply(const float* src1, const float* src2, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+constantMultiply(const float* src, float constant, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+calcPhases(const std::complex<float>* src, float* dst, int32_t n);
+TIME_AND_PITCH_API void
+calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n);
+TIME_AND_PITCH_API void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n);
+TIME_AND_PITCH_API void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst,
+   int32_t n);
+} // namespace avx2
+#endif
 
 } // namespace vo
 } // namespace staffpad
@@ -0,0 +1,242 @@
+#include "VectorOps.h"
+
+#if STAFFPAD_HAS_AVX2_KERNELS
+
+#   include <immintrin.h>
+
+#   if defined(_MSC_VER) && !defined(__clang__)
+#      include <intrin.h>
+// MSVC accepts AVX2 intrinsics without compiler flags
+#      define STAFFPAD_AVX2_TARGET
+#   else
+// Only these functions are compiled for AVX2, so the library still runs on
+// any x86 CPU
+#      define STAFFPAD_AVX2_TARGET __attribute__((target("avx2,fma")))
+#   endif
+
+namespace staffpad
+{
+namespace vo
+{
+namespace avx2
+{
+
+namespace
+{
+constexpr float pi = 3.14159265358979323846f;
+
+/// Splits 8 interleaved complex numbers into their real and imaginary parts
+STAFFPAD_AVX2_TARGET inline void
+deinterleave(const std::complex<float>* src, __m256& re, __m256& im)
+{
+   const auto* p = reinterpret_cast<const float*>(src);
+   const auto a = _mm256_loadu_ps(p);
+   const auto b = _mm256_loadu_ps(p + 8);
+   // Within each 128 bit lane, then fix the order of the 64 bit quarters
+   re = _mm256_castpd_ps(_mm256_permute4x64_pd(
+      _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+      _MM_SHUFFLE(3, 1, 2, 0)));
+   im = _mm256_castpd_ps(_mm256_permute4x64_pd(
+      _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+      _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+/// Inverse of deinterleave
+STAFFPAD_AVX2_TARGET inline void
+interleave(__m256 re, __m256 im, std::complex<float>* dst)
+{
+   auto* p = reinterpret_cast<float*>(dst);
+   const auto lo = _mm256_unpacklo_ps(re, im);
+   const auto hi = _mm256_unpackhi_ps(re, im);
+   _mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+   _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+STAFFPAD_AVX2_TARGET inline __m256 magnitude(__m256 re, __m256 im)
+{
+   return _mm256_sqrt_ps(_mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im)));
+}
+
+/// atan2(im, re), as in Cephes atanf after reduction to the first octant
+STAFFPAD_AVX2_TARGET inline __m256 phase(__m256 re, __m256 im)
+{
+   const auto signMask = _mm256_set1_ps(-0.f);
+   const auto ax = _mm256_andnot_ps(signMask, re);
+   const auto ay = _mm256_andnot_ps(signMask, im);
+   const auto mx = _mm256_max_ps(ax, ay);
+   const auto mn = _mm256_min_ps(ax, ay);
+   // 0 / 0 gives 0, as std::arg does
+   const auto a = _mm256_div_ps(
+      mn, _mm256_max_ps(mx, _mm256_set1_ps(std::numeric_limits<float>::min())));
+
+   const auto one = _mm256_set1_ps(1.f);
+   const auto big =
+      _mm256_cmp_ps(a, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ);
+   const auto x = _mm256_blendv_ps(
+      a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), big);
+   const auto y0 =
+      _mm256_and_ps(big, _mm256_set1_ps(pi / 4));
+
+   const auto z = _mm256_mul_ps(x, x);
+   auto poly = _mm256_set1_ps(8.05374449538e-2f);
+   poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(-1.38776856032e-1f));
+   poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(1.99777106478e-1f));
+   poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(-3.33329491539e-1f));
+   auto r = _mm256_add_ps(
+      y0, _mm256_fmadd_ps(_mm256_mul_ps(poly, z), x, x));
+
+   // Unfold the octants
+   r = _mm256_blendv_ps(
+      r, _mm256_sub_ps(_mm256_set1_ps(pi / 2), r),
+      _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+   r = _mm256_blendv_ps(
+      r, _mm256_sub_ps(_mm256_set1_ps(pi), r),
+      _mm256_cmp_ps(re, _mm256_setzero_ps(), _CMP_LT_OQ));
+   return _mm256_xor_ps(r, _mm256_and_ps(im, signMask));
+}
+
+/// sin and cos, as in Cephes sinf and cosf after reduction to
+/// [-pi/4, pi/4]; accurate for arguments of moderate size, as phases are
+STAFFPAD_AVX2_TARGET inline void sinCos(__m256 x, __m256& s, __m256& c)
+{
+   const auto j = _mm256_round_ps(
+      _mm256_mul_ps(x, _mm256_set1_ps(2 / pi)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+   const auto q = _mm256_cvtps_epi32(j);
+   // Extended precision subtraction of j * pi / 2
+   auto r = _mm256_fnmadd_ps(j, _mm256_set1_ps(1.5703125f), x);
+   r = _mm256_fnmadd_ps(j, _mm256_set1_ps(4.837512969970703125e-4f), r);
+   r = _mm256_fnmadd_ps(j, _mm256_set1_ps(7.549789948768648e-8f), r);
+
+   const auto z = _mm256_mul_ps(r, r);
+   auto ps = _mm256_set1_ps(-1.9515295891e-4f);
+   ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(8.3321608736e-3f));
+   ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(-1.6666654611e-1f));
+   const auto sr = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), r, r);
+
+   auto pc = _mm256_set1_ps(2.443315711809948e-5f);
+   pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(-1.388731625493765e-3f));
+   pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(4.166664568298827e-2f));
+   const auto cr = _mm256_fmadd_ps(
+      _mm256_mul_ps(pc, z), z,
+      _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.f)));
+
+   // Quadrant q: sin is sr, cr, -sr, -cr and cos is cr, -sr, -cr, sr
+   const auto one = _mm256_set1_epi32(1);
+   const auto two = _mm256_set1_epi32(2);
+   const auto swap = _mm256_castsi256_ps(
+      _mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+   const auto sinSign =
+      _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30));
+   const auto cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_and_si256(_mm256_add_epi32(q, one), two), 30));
+   s = _mm256_xor_ps(_mm256_blendv_ps(sr, cr, swap), sinSign);
+   c = _mm256_xor_ps(_mm256_blendv_ps(cr, sr, swap), cosSign);
+}
+} // namespace
+
+bool isSupported()
+{
+#   if defined(_MSC_VER) && !defined(__clang__)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7)
+      return false;
+   __cpuid(info, 1);
+   const auto fma = (info[2] & (1 << 12)) != 0;
+   const auto osxsave = (info[2] & (1 << 27)) != 0;
+   if (!fma || !osxsave)
+      return false;
+   // The OS saves the YMM registers
+   if ((_xgetbv(0) & 6) != 6)
+      return false;
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) != 0;
+#   else
+   // Also checks that the OS saves the YMM registers
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#   endif
+}
+
+STAFFPAD_AVX2_TARGET void
+multiply(const float* src1, const float* src2, float* dst, int32_t n)
+{
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+      _mm256_storeu_ps(
+         dst + i,
+         _mm256_mul_ps(_mm256_loadu_ps(src1 + i), _mm256_loadu_ps(src2 + i)));
+   for (; i < n; i++)
+      dst[i] = src1[i] * src2[i];
+}
+
+STAFFPAD_AVX2_TARGET void
+constantMultiply(const float* src, float constant, float* dst, int32_t n)
+{
+   const auto k = _mm256_set1_ps(constant);
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+      _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), k));
+   for (; i < n; i++)
+      dst[i] = src[i] * constant;
+}
+
+STAFFPAD_AVX2_TARGET void
+calcPhases(const std::complex<float>* src, float* dst, int32_t n)
+{
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256 re, im;
+      deinterleave(src + i, re, im);
+      _mm256_storeu_ps(dst + i, phase(re, im));
+   }
+   scalar::calcPhases(src + i, dst + i, n - i);
+}
+
+STAFFPAD_AVX2_TARGET void
+calcMagnitudes(const std::complex<float>* src, float* dst, int32_t n)
+{
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256 re, im;
+      deinterleave(src + i, re, im);
+      _mm256_storeu_ps(dst + i, magnitude(re, im));
+   }
+   scalar::calcMagnitudes(src + i, dst + i, n - i);
+}
+
+STAFFPAD_AVX2_TARGET void calcMagnitudesAndPhases(
+   const std::complex<float>* src, float* mag, float* ph, int32_t n)
+{
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256 re, im;
+      deinterleave(src + i, re, im);
+      _mm256_storeu_ps(mag + i, magnitude(re, im));
+      _mm256_storeu_ps(ph + i, phase(re, im));
+   }
+   scalar::calcMagnitudesAndPhases(src + i, mag + i, ph + i, n - i);
+}
+
+STAFFPAD_AVX2_TARGET void convertPolarToCartesian(
+   const float* srcMag, const float* srcPh, std::complex<float>* dst, int32_t n)
+{
+   int32_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256 s, c;
+      sinCos(_mm256_loadu_ps(srcPh + i), s, c);
+      const auto m = _mm256_loadu_ps(srcMag + i);
+      interleave(_mm256_mul_ps(m, c), _mm256_mul_ps(m, s), dst + i);
+   }
+   scalar::convertPolarToCartesian(srcMag + i, srcPh + i, dst + i, n - i);
+}
+
+} // namespace avx2
+} // namespace vo
+} // namespace staffpad
+
+#endif
@@ -0,0 +1,212 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  VectorOpsTest.cpp
+
+**********************************************************************/
+#include "StaffPad/VectorOps.h"
+#include "StaffPadTimeAndPitch.h"
+#include "TimeAndPitchRealSource.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace staffpad;
+
+namespace
+{
+// Not a multiple of 8, to exercise the tails of the vectorized loops
+constexpr int32_t numBins = 2049;
+
+std::vector<std::complex<float>> MakeSpectrum(int32_t n)
+{
+   std::mt19937 engine { 42 };
+   std::uniform_real_distribution<float> dist { -10.f, 10.f };
+   std::vector<std::complex<float>> spectrum(n);
+   for (auto& value : spectrum)
+      value = { dist(engine), dist(engine) };
+   // Special cases of the phase computation
+   spectrum[0] = { 0.f, 0.f };
+   spectrum[1] = { -1.f, 0.f };
+   spectrum[2] = { 0.f, -1.f };
+   spectrum[3] = { 1.f, 1.f };
+   spectrum[4] = { -3.f, -3.f };
+   return spectrum;
+}
+
+float PhaseDistance(float a, float b)
+{
+   constexpr auto twoPi = 6.28318530717958647692f;
+   const auto d = std::fmod(std::abs(a - b), twoPi);
+   return std::min(d, twoPi - d);
+}
+
+template <typename Function> double SecondsPerCall(Function&& function)
+{
+   using namespace std::chrono;
+   constexpr auto numCalls = 2000;
+   const auto start = steady_clock::now();
+   for (auto i = 0; i < numCalls; ++i)
+      function();
+   return duration<double>(steady_clock::now() - start).count() / numCalls;
+}
+} // namespace
+
+TEST_CASE("VectorOps")
+{
+   const auto spectrum = MakeSpectrum(numBins);
+   std::vector<float> mag(numBins);
+   std::vector<float> phase(numBins);
+
+   SECTION("Magnitudes and phases in one pass are the same as separately")
+   {
+      std::vector<float> expectedMag(numBins);
+      std::vector<float> expectedPhase(numBins);
+      vo::calcMagnitudes(spectrum.data(), expectedMag.data(), numBins);
+      vo::calcPhases(spectrum.data(), expectedPhase.data(), numBins);
+      vo::calcMagnitudesAndPhases(
+         spectrum.data(), mag.data(), phase.data(), numBins);
+      REQUIRE(mag == expectedMag);
+      REQUIRE(phase == expectedPhase);
+   }
+
+   SECTION("Polar to cartesian inverts the conversion to polar")
+   {
+      vo::calcMagnitudesAndPhases(
+         spectrum.data(), mag.data(), phase.data(), numBins);
+      std::vector<std::complex<float>> result(numBins);
+      vo::convertPolarToCartesian(
+         mag.data(), phase.data(), result.data(), numBins);
+      for (auto i = 0; i < numBins; ++i)
+      {
+         REQUIRE(result[i].real() == Approx(spectrum[i].real()).margin(1e-4));
+         REQUIRE(result[i].imag() == Approx(spectrum[i].imag()).margin(1e-4));
+      }
+   }
+
+#if STAFFPAD_HAS_AVX2_KERNELS
+   SECTION("AVX2 kernels agree with the scalar ones")
+   {
+      if (!vo::avx2::isSupported())
+         return;
+      REQUIRE(vo::usesAvx2());
+
+      std::vector<float> expectedMag(numBins);
+      std::vector<float> expectedPhase(numBins);
+      vo::scalar::calcMagnitudesAndPhases(
+         spectrum.data(), expectedMag.data(), expectedPhase.data(), numBins);
+      vo::avx2::calcMagnitudesAndPhases(
+         spectrum.data(), mag.data(), phase.data(), numBins);
+      for (auto i = 0; i < numBins; ++i)
+      {
+         REQUIRE(mag[i] == Approx(expectedMag[i]).epsilon(1e-6));
+         REQUIRE(PhaseDistance(phase[i], expectedPhase[i]) < 1e-5f);
+      }
+
+      // Phases as they are after unwrapping
+      std::vector<float> phases(numBins);
+      for (auto i = 0; i < numBins; ++i)
+         phases[i] = -3.14159f + 6.28318f * i / numBins;
+      std::vector<std::complex<float>> expected(numBins);
+      std::vector<std::complex<float>> result(numBins);
+      vo::scalar::convertPolarToCartesian(
+         expectedMag.data(), phases.data(), expected.data(), numBins);
+      vo::avx2::convertPolarToCartesian(
+         expectedMag.data(), phases.data(), result.data(), numBins);
+      for (auto i = 0; i < numBins; ++i)
+      {
+         const auto tolerance = 1e-5f * std::max(1.f, expectedMag[i]);
+         REQUIRE(std::abs(result[i] - expected[i]) < tolerance);
+      }
+
+      std::vector<float> expectedProduct(numBins);
+      std::vector<float> product(numBins);
+      vo::scalar::multiply(
+         expectedMag.data(), phases.data(), expectedProduct.data(), numBins);
+      vo::avx2::multiply(
+         expectedMag.data(), phases.data(), product.data(), numBins);
+      REQUIRE(product == expectedProduct);
+      vo::scalar::constantMultiply(
+         expectedMag.data(), .5f, expectedProduct.data(), numBins);
+      vo::avx2::constantMultiply(
+         expectedMag.data(), .5f, product.data(), numBins);
+      REQUIRE(product == expectedProduct);
+   }
+#endif
+}
+
+// Hidden: run explicitly with the "[benchmark]" tag
+TEST_CASE("VectorOps throughput", "[.][benchmark]")
+{
+   const auto spectrum = MakeSpectrum(numBins);
+   std::vector<float> mag(numBins);
+   std::vector<float> phase(numBins);
+   std::vector<std::complex<float>> result(numBins);
+
+   const auto report = [](const char* name, double seconds) {
+      std::cout << name << ": " << numBins / seconds / 1e6
+                << " Mbins/s\n";
+   };
+   std::cout << "AVX2 kernels: " << (vo::usesAvx2() ? "yes" : "no") << "\n";
+   report("scalar magnitudes and phases", SecondsPerCall([&] {
+             vo::scalar::calcMagnitudesAndPhases(
+                spectrum.data(), mag.data(), phase.data(), numBins);
+          }));
+   report("dispatched magnitudes and phases", SecondsPerCall([&] {
+             vo::calcMagnitudesAndPhases(
+                spectrum.data(), mag.data(), phase.data(), numBins);
+          }));
+   report("scalar polar to cartesian", SecondsPerCall([&] {
+             vo::scalar::convertPolarToCartesian(
+                mag.data(), phase.data(), result.data(), numBins);
+          }));
+   report("dispatched polar to cartesian", SecondsPerCall([&] {
+             vo::convertPolarToCartesian(
+                mag.data(), phase.data(), result.data(), numBins);
+          }));
+}
+
+TEST_CASE("StaffPadTimeAndPitch throughput", "[.][benchmark]")
+{
+   constexpr auto sampleRate = 44100;
+   constexpr size_t numFrames = 30 * sampleRate;
+   constexpr size_t blockSize = 1024;
+   for (const auto numChannels : { 1u, 2u })
+   {
+      std::vector<std::vector<float>> input(numChannels);
+      for (auto ch = 0u; ch < numChannels; ++ch)
+      {
+         input[ch].resize(numFrames);
+         for (size_t i = 0; i < numFrames; ++i)
+            input[ch][i] =
+               .5f * std::sin(2 * 3.14159265f * (220.f + 110 * ch) * i /
+                              sampleRate);
+      }
+      TimeAndPitchInterface::Parameters params;
+      params.timeRatio = 1.5;
+      TimeAndPitchRealSource src(input);
+      StaffPadTimeAndPitch sut(numChannels, src, std::move(params));
+
+      std::vector<std::vector<float>> output(
+         numChannels, std::vector<float>(blockSize));
+      std::vector<float*> buffers(numChannels);
+      for (auto ch = 0u; ch < numChannels; ++ch)
+         buffers[ch] = output[ch].data();
+
+      using namespace std::chrono;
+      const auto start = steady_clock::now();
+      for (size_t done = 0; done < numFrames; done += blockSize)
+         sut.GetSamples(buffers.data(), blockSize);
+      const auto seconds = duration<double>(steady_clock::now() - start).count();
+      std::cout << numChannels << " channel(s): "
+                << numFrames / seconds / sampleRate
+                << " times real time at 44.1 kHz\n";
+   }
+}
@@ -0,0 +1,121 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file IntervalIndex.cpp
+
+ **********************************************************************/
+
+#include "IntervalIndex.h"
+
+#include <algorithm>
+
+/*
+ The tree is as in the cgranges library by Heng Li.  A node at index i is at
+ level k, where k is the count of trailing 1 bits of i; leaves, at level 0,
+ are the even indices.  The children of the node at index i and level k > 0
+ are at indices i - 2^(k-1) and i + 2^(k-1).  Nodes at indices beyond the
+ last interval have no interval, but their subtrees may have some.
+ */
+
+void IntervalIndex::clear()
+{
+   mStarts.clear();
+   mEnds.clear();
+   mMaxEnds.clear();
+   mRootLevel = -1;
+   mBuilt = true;
+}
+
+void IntervalIndex::reserve(size_t size)
+{
+   mStarts.reserve(size);
+   mEnds.reserve(size);
+}
+
+bool IntervalIndex::Append(double start, double end)
+{
+   if (!mStarts.empty() && start < mStarts.back())
+      return false;
+   mStarts.push_back(start);
+   mEnds.push_back(end);
+   mBuilt = false;
+   return true;
+}
+
+void IntervalIndex::Build() const
+{
+   const auto n = mStarts.size();
+   mMaxEnds = mEnds;
+   mRootLevel = -1;
+   mBuilt = true;
+   if (n == 0)
+      return;
+
+   // The greatest end of the subtree holding the last interval, which
+   // stands for the missing children of nodes beyond the last interval
+   size_t lastIndex = (n - 1) & ~size_t(1);
+   double lastMax = mMaxEnds[lastIndex];
+   int k = 1;
+   for (; (size_t(1) << k) <= n; ++k) {
+      const size_t x = size_t(1) << (k - 1);
+      const size_t step = x << 2;
+      for (size_t i = (x << 1) - 1; i < n; i += step) {
+         const auto left = mMaxEnds[i - x];
+         const auto right = i + x < n ? mMaxEnds[i + x] : lastMax;
+         mMaxEnds[i] = std::max({ mEnds[i], left, right });
+      }
+      lastIndex = (lastIndex >> k) & 1 ? lastIndex - x : lastIndex + x;
+      if (lastIndex < n)
+         lastMax = std::max(lastMax, mMaxEnds[lastIndex]);
+   }
+   mRootLevel = k - 1;
+}
+
+void IntervalIndex::Find(
+   double t0, double t1, std::vector<size_t> &result) const
+{
+   if (!mBuilt)
+      Build();
+   if (mRootLevel < 0)
+      return;
+
+   const auto n = mStarts.size();
+   struct Node {
+      size_t index;
+      int level;
+      //! Whether the left subtree was visited
+      bool visitedLeft;
+   };
+   // Deep enough for any tree that fits in memory
+   Node stack[64];
+   int depth = 0;
+   stack[depth++] = { (size_t(1) << mRootLevel) - 1, mRootLevel, false };
+   while (depth > 0) {
+      auto node = stack[--depth];
+      if (node.level <= 3) {
+         // Small subtree: scan it in order
+         const size_t first = node.index >> node.level << node.level;
+         const size_t last = std::min(
+            first + (size_t(1) << (node.level + 1)) - 1, n);
+         for (auto i = first; i < last && mStarts[i] <= t1; ++i)
+            if (mEnds[i] >= t0)
+               result.push_back(i);
+      }
+      else if (!node.visitedLeft) {
+         // Come back to this node after its left subtree
+         const auto left = node.index - (size_t(1) << (node.level - 1));
+         stack[depth++] = { node.index, node.level, true };
+         if (left >= n || mMaxEnds[left] >= t0)
+            stack[depth++] = { left, node.level - 1, false };
+      }
+      else if (node.index < n && mStarts[node.index] <= t1) {
+         // Intervals of the right subtree start no earlier than this one
+         if (mEnds[node.index] >= t0)
+            result.push_back(node.index);
+         stack[depth++] = {
+            node.index + (size_t(1) << (node.level - 1)), node.level - 1, false
+         };
+      }
+   }
+}
@@ -0,0 +1,59 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file IntervalIndex.h
+
+ @brief Finds which of many intervals, in order of their starts, meet a
+ given range
+
+ **********************************************************************/
+
+#ifndef __AUDACITY_INTERVAL_INDEX__
+#define __AUDACITY_INTERVAL_INDEX__
+
+#include <cstddef>
+#include <vector>
+
+//! Index of closed intervals, appended in order of non-decreasing start
+/*!
+ The intervals, sorted by start, are also the nodes of an implicit balanced
+ binary tree, in which each node knows the greatest end in its subtree.  A
+ query visits only subtrees that may hold a meeting interval, so it takes
+ time logarithmic in the number of intervals, plus linear in the number
+ found, even when some intervals are very long.
+
+ The tree is completed by the first query after appending.
+ */
+class UTILITY_API IntervalIndex final
+{
+public:
+   void clear();
+   void reserve(size_t size);
+   size_t size() const { return mStarts.size(); }
+   bool empty() const { return mStarts.empty(); }
+
+   //! Add an interval after all others
+   /*!
+    @return false, changing nothing, if `start` is less than the start of
+    the last interval
+    */
+   bool Append(double start, double end);
+
+   //! Append to `result` the indices, in increasing order, of exactly the
+   //! intervals that meet [t0, t1]
+   void Find(double t0, double t1, std::vector<size_t> &result) const;
+
+private:
+   void Build() const;
+
+   std::vector<double> mStarts;
+   std::vector<double> mEnds;
+   //! Greatest end in the subtree of each node
+   mutable std::vector<double> mMaxEnds;
+   //! Level of the root, whose index is 2 to this power, minus 1
+   mutable int mRootLevel{ -1 };
+   mutable bool mBuilt{ true };
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file LRUList.h
+
+ @brief Orders keys by when they were last used
+
+ **********************************************************************/
+
+#ifndef __AUDACITY_LRU_LIST__
+#define __AUDACITY_LRU_LIST__
+
+#include <cassert>
+#include <list>
+#include <unordered_map>
+
+//! Keys in order of last use, so that a cache with a limit on its size can
+//! find which entry to forget first
+/*!
+ All operations take constant time on average.  Not thread safe.
+ */
+template<typename Key, typename Hash = std::hash<Key>>
+class LRUList final
+{
+public:
+   size_t size() const { return mOrder.size(); }
+   bool empty() const { return mOrder.empty(); }
+
+   void clear()
+   {
+      mOrder.clear();
+      mPositions.clear();
+   }
+
+   bool Contains(const Key &key) const { return mPositions.count(key) > 0; }
+
+   //! Make `key` the most recently used, inserting it if absent
+   void Touch(const Key &key)
+   {
+      if (const auto iter = mPositions.find(key); iter != mPositions.end())
+         mOrder.splice(mOrder.begin(), mOrder, iter->second);
+      else {
+         mOrder.push_front(key);
+         try { mPositions.emplace(key, mOrder.begin()); }
+         catch (...) { mOrder.pop_front(); throw; }
+      }
+   }
+
+   //! Remove `key` if present
+   void Erase(const Key &key)
+   {
+      if (const auto iter = mPositions.find(key); iter != mPositions.end()) {
+         mOrder.erase(iter->second);
+         mPositions.erase(iter);
+      }
+   }
+
+   //! @pre `!empty()`
+   const Key &Oldest() const
+   {
+      assert(!empty());
+      return mOrder.back();
+   }
+
+   //! Remove the least recently used key and return it
+   //! @pre `!empty()`
+   Key PopOldest()
+   {
+      assert(!empty());
+      Key result = std::move(mOrder.back());
+      mPositions.erase(result);
+      mOrder.pop_back();
+      return result;
+   }
+
+private:
+   //! Most recently used first
+   std::list<Key> mOrder;
+   std::unordered_map<Key, typename std::list<Key>::iterator, Hash>
+      mPositions;
+};
+
+#endif
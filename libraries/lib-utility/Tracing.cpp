@@ -0,0 +1,347 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file Tracing.cpp
+
+**********************************************************************/
+#include "Tracing.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tracing {
+
+namespace detail {
+std::atomic<bool> enabled{ false };
+}
+
+namespace {
+
+struct Event {
+   const char *category;
+   const char *name;
+   uint64_t start;
+   uint64_t duration;
+   //! Identifies the thread, which may not be the only one to have used
+   //! the buffer
+   uint32_t thread;
+   //! As in the trace event format: 'X' complete, 'B' begin, 'E' end, and
+   //! 'M' for the name of the thread
+   char phase;
+};
+
+//! Single producer, single consumer queue of the events of one thread
+struct ThreadBuffer {
+   static constexpr size_t Capacity = 1 << 15;
+
+   ThreadBuffer() : events(Capacity) {}
+
+   //! @return whether there was room for the event
+   bool Push(const Event &event) noexcept
+   {
+      const auto h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) >= Capacity) {
+         dropped.fetch_add(1, std::memory_order_relaxed);
+         return false;
+      }
+      events[h % Capacity] = event;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+   }
+
+   std::vector<Event> events;
+   //! Written only by the owning thread
+   std::atomic<size_t> head{ 0 };
+   //! Written only by the exporting thread
+   std::atomic<size_t> tail{ 0 };
+   //! Set when a thread claims the buffer, and reset when it exits
+   std::atomic<bool> claimed{ false };
+   std::atomic<uint64_t> dropped{ 0 };
+};
+
+//! Buffers are allocated all at once by the first SetEnabled(true), so that
+//! a thread recording its first event, which may be the audio callback,
+//! only claims one without locking or allocating
+constexpr size_t MaxThreads = 32;
+
+struct Registry {
+   //! Serializes allocation, export and clearing
+   std::mutex mutex;
+   //! Buffers outlive their threads, so that late exports see all events
+   std::unique_ptr<ThreadBuffer> buffers[MaxThreads];
+   //! Published copies of the pointers in buffers, for claiming without
+   //! the mutex
+   std::atomic<ThreadBuffer *> slots[MaxThreads]{};
+   //! Events of threads that found no unclaimed buffer
+   std::atomic<uint64_t> unregisteredDropped{ 0 };
+   //! 0 is for the events of untraced threads
+   std::atomic<uint32_t> nextThread{ 1 };
+   //! Names of threads, as exported so far; used only by the exporter
+   std::unordered_map<uint32_t, const char *> threadNames;
+};
+
+Registry &GetRegistry()
+{
+   static Registry registry;
+   return registry;
+}
+
+//! Gives the buffer of a thread back when the thread exits
+/*!
+ Its destructor is registered when the thread claims a buffer, which may
+ allocate, once for each thread
+ */
+struct BufferOwner {
+   ~BufferOwner()
+   {
+      if (pBuffer)
+         pBuffer->claimed.store(false, std::memory_order_release);
+   }
+
+   ThreadBuffer *pBuffer{};
+};
+
+thread_local BufferOwner tOwner;
+// The rest of the thread's state is trivially destructible, so that its use
+// does not register anything
+thread_local ThreadBuffer *tBuffer = nullptr;
+thread_local uint32_t tThread = 0;
+thread_local const char *tThreadName = nullptr;
+//! Whether the Begin at each level of nesting was recorded, for the
+//! innermost 64 levels
+thread_local uint64_t tBegun = 0;
+thread_local unsigned tDepth = 0;
+
+ThreadBuffer *GetBuffer() noexcept
+{
+   if (!tBuffer) {
+      auto &registry = GetRegistry();
+      for (size_t ii = 0; ii < MaxThreads; ++ii) {
+         const auto pBuffer =
+            registry.slots[ii].load(std::memory_order_acquire);
+         if (!pBuffer)
+            break;
+         if (!pBuffer->claimed.exchange(true, std::memory_order_acq_rel)) {
+            tOwner.pBuffer = tBuffer = pBuffer;
+            tThread =
+               registry.nextThread.fetch_add(1, std::memory_order_relaxed);
+            if (tThreadName)
+               pBuffer->Push({ nullptr, tThreadName, 0, 0, tThread, 'M' });
+            break;
+         }
+      }
+   }
+   return tBuffer;
+}
+
+//! @return whether the event was recorded
+bool Push(Event event) noexcept
+{
+   if (const auto pBuffer = GetBuffer()) {
+      event.thread = tThread;
+      return pBuffer->Push(event);
+   }
+   GetRegistry().unregisteredDropped.fetch_add(1, std::memory_order_relaxed);
+   return false;
+}
+
+void WriteString(std::ostream &stream, const char *str)
+{
+   stream << '"';
+   for (; str && *str; ++str) {
+      const auto c = *str;
+      if (c == '"' || c == '\\')
+         stream << '\\' << c;
+      else if (static_cast<unsigned char>(c) < 0x20)
+         stream << ' ';
+      else
+         stream << c;
+   }
+   stream << '"';
+}
+
+//! Trace event timestamps are in microseconds
+void WriteTime(std::ostream &stream, uint64_t nanoseconds)
+{
+   const auto fraction = nanoseconds % 1000;
+   stream << nanoseconds / 1000 << '.'
+      << fraction / 100 << (fraction / 10) % 10 << fraction % 10;
+}
+}
+
+void SetEnabled(bool enabled)
+{
+   if (enabled) {
+      auto &registry = GetRegistry();
+      std::lock_guard<std::mutex> lock{ registry.mutex };
+      for (size_t ii = 0; ii < MaxThreads; ++ii) {
+         if (registry.buffers[ii])
+            continue;
+         try {
+            registry.buffers[ii] = std::make_unique<ThreadBuffer>();
+         }
+         catch (...) {
+            // Trace fewer threads
+            break;
+         }
+         registry.slots[ii].store(
+            registry.buffers[ii].get(), std::memory_order_release);
+      }
+   }
+   detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SetThreadName(const char *name)
+{
+   tThreadName = name;
+   if (tBuffer)
+      tBuffer->Push({ nullptr, name, 0, 0, tThread, 'M' });
+}
+
+uint64_t Now() noexcept
+{
+   using namespace std::chrono;
+   // Never 0, which Zone takes to mean disabled
+   return 1 + duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+}
+
+void AddZone(const char *category, const char *name,
+   uint64_t start, uint64_t end) noexcept
+{
+   if (IsEnabled())
+      Push({ category, name, start, end > start ? end - start : 0, 0, 'X' });
+}
+
+void Begin(const char *category, const char *name) noexcept
+{
+   const auto recorded =
+      IsEnabled() && Push({ category, name, Now(), 0, 0, 'B' });
+   if (tDepth < 64) {
+      const auto bit = uint64_t{ 1 } << tDepth;
+      tBegun = recorded ? tBegun | bit : tBegun & ~bit;
+   }
+   ++tDepth;
+}
+
+void End(const char *category, const char *name) noexcept
+{
+   if (tDepth == 0)
+      return;
+   --tDepth;
+   // Don't test IsEnabled(), so that zones are not left open, but don't end
+   // a zone whose beginning was not recorded
+   if (tDepth < 64 && (tBegun >> tDepth) & 1)
+      Push({ category, name, Now(), 0, 0, 'E' });
+}
+
+size_t WriteChromeTrace(std::ostream &stream)
+{
+   auto &registry = GetRegistry();
+   std::lock_guard<std::mutex> lock{ registry.mutex };
+
+   size_t count = 0;
+   const char *separator = "\n";
+   // Zones begun in this export and not yet ended, by thread; the end of a
+   // zone begun in an earlier export, or cleared, is left out
+   std::unordered_map<uint32_t, size_t> depths;
+   stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+   for (auto &pBuffer : registry.buffers) {
+      if (!pBuffer)
+         break;
+      auto &buffer = *pBuffer;
+
+      const auto tail = buffer.tail.load(std::memory_order_relaxed);
+      const auto head = buffer.head.load(std::memory_order_acquire);
+      for (auto ii = tail; ii != head; ++ii) {
+         const auto &event = buffer.events[ii % ThreadBuffer::Capacity];
+         auto &depth = depths[event.thread];
+         if (event.phase == 'M') {
+            registry.threadNames[event.thread] = event.name;
+            continue;
+         }
+         else if (event.phase == 'B')
+            ++depth;
+         else if (event.phase == 'E') {
+            if (depth == 0)
+               continue;
+            --depth;
+         }
+         stream << separator << "{\"ph\":\"" << event.phase << "\",\"cat\":";
+         WriteString(stream, event.category);
+         stream << ",\"name\":";
+         WriteString(stream, event.name);
+         stream << ",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+         WriteTime(stream, event.start);
+         if (event.phase == 'X') {
+            stream << ",\"dur\":";
+            WriteTime(stream, event.duration);
+         }
+         stream << "}";
+         separator = ",\n";
+         ++count;
+      }
+      buffer.tail.store(head, std::memory_order_release);
+
+      if (auto dropped =
+          buffer.dropped.exchange(0, std::memory_order_relaxed)) {
+         // Not attributed to a thread, because several may have used the
+         // buffer
+         stream << separator
+            << "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"dropped events\",\"pid\":1,\"tid\":0,\"ts\":";
+         WriteTime(stream, Now());
+         stream << ",\"args\":{\"count\":" << dropped << "}}";
+         separator = ",\n";
+      }
+   }
+   // Name the threads of this export, also those named in earlier ones
+   for (const auto &entry : depths) {
+      const auto thread = entry.first;
+      const auto iter = registry.threadNames.find(thread);
+      if (iter == registry.threadNames.end())
+         continue;
+      stream << separator
+         << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+         << thread << ",\"args\":{\"name\":";
+      WriteString(stream, iter->second);
+      stream << "}}";
+      separator = ",\n";
+   }
+   if (auto dropped = registry.unregisteredDropped.exchange(
+       0, std::memory_order_relaxed)) {
+      stream << separator
+         << "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"events of untraced threads\",\"pid\":1,\"tid\":0,\"ts\":";
+      WriteTime(stream, Now());
+      stream << ",\"args\":{\"count\":" << dropped << "}}";
+   }
+   stream << "\n]}\n";
+   return count;
+}
+
+void Clear()
+{
+   auto &registry = GetRegistry();
+   std::lock_guard<std::mutex> lock{ registry.mutex };
+   for (auto &pBuffer : registry.buffers) {
+      if (!pBuffer)
+         break;
+      auto &buffer = *pBuffer;
+      const auto tail = buffer.tail.load(std::memory_order_relaxed);
+      const auto head = buffer.head.load(std::memory_order_acquire);
+      // Keep the names for later exports
+      for (auto ii = tail; ii != head; ++ii) {
+         const auto &event = buffer.events[ii % ThreadBuffer::Capacity];
+         if (event.phase == 'M')
+            registry.threadNames[event.thread] = event.name;
+      }
+      buffer.tail.store(head, std::memory_order_release);
+      buffer.dropped.store(0, std::memory_order_relaxed);
+   }
+   registry.unregisteredDropped.store(0, std::memory_order_relaxed);
+}
+
+}
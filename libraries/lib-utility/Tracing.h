@@ -0,0 +1,108 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file Tracing.h
+  @brief Low overhead recording of timed zones, per thread, exportable in
+  the Chrome trace event format
+
+**********************************************************************/
+#ifndef __AUDACITY_TRACING__
+#define __AUDACITY_TRACING__
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+//! Recording of named time intervals in any thread
+/*!
+ Each thread writes its events to its own fixed size buffer, without locks
+ or allocations, also for its first event, which claims one of the buffers
+ that SetEnabled(true) allocates.  If a buffer is full, further events of the
+ thread are dropped until the next export.  A thread gives its buffer back
+ when it exits, keeping the events for export; registering that may allocate
+ once per thread, when it claims a buffer.  Events of threads beyond the
+ fixed count of buffers in use at once are only counted.
+
+ The end of a zone is left out of the export if its beginning was not
+ recorded, or was exported or cleared earlier.
+
+ When tracing is disabled, a zone costs one relaxed atomic load.
+
+ The result can be viewed in chrome://tracing or in Perfetto.
+
+ Names and categories must be string literals or otherwise outlive the
+ export of the trace.
+ */
+namespace Tracing {
+
+namespace detail {
+extern UTILITY_API std::atomic<bool> enabled;
+}
+
+//! May be called in any thread
+inline bool IsEnabled() noexcept
+{
+   return detail::enabled.load(std::memory_order_relaxed);
+}
+
+//! Turn recording on or off; events already recorded are kept
+/*! The first call with true allocates the buffers; not for realtime threads */
+UTILITY_API void SetEnabled(bool enabled);
+
+//! Name shown for the calling thread in the trace; call it once per thread
+UTILITY_API void SetThreadName(const char *name);
+
+//! Nanoseconds on a steady clock
+UTILITY_API uint64_t Now() noexcept;
+
+//! Record a complete zone of the calling thread
+UTILITY_API void AddZone(const char *category, const char *name,
+   uint64_t start, uint64_t end) noexcept;
+
+//! Record the start of a zone, which must be ended in the same thread
+UTILITY_API void Begin(const char *category, const char *name) noexcept;
+//! Record the end of the innermost zone started with Begin
+UTILITY_API void End(const char *category, const char *name) noexcept;
+
+//! Write the events of all threads as trace event JSON, and discard them
+/*!
+ Call while no other thread exports or clears
+ @return how many events were written
+ */
+UTILITY_API size_t WriteChromeTrace(std::ostream &stream);
+
+//! Discard events of all threads
+UTILITY_API void Clear();
+
+//! Records the time from its construction to its destruction
+class Zone final {
+public:
+   Zone(const char *category, const char *name) noexcept
+      : mCategory{ category }, mName{ name }
+      , mStart{ IsEnabled() ? Now() : 0 }
+   {}
+   Zone(const Zone&) = delete;
+   Zone &operator=(const Zone&) = delete;
+   ~Zone()
+   {
+      if (mStart)
+         AddZone(mCategory, mName, mStart, Now());
+   }
+
+private:
+   const char *const mCategory;
+   const char *const mName;
+   const uint64_t mStart;
+};
+
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+//! Time the rest of the enclosing scope
+#define TRACE_ZONE(category, name) \
+   const ::Tracing::Zone TRACE_CONCAT(traceZone, __LINE__){ category, name }
+
+#endif
@@ -0,0 +1,173 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  IntervalIndexTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "IntervalIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+struct Interval { double start, end; };
+
+//! Like labels of speech segments: mostly short and disjoint, some points,
+//! and now and then a long one
+std::vector<Interval> MakeIntervals(size_t n, unsigned seed)
+{
+   std::mt19937 engine{ seed };
+   std::exponential_distribution<double> gap{ 2.0 };
+   std::exponential_distribution<double> length{ 1.0 };
+   std::uniform_int_distribution<int> kind{ 0, 99 };
+   std::vector<Interval> result;
+   result.reserve(n);
+   double start = 0;
+   for (size_t ii = 0; ii < n; ++ii) {
+      start += gap(engine);
+      const auto k = kind(engine);
+      const auto len = k < 10 ? 0 : k < 98 ? length(engine) : 100 * length(engine);
+      result.push_back({ start, start + len });
+   }
+   return result;
+}
+
+IntervalIndex MakeIndex(const std::vector<Interval> &intervals)
+{
+   IntervalIndex index;
+   index.reserve(intervals.size());
+   for (auto &interval : intervals)
+      REQUIRE(index.Append(interval.start, interval.end));
+   return index;
+}
+
+bool Meets(const Interval &interval, double t0, double t1)
+{
+   return interval.start <= t1 && interval.end >= t0;
+}
+
+std::vector<size_t> Find(const IntervalIndex &index, double t0, double t1)
+{
+   std::vector<size_t> result;
+   index.Find(t0, t1, result);
+   return result;
+}
+
+std::vector<size_t> FindSlowly(
+   const std::vector<Interval> &intervals, double t0, double t1)
+{
+   std::vector<size_t> result;
+   for (size_t ii = 0; ii < intervals.size(); ++ii)
+      if (Meets(intervals[ii], t0, t1))
+         result.push_back(ii);
+   return result;
+}
+}
+
+TEST_CASE("IntervalIndex")
+{
+   SECTION("Empty index finds nothing")
+   {
+      IntervalIndex index;
+      REQUIRE(Find(index, 0, 10).empty());
+   }
+
+   SECTION("Out of order starts are refused")
+   {
+      IntervalIndex index;
+      REQUIRE(index.Append(1, 2));
+      REQUIRE(index.Append(1, 1));
+      REQUIRE(!index.Append(0.5, 3));
+      REQUIRE(index.size() == 2);
+   }
+
+   SECTION("Queries find exactly the intervals that meet the range")
+   {
+      for (const size_t size : { 1, 2, 3, 7, 8, 9, 100, 2000 }) {
+         const auto intervals = MakeIntervals(size, 42);
+         const auto index = MakeIndex(intervals);
+         std::mt19937 engine{ 43 };
+         std::uniform_real_distribution<double> position{
+            -10, intervals.back().end + 10 };
+         std::exponential_distribution<double> width{ 0.5 };
+         for (int trial = 0; trial < 1000; ++trial) {
+            const auto t0 = position(engine);
+            const auto t1 = trial % 10 == 0 ? t0 : t0 + width(engine);
+            REQUIRE(Find(index, t0, t1) == FindSlowly(intervals, t0, t1));
+         }
+      }
+   }
+
+   SECTION("Closed intervals meet at their ends")
+   {
+      IntervalIndex index;
+      REQUIRE(index.Append(1, 2));
+      REQUIRE(index.Append(3, 3));
+      REQUIRE(Find(index, 2, 3) == std::vector<size_t>{ 0, 1 });
+      REQUIRE(Find(index, 2.5, 2.75).empty());
+   }
+
+   SECTION("A long interval is found without the others before it")
+   {
+      std::vector<Interval> intervals{ { 0, 1e6 } };
+      for (int ii = 1; ii < 100000; ++ii)
+         intervals.push_back({ double(ii), ii + 0.5 });
+      const auto index = MakeIndex(intervals);
+      REQUIRE(Find(index, 50000.75, 50000.8) == std::vector<size_t>{ 0 });
+      REQUIRE(Find(index, 50000.25, 50000.3) ==
+         (std::vector<size_t>{ 0, 50000 }));
+   }
+
+   SECTION("Appending after a query extends the tree")
+   {
+      IntervalIndex index;
+      REQUIRE(index.Append(0, 1));
+      REQUIRE(Find(index, 5, 6).empty());
+      REQUIRE(index.Append(2, 10));
+      REQUIRE(Find(index, 5, 6) == std::vector<size_t>{ 1 });
+   }
+}
+
+// Hidden: run explicitly with the "[benchmark]" tag
+TEST_CASE("IntervalIndex with a million labels", "[.][benchmark]")
+{
+   using Clock = std::chrono::steady_clock;
+   constexpr size_t numLabels = 1000000;
+   const auto intervals = MakeIntervals(numLabels, 44);
+
+   auto start = Clock::now();
+   const auto index = MakeIndex(intervals);
+   // The first query completes the tree
+   Find(index, 0, 0);
+   const auto buildTime = Clock::now() - start;
+
+   // Windows of about as many seconds as a screen shows when zoomed in
+   std::mt19937 engine{ 45 };
+   std::uniform_real_distribution<double> position{ 0, intervals.back().end };
+   constexpr int numQueries = 100000;
+   size_t found = 0;
+   std::vector<size_t> result;
+   start = Clock::now();
+   for (int ii = 0; ii < numQueries; ++ii) {
+      const auto t0 = position(engine);
+      result.clear();
+      index.Find(t0, t0 + 20, result);
+      found += result.size();
+   }
+   const auto queryTime = Clock::now() - start;
+
+   using namespace std::chrono;
+   std::cout << "Build index of " << numLabels << " labels: "
+      << duration_cast<milliseconds>(buildTime).count() << " ms\n"
+      << "Query: "
+      << duration_cast<nanoseconds>(queryTime).count() / numQueries
+      << " ns, " << double(found) / numQueries << " labels found\n";
+   REQUIRE(found > 0);
+}
@@ -0,0 +1,82 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  LRUListTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "LRUList.h"
+
+#include <vector>
+
+namespace {
+std::vector<int> PopAll(LRUList<int> &list)
+{
+   std::vector<int> result;
+   while (!list.empty())
+      result.push_back(list.PopOldest());
+   return result;
+}
+}
+
+TEST_CASE("LRUList", "[LRUList]")
+{
+   LRUList<int> list;
+   REQUIRE(list.empty());
+   for (auto key : { 1, 2, 3, 4 })
+      list.Touch(key);
+   REQUIRE(list.size() == 4);
+   CHECK(list.Oldest() == 1);
+
+   SECTION("Keys are popped in order of first use, if used once")
+   {
+      CHECK(PopAll(list) == std::vector{ 1, 2, 3, 4 });
+   }
+
+   SECTION("Using a key again makes it the newest, without duplicating it")
+   {
+      list.Touch(1);
+      list.Touch(3);
+      CHECK(list.size() == 4);
+      CHECK(PopAll(list) == std::vector{ 2, 4, 1, 3 });
+   }
+
+   SECTION("Erased keys are not popped")
+   {
+      list.Erase(2);
+      list.Erase(5);
+      CHECK(!list.Contains(2));
+      CHECK(list.Contains(3));
+      CHECK(list.size() == 3);
+      CHECK(PopAll(list) == std::vector{ 1, 3, 4 });
+   }
+
+   SECTION("Popped keys may be used again")
+   {
+      CHECK(list.PopOldest() == 1);
+      CHECK(!list.Contains(1));
+      list.Touch(1);
+      CHECK(PopAll(list) == std::vector{ 2, 3, 4, 1 });
+   }
+
+   SECTION("Keeping a limit")
+   {
+      constexpr size_t Limit = 3;
+      for (auto key : { 5, 2, 6 }) {
+         list.Touch(key);
+         while (list.size() > Limit)
+            list.PopOldest();
+      }
+      CHECK(PopAll(list) == std::vector{ 5, 2, 6 });
+   }
+
+   SECTION("clear")
+   {
+      list.clear();
+      CHECK(list.empty());
+      CHECK(!list.Contains(1));
+   }
+}
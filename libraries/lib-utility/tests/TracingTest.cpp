@@ -0,0 +1,157 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  TracingTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "Tracing.h"
+
+#include <atomic>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+size_t Count(const std::string &text, const std::string &pattern)
+{
+   size_t result = 0;
+   for (auto pos = text.find(pattern); pos != std::string::npos;
+      pos = text.find(pattern, pos + 1))
+      ++result;
+   return result;
+}
+}
+
+TEST_CASE("Tracing")
+{
+   Tracing::Clear();
+
+   SECTION("Nothing is recorded while disabled")
+   {
+      Tracing::SetEnabled(false);
+      {
+         TRACE_ZONE("test", "disabled");
+      }
+      std::ostringstream stream;
+      REQUIRE(Tracing::WriteChromeTrace(stream) == 0);
+      REQUIRE(Count(stream.str(), "disabled") == 0);
+   }
+
+   SECTION("Zones of several threads are exported once")
+   {
+      Tracing::SetEnabled(true);
+      {
+         TRACE_ZONE("test", "main \"zone\"");
+      }
+      std::thread worker{ []{
+         Tracing::SetThreadName("Worker");
+         for (int ii = 0; ii < 3; ++ii) {
+            TRACE_ZONE("test", "worker zone");
+         }
+         Tracing::Begin("test", "open zone");
+         Tracing::End("test", "open zone");
+      } };
+      worker.join();
+      Tracing::SetEnabled(false);
+
+      std::ostringstream stream;
+      REQUIRE(Tracing::WriteChromeTrace(stream) == 6);
+      const auto text = stream.str();
+      REQUIRE(Count(text, "\"main \\\"zone\\\"\"") == 1);
+      REQUIRE(Count(text, "\"worker zone\"") == 3);
+      REQUIRE(Count(text, "\"ph\":\"B\"") == 1);
+      REQUIRE(Count(text, "\"ph\":\"E\"") == 1);
+      REQUIRE(Count(text, "\"Worker\"") == 1);
+
+      // Exported events are discarded
+      std::ostringstream again;
+      REQUIRE(Tracing::WriteChromeTrace(again) == 0);
+   }
+
+   SECTION("Buffers of threads that exited are used again")
+   {
+      // More than the buffers, but never more than two threads at once
+      constexpr int nThreads = 100;
+      Tracing::SetEnabled(true);
+      for (int ii = 0; ii < nThreads; ++ii) {
+         std::thread{ []{
+            Tracing::SetThreadName("Short lived");
+            TRACE_ZONE("test", "short lived");
+         } }.join();
+      }
+      Tracing::SetEnabled(false);
+
+      std::ostringstream stream;
+      REQUIRE(Tracing::WriteChromeTrace(stream) == nThreads);
+      const auto text = stream.str();
+      REQUIRE(Count(text, "\"short lived\"") == nThreads);
+      REQUIRE(Count(text, "\"Short lived\"") == nThreads);
+      REQUIRE(Count(text, "\"events of untraced threads\"") == 0);
+   }
+
+   SECTION("Events of threads beyond the buffers are only counted")
+   {
+      constexpr int nThreads = 40;
+      Tracing::SetEnabled(true);
+      std::promise<void> release;
+      const auto released = release.get_future().share();
+      std::atomic<int> started{ 0 };
+      std::vector<std::thread> threads;
+      for (int ii = 0; ii < nThreads; ++ii)
+         threads.emplace_back([&]{
+            {
+               TRACE_ZONE("test", "concurrent");
+            }
+            ++started;
+            // Keep the buffer until all threads have recorded
+            released.wait();
+         });
+      while (started < nThreads)
+         std::this_thread::yield();
+      release.set_value();
+      for (auto &thread : threads)
+         thread.join();
+      Tracing::SetEnabled(false);
+
+      std::ostringstream stream;
+      const auto count = Tracing::WriteChromeTrace(stream);
+      REQUIRE(count > 0);
+      REQUIRE(count < nThreads);
+      const auto text = stream.str();
+      REQUIRE(Count(text, "\"concurrent\"") == count);
+      REQUIRE(Count(text, "\"events of untraced threads\"") == 1);
+   }
+
+   SECTION("Ends of zones whose beginnings are not exported are left out")
+   {
+      std::thread{ []{
+         // Begun while disabled
+         Tracing::SetEnabled(false);
+         Tracing::Begin("test", "unrecorded");
+         Tracing::SetEnabled(true);
+         Tracing::End("test", "unrecorded");
+
+         // Begun before the last export
+         Tracing::Begin("test", "exported");
+         std::ostringstream stream;
+         Tracing::WriteChromeTrace(stream);
+         Tracing::End("test", "exported");
+
+         // Begun before clearing
+         Tracing::Begin("test", "cleared");
+         Tracing::Clear();
+         Tracing::End("test", "cleared");
+      } }.join();
+      Tracing::SetEnabled(false);
+
+      std::ostringstream stream;
+      REQUIRE(Tracing::WriteChromeTrace(stream) == 0);
+      REQUIRE(Count(stream.str(), "\"ph\":\"E\"") == 0);
+   }
+}
@@ -10,6 +10,7 @@
 **********************************************************************/
 #include "CachingPlayableSequence.h"
 #include "AudioSegmentSampleView.h"
+#include "StretchedClipCache.h"
 #include "WaveTrack.h"
 
 #include <cassert>
@@ -33,6 +34,18 @@ void FillBufferFromTrackBlockSequence(
 CachingPlayableSequence::CachingPlayableSequence(const WaveTrack& waveTrack)
     : mWaveTrack { waveTrack }
 {
+   auto& cache = StretchedClipCache::Get();
+   const auto findRenders = [&](const WaveTrack& track) {
+      for (const auto& clip : track.GetClips())
+         // Returns null at once for unstretched clips
+         if (auto render = cache.Find(*clip))
+            mRenders.emplace(clip.get(), std::move(render));
+   };
+   if (waveTrack.GetOwner())
+      for (const auto pChannel : TrackList::Channels(&waveTrack))
+         findRenders(*pChannel);
+   else
+      findRenders(waveTrack);
 }
 
 const WideSampleSequence* CachingPlayableSequence::DoGetDecorated() const
@@ -59,8 +72,8 @@ bool CachingPlayableSequence::Get(size_t iChannel, size_t nBuffers,
   // need backward access. Leaving it unimplemented at least for now.
   assert(!backwards);
   assert(iChannel + nBuffers <= mWaveTrack.NChannels());
-  mCacheHolders =
-      mWaveTrack.GetSampleView(iChannel, nBuffers, start, len, backwards);
+  mCacheHolders = mWaveTrack.GetSampleView(
+      iChannel, nBuffers, start, len, backwards, &mRenders);
   assert(mCacheHolders.size() == nBuffers);
   for (auto i = 0u; i < mCacheHolders.size(); ++i)
     FillBufferFromTrackBlockSequence(
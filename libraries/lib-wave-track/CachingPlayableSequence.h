@@ -12,6 +12,7 @@
 
 #include "AudioIOSequences.h"
 #include "AudioSegmentSampleView.h"
+#include "StretchedClipCache.h"
 
 #include <memory>
 
@@ -24,6 +25,10 @@ using ChannelSampleView = std::vector<AudioSegmentSampleView>;
  * A new fetch only happens when the new `Get` does not overlap the underlying
  * sample block (up to 1MB of audio) of the previous `Get`. Cache misses are
  * thus rare for continuous forward or backward sample readout.
+ *
+ * Stretched clips are read from their background renders in
+ * `StretchedClipCache` if complete when the sequence is made, and scheduled
+ * for rendering otherwise.
  */
 class WAVE_TRACK_API CachingPlayableSequence final : public PlayableSequence
 {
@@ -57,6 +62,8 @@ public:
 
 private:
    const WaveTrack& mWaveTrack;
+   //! Found at construction, so that `Get` does not search the cache
+   StretchedClipRenders mRenders;
    // Ok to have it mutable so long as it is used by one thread only.
    // One per channel.
    mutable std::vector<ChannelSampleView> mCacheHolders;
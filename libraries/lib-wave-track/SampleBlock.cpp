@@ -56,6 +56,56 @@ SampleBlockPtr SampleBlockFactory::CreateFromXML(
    return result;
 }
 
+SampleBlockPtr SampleBlockFactory::CreateDeferred(
+   std::shared_ptr<const SampleBlockSource> pSource)
+{
+   if (!pSource)
+      THROW_INCONSISTENCY_EXCEPTION;
+   auto result = DoCreateDeferred(std::move(pSource));
+   if (!result)
+      THROW_INCONSISTENCY_EXCEPTION;
+   Publisher<SampleBlockCreateMessage>::Publish({});
+   return result;
+}
+
+SampleBlockPtr SampleBlockFactory::CreateCopy(
+   const SampleBlockPtr &pBlock, sampleFormat format)
+{
+   if (!pBlock)
+      THROW_INCONSISTENCY_EXCEPTION;
+   auto result = DoCreateCopy(pBlock, format);
+   if (!result)
+      THROW_INCONSISTENCY_EXCEPTION;
+   Publisher<SampleBlockCreateMessage>::Publish({});
+   return result;
+}
+
+void SampleBlockFactory::MaterializeAll()
+{
+}
+
+SampleBlockPtr SampleBlockFactory::DoCreateDeferred(
+   std::shared_ptr<const SampleBlockSource> pSource)
+{
+   const auto format = pSource->GetSampleFormat();
+   const auto numsamples = pSource->GetSampleCount();
+   SampleBuffer buffer(numsamples, format);
+   if (!pSource->Read(buffer.ptr(), 0, numsamples))
+      return nullptr;
+   return DoCreate(buffer.ptr(), numsamples, format);
+}
+
+SampleBlockPtr SampleBlockFactory::DoCreateCopy(
+   const SampleBlockPtr &pBlock, sampleFormat format)
+{
+   const auto numsamples = pBlock->GetSampleCount();
+   SampleBuffer buffer(numsamples, format);
+   pBlock->GetSamples(buffer.ptr(), format, 0, numsamples);
+   return DoCreate(buffer.ptr(), numsamples, format);
+}
+
+SampleBlockSource::~SampleBlockSource() = default;
+
 SampleBlock::~SampleBlock() = default;
 
 size_t SampleBlock::GetSamples(samplePtr dest,
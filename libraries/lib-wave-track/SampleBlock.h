@@ -15,6 +15,7 @@ SampleBlock.h
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <unordered_set>
 
 #include "Observer.h"
@@ -109,6 +110,35 @@ BlockSpaceUsageAccumulator (unsigned long long &total)
    };
 };
 
+//! Samples kept outside of the project, such as in an imported file, that a
+//! block may read until it copies them into the project
+class WAVE_TRACK_API SampleBlockSource
+{
+public:
+   //! Recreates a source from the result of Serialize(), when a project that
+   //! still refers to it is reopened
+   /*! Returns null if the string is not understood */
+   struct WAVE_TRACK_API Restorer : GlobalHook<Restorer,
+      std::shared_ptr<const SampleBlockSource>(const std::string &)
+   >{};
+
+   virtual ~SampleBlockSource();
+
+   virtual sampleFormat GetSampleFormat() const = 0;
+   virtual size_t GetSampleCount() const = 0;
+
+   //! Read samples in GetSampleFormat(); may be called from any thread
+   /*!
+    @pre `offset + len <= GetSampleCount()`
+    @return false if the samples are gone, or changed since the source was
+    made
+    */
+   virtual bool Read(samplePtr dest, size_t offset, size_t len) const = 0;
+
+   //! Describes the source so that a Restorer can make it again
+   virtual std::string Serialize() const = 0;
+};
+
 struct SampleBlockCreateMessage { };
 
 ///\brief abstract base class with methods to produce @ref SampleBlock objects
@@ -141,10 +171,36 @@ public:
       sampleFormat srcformat,
       const AttributesList &attrs);
 
+   //! Returns a non-null pointer or else throws an exception
+   /*!
+    The block may go on reading from the source, until the factory copies the
+    samples in the background, or before the project is copied
+    */
+   SampleBlockPtr CreateDeferred(
+      std::shared_ptr<const SampleBlockSource> pSource);
+
+   //! Returns a non-null pointer to a block with the samples of a block that
+   //! another factory made, or else throws an exception
+   /*!
+    @param format the format in which the samples of `pBlock` are stored
+    */
+   SampleBlockPtr CreateCopy(
+      const SampleBlockPtr &pBlock, sampleFormat format);
+
+   //! Copy now the samples of all blocks that are still read from their
+   //! sources
+   /*! The default does nothing, which suits factories that copy at once */
+   virtual void MaterializeAll();
+
    using SampleBlockIDs = std::unordered_set<SampleBlockID>;
    /*! @return ids of all sample blocks created by this factory and still extant */
    virtual SampleBlockIDs GetActiveBlockIDs() = 0;
 
+   //! Bytes of samples per block for new sequences of the project; 0 means
+   //! that of Sequence::GetMaxDiskBlockSize()
+   size_t GetMaxDiskBlockSize() const { return mMaxDiskBlockSize; }
+   void SetMaxDiskBlockSize(size_t bytes) { mMaxDiskBlockSize = bytes; }
+
 protected:
    // The override should throw more informative exceptions on error than the
    // default InconsistencyException thrown by Create
@@ -163,6 +219,17 @@ protected:
    virtual SampleBlockPtr DoCreateFromXML(
       sampleFormat srcformat,
       const AttributesList &attrs) = 0;
+
+   //! The default reads all samples of the source and calls DoCreate
+   virtual SampleBlockPtr DoCreateDeferred(
+      std::shared_ptr<const SampleBlockSource> pSource);
+
+   //! The default reads all samples of the block and calls DoCreate
+   virtual SampleBlockPtr DoCreateCopy(
+      const SampleBlockPtr &pBlock, sampleFormat format);
+
+private:
+   size_t mMaxDiskBlockSize{ 0 };
 };
 
 #endif
@@ -32,7 +32,11 @@
 #include "Sequence.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <float.h>
 #include <math.h>
 
@@ -52,7 +56,8 @@ Sequence::Sequence(
    const SampleBlockFactoryPtr &pFactory, SampleFormats formats)
 :  mpFactory(pFactory),
    mSampleFormats{ formats },
-   mMinSamples(sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormats.Stored()) / 2),
+   mMinSamples(GetMaxDiskBlockSize(pFactory.get())
+      / SAMPLE_SIZE(mSampleFormats.Stored()) / 2),
    mMaxSamples(mMinSamples * 2)
 {
 }
@@ -137,102 +142,205 @@ namespace {
 bool Sequence::ConvertToSampleFormat(sampleFormat format,
    const std::function<void(size_t)> & progressReport)
 {
-   if (format == mSampleFormats.Stored())
-      // no change
-      return false;
-
-   if (mBlock.size() == 0)
-   {
-      // Effective format can be made narrowest when there is no content
-      mSampleFormats = { narrowestSampleFormat, format };
-      return true;
-   }
-
-   // Decide the new pair of formats.  If becoming narrower than the effective,
-   // this will change the effective.
-   SampleFormats newFormats{ mSampleFormats.Effective(), format };
-
-   const auto oldFormats = mSampleFormats;
-   mSampleFormats = newFormats;
-
-   const auto oldMinSamples = mMinSamples, oldMaxSamples = mMaxSamples;
-   // These are the same calculations as in the constructor.
-   mMinSamples = sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormats.Stored()) / 2;
-   mMaxSamples = mMinSamples * 2;
+   return ConvertToSampleFormat(
+      std::vector<Sequence*>{ this }, format, progressReport)[0];
+}
 
-   bool bSuccess = false;
-   auto cleanup = finally( [&] {
-      if (!bSuccess) {
-         // Conversion failed. Revert these member vars.
-         mSampleFormats = oldFormats;
-         mMaxSamples = oldMaxSamples;
-         mMinSamples = oldMinSamples;
+/*! @excsafety{Strong} */
+std::vector<bool> Sequence::ConvertToSampleFormat(
+   const std::vector<Sequence*> &sequences, sampleFormat format,
+   const std::function<void(size_t)> & progressReport)
+{
+   std::vector<bool> result(sequences.size(), false);
+
+   // What each changing sequence will become
+   struct Conversion {
+      Sequence &sequence;
+      SampleFormats newFormats;
+      size_t minSamples, maxSamples;
+      //! New blocks made from each of the old blocks
+      std::vector<BlockArray> pieces;
+      BlockArray newBlockArray;
+   };
+   std::vector<Conversion> conversions;
+   // Indices of a conversion and of an old block of its sequence
+   std::vector<std::pair<size_t, size_t>> jobs;
+
+   for (size_t ii = 0, nn = sequences.size(); ii < nn; ++ii) {
+      auto &sequence = *sequences[ii];
+      if (format == sequence.mSampleFormats.Stored())
+         // no change
+         continue;
+      result[ii] = true;
+
+      if (sequence.mBlock.empty()) {
+         // Effective format can be made narrowest when there is no content
+         conversions.push_back({ sequence,
+            { narrowestSampleFormat, format },
+            sequence.mMinSamples, sequence.mMaxSamples });
+         continue;
       }
-   } );
-
-   BlockArray newBlockArray;
-   // Use the ratio of old to NEW mMaxSamples to make a reasonable guess
-   // at allocation.
-   newBlockArray.reserve
-      (1 + mBlock.size() * ((float)oldMaxSamples / (float)mMaxSamples));
-
-   {
-      size_t oldSize = oldMaxSamples;
-      SampleBuffer bufferOld(oldSize, oldFormats.Stored());
-      size_t newSize = oldMaxSamples;
-      SampleBuffer bufferNew(newSize, format);
 
-      for (size_t i = 0, nn = mBlock.size(); i < nn; i++)
-      {
-         SeqBlock &oldSeqBlock = mBlock[i];
-         const auto &oldBlockFile = oldSeqBlock.sb;
-         const auto len = oldBlockFile->GetSampleCount();
-         ensureSampleBufferSize(bufferOld, oldFormats.Stored(), oldSize, len);
-
-         // Dither won't happen here, reading back the same as-saved format
-         Read(bufferOld.ptr(), oldFormats.Stored(), oldSeqBlock, 0, len, true);
-
-         ensureSampleBufferSize(bufferNew, format, newSize, len);
-
-         CopySamples(
-            bufferOld.ptr(), oldFormats.Stored(), bufferNew.ptr(), format, len,
-            // Do not dither to reformat samples if format is at least as wide
-            // as the old effective (though format might be narrower than the
-            // old stored).
-            format < oldFormats.Effective()
-               ? gHighQualityDither
-               : DitherType::none );
-
-         // Note this fix for http://bugzilla.audacityteam.org/show_bug.cgi?id=451,
-         // using Blockify, allows (len < mMinSamples).
-         // This will happen consistently when going from more bytes per sample to fewer...
-         // This will create a block that's smaller than mMinSamples, which
-         // shouldn't be allowed, but we agreed it's okay for now.
-         //vvv ANSWER-ME: Does this cause any bugs, or failures on write, elsewhere?
-         //    If so, need to special-case (len < mMinSamples) and start combining data
-         //    from the old blocks... Oh no!
-
-         // Using Blockify will handle the cases where len > the NEW mMaxSamples. Previous code did not.
-         const auto blockstart = oldSeqBlock.start;
-         Blockify(*mpFactory, mMaxSamples, format,
-                  newBlockArray, blockstart, bufferNew.ptr(), len);
+      // Decide the new pair of formats.  If becoming narrower than the
+      // effective, this will change the effective.
+      // The sizes are the same calculations as in the constructor.
+      const auto minSamples =
+         GetMaxDiskBlockSize(sequence.mpFactory.get()) / SAMPLE_SIZE(format) / 2;
+      conversions.push_back({ sequence,
+         { sequence.mSampleFormats.Effective(), format },
+         minSamples, minSamples * 2 });
+      const auto nBlocks = sequence.mBlock.size();
+      conversions.back().pieces.resize(nBlocks);
+      for (size_t jj = 0; jj < nBlocks; ++jj)
+         jobs.emplace_back(conversions.size() - 1, jj);
+   }
 
+   // Buffers are reused for blocks of any stored format, so they are sized
+   // for the widest
+   struct Buffers {
+      SampleBuffer bufferOld, bufferNew;
+      size_t oldSize{ 0 }, newSize{ 0 };
+   };
+   // Does not change the sequence; may run on any thread
+   const auto convert =
+   [&](const std::pair<size_t, size_t> &job, Buffers &buffers) -> size_t {
+      auto &conversion = conversions[job.first];
+      auto &sequence = conversion.sequence;
+      const auto oldFormats = sequence.mSampleFormats;
+      const SeqBlock &oldSeqBlock = sequence.mBlock[job.second];
+      const auto len = oldSeqBlock.sb->GetSampleCount();
+      ensureSampleBufferSize(
+         buffers.bufferOld, widestSampleFormat, buffers.oldSize, len);
+
+      // Dither won't happen here, reading back the same as-saved format
+      Read(buffers.bufferOld.ptr(), oldFormats.Stored(), oldSeqBlock, 0, len,
+         true);
+
+      ensureSampleBufferSize(
+         buffers.bufferNew, widestSampleFormat, buffers.newSize, len);
+
+      CopySamples(
+         buffers.bufferOld.ptr(), oldFormats.Stored(),
+         buffers.bufferNew.ptr(), format, len,
+         // Do not dither to reformat samples if format is at least as wide
+         // as the old effective (though format might be narrower than the
+         // old stored).
+         format < oldFormats.Effective()
+            ? gHighQualityDither
+            : DitherType::none );
+
+      // Note this fix for http://bugzilla.audacityteam.org/show_bug.cgi?id=451,
+      // using Blockify, allows (len < mMinSamples).
+      // This will happen consistently when going from more bytes per sample to fewer...
+      // This will create a block that's smaller than mMinSamples, which
+      // shouldn't be allowed, but we agreed it's okay for now.
+      //vvv ANSWER-ME: Does this cause any bugs, or failures on write, elsewhere?
+      //    If so, need to special-case (len < mMinSamples) and start combining data
+      //    from the old blocks... Oh no!
+
+      // Using Blockify will handle the cases where len > the NEW mMaxSamples. Previous code did not.
+      Blockify(*sequence.mpFactory, conversion.maxSamples, format,
+         conversion.pieces[job.second], oldSeqBlock.start,
+         buffers.bufferNew.ptr(), len);
+      return len;
+   };
+
+   const auto nThreads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+   if (nThreads <= 1) {
+      Buffers buffers;
+      for (const auto &job : jobs) {
+         const auto len = convert(job, buffers);
          if (progressReport)
             progressReport(len);
       }
    }
+   else {
+      // Each worker takes the next block until none remain.  Making the new
+      // blocks, with their summaries, is most of the work.
+      std::atomic<size_t> next{ 0 };
+      std::atomic<size_t> converted{ 0 };
+      std::atomic<bool> stop{ false };
+      std::vector<std::exception_ptr> exceptions(nThreads);
+      std::mutex mutex;
+      std::condition_variable condition;
+      size_t finished = 0;
+      const auto work = [&](std::exception_ptr &exception) {
+         Buffers buffers;
+         try {
+            for (size_t jj; !stop && (jj = next++) < jobs.size();)
+               converted += convert(jobs[jj], buffers);
+         }
+         catch (...) {
+            exception = std::current_exception();
+            stop = true;
+         }
+         std::lock_guard<std::mutex> lock{ mutex };
+         ++finished;
+         condition.notify_one();
+      };
 
-   // Invalidate all the old, non-aliased block files.
-   // Aliased files will be converted at save, per comment above.
+      std::vector<std::thread> workers;
+      // However this scope is left, as when progressReport throws to cancel
+      auto cleanup = finally([&]{
+         stop = true;
+         for (auto &worker : workers)
+            worker.join();
+      });
+      for (size_t ii = 0; ii < nThreads; ++ii)
+         workers.emplace_back(work, std::ref(exceptions[ii]));
+
+      size_t reported = 0;
+      const auto report = [&]{
+         const size_t total = converted;
+         if (progressReport && total > reported)
+            progressReport(total - reported);
+         reported = total;
+      };
+      using namespace std::chrono_literals;
+      std::unique_lock<std::mutex> lock{ mutex };
+      while (!condition.wait_for(lock, 50ms,
+         [&]{ return finished == nThreads; })) {
+         lock.unlock();
+         report();
+         lock.lock();
+      }
+      lock.unlock();
 
-   // Commit the changes to block file array
-   CommitChangesIfConsistent
-      (newBlockArray, mNumSamples, wxT("Sequence::ConvertToSampleFormat()"));
+      for (auto &exception : exceptions)
+         if (exception)
+            std::rethrow_exception(exception);
+      report();
+   }
 
-   // Commit the other changes
-   bSuccess = true;
+   // Check all before changing any
+   for (auto &conversion : conversions) {
+      auto &newBlockArray = conversion.newBlockArray;
+      size_t size = 0;
+      for (const auto &piece : conversion.pieces)
+         size += piece.size();
+      newBlockArray.reserve(size);
+      for (const auto &piece : conversion.pieces)
+         newBlockArray.insert(newBlockArray.end(), piece.begin(), piece.end());
+      if (!conversion.pieces.empty())
+         ConsistencyCheck(newBlockArray, conversion.maxSamples, 0,
+            conversion.sequence.mNumSamples,
+            wxT("Sequence::ConvertToSampleFormat()")); // may throw
+   }
 
-   return true;
+   // Commit the changes to block file arrays and the other changes
+   // use No-fail-guarantee
+   for (auto &conversion : conversions) {
+      auto &sequence = conversion.sequence;
+      sequence.mSampleFormats = conversion.newFormats;
+      if (!conversion.pieces.empty()) {
+         sequence.mBlock.swap(conversion.newBlockArray);
+         sequence.mMinSamples = conversion.minSamples;
+         sequence.mMaxSamples = conversion.maxSamples;
+      }
+   }
+
+   return result;
 }
 
 std::pair<float, float> Sequence::GetMinMax(
@@ -391,6 +499,9 @@ std::unique_ptr<Sequence> Sequence::Copy( const SampleBlockFactoryPtr &pFactory,
 {
    // Make a new Sequence object for the specified factory:
    auto dest = std::make_unique<Sequence>(pFactory, mSampleFormats);
+   // Blocks may be used whole, so let them be as large as ours
+   dest->mMinSamples = std::max(dest->mMinSamples, mMinSamples);
+   dest->mMaxSamples = std::max(dest->mMaxSamples, mMaxSamples);
    if (s0 >= s1 || s0 >= mNumSamples || s1 < 0) {
       return dest;
    }
@@ -478,13 +589,9 @@ namespace {
    SampleBlockPtr ShareOrCopySampleBlock(
       SampleBlockFactory *pFactory, sampleFormat format, SampleBlockPtr sb )
    {
-      if ( pFactory ) {
+      if ( pFactory )
          // must copy contents to a fresh SampleBlock object in another database
-         auto sampleCount = sb->GetSampleCount();
-         SampleBuffer buffer{ sampleCount, format };
-         sb->GetSamples( buffer.ptr(), format, 0, sampleCount );
-         sb = pFactory->Create( buffer.ptr(), sampleCount, format );
-      }
+         sb = pFactory->CreateCopy( sb, format );
       else
          // Can just share
          ;
@@ -526,6 +633,11 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       THROW_INCONSISTENCY_EXCEPTION;
    }
 
+   // Blocks of src may be used whole, so let them be as large as its own.
+   // Raising the limits leaves our blocks valid, even if pasting fails.
+   mMinSamples = std::max(mMinSamples, src->mMinSamples);
+   mMaxSamples = std::max(mMaxSamples, src->mMaxSamples);
+
    const BlockArray &srcBlock = src->mBlock;
    auto addedLen = src->mNumSamples;
    const unsigned int srcNumBlocks = srcBlock.size();
@@ -1342,6 +1454,21 @@ void Sequence::AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock)
 #endif
 }
 
+/*! @excsafety{Strong} */
+void Sequence::AppendDeferredBlock(
+   std::shared_ptr<const SampleBlockSource> pSource,
+   sampleFormat effectiveFormat)
+{
+   if (pSource->GetSampleFormat() != mSampleFormats.Stored() ||
+       pSource->GetSampleCount() > mMaxSamples ||
+       mAppendBufferLen > 0)
+      THROW_INCONSISTENCY_EXCEPTION;
+
+   AppendSharedBlock(mpFactory->CreateDeferred(std::move(pSource)));
+   // Change our effective format now that nothing threw
+   mSampleFormats.UpdateEffective(effectiveFormat);
+}
+
 /*! @excsafety{Weak} */
 bool Sequence::Append(
    constSamplePtr buffer, sampleFormat format, size_t len, size_t stride,
@@ -1545,6 +1672,72 @@ void Sequence::Blockify(SampleBlockFactory &factory,
    }
 }
 
+/*! @excsafety{Strong} */
+bool Sequence::Coalesce()
+{
+   const auto numBlocks = mBlock.size();
+   const auto format = mSampleFormats.Stored();
+
+   // The project may have chosen larger blocks since this sequence was made
+   const auto factoryMaxSamples =
+      GetMaxDiskBlockSize(mpFactory.get()) / SAMPLE_SIZE(format);
+   const auto minSamples = std::max(mMinSamples, factoryMaxSamples / 2);
+   const auto maxSamples = std::max(mMaxSamples, factoryMaxSamples);
+
+   const auto IsSmall = [&](const SeqBlock &block){
+      // Leave silent blocks alone; they take no space
+      return block.sb->GetBlockID() > 0 &&
+         block.sb->GetSampleCount() < minSamples;
+   };
+
+   BlockArray newBlock;
+   newBlock.reserve(numBlocks);
+   SampleBuffer buffer;
+   size_t bufferSize = 0;
+   bool changed = false;
+   for (size_t b = 0; b < numBlocks;) {
+      // Find a run of small blocks, holding not much more than one full block
+      auto e = b;
+      size_t total = 0;
+      while (e < numBlocks && total < maxSamples && IsSmall(mBlock[e]))
+         total += mBlock[e++].sb->GetSampleCount();
+
+      const auto nNew = (total + maxSamples - 1) / maxSamples;
+      if (e - b < 2 || nNew >= e - b) {
+         // Nothing to gain
+         const auto next = std::max(e, b + 1);
+         for (; b < next; ++b)
+            newBlock.push_back(mBlock[b]);
+         continue;
+      }
+
+      ensureSampleBufferSize(buffer, format, bufferSize, total);
+      size_t offset = 0;
+      for (auto ii = b; ii < e; ++ii) {
+         const auto &block = mBlock[ii];
+         const auto len = block.sb->GetSampleCount();
+         Read(buffer.ptr() + offset * SAMPLE_SIZE(format), format,
+              block, 0, len, true);
+         offset += len;
+      }
+      Blockify(*mpFactory, maxSamples, format,
+               newBlock, mBlock[b].start, buffer.ptr(), total);
+      changed = true;
+      b = e;
+   }
+
+   if (changed) {
+      ConsistencyCheck(newBlock, maxSamples, 0, mNumSamples,
+         wxT("Coalesce")); // may throw
+
+      // use No-fail-guarantee
+      mBlock.swap(newBlock);
+      mMinSamples = minSamples;
+      mMaxSamples = maxSamples;
+   }
+   return changed;
+}
+
 /*! @excsafety{Strong} */
 void Sequence::Delete(sampleCount start, sampleCount len)
 {
@@ -1872,6 +2065,12 @@ size_t Sequence::GetMaxDiskBlockSize()
    return sMaxDiskBlockSize;
 }
 
+size_t Sequence::GetMaxDiskBlockSize(const SampleBlockFactory *pFactory)
+{
+   const auto bytes = pFactory ? pFactory->GetMaxDiskBlockSize() : 0;
+   return bytes ? bytes : sMaxDiskBlockSize;
+}
+
 bool Sequence::IsValidSampleFormat(const int iValue)
 {
    auto nValue = static_cast<sampleFormat>(iValue);
@@ -23,6 +23,7 @@
 
 class SampleBlock;
 class SampleBlockFactory;
+class SampleBlockSource;
 using SampleBlockFactoryPtr = std::shared_ptr<SampleBlockFactory>;
 
 // This is an internal data structure!  For advanced use only.
@@ -59,6 +60,9 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
 
    static void SetMaxDiskBlockSize(size_t bytes);
    static size_t GetMaxDiskBlockSize();
+   //! The size for new sequences made with the factory, which its project
+   //! may choose
+   static size_t GetMaxDiskBlockSize(const SampleBlockFactory *pFactory);
 
    //! true if nValue is one of the sampleFormat enum values
    static bool IsValidSampleFormat(const int nValue);
@@ -113,6 +117,17 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
 
    size_t GetIdealAppendLen() const;
 
+   //! Replace runs of neighboring blocks, each less than the minimum size,
+   //! with fewer blocks of the same samples
+   /*!
+    Editing leaves such small blocks at the boundaries of the edits.
+    If the factory's block size is now larger than this sequence's, the
+    sequence adopts it, so that its blocks may grow.
+    @return whether any blocks were replaced
+    */
+   /*! @excsafety{Strong} */
+   bool Coalesce();
+
    /*!
        Samples may be retained in a memory buffer, pending Flush()
        If there are exceptions, an unspecified prefix of buffer may be
@@ -146,6 +161,16 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
    //! Append a complete block, not coalescing
    /*! @excsafety{Strong} */
    void AppendSharedBlock(const SeqBlock::SampleBlockPtr &pBlock);
+   //! Append a complete block, not coalescing, that reads its samples from
+   //! the source until the factory copies them
+   /*!
+    @pre `pSource->GetSampleFormat() == GetSampleFormats().Stored()`
+    @pre `pSource->GetSampleCount() <= GetMaxBlockSize()`
+    @pre `GetAppendBufferLen() == 0`
+    @excsafety{Strong}
+    */
+   void AppendDeferredBlock(std::shared_ptr<const SampleBlockSource> pSource,
+      sampleFormat effectiveFormat);
    /*! @excsafety{Strong} */
    void Delete(sampleCount start, sampleCount len);
 
@@ -186,6 +211,17 @@ class WAVE_TRACK_API Sequence final : public XMLTagHandler{
    bool ConvertToSampleFormat(sampleFormat format,
       const std::function<void(size_t)> & progressReport = {});
 
+   //! Convert several sequences together, making new blocks on worker threads
+   /*!
+    No sequence changes until the blocks of all of them are made.
+    `progressReport` is called on this thread only.
+    @return for each sequence, whether there was a change of format
+    */
+   /*! @excsafety{Strong} */
+   static std::vector<bool> ConvertToSampleFormat(
+      const std::vector<Sequence*> &sequences, sampleFormat format,
+      const std::function<void(size_t)> & progressReport = {});
+
    //
    // Retrieving summary info
    //
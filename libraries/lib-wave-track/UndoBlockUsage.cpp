@@ -0,0 +1,241 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  UndoBlockUsage.cpp
+
+**********************************************************************/
+#include "UndoBlockUsage.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "Project.h"
+#include "SampleBlock.h"
+#include "Track.h"
+#include "UndoManager.h"
+
+struct UndoBlockUsage::Record {
+   //! Order of the state in the history
+   uint64_t serial{};
+   //! Distinct blocks of the state
+   std::vector<SampleBlockID> blocks;
+   unsigned long long usage{};
+   //! Changes when newer states using the same blocks come and go
+   mutable unsigned long long attributed{};
+};
+
+//! Undo state extension that keeps the blocks of the state counted
+class BlockUsageRecorder final : public UndoStateExtension {
+public:
+   explicit BlockUsageRecorder(AudacityProject &project)
+      : mpUsage{ UndoBlockUsage::Get(project).shared_from_this() }
+   {
+      std::vector<std::pair<SampleBlockID, size_t>> blocks;
+      SampleBlockIDSet seen;
+      InspectBlocks(TrackList::Get(project),
+         [&](const SampleBlock &block){
+            blocks.emplace_back(block.GetBlockID(), block.GetSpaceUsage());
+         },
+         &seen
+      );
+
+      mRecord.serial = mpUsage->mNextSerial++;
+
+      // A new state is always the newest, but the current state may be
+      // modified while there are redo states after it; then keep its place
+      auto &manager = UndoManager::Get(project);
+      const auto current = manager.GetCurrentState();
+      if (current + 1 < manager.GetNumStates())
+         manager.VisitStates([&](const UndoStackElem &elem){
+            if (auto pRecord = UndoBlockUsage::FindRecord(elem))
+               mRecord.serial = pRecord->serial;
+         }, current, current + 1);
+
+      mpUsage->Add(mRecord, blocks);
+   }
+
+   ~BlockUsageRecorder() override
+   {
+      mpUsage->Remove(mRecord);
+   }
+
+   void RestoreUndoRedoState(AudacityProject &) override {}
+
+   UndoBlockUsage::Record mRecord;
+
+private:
+   const std::shared_ptr<UndoBlockUsage> mpUsage;
+};
+
+namespace {
+UndoRedoExtensionRegistry::Entry sEntry {
+   [](AudacityProject &project) -> std::shared_ptr<UndoStateExtension> {
+      return std::make_shared<BlockUsageRecorder>(project);
+   }
+};
+
+const AudacityProject::AttachedObjects::RegisteredFactory key{
+   [](AudacityProject &) { return std::make_shared<UndoBlockUsage>(); }
+};
+}
+
+UndoBlockUsage &UndoBlockUsage::Get(AudacityProject &project)
+{
+   return project.AttachedObjects::Get<UndoBlockUsage>(key);
+}
+
+const UndoBlockUsage &UndoBlockUsage::Get(const AudacityProject &project)
+{
+   return Get(const_cast<AudacityProject &>(project));
+}
+
+UndoBlockUsage::UndoBlockUsage() = default;
+
+UndoBlockUsage::~UndoBlockUsage() = default;
+
+unsigned long long UndoBlockUsage::GetTotalUsage() const
+{
+   return mTotalUsage;
+}
+
+size_t UndoBlockUsage::GetBlockCount() const
+{
+   return mBlocks.size();
+}
+
+bool UndoBlockUsage::IsUsed(SampleBlockID id) const
+{
+   return mBlocks.count(id) > 0;
+}
+
+unsigned long long UndoBlockUsage::GetUsage(const UndoStackElem &state) const
+{
+   if (auto pRecord = FindRecord(state))
+      return pRecord->usage;
+   return 0;
+}
+
+unsigned long long UndoBlockUsage::GetUsage(
+   const std::vector<const UndoStackElem*> &states) const
+{
+   if (states.size() == 1)
+      return GetUsage(*states.front());
+
+   unsigned long long result = 0;
+   SampleBlockIDSet seen;
+   for (auto pState : states) {
+      auto pRecord = pState ? FindRecord(*pState) : nullptr;
+      if (!pRecord)
+         continue;
+      for (auto id : pRecord->blocks)
+         if (seen.insert(id).second)
+            if (auto iter = mBlocks.find(id); iter != mBlocks.end())
+               result += iter->second.spaceUsage;
+   }
+   return result;
+}
+
+unsigned long long
+UndoBlockUsage::GetAttributedUsage(const UndoStackElem &state) const
+{
+   if (auto pRecord = FindRecord(state))
+      return pRecord->attributed;
+   return 0;
+}
+
+size_t UndoBlockUsage::CountBlocksOnlyIn(UndoManager &manager,
+   size_t begin, size_t end, const SampleBlockIDSet &keep) const
+{
+   // Records of the states to be discarded, in order
+   std::vector<const Record*> records;
+   const auto saved = manager.GetSavedState();
+   auto index = begin;
+   manager.VisitStates([&](const UndoStackElem &elem){
+      if (static_cast<int>(index++) != saved)
+         if (auto pRecord = FindRecord(elem))
+            records.push_back(pRecord);
+   }, begin, end);
+   const std::unordered_set<const Record*> discarded{
+      records.begin(), records.end() };
+
+   size_t result = 0;
+   SampleBlockIDSet seen;
+   for (auto pRecord : records)
+      for (auto id : pRecord->blocks) {
+         // Negative ids are pseudo blocks for silence
+         if (id <= 0 || keep.count(id) || !seen.insert(id).second)
+            continue;
+         auto iter = mBlocks.find(id);
+         if (iter == mBlocks.end())
+            continue;
+         const auto &owners = iter->second.owners;
+         if (std::all_of(owners.begin(), owners.end(),
+            [&](auto pOwner){ return discarded.count(pOwner) > 0; }))
+            ++result;
+      }
+   return result;
+}
+
+auto UndoBlockUsage::FindRecord(const UndoStackElem &state) -> const Record *
+{
+   for (auto &pExt : state.state.extensions)
+      if (auto pRecorder = dynamic_cast<BlockUsageRecorder*>(pExt.get()))
+         return &pRecorder->mRecord;
+   return nullptr;
+}
+
+void UndoBlockUsage::Add(Record &record,
+   const std::vector<std::pair<SampleBlockID, size_t>> &blocks)
+{
+   record.blocks.reserve(blocks.size());
+   for (auto [id, spaceUsage] : blocks) {
+      record.blocks.push_back(id);
+      record.usage += spaceUsage;
+
+      auto [iter, inserted] = mBlocks.try_emplace(id);
+      auto &entry = iter->second;
+      if (inserted) {
+         entry.spaceUsage = spaceUsage;
+         mTotalUsage += spaceUsage;
+      }
+
+      // Usually appended at the end; a modified state takes its old place,
+      // after its previous record which is removed next
+      auto &owners = entry.owners;
+      const auto pos = std::upper_bound(owners.begin(), owners.end(),
+         record.serial, [](uint64_t serial, const Record *pOwner){
+            return serial < pOwner->serial;
+         });
+      if (pos == owners.end()) {
+         // Attribution moves to the newest state
+         if (!owners.empty())
+            owners.back()->attributed -= entry.spaceUsage;
+         record.attributed += entry.spaceUsage;
+      }
+      owners.insert(pos, &record);
+   }
+}
+
+void UndoBlockUsage::Remove(const Record &record)
+{
+   for (auto id : record.blocks) {
+      auto iter = mBlocks.find(id);
+      if (iter == mBlocks.end())
+         continue;
+      auto &entry = iter->second;
+      auto &owners = entry.owners;
+      const auto pos = std::find(owners.begin(), owners.end(), &record);
+      if (pos == owners.end())
+         continue;
+      const bool wasNewest = (pos + 1 == owners.end());
+      owners.erase(pos);
+      if (owners.empty()) {
+         mTotalUsage -= entry.spaceUsage;
+         mBlocks.erase(iter);
+      }
+      else if (wasNewest)
+         // Attribution moves back to the next newest state
+         owners.back()->attributed += entry.spaceUsage;
+   }
+}
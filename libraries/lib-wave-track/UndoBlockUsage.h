@@ -0,0 +1,92 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  UndoBlockUsage.h
+
+**********************************************************************/
+#ifndef __AUDACITY_UNDO_BLOCK_USAGE__
+#define __AUDACITY_UNDO_BLOCK_USAGE__
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ClientData.h"
+#include "WaveTrack.h" // SampleBlockID, SampleBlockIDSet
+
+class AudacityProject;
+struct UndoStackElem;
+class UndoManager;
+
+//! Reference counts of sample blocks among the states of the undo history
+/*!
+ Each undo state captures the list of the distinct blocks it uses when it is
+ pushed or modified, and releases it when it is discarded, so that the space
+ usage of the history can be queried without visiting the clips and
+ sequences of every state.
+
+ A block is attributed to the newest state that uses it: to reclaim the disk
+ space of a block, all states using it must be discarded, and the states are
+ discarded oldest first.
+ */
+class WAVE_TRACK_API UndoBlockUsage final
+   : public ClientData::Base
+   , public std::enable_shared_from_this<UndoBlockUsage>
+{
+public:
+   static UndoBlockUsage &Get(AudacityProject &project);
+   static const UndoBlockUsage &Get(const AudacityProject &project);
+
+   UndoBlockUsage();
+   ~UndoBlockUsage() override;
+
+   UndoBlockUsage(const UndoBlockUsage&) = delete;
+   UndoBlockUsage &operator=(const UndoBlockUsage&) = delete;
+
+   //! Space used by the distinct blocks of all undo states
+   unsigned long long GetTotalUsage() const;
+   //! Number of distinct blocks used by all undo states
+   size_t GetBlockCount() const;
+   //! Whether any undo state uses the block
+   bool IsUsed(SampleBlockID id) const;
+
+   //! Space used by the distinct blocks of one state
+   unsigned long long GetUsage(const UndoStackElem &state) const;
+   //! Space used by the distinct blocks of several states together
+   unsigned long long GetUsage(
+      const std::vector<const UndoStackElem*> &states) const;
+   //! Space used by the blocks, for which the state is the newest one
+   //! using them
+   unsigned long long GetAttributedUsage(const UndoStackElem &state) const;
+
+   //! Number of blocks with positive ids, used only by the states in
+   //! [begin, end), except the saved state, and not contained in keep
+   size_t CountBlocksOnlyIn(UndoManager &manager,
+      size_t begin, size_t end, const SampleBlockIDSet &keep) const;
+
+   //! Per state data, owned by the undo state extension
+   struct Record;
+
+private:
+   struct BlockEntry {
+      size_t spaceUsage{};
+      //! Sorted from oldest to newest state
+      std::vector<const Record*> owners;
+   };
+
+   static const Record *FindRecord(const UndoStackElem &state);
+
+   void Add(Record &record,
+      const std::vector<std::pair<SampleBlockID, size_t>> &blocks);
+   void Remove(const Record &record);
+
+   std::unordered_map<SampleBlockID, BlockEntry> mBlocks;
+   unsigned long long mTotalUsage{};
+   uint64_t mNextSerial{};
+
+   friend class BlockUsageRecorder;
+};
+
+#endif
@@ -15,6 +15,8 @@
 *//*******************************************************************/
 #include "WaveClip.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <math.h>
 #include <optional>
 #include <vector>
@@ -36,6 +38,11 @@ WaveClipListener::~WaveClipListener()
 {
 }
 
+void WaveClipListener::MarkAppended()
+{
+   MarkChanged();
+}
+
 WaveClip::WaveClip(size_t width,
    const SampleBlockFactoryPtr &factory,
    sampleFormat format, int rate, int colourIndex)
@@ -144,6 +151,112 @@ WaveClip::GetSampleView(size_t ii, sampleCount start, size_t length) const
       start + TimeToSamples(mTrimLeft), length);
 }
 
+namespace
+{
+//! What is needed of a clip to read its play region, with no reference to the
+//! clip, which may change meanwhile
+class WaveClipSnapshot final : public ClipInterface
+{
+public:
+   WaveClipSnapshot(
+      std::vector<BlockArray> channels, sampleCount offset,
+      sampleCount numSamples, int rate, double playStartTime,
+      double playEndTime, double stretchRatio)
+       : mChannels { std::move(channels) }
+       , mOffset { offset }
+       , mNumSamples { numSamples }
+       , mRate { rate }
+       , mPlayStartTime { playStartTime }
+       , mPlayEndTime { playEndTime }
+       , mStretchRatio { stretchRatio }
+   {
+   }
+
+   AudioSegmentSampleView
+   GetSampleView(size_t ii, sampleCount start, size_t length) const override
+   {
+      assert(ii < GetWidth());
+      if (start < 0 || start >= mNumSamples)
+         return AudioSegmentSampleView { sampleCount { 0 } };
+      length = limitSampleBufferSize(length, mNumSamples - start);
+      const auto& blocks = mChannels[ii];
+      start += mOffset;
+      // As in Sequence::FindBlock and Sequence::GetFloatSampleView
+      auto it = std::upper_bound(
+         blocks.begin(), blocks.end(), start,
+         [](sampleCount pos, const SeqBlock& block) {
+            return pos < block.start;
+         });
+      assert(it != blocks.begin());
+      --it;
+      const auto blockOffset = (start - it->start).as_size_t();
+      std::vector<BlockSampleView> blockViews;
+      for (auto cursor = start; cursor < start + length; ++it)
+      {
+         blockViews.push_back(it->sb->GetFloatSampleView());
+         cursor = it->start + it->sb->GetSampleCount();
+      }
+      return { std::move(blockViews), blockOffset, length };
+   }
+
+   sampleCount GetPlaySamplesCount() const override { return mNumSamples; }
+   size_t GetWidth() const override { return mChannels.size(); }
+   int GetRate() const override { return mRate; }
+   double GetPlayStartTime() const override { return mPlayStartTime; }
+   double GetPlayEndTime() const override { return mPlayEndTime; }
+   double GetStretchRatio() const override { return mStretchRatio; }
+
+private:
+   const std::vector<BlockArray> mChannels;
+   const sampleCount mOffset;
+   const sampleCount mNumSamples;
+   const int mRate;
+   const double mPlayStartTime;
+   const double mPlayEndTime;
+   const double mStretchRatio;
+};
+} // namespace
+
+ClipContentKey WaveClip::GetContentKey() const
+{
+   ClipContentKey key;
+   key.push_back(TimeToSamples(mTrimLeft).as_long_long());
+   key.push_back(GetPlaySamplesCount().as_long_long());
+   for (const auto& pSequence : mSequences)
+   {
+      if (pSequence->GetAppendBufferLen() > 0)
+         return {};
+      // Block ids are unique only within the storage of one project
+      key.push_back(
+         reinterpret_cast<std::intptr_t>(pSequence->GetFactory().get()));
+      const auto& blocks = pSequence->GetBlockArray();
+      key.push_back(blocks.size());
+      for (const auto& block : blocks)
+      {
+         key.push_back(block.start.as_long_long());
+         key.push_back(block.sb->GetBlockID());
+      }
+   }
+   return key;
+}
+
+std::shared_ptr<const ClipInterface> WaveClip::GetSnapshot() const
+{
+   if (GetPlaySamplesCount() <= 0)
+      return nullptr;
+   std::vector<BlockArray> channels;
+   channels.reserve(mSequences.size());
+   for (const auto& pSequence : mSequences)
+   {
+      if (pSequence->GetAppendBufferLen() > 0)
+         return nullptr;
+      channels.push_back(pSequence->GetBlockArray());
+   }
+   return std::make_shared<WaveClipSnapshot>(
+      std::move(channels), TimeToSamples(mTrimLeft), GetPlaySamplesCount(),
+      GetRate(), GetPlayStartTime(), GetPlayEndTime(), GetStretchRatio());
+}
+
 size_t WaveClip::GetWidth() const
 {
    return mSequences.size();
@@ -228,6 +341,11 @@ void WaveClip::MarkChanged() // NOFAIL-GUARANTEE
    Caches::ForEach( std::mem_fn( &WaveClipListener::MarkChanged ) );
 }
 
+void WaveClip::MarkAppended() // NOFAIL-GUARANTEE
+{
+   Caches::ForEach( std::mem_fn( &WaveClipListener::MarkAppended ) );
+}
+
 std::pair<float, float> WaveClip::GetMinMax(size_t ii,
    double t0, double t1, bool mayThrow) const
 {
@@ -272,23 +390,45 @@ float WaveClip::GetRMS(size_t ii, double t0, double t1, bool mayThrow) const
 
 void WaveClip::ConvertToSampleFormat(sampleFormat format,
    const std::function<void(size_t)> & progressReport)
+{
+   ConvertToSampleFormat(std::vector<WaveClip*>{ this }, format, progressReport);
+}
+
+void WaveClip::ConvertToSampleFormat(const std::vector<WaveClip*> &clips,
+   sampleFormat format, const std::function<void(size_t)> & progressReport)
 {
    // Note:  it is not necessary to do this recursively to cutlines.
    // They get converted as needed when they are expanded.
 
-   Transaction transaction{ *this };
-
-   auto bChanged = mSequences[0]->ConvertToSampleFormat(format, progressReport);
-   for (size_t ii = 1, width = GetWidth(); ii < width; ++ii) {
-      bool alsoChanged =
-         mSequences[ii]->ConvertToSampleFormat(format, progressReport);
-      // Class invariant implies:
-      assert(bChanged == alsoChanged);
+   std::vector<Sequence*> sequences;
+   for (const auto pClip : clips)
+      for (const auto &pSequence : pClip->mSequences)
+         sequences.push_back(pSequence.get());
+
+   // Sequence gives the strong guarantee for all of them together
+   const auto changed =
+      Sequence::ConvertToSampleFormat(sequences, format, progressReport);
+
+   auto iChanged = changed.begin();
+   for (const auto pClip : clips) {
+      const bool bChanged = *iChanged;
+      for (size_t ii = 0, width = pClip->GetWidth(); ii < width;
+           ++ii, ++iChanged)
+         // Class invariant implies:
+         assert(*iChanged == bChanged);
+      if (bChanged)
+         pClip->MarkChanged();
    }
-   if (bChanged)
-      MarkChanged();
+}
 
-   transaction.Commit();
+bool WaveClip::Coalesce()
+{
+   // Cut lines are left alone, as in ConvertToSampleFormat
+   bool changed = false;
+   for (auto &pSequence : mSequences)
+      changed = pSequence->Coalesce() || changed;
+   // Samples are the same, so caches need not be invalidated
+   return changed;
 }
 
 /*! @excsafety{No-fail} */
@@ -318,6 +458,19 @@ void WaveClip::AppendSharedBlock(const std::shared_ptr<SampleBlock> &pBlock)
    mSequences[0]->AppendSharedBlock( pBlock );
 }
 
+/*! @excsafety{Strong} */
+void WaveClip::AppendDeferredBlock(
+   std::shared_ptr<const SampleBlockSource> pSource,
+   sampleFormat effectiveFormat)
+{
+   assert(GetWidth() == 1);
+   Finally Do{ [this]{ assert(CheckInvariants()); } };
+   mSequences[0]->AppendDeferredBlock(std::move(pSource), effectiveFormat);
+   // use No-fail-guarantee
+   UpdateEnvelopeTrackLen();
+   MarkAppended();
+}
+
 bool WaveClip::Append(constSamplePtr buffers[], sampleFormat format,
    size_t len, unsigned int stride, sampleFormat effectiveFormat)
 {
@@ -337,7 +490,7 @@ bool WaveClip::Append(constSamplePtr buffers[], sampleFormat format,
    transaction.Commit();
    // use No-fail-guarantee
    UpdateEnvelopeTrackLen();
-   MarkChanged();
+   MarkAppended();
 
    return appended;
 }
@@ -359,7 +512,7 @@ void WaveClip::Flush()
 
       // No-fail operations
       UpdateEnvelopeTrackLen();
-      MarkChanged();
+      MarkAppended();
    }
 
    //wxLogDebug(wxT("now sample count %lli"), (long long) mSequence->GetNumSamples());
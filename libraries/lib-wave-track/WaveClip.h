@@ -34,6 +34,7 @@ class ProgressDialog;
 class sampleCount;
 class SampleBlock;
 class SampleBlockFactory;
+class SampleBlockSource;
 using SampleBlockFactoryPtr = std::shared_ptr<SampleBlockFactory>;
 class Sequence;
 class wxFileNameWrapper;
@@ -92,6 +93,8 @@ struct WAVE_TRACK_API WaveClipListener
 {
    virtual ~WaveClipListener() = 0;
    virtual void MarkChanged() = 0;
+   //! Samples were only added at the end; the default calls MarkChanged()
+   virtual void MarkAppended();
    virtual void Invalidate() = 0;
 };
 
@@ -151,6 +154,15 @@ public:
 
    void ConvertToSampleFormat(sampleFormat format,
       const std::function<void(size_t)> & progressReport = {});
+   //! Convert the sequences of all the clips together, on worker threads
+   /*! @excsafety{Strong} */
+   static void ConvertToSampleFormat(const std::vector<WaveClip*> &clips,
+      sampleFormat format,
+      const std::function<void(size_t)> & progressReport = {});
+
+   //! Coalesce small neighboring blocks in each sequence; samples are unchanged
+   /*! @return whether any sequence changed */
+   bool Coalesce();
 
    // Always gives non-negative answer, not more than sample sequence length
    // even if t0 really falls outside that range
@@ -238,6 +250,13 @@ public:
    AudioSegmentSampleView GetSampleView(
       size_t iChannel, sampleCount start, size_t length) const override;
 
+   //! Made of the block identities of all channels, and the play region;
+   //! empty while there are appended samples not yet in blocks
+   ClipContentKey GetContentKey() const override;
+
+   //! Shares the sample blocks, which never change, of the current state
+   std::shared_ptr<const ClipInterface> GetSnapshot() const override;
+
    //! Get samples from one channel
    /*!
     @param ii identifies the channel
@@ -301,6 +320,10 @@ public:
    /*! @excsafety{No-fail} */
    void MarkChanged();
 
+   //! Like MarkChanged(), when samples were only appended, as in recording
+   /*! @excsafety{No-fail} */
+   void MarkAppended();
+
    /** Getting high-level data for one channel for screen display and clipping
     * calculations and Contrast */
    /*!
@@ -328,6 +351,12 @@ public:
    //! @pre `GetWidth() == 1`
    void AppendSharedBlock(const std::shared_ptr<SampleBlock> &pBlock);
 
+   //! Append a block that reads its samples from elsewhere until they are
+   //! copied into the project
+   //! @pre `GetWidth() == 1`
+   void AppendDeferredBlock(std::shared_ptr<const SampleBlockSource> pSource,
+      sampleFormat effectiveFormat);
+
    //! Append (non-interleaved) samples to all channels
    //! You must call Flush after the last Append
    /*!
@@ -28,6 +28,7 @@ from the project that will own the track.
 
 #include "WaveTrack.h"
 
+#include "StretchedClipCache.h"
 #include "WideClip.h"
 #include "WaveClip.h"
 
@@ -54,6 +55,7 @@ from the project that will own the track.
 #include "SyncLock.h"
 #include "TimeWarper.h"
 #include "QualitySettings.h"
+#include "SampleBlock.h"
 
 #include "InconsistencyException.h"
 
@@ -216,6 +218,28 @@ static ProjectFileIORegistry::ObjectReaderEntry readerEntry{
    WaveTrack::New
 };
 
+// A project keeps the block size it was made with, whatever the preference is
+// when it is opened again
+static ProjectFileIORegistry::AttributeWriterEntry blockSizeWriterEntry {
+[](const AudacityProject &project, XMLWriter &xmlFile){
+   const auto &pFactory = WaveTrackFactory::Get(project).GetSampleBlockFactory();
+   xmlFile.WriteAttr(wxT("sampleblocksize"),
+      Sequence::GetMaxDiskBlockSize(pFactory.get()));
+}
+};
+
+static ProjectFileIORegistry::AttributeReaderEntries blockSizeReaderEntries {
+// Just a pointer to function, but needing overload resolution as non-const:
+(WaveTrackFactory& (*)(AudacityProject &)) &WaveTrackFactory::Get, {
+   { "sampleblocksize", [](auto &factory, auto value){
+      long long bytes = 0;
+      // Within the limits that Sequence::HandleXMLTag checks, for any format
+      if (value.TryGet(bytes) &&
+          bytes >= 4 * 1024 && bytes <= 64 * 1024 * 1024)
+         factory.GetSampleBlockFactory()->SetMaxDiskBlockSize(bytes);
+   } },
+} };
+
 std::shared_ptr<WaveTrack> WaveTrackFactory::Create()
 {
    return Create(QualitySettings::SampleFormatChoice(), mRate.GetRate());
@@ -644,16 +668,30 @@ size_t WaveTrack::CountBlocks() const
    return result;
 }
 
-/*! @excsafety{Weak} -- Might complete on only some clips */
+bool WaveTrack::Coalesce()
+{
+   assert(IsLeader());
+   bool changed = false;
+   for (const auto pChannel : TrackList::Channels(this))
+      for (const auto& clip : pChannel->mClips)
+         changed = clip->Coalesce() || changed;
+   return changed;
+}
+
+/*! @excsafety{Strong} */
 void WaveTrack::ConvertToSampleFormat(sampleFormat format,
    const std::function<void(size_t)> & progressReport)
 {
    assert(IsLeader());
-   for (const auto pChannel : TrackList::Channels(this)) {
+   // Convert all clips of all channels together, so that many short clips
+   // still keep all worker threads busy
+   std::vector<WaveClip*> clips;
+   for (const auto pChannel : TrackList::Channels(this))
       for (const auto& clip : pChannel->mClips)
-         clip->ConvertToSampleFormat(format, progressReport);
+         clips.push_back(clip.get());
+   WaveClip::ConvertToSampleFormat(clips, format, progressReport);
+   for (const auto pChannel : TrackList::Channels(this))
       pChannel->mFormat = format;
-   }
 }
 
 
@@ -1887,6 +1925,14 @@ bool WaveTrack::Append(constSamplePtr buffer, sampleFormat format,
       ->Append(buffers, format, len, stride, effectiveFormat);
 }
 
+void WaveTrack::AppendDeferred(
+   std::shared_ptr<const SampleBlockSource> pSource,
+   sampleFormat effectiveFormat)
+{
+   RightmostOrNewClip()
+      ->AppendDeferredBlock(std::move(pSource), effectiveFormat);
+}
+
 size_t WaveTrack::GetBestBlockSize(sampleCount s) const
 {
    auto bestBlockSize = GetMaxBlockSize();
@@ -2370,7 +2416,7 @@ bool WaveTrack::GetOne(
 
 std::vector<ChannelSampleView> WaveTrack::GetSampleView(
    size_t iChannel, size_t nBuffers, sampleCount start, size_t length,
-   bool backwards) const
+   bool backwards, const StretchedClipRenders* pRenders) const
 {
    const auto nChannels = NChannels();
    assert(iChannel + nBuffers <= nChannels); // precondition
@@ -2390,7 +2436,8 @@ std::vector<ChannelSampleView> WaveTrack::GetSampleView(
    }
    for (auto i = 0u; i < nBuffers; ++i)
    {
-      result.push_back(pTrack->GetOneSampleView(start, length, backwards));
+      result.push_back(
+         pTrack->GetOneSampleView(start, length, backwards, pRenders));
       if (iter)
          pTrack = *(++*iter);
    }
@@ -2398,7 +2445,8 @@ std::vector<ChannelSampleView> WaveTrack::GetSampleView(
 }
 
 ChannelSampleView WaveTrack::GetOneSampleView(
-   sampleCount start, size_t length, bool backwards) const
+   sampleCount start, size_t length, bool backwards,
+   const StretchedClipRenders* pRenders) const
 {
    if (backwards)
       start -= length;
@@ -2429,9 +2477,17 @@ ChannelSampleView WaveTrack::GetOneSampleView(
       }
       const auto clipT0 = t0 - clipStartTime;
       const auto clipS0 = TimeToLongSamples(clipT0);
+      std::shared_ptr<const StretchedClipRender> render;
+      if (pRenders)
+         if (const auto iter = pRenders->find(clip.get());
+             iter != pRenders->end())
+            render = iter->second;
+      const auto numClipSamples =
+         render ? render->GetSampleCount() : clip->GetPlaySamplesCount();
       const auto len =
-         limitSampleBufferSize(length, clip->GetPlaySamplesCount() - clipS0);
-      auto newSegment = clip->GetSampleView(0u, clipS0, len);
+         limitSampleBufferSize(length, numClipSamples - clipS0);
+      auto newSegment = render ? render->GetSampleView(0u, clipS0, len) :
+                                 clip->GetSampleView(0u, clipS0, len);
       t0 += newSegment.GetSampleCount().as_double() / GetRate();
       segments.push_back(std::move(newSegment));
       length -= len;
@@ -3207,9 +3263,11 @@ void InspectBlocks(const TrackList &tracks, BlockInspector inspector,
 #include "Project.h"
 #include "SampleBlock.h"
 static auto TrackFactoryFactory = []( AudacityProject &project ) {
+   auto pFactory = SampleBlockFactory::New( project );
+   // Until a saved project says otherwise
+   pFactory->SetMaxDiskBlockSize(SampleBlockSizeSetting.ReadEnum() * 1024);
    return std::make_shared< WaveTrackFactory >(
-      ProjectRate::Get( project ),
-      SampleBlockFactory::New( project ) );
+      ProjectRate::Get( project ), std::move(pFactory) );
 };
 
 static const AudacityProject::AttachedObjects::RegisteredFactory key2{
@@ -3272,4 +3330,18 @@ bool GetEditClipsCanMove()
 BoolSetting EditClipsCanMove{
    L"/GUI/EditClipCanMove",         false  };
 
+static const std::initializer_list<EnumValueSymbol> choicesSampleBlockSize{
+   { wxT("Standard"), XO("Standard") },
+   { wxT("Small"), XO("Small, for much editing") },
+   { wxT("Large"), XO("Large, for long recordings and archiving") },
+};
+
+EnumSetting<int> SampleBlockSizeSetting{
+   wxT("/Directories/SampleBlockSize"),
+   choicesSampleBlockSize,
+   0, // Standard
+   // Kilobytes; 0 leaves Sequence::GetMaxDiskBlockSize() in effect
+   { 0, 256, 4096 },
+};
+
 DEFINE_XML_METHOD_REGISTRY( WaveTrackIORegistry );
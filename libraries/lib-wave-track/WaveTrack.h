@@ -18,18 +18,21 @@
 
 #include <vector>
 #include <functional>
+#include <unordered_map>
 #include <wx/thread.h>
 #include <wx/longlong.h>
 
 namespace BasicUI{ class ProgressDialog; }
 
 class SampleBlockFactory;
+class SampleBlockSource;
 using SampleBlockFactoryPtr = std::shared_ptr<SampleBlockFactory>;
 
 class TimeWarper;
 
 class ClipInterface;
 class Sequence;
+class StretchedClipRender;
 class WaveClip;
 class AudioSegmentSampleView;
 
@@ -39,6 +42,8 @@ using WaveClipHolders = std::vector<WaveClipHolder>;
 using WaveClipConstHolders = std::vector < std::shared_ptr< const WaveClip > >;
 
 using ClipConstHolders = std::vector<std::shared_ptr<const ClipInterface>>;
+using StretchedClipRenders = std::unordered_map<
+   const ClipInterface*, std::shared_ptr<const StretchedClipRender>>;
 
 // Temporary arrays of mere pointers
 using WaveClipPointers = std::vector < WaveClip* >;
@@ -177,6 +182,14 @@ private:
     */
    size_t CountBlocks() const;
 
+   /*!
+    Coalesce small neighboring blocks of all clips of all channels, as editing
+    leaves them, without changing any samples
+    @return whether any blocks were replaced
+    @pre `IsLeader()`
+    */
+   bool Coalesce();
+
    sampleFormat GetSampleFormat() const override { return mFormat; }
 
    /*!
@@ -323,6 +336,16 @@ private:
 
    void Flush() override;
 
+   //! Append one block of a mono track that reads its samples from the
+   //! source until they are copied into the project
+   /*!
+    Call Flush first, if samples were appended otherwise.  The source must
+    supply samples in the format of the track, and no more than
+    GetMaxBlockSize().
+    */
+   void AppendDeferred(std::shared_ptr<const SampleBlockSource> pSource,
+      sampleFormat effectiveFormat = widestSampleFormat);
+
    //! @name PlayableSequence implementation
    //! @{
    bool IsLeader() const override;
@@ -332,11 +355,13 @@ private:
 
    /*!
     * @pre `iChannel + nBuffers <= NChannels()`
+    * @param pRenders if not null, clips found in it are viewed from their
+    * renders
     * @return nBuffers `ChannelSampleView`s, one per channel.
     */
    std::vector<ChannelSampleView> GetSampleView(
       size_t iChannel, size_t nBuffers, sampleCount start, size_t len,
-      bool backwards) const;
+      bool backwards, const StretchedClipRenders* pRenders = nullptr) const;
 
    ///
    /// MM: Now that each wave track can contain multiple clips, we don't
@@ -733,8 +758,9 @@ private:
       samplePtr buffer, sampleFormat format, sampleCount start, size_t len,
       bool backwards, fillFormat fill, bool mayThrow,
       sampleCount* pNumWithinClips) const;
-   ChannelSampleView
-   GetOneSampleView(sampleCount start, size_t len, bool backwards) const;
+   ChannelSampleView GetOneSampleView(
+      sampleCount start, size_t len, bool backwards,
+      const StretchedClipRenders* pRenders) const;
 
    void DoSetPan(float value);
    void DoSetGain(float value);
@@ -835,6 +861,9 @@ extern WAVE_TRACK_API BoolSetting
 
 extern WAVE_TRACK_API StringSetting AudioTrackNameSetting;
 
+//! Kilobytes of samples per block in new projects, or 0 for the default
+extern WAVE_TRACK_API EnumSetting<int> SampleBlockSizeSetting;
+
 WAVE_TRACK_API bool GetEditClipsCanMove();
 
 // Generate a registry for serialized data
@@ -11,7 +11,8 @@
 #include "WideClip.h"
 
 WideClip::WideClip(
-   std::shared_ptr<ClipInterface> left, std::shared_ptr<ClipInterface> right)
+   std::shared_ptr<const ClipInterface> left,
+   std::shared_ptr<const ClipInterface> right)
     : mChannels { std::move(left), std::move(right) }
 {
 }
@@ -51,3 +52,32 @@ double WideClip::GetStretchRatio() const
 {
    return mChannels[0u]->GetStretchRatio();
 }
+
+ClipContentKey WideClip::GetContentKey() const
+{
+   auto key = mChannels[0u]->GetContentKey();
+   if (key.empty() || !mChannels[1u])
+      return key;
+   const auto rightKey = mChannels[1u]->GetContentKey();
+   if (rightKey.empty())
+      return {};
+   // Delimit, so that keys of different channel splits don't compare equal
+   key.push_back(key.size());
+   key.insert(key.end(), rightKey.begin(), rightKey.end());
+   return key;
+}
+
+std::shared_ptr<const ClipInterface> WideClip::GetSnapshot() const
+{
+   auto left = mChannels[0u]->GetSnapshot();
+   if (!left)
+      return nullptr;
+   std::shared_ptr<const ClipInterface> right;
+   if (mChannels[1u])
+   {
+      right = mChannels[1u]->GetSnapshot();
+      if (!right)
+         return nullptr;
+   }
+   return std::make_shared<WideClip>(std::move(left), std::move(right));
+}
@@ -26,8 +26,8 @@ public:
     * sample rate, play start time, play end time and stretch ratio.
     */
    WideClip(
-      std::shared_ptr<ClipInterface> left,
-      std::shared_ptr<ClipInterface> right);
+      std::shared_ptr<const ClipInterface> left,
+      std::shared_ptr<const ClipInterface> right);
 
    AudioSegmentSampleView
    GetSampleView(size_t ii, sampleCount start, size_t len) const override;
@@ -44,6 +44,10 @@ public:
 
    double GetStretchRatio() const override;
 
+   ClipContentKey GetContentKey() const override;
+
+   std::shared_ptr<const ClipInterface> GetSnapshot() const override;
+
 private:
-   const std::array<std::shared_ptr<ClipInterface>, 2> mChannels;
+   const std::array<std::shared_ptr<const ClipInterface>, 2> mChannels;
 };
@@ -0,0 +1,133 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MockSampleBlockFactory.h
+
+**********************************************************************/
+#pragma once
+
+#include "SampleBlock.h"
+
+#include <atomic>
+#include <vector>
+
+//! Keeps samples in memory, in the format they were given
+class MockSampleBlock final : public SampleBlock
+{
+public:
+   MockSampleBlock(
+      long long id, constSamplePtr src, size_t numsamples,
+      sampleFormat srcformat)
+       : id { id }
+       , format { srcformat }
+       , data(src, src + numsamples * SAMPLE_SIZE(srcformat))
+   {
+   }
+
+   void CloseLock() noexcept override
+   {
+   }
+
+   SampleBlockID GetBlockID() const override
+   {
+      return id;
+   }
+
+   BlockSampleView GetFloatSampleView() override
+   {
+      auto result =
+         std::make_shared<std::vector<float>>(GetSampleCount());
+      DoGetSamples(reinterpret_cast<samplePtr>(result->data()), floatSample,
+         0, result->size());
+      return result;
+   }
+
+   size_t GetSampleCount() const override
+   {
+      return data.size() / SAMPLE_SIZE(format);
+   }
+
+   bool GetSummary256(float*, size_t, size_t) override
+   {
+      return true;
+   }
+
+   bool GetSummary64k(float*, size_t, size_t) override
+   {
+      return true;
+   }
+
+   size_t GetSpaceUsage() const override
+   {
+      return data.size();
+   }
+
+   void SaveXML(XMLWriter&) override
+   {
+   }
+
+   size_t DoGetSamples(
+      samplePtr dest, sampleFormat destformat, size_t sampleoffset,
+      size_t numsamples) override
+   {
+      CopySamples(data.data() + sampleoffset * SAMPLE_SIZE(format), format,
+         dest, destformat, numsamples, DitherType::none);
+      return numsamples;
+   }
+
+   MinMaxRMS DoGetMinMaxRMS(size_t, size_t) override
+   {
+      return { 0, 0, 0 };
+   }
+
+   MinMaxRMS DoGetMinMaxRMS() const override
+   {
+      return { 0, 0, 0 };
+   }
+
+   const long long id;
+   const sampleFormat format;
+   const std::vector<char> data;
+};
+
+//! Makes MockSampleBlock; may be used from several threads at once, as
+//! Sequence does when converting formats
+class MockSampleBlockFactory final : public SampleBlockFactory
+{
+public:
+   SampleBlockIDs GetActiveBlockIDs() override
+   {
+      SampleBlockIDs ids;
+      for (long long id = 1; id < nextId; ++id)
+         ids.insert(id);
+      return ids;
+   }
+
+   SampleBlockPtr DoCreate(
+      constSamplePtr src, size_t numsamples, sampleFormat srcformat) override
+   {
+      return std::make_shared<MockSampleBlock>(
+         nextId++, src, numsamples, srcformat);
+   }
+
+   SampleBlockPtr
+   DoCreateSilent(size_t numsamples, sampleFormat srcformat) override
+   {
+      std::vector<char> silence(numsamples * SAMPLE_SIZE(srcformat));
+      // Like the blocks of a project, with a negative id that is not stored
+      return std::make_shared<MockSampleBlock>(
+         -static_cast<long long>(numsamples), silence.data(), numsamples,
+         srcformat);
+   }
+
+   SampleBlockPtr
+   DoCreateFromXML(sampleFormat, const AttributesList&) override
+   {
+      return nullptr;
+   }
+
+   //! Ids start at 1, because Sequence treats others as silence
+   std::atomic<long long> nextId { 1 };
+};
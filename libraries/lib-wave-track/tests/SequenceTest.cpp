@@ -0,0 +1,277 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SequenceTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "MockSampleBlockFactory.h"
+#include "Sequence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+// Small blocks, so that there are many of them
+constexpr size_t DiskBlockSize = 4096;
+
+struct BlockSizeScope {
+   BlockSizeScope() { Sequence::SetMaxDiskBlockSize(DiskBlockSize); }
+   ~BlockSizeScope() { Sequence::SetMaxDiskBlockSize(saved); }
+   const size_t saved = Sequence::GetMaxDiskBlockSize();
+};
+
+//! Stored as float, but all values are exact in int16, so that no conversion
+//! dithers
+std::unique_ptr<Sequence> MakeSequence(const SampleBlockFactoryPtr &pFactory,
+   const std::vector<size_t> &blockLengths, long long seed)
+{
+   auto pSequence = std::make_unique<Sequence>(
+      pFactory, SampleFormats{ int16Sample, floatSample });
+   for (auto length : blockLengths) {
+      std::vector<float> samples(length);
+      for (auto &sample : samples)
+         sample = ((seed++ * 7919) % 65536 - 32768) / 32768.0f;
+      pSequence->AppendNewBlock(
+         reinterpret_cast<constSamplePtr>(samples.data()), floatSample,
+         length);
+   }
+   return pSequence;
+}
+
+std::vector<float> GetSamples(const Sequence &sequence)
+{
+   std::vector<float> samples(sequence.GetNumSamples().as_size_t());
+   REQUIRE(sequence.Get(reinterpret_cast<samplePtr>(samples.data()),
+      floatSample, 0, samples.size(), true));
+   return samples;
+}
+
+struct BlockShape {
+   sampleCount start;
+   size_t length;
+   bool operator ==(const BlockShape &other) const {
+      return start == other.start && length == other.length;
+   }
+};
+
+std::vector<BlockShape> GetShape(const Sequence &sequence)
+{
+   std::vector<BlockShape> result;
+   for (const auto &block : sequence.GetBlockArray())
+      result.push_back({ block.start, block.sb->GetSampleCount() });
+   return result;
+}
+
+//! What the serial path makes: each block converted alone, in a sequence of
+//! its own, which has just one job and so uses no worker threads
+std::vector<BlockShape> ConvertEachBlock(const SampleBlockFactoryPtr &pFactory,
+   const Sequence &sequence, sampleFormat format)
+{
+   std::vector<BlockShape> result;
+   for (const auto &block : sequence.GetBlockArray()) {
+      Sequence single{ pFactory, sequence.GetSampleFormats() };
+      single.AppendSharedBlock(block.sb);
+      single.ConvertToSampleFormat(format);
+      for (const auto &shape : GetShape(single))
+         result.push_back({ block.start + shape.start, shape.length });
+   }
+   return result;
+}
+}
+
+TEST_CASE("Sequence::ConvertToSampleFormat of several sequences", "[Sequence]")
+{
+   BlockSizeScope scope;
+   const auto pFactory = std::make_shared<MockSampleBlockFactory>();
+   std::vector<std::unique_ptr<Sequence>> sequences;
+   sequences.push_back(MakeSequence(pFactory, { 1024, 1024, 700, 1024 }, 1));
+   sequences.push_back(MakeSequence(pFactory, { 300, 1024, 1024 }, 2));
+   sequences.push_back(MakeSequence(pFactory, {}, 3));
+   std::vector<Sequence*> pointers;
+   for (auto &pSequence : sequences)
+      pointers.push_back(pSequence.get());
+
+   SECTION("Same blocks and samples as converting one block at a time")
+   {
+      for (auto format : { int16Sample, int24Sample }) {
+         std::vector<std::vector<BlockShape>> expectedShapes;
+         std::vector<std::vector<float>> expectedSamples;
+         for (auto pSequence : pointers) {
+            expectedShapes.push_back(
+               ConvertEachBlock(pFactory, *pSequence, format));
+            expectedSamples.push_back(GetSamples(*pSequence));
+         }
+
+         size_t reported = 0;
+         const auto result = Sequence::ConvertToSampleFormat(pointers, format,
+            [&](size_t len){ reported += len; });
+
+         CHECK(result == std::vector<bool>(pointers.size(), true));
+         CHECK(reported == 1024 * 5 + 700 + 300);
+         for (size_t ii = 0; ii < pointers.size(); ++ii) {
+            const auto &sequence = *pointers[ii];
+            CHECK(sequence.GetSampleFormats().Stored() == format);
+            CHECK(GetShape(sequence) == expectedShapes[ii]);
+            CHECK(GetSamples(sequence) == expectedSamples[ii]);
+            sequence.ConsistencyCheck(wxT("SequenceTest"));
+         }
+      }
+   }
+
+   SECTION("Nothing changes if the progress callback throws")
+   {
+      struct Cancel {};
+      std::vector<SampleFormats> oldFormats;
+      std::vector<std::vector<SampleBlock*>> oldBlocks;
+      for (auto pSequence : pointers) {
+         oldFormats.push_back(pSequence->GetSampleFormats());
+         auto &blocks = oldBlocks.emplace_back();
+         for (const auto &block : pSequence->GetBlockArray())
+            blocks.push_back(block.sb.get());
+      }
+
+      CHECK_THROWS_AS(Sequence::ConvertToSampleFormat(pointers, int16Sample,
+         [](size_t){ throw Cancel{}; }), Cancel);
+
+      for (size_t ii = 0; ii < pointers.size(); ++ii) {
+         const auto &sequence = *pointers[ii];
+         CHECK(sequence.GetSampleFormats().Stored() ==
+            oldFormats[ii].Stored());
+         CHECK(sequence.GetSampleFormats().Effective() ==
+            oldFormats[ii].Effective());
+         std::vector<SampleBlock*> blocks;
+         for (const auto &block : sequence.GetBlockArray())
+            blocks.push_back(block.sb.get());
+         CHECK(blocks == oldBlocks[ii]);
+      }
+   }
+}
+
+TEST_CASE("Sequence::Coalesce", "[Sequence]")
+{
+   BlockSizeScope scope;
+   const auto pFactory = std::make_shared<MockSampleBlockFactory>();
+   const auto pSilence = pFactory->CreateSilent(100, floatSample);
+   auto pSequence = MakeSequence(pFactory, { 1024, 100, 200, 300 }, 1);
+   pSequence->AppendSharedBlock(pSilence);
+   for (const auto &block :
+      MakeSequence(pFactory, { 50, 60, 1024 }, 2)->GetBlockArray())
+      pSequence->AppendSharedBlock(block.sb);
+   auto &sequence = *pSequence;
+   REQUIRE(sequence.GetBlockArray().size() == 8);
+   const auto samples = GetSamples(sequence);
+
+   const auto checkBlocks = [&]{
+      for (const auto &block : sequence.GetBlockArray())
+         CHECK(block.sb->GetSampleCount() <= sequence.GetMaxBlockSize());
+      sequence.ConsistencyCheck(wxT("SequenceTest"));
+      CHECK(GetSamples(sequence) == samples);
+   };
+
+   SECTION("Runs of small blocks become one block, but not across silence")
+   {
+      CHECK(sequence.Coalesce());
+      const auto &blocks = sequence.GetBlockArray();
+      REQUIRE(blocks.size() == 5);
+      CHECK(blocks[1].sb->GetSampleCount() == 600);
+      CHECK(blocks[2].sb == pSilence);
+      CHECK(blocks[3].sb->GetSampleCount() == 110);
+      checkBlocks();
+
+      // Nothing more to do
+      CHECK(!sequence.Coalesce());
+   }
+
+   SECTION("A larger block size of the project is adopted")
+   {
+      const auto oldMax = sequence.GetMaxBlockSize();
+      pFactory->SetMaxDiskBlockSize(4 * DiskBlockSize);
+      CHECK(sequence.Coalesce());
+      CHECK(sequence.GetMaxBlockSize() == 4 * oldMax);
+      // Full blocks of the old size are small now
+      const auto &blocks = sequence.GetBlockArray();
+      REQUIRE(blocks.size() == 3);
+      CHECK(blocks[0].sb->GetSampleCount() == 1624);
+      CHECK(blocks[1].sb == pSilence);
+      CHECK(blocks[2].sb->GetSampleCount() == 1134);
+      checkBlocks();
+   }
+
+   SECTION("Pasting from a sequence with larger blocks adopts its size")
+   {
+      Sequence small{ pFactory, sequence.GetSampleFormats() };
+      pFactory->SetMaxDiskBlockSize(4 * DiskBlockSize);
+      const auto pLarge = MakeSequence(pFactory, { 4096 }, 3);
+      REQUIRE(pLarge->GetMaxBlockSize() == 4 * small.GetMaxBlockSize());
+
+      // The block is shared, not split
+      small.Paste(0, pLarge.get());
+      CHECK(small.GetMaxBlockSize() == pLarge->GetMaxBlockSize());
+      REQUIRE(small.GetBlockArray().size() == 1);
+      CHECK(small.GetBlockArray()[0].sb == pLarge->GetBlockArray()[0].sb);
+      small.ConsistencyCheck(wxT("SequenceTest"));
+
+      // Likewise copying, though new sequences would have smaller blocks
+      pFactory->SetMaxDiskBlockSize(0);
+      const auto pCopy = pLarge->Copy(pFactory, 0, pLarge->GetNumSamples());
+      CHECK(pCopy->GetMaxBlockSize() == pLarge->GetMaxBlockSize());
+      CHECK(pCopy->GetBlockArray()[0].sb == pLarge->GetBlockArray()[0].sb);
+   }
+}
+
+TEST_CASE("Sequence::ConvertToSampleFormat throughput", "[.][benchmark]")
+{
+   constexpr size_t NSequences = 4;
+   constexpr size_t NBlocks = 16;
+   const auto pFactory = std::make_shared<MockSampleBlockFactory>();
+   // Blocks of the default size, as in a project
+   const auto blockSize =
+      Sequence{ pFactory, SampleFormats{ int16Sample, floatSample } }
+         .GetMaxBlockSize();
+   const auto makeSequences = [&]{
+      std::vector<std::unique_ptr<Sequence>> sequences;
+      for (size_t ii = 0; ii < NSequences; ++ii)
+         sequences.push_back(MakeSequence(pFactory,
+            std::vector<size_t>(NBlocks, blockSize), ii * blockSize));
+      return sequences;
+   };
+   const auto nSamples = NSequences * NBlocks * blockSize;
+
+   using namespace std::chrono;
+   const auto report = [&](const char *what, steady_clock::duration elapsed){
+      const auto ms = duration_cast<milliseconds>(elapsed).count();
+      std::cout << what << ": " << nSamples << " samples in " << ms
+         << " ms (" << nSamples / 1000.0 / std::max<long long>(1, ms)
+         << " Msamples/s)\n";
+   };
+
+   // One block per call takes the serial path
+   {
+      const auto sequences = makeSequences();
+      const auto start = steady_clock::now();
+      for (auto &pSequence : sequences)
+         for (const auto &block : pSequence->GetBlockArray()) {
+            Sequence single{ pFactory, pSequence->GetSampleFormats() };
+            single.AppendSharedBlock(block.sb);
+            single.ConvertToSampleFormat(int16Sample);
+         }
+      report("One block at a time", steady_clock::now() - start);
+   }
+
+   {
+      const auto sequences = makeSequences();
+      std::vector<Sequence*> pointers;
+      for (auto &pSequence : sequences)
+         pointers.push_back(pSequence.get());
+      const auto start = steady_clock::now();
+      Sequence::ConvertToSampleFormat(pointers, int16Sample);
+      report("All sequences together", steady_clock::now() - start);
+   }
+}
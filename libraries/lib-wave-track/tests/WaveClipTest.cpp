@@ -0,0 +1,60 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveClipTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "MockSampleBlockFactory.h"
+#include "WaveClip.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+//! Counts what the clip tells its caches
+struct CountingListener final : WaveClipListener
+{
+   void MarkChanged() override { ++changed; }
+   void MarkAppended() override { ++appended; }
+   void Invalidate() override {}
+
+   static CountingListener &Get(WaveClip &clip);
+
+   int changed{ 0 };
+   int appended{ 0 };
+};
+
+WaveClip::Caches::RegisteredFactory sKey{ [](WaveClip &) {
+   return std::make_unique<CountingListener>();
+} };
+
+CountingListener &CountingListener::Get(WaveClip &clip)
+{
+   return clip.Caches::Get<CountingListener>(sKey);
+}
+}
+
+TEST_CASE("WaveClip tells caches whether samples were only appended",
+   "[WaveClip]")
+{
+   const auto pFactory = std::make_shared<MockSampleBlockFactory>();
+   WaveClip clip{ 1, pFactory, floatSample, 44100, 0 };
+   auto &listener = CountingListener::Get(clip);
+
+   const std::vector<float> samples(1000, 0.5f);
+   constSamplePtr buffers[]{
+      reinterpret_cast<constSamplePtr>(samples.data()) };
+   clip.Append(buffers, floatSample, samples.size(), 1, floatSample);
+   clip.Flush();
+   CHECK(listener.appended == 2);
+   CHECK(listener.changed == 0);
+   CHECK(clip.GetPlaySamplesCount() == 1000);
+
+   clip.SetSamples(0, buffers[0], floatSample, 0, 100, floatSample);
+   CHECK(listener.changed == 1);
+   CHECK(listener.appended == 2);
+}
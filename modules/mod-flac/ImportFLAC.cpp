@@ -108,6 +108,7 @@ class FLACImportPlugin final : public ImportPlugin
 
    wxString GetPluginStringID() override { return wxT("libflac"); }
    TranslatableString GetPluginFormatDescription() override;
+   bool SupportsConcurrentImport() const override { return true; }
    std::unique_ptr<ImportFileHandle> Open(
       const FilePath &Filename, AudacityProject*)  override;
 };
@@ -117,6 +117,11 @@ public:
       return DESC;
    }
 
+   bool SupportsConcurrentImport() const override
+   {
+      return true;
+   }
+
    std::unique_ptr<ImportFileHandle> Open(const FilePath &Filename, AudacityProject*) override;
 }; // class MP3ImportPlugin
 
@@ -67,6 +67,7 @@ public:
 
    wxString GetPluginStringID() override { return wxT("liboggvorbis"); }
    TranslatableString GetPluginFormatDescription() override;
+   bool SupportsConcurrentImport() const override { return true; }
    std::unique_ptr<ImportFileHandle> Open(
       const FilePath &Filename, AudacityProject*) override;
 };
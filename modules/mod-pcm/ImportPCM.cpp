@@ -34,6 +34,7 @@
 #endif
 
 #include "FileFormats.h"
+#include "PCMBlockSource.h"
 #include "WaveTrack.h"
 #include "ImportPlugin.h"
 #include "ImportUtils.h"
@@ -67,11 +68,14 @@ public:
 
    wxString GetPluginStringID() override { return wxT("libsndfile"); }
    TranslatableString GetPluginFormatDescription() override;
+   bool SupportsConcurrentImport() const override { return true; }
    std::unique_ptr<ImportFileHandle> Open(
       const FilePath &Filename, AudacityProject*) override;
 };
 
 
+using NewChannelGroup = std::vector< std::shared_ptr<WaveTrack> >;
+
 class PCMImportFileHandle final : public ImportFileHandleEx
 {
 public:
@@ -97,10 +101,21 @@ public:
    {}
 
 private:
+   //! Append the samples of plain PCM files straight from a mapping of
+   //! the file, not through libsndfile
+   /*!
+    @return false, having appended nothing, if the file is of another kind
+    */
+   bool ImportMapped(ImportProgressListener &progressListener,
+                     const NewChannelGroup &channels);
+
    SFFile                mFile;
    const SF_INFO         mInfo;
    sampleFormat          mEffectiveFormat;
    sampleFormat          mFormat;
+   //! Read in Open(), because Import() may run in a worker thread, which
+   //! must not read preferences
+   const bool            mOnDemand;
 };
 
 TranslatableString PCMImportPlugin::GetPluginFormatDescription()
@@ -181,7 +196,8 @@ PCMImportFileHandle::PCMImportFileHandle(const FilePath &name,
                                          SFFile &&file, SF_INFO info)
 :  ImportFileHandleEx(name),
    mFile(std::move(file)),
-   mInfo(info)
+   mInfo(info),
+   mOnDemand(OnDemandImport.Read())
 {
    wxASSERT(info.channels >= 0);
 
@@ -277,7 +293,103 @@ struct id3_tag_deleter {
 using id3_tag_holder = std::unique_ptr<id3_tag, id3_tag_deleter>;
 #endif
 
-using NewChannelGroup = std::vector< std::shared_ptr<WaveTrack> >;
+bool PCMImportFileHandle::ImportMapped(
+   ImportProgressListener &progressListener, const NewChannelGroup &channels)
+{
+   if (channels.empty())
+      return false;
+   switch (mInfo.format & SF_FORMAT_TYPEMASK) {
+   case SF_FORMAT_WAV:
+   case SF_FORMAT_WAVEX:
+   case SF_FORMAT_W64:
+   case SF_FORMAT_RF64:
+   case SF_FORMAT_AIFF:
+      break;
+   default:
+      return false;
+   }
+
+   const auto pSourceFile = PCMSourceFile::Open(GetFilename());
+   if (!pSourceFile)
+      return false;
+   const auto pFile = &pSourceFile->GetMapping();
+   const auto layout = &pSourceFile->GetLayout();
+   // Unless libsndfile agrees about the samples, leave the file to it
+   if (layout->channels != static_cast<unsigned>(mInfo.channels) ||
+       layout->frames != static_cast<uint64_t>(mInfo.frames))
+      return false;
+   using Encoding = PCMFileLayout::Encoding;
+   const auto subtype = mInfo.format & SF_FORMAT_SUBMASK;
+   if (!(subtype == SF_FORMAT_PCM_16 && layout->encoding == Encoding::Int16) &&
+       !(subtype == SF_FORMAT_PCM_24 && layout->encoding == Encoding::Int24) &&
+       !(subtype == SF_FORMAT_FLOAT && layout->encoding == Encoding::Float32))
+      return false;
+
+   if (mOnDemand) {
+      // Each block reads from the file, until the project copies it
+      const size_t blockSize = channels.front()->GetMaxBlockSize();
+      for (uint64_t done = 0;
+           done < layout->frames && !IsCancelled() && !IsStopped();) {
+         const auto len = static_cast<size_t>(
+            std::min<uint64_t>(blockSize, layout->frames - done));
+         for (size_t c = 0; c < channels.size(); ++c)
+            channels[c]->AppendDeferred(std::make_shared<PCMBlockSource>(
+               pSourceFile, c, done, len, mFormat), mEffectiveFormat);
+         done += len;
+         progressListener.OnImportProgress(
+            static_cast<double>(done) / layout->frames);
+      }
+      return true;
+   }
+
+   const auto format = layout->GetSampleFormat();
+   const auto sampleBytes = layout->BytesPerSample();
+   const auto frameBytes = layout->BytesPerFrame();
+   // Samples in the byte order of the machine are appended in place, the
+   // sequences de-interleaving them as they copy them into their blocks;
+   // others are decoded into a buffer first
+   const auto inPlace =
+      layout->IsNative() && layout->dataOffset % sampleBytes == 0;
+
+   // Append several blocks at a time, which each sequence then commits in a
+   // run
+   constexpr size_t BlocksPerBatch = 8;
+   const size_t batch = channels.front()->GetMaxBlockSize() * BlocksPerBatch;
+   SampleBuffer scratch;
+   if (!inPlace)
+      scratch.Allocate(batch, format);
+
+   for (uint64_t done = 0;
+        done < layout->frames && !IsCancelled() && !IsStopped();) {
+      const auto len =
+         static_cast<size_t>(std::min<uint64_t>(batch, layout->frames - done));
+      const auto offset = layout->dataOffset + done * frameBytes;
+      const auto bytes = uint64_t(len) * frameBytes;
+      // Reading past the end of a file truncated meanwhile would crash; keep
+      // what was read, as libsndfile does when a file ends early
+      if (!pFile->IsReadable(offset, bytes))
+         break;
+      pFile->WillNeed(offset + bytes, bytes);
+      for (size_t c = 0; c < channels.size(); ++c) {
+         if (inPlace)
+            channels[c]->Append(
+               reinterpret_cast<constSamplePtr>(
+                  pFile->GetData() + offset + c * sampleBytes),
+               format, len, layout->channels, mEffectiveFormat);
+         else {
+            layout->Decode(pFile->GetData(), c, done, len, scratch.ptr());
+            channels[c]->Append(
+               scratch.ptr(), format, len, 1, mEffectiveFormat);
+         }
+      }
+      // These pages are not read again
+      pFile->DontNeed(offset, bytes);
+      done += len;
+      progressListener.OnImportProgress(
+         static_cast<double>(done) / layout->frames);
+   }
+   return true;
+}
 
 void PCMImportFileHandle::Import(ImportProgressListener &progressListener,
                                  WaveTrackFactory *trackFactory,
@@ -300,6 +412,7 @@ void PCMImportFileHandle::Import(ImportProgressListener &progressListener,
       (sampleCount)mInfo.frames; // convert from sf_count_t
    auto maxBlockSize = channels.begin()->get()->GetMaxBlockSize();
 
+   if (!ImportMapped(progressListener, channels))
    {
       // Otherwise, we're in the "copy" mode, where we read in the actual
       // samples from the file and store our own local copy of the
@@ -0,0 +1,231 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PCMBlockSource.cpp
+
+**********************************************************************/
+
+#include "PCMBlockSource.h"
+
+#include "CodeConversions.h"
+#include "Dither.h"
+
+#include <wx/filename.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+//! How long an answer of IsUnchanged() is trusted
+constexpr long long RecheckInterval = 1000;
+
+long long Milliseconds()
+{
+   using namespace std::chrono;
+   return duration_cast<milliseconds>(
+      steady_clock::now().time_since_epoch()).count();
+}
+
+std::optional<long long> ModificationTime(const wxFileName &fileName)
+{
+   if (!fileName.FileExists())
+      return {};
+   const auto time = fileName.GetModificationTime();
+   if (!time.IsValid())
+      return {};
+   return time.GetValue().GetValue();
+}
+
+// Mappings are shared by all sources of one file, including those restored
+// when a project is reopened, which may be many
+std::mutex sFilesMutex;
+std::map<FilePath, std::weak_ptr<PCMSourceFile>> sFiles;
+
+// Serialized sources begin with this
+const char Tag[] = "pcm";
+
+}
+
+PCMSourceFile::PCMSourceFile(const FilePath &path,
+   std::unique_ptr<MemoryMappedFile> pMapping, const PCMFileLayout &layout,
+   long long modified)
+   : mPath{ path }
+   , mpMapping{ std::move(pMapping) }
+   , mLayout{ layout }
+   , mModified{ modified }
+   , mCheckedAt{ Milliseconds() }
+{
+}
+
+std::shared_ptr<PCMSourceFile> PCMSourceFile::Open(const FilePath &path)
+{
+   std::lock_guard<std::mutex> lock(sFilesMutex);
+   auto &wFile = sFiles[path];
+   if (auto pFile = wFile.lock(); pFile && pFile->CheckUnchanged())
+      return pFile;
+
+   // Find the time before mapping, so that a change while mapping is detected
+   const auto modified = ModificationTime(wxFileName{ path });
+   if (!modified)
+      return nullptr;
+   auto pMapping = MemoryMappedFile::Open(path);
+   if (!pMapping)
+      return nullptr;
+   const auto layout =
+      PCMFileLayout::Parse(pMapping->GetData(), pMapping->GetSize());
+   if (!layout)
+      return nullptr;
+   auto pFile = std::make_shared<PCMSourceFile>(
+      path, std::move(pMapping), *layout, *modified);
+   wFile = pFile;
+   return pFile;
+}
+
+bool PCMSourceFile::IsUnchanged() const
+{
+   if (mChanged.load(std::memory_order_relaxed))
+      return false;
+   if (Milliseconds() - mCheckedAt.load(std::memory_order_relaxed) <
+       RecheckInterval)
+      return true;
+   return CheckUnchanged();
+}
+
+bool PCMSourceFile::CheckUnchanged() const
+{
+   if (mChanged.load(std::memory_order_relaxed))
+      return false;
+   const auto now = Milliseconds();
+   const wxFileName fileName{ mPath };
+   const auto modified = ModificationTime(fileName);
+   if (!(modified && *modified == mModified &&
+      fileName.GetSize().GetValue() == mpMapping->GetSize())) {
+      mChanged.store(true, std::memory_order_relaxed);
+      return false;
+   }
+   mCheckedAt.store(now, std::memory_order_relaxed);
+   return true;
+}
+
+PCMBlockSource::PCMBlockSource(std::shared_ptr<PCMSourceFile> pFile,
+   unsigned channel, uint64_t start, size_t len, sampleFormat format)
+   : mpFile{ std::move(pFile) }
+   , mChannel{ channel }
+   , mStart{ start }
+   , mLen{ len }
+   , mFormat{ format }
+{
+}
+
+PCMBlockSource::~PCMBlockSource() = default;
+
+sampleFormat PCMBlockSource::GetSampleFormat() const
+{
+   return mFormat;
+}
+
+size_t PCMBlockSource::GetSampleCount() const
+{
+   return mLen;
+}
+
+bool PCMBlockSource::Read(samplePtr dest, size_t offset, size_t len) const
+{
+   // Don't give samples of a file rewritten since it was mapped
+   if (!mpFile->IsUnchanged())
+      return false;
+
+   if (offset > mLen || len > mLen - offset)
+      return false;
+
+   const auto &layout = mpFile->GetLayout();
+   const auto &mapping = mpFile->GetMapping();
+   const auto data = mapping.GetData();
+   const auto fileFormat = layout.GetSampleFormat();
+   const auto start = mStart + offset;
+   const auto sampleBytes = layout.BytesPerSample();
+
+   // The check above may be a second old; reading past the end of a file
+   // truncated since would crash
+   const auto first = layout.dataOffset + start * layout.BytesPerFrame();
+   if (!mapping.IsReadable(first, uint64_t(len) * layout.BytesPerFrame()))
+      return false;
+
+   // Formats only widen, so there is never dither
+   if (layout.IsNative() && layout.dataOffset % sampleBytes == 0)
+      CopySamples(
+         reinterpret_cast<constSamplePtr>(data + layout.dataOffset +
+            start * layout.BytesPerFrame() + mChannel * sampleBytes),
+         fileFormat, dest, mFormat, len, DitherType::none,
+         layout.channels, 1);
+   else if (fileFormat == mFormat)
+      layout.Decode(data, mChannel, start, len, dest);
+   else {
+      SampleBuffer buffer(len, fileFormat);
+      layout.Decode(data, mChannel, start, len, buffer.ptr());
+      CopySamples(buffer.ptr(), fileFormat, dest, mFormat, len,
+         DitherType::none);
+   }
+   return true;
+}
+
+std::string PCMBlockSource::Serialize() const
+{
+   // The path comes last, so that it may contain any characters
+   std::ostringstream stream;
+   stream << Tag << ' ' << mpFile->GetModificationTime()
+      << ' ' << mpFile->GetMapping().GetSize()
+      << ' ' << mChannel << ' ' << mStart << ' ' << mLen
+      << ' ' << static_cast<unsigned>(mFormat)
+      << '\n' << audacity::ToUTF8(mpFile->GetPath());
+   return stream.str();
+}
+
+std::shared_ptr<const SampleBlockSource>
+PCMBlockSource::Deserialize(const std::string &str)
+{
+   const auto newline = str.find('\n');
+   if (newline == std::string::npos)
+      return nullptr;
+   std::istringstream stream{ str.substr(0, newline) };
+   std::string tag;
+   long long modified;
+   uint64_t size, start;
+   unsigned channel, format;
+   size_t len;
+   if (!(stream >> tag >> modified >> size >> channel >> start >> len
+      >> format) || tag != Tag)
+      return nullptr;
+
+   const auto path = audacity::ToWXString(str.substr(newline + 1));
+   auto pFile = PCMSourceFile::Open(path);
+   if (!pFile || pFile->GetModificationTime() != modified ||
+       pFile->GetMapping().GetSize() != size)
+      return nullptr;
+   const auto &layout = pFile->GetLayout();
+   const auto blockFormat = static_cast<sampleFormat>(format);
+   if (channel >= layout.channels || start > layout.frames ||
+       len > layout.frames - start)
+      return nullptr;
+   switch (blockFormat) {
+   case int16Sample:
+   case int24Sample:
+   case floatSample:
+      if (blockFormat >= layout.GetSampleFormat())
+         break;
+      [[fallthrough]];
+   default:
+      return nullptr;
+   }
+   return std::make_shared<PCMBlockSource>(
+      std::move(pFile), channel, start, len, blockFormat);
+}
+
+// Let projects refer to files that were imported on demand
+static SampleBlockSource::Restorer::Scope scope{
+   PCMBlockSource::Deserialize };
@@ -0,0 +1,92 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PCMBlockSource.h
+  @brief Sample block sources reading uncompressed files in place, for
+  import on demand
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PCM_BLOCK_SOURCE__
+#define __AUDACITY_PCM_BLOCK_SOURCE__
+
+#include "MemoryMappedFile.h"
+#include "PCMFileLayout.h"
+#include "SampleBlock.h"
+
+#include <atomic>
+#include <memory>
+
+//! A mapped file, with the size and time of modification that it had when
+//! it was mapped
+/*! Sources of all blocks from one file share one mapping */
+class PCMSourceFile final
+{
+public:
+   //! @return a mapping shared with other callers if the file did not change,
+   //! or else null if the file can't be mapped or its layout can't be found
+   static std::shared_ptr<PCMSourceFile> Open(const FilePath &path);
+
+   const FilePath &GetPath() const { return mPath; }
+   const MemoryMappedFile &GetMapping() const { return *mpMapping; }
+   const PCMFileLayout &GetLayout() const { return mLayout; }
+   long long GetModificationTime() const { return mModified; }
+
+   //! Whether the file still has the size and time of modification that it
+   //! had when it was mapped
+   /*!
+    The file system is asked again only after some time since the last
+    answer, because this is called for each block read.  Once changed, the
+    file is always changed.  May be called in any thread.
+    */
+   bool IsUnchanged() const;
+
+   PCMSourceFile(const FilePath &path,
+      std::unique_ptr<MemoryMappedFile> pMapping, const PCMFileLayout &layout,
+      long long modified);
+
+private:
+   //! Like IsUnchanged(), but always asks the file system
+   bool CheckUnchanged() const;
+
+   const FilePath mPath;
+   const std::unique_ptr<MemoryMappedFile> mpMapping;
+   const PCMFileLayout mLayout;
+   const long long mModified;
+   //! Milliseconds on a steady clock when the file system was last asked
+   mutable std::atomic<long long> mCheckedAt;
+   mutable std::atomic<bool> mChanged{ false };
+};
+
+//! Samples of one channel of a file, from some frame on
+class PCMBlockSource final : public SampleBlockSource
+{
+public:
+   /*!
+    @pre `start + len <= pFile->GetLayout().frames`
+    @pre `format` is not narrower than `pFile->GetLayout().GetSampleFormat()`
+    */
+   PCMBlockSource(std::shared_ptr<PCMSourceFile> pFile, unsigned channel,
+      uint64_t start, size_t len, sampleFormat format);
+   ~PCMBlockSource() override;
+
+   sampleFormat GetSampleFormat() const override;
+   size_t GetSampleCount() const override;
+   bool Read(samplePtr dest, size_t offset, size_t len) const override;
+   std::string Serialize() const override;
+
+   //! Inverse of Serialize(); null if the string is not understood, or the
+   //! file changed since
+   static std::shared_ptr<const SampleBlockSource>
+   Deserialize(const std::string &str);
+
+private:
+   const std::shared_ptr<PCMSourceFile> mpFile;
+   const unsigned mChannel;
+   const uint64_t mStart;
+   const size_t mLen;
+   const sampleFormat mFormat;
+};
+
+#endif
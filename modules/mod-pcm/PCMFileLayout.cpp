@@ -0,0 +1,320 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PCMFileLayout.cpp
+
+**********************************************************************/
+
+#include "PCMFileLayout.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool HostIsBigEndian = true;
+#else
+constexpr bool HostIsBigEndian = false;
+#endif
+
+uint16_t LE16(const uint8_t *p) { return p[0] | p[1] << 8; }
+uint16_t BE16(const uint8_t *p) { return p[0] << 8 | p[1]; }
+uint32_t LE32(const uint8_t *p) { return LE16(p) | uint32_t(LE16(p + 2)) << 16; }
+uint32_t BE32(const uint8_t *p) { return uint32_t(BE16(p)) << 16 | BE16(p + 2); }
+uint64_t LE64(const uint8_t *p) { return LE32(p) | uint64_t(LE32(p + 4)) << 32; }
+
+bool Is(const uint8_t *p, const char *id, size_t len = 4)
+{
+   return memcmp(p, id, len) == 0;
+}
+
+// Chunk identifiers of Sony Wave64
+const char W64Riff[] =
+   "riff\x2E\x91\xCF\x11\xA5\xD6\x28\xDB\x04\xC1\x00\x00";
+const char W64Wave[] =
+   "wave\xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+const char W64Fmt[] =
+   "fmt \xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+const char W64Data[] =
+   "data\xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+
+constexpr unsigned WaveFormatPCM = 1;
+constexpr unsigned WaveFormatFloat = 3;
+constexpr unsigned WaveFormatExtensible = 0xFFFE;
+
+struct WaveFormat {
+   unsigned tag{ 0 };
+   unsigned channels{ 0 };
+   unsigned blockAlign{ 0 };
+   unsigned bits{ 0 };
+};
+
+//! Parse the body of a WAV or W64 "fmt " chunk
+std::optional<WaveFormat> ParseWaveFormat(const uint8_t *p, uint64_t len)
+{
+   if (len < 16)
+      return {};
+   WaveFormat result;
+   result.tag = LE16(p);
+   result.channels = LE16(p + 2);
+   result.blockAlign = LE16(p + 12);
+   result.bits = LE16(p + 14);
+   if (result.tag == WaveFormatExtensible) {
+      if (len < 40)
+         return {};
+      // Padded containers such as 20 bits in 24 are left to libsndfile
+      const auto validBits = LE16(p + 18);
+      if (validBits != result.bits)
+         return {};
+      // The sub-format GUID begins with the format tag
+      result.tag = LE16(p + 24);
+   }
+   if (result.tag != WaveFormatPCM && result.tag != WaveFormatFloat)
+      return {};
+   return result;
+}
+
+std::optional<PCMFileLayout> MakeLayout(bool isFloat, unsigned bits,
+   unsigned channels, unsigned blockAlign, bool bigEndian,
+   uint64_t dataOffset, uint64_t dataBytes, uint64_t frames = ~uint64_t{})
+{
+   PCMFileLayout result;
+   if (!isFloat && bits == 16)
+      result.encoding = PCMFileLayout::Encoding::Int16;
+   else if (!isFloat && bits == 24)
+      result.encoding = PCMFileLayout::Encoding::Int24;
+   else if (isFloat && bits == 32)
+      result.encoding = PCMFileLayout::Encoding::Float32;
+   else
+      return {};
+   result.bigEndian = bigEndian;
+   result.channels = channels;
+   result.dataOffset = dataOffset;
+   if (channels == 0 || blockAlign != result.BytesPerFrame())
+      return {};
+   result.frames = std::min(frames, dataBytes / blockAlign);
+   return result;
+}
+
+std::optional<PCMFileLayout> ParseWav(const uint8_t *data, uint64_t size)
+{
+   if (size < 12 || !Is(data + 8, "WAVE"))
+      return {};
+   const auto rf64 = Is(data, "RF64");
+   if (!rf64 && !Is(data, "RIFF"))
+      return {};
+
+   std::optional<WaveFormat> format;
+   uint64_t ds64DataBytes = 0;
+   for (uint64_t pos = 12; pos + 8 <= size;) {
+      const auto id = data + pos;
+      uint64_t len = LE32(id + 4);
+      const auto body = pos + 8;
+      const auto available = size - body;
+      if (Is(id, "ds64")) {
+         if (len < 24 || available < 24)
+            return {};
+         ds64DataBytes = LE64(data + body + 8);
+      }
+      else if (Is(id, "fmt ")) {
+         if (!(format = ParseWaveFormat(data + body, std::min(len, available))))
+            return {};
+      }
+      else if (Is(id, "data")) {
+         if (!format)
+            return {};
+         if (rf64 && len == 0xFFFFFFFF)
+            len = ds64DataBytes;
+         return MakeLayout(format->tag == WaveFormatFloat, format->bits,
+            format->channels, format->blockAlign, false,
+            body, std::min(len, available));
+      }
+      pos = body + len + (len & 1);
+   }
+   return {};
+}
+
+std::optional<PCMFileLayout> ParseW64(const uint8_t *data, uint64_t size)
+{
+   if (size < 40 || !Is(data, W64Riff, 16) || !Is(data + 24, W64Wave, 16))
+      return {};
+
+   std::optional<WaveFormat> format;
+   for (uint64_t pos = 40; pos + 24 <= size;) {
+      const auto id = data + pos;
+      // Sizes of chunks include their headers
+      const auto len = LE64(id + 16);
+      if (len < 24)
+         return {};
+      const auto body = pos + 24;
+      const auto available = size - body;
+      if (Is(id, W64Fmt, 16)) {
+         if (!(format =
+            ParseWaveFormat(data + body, std::min(len - 24, available))))
+            return {};
+      }
+      else if (Is(id, W64Data, 16)) {
+         if (!format)
+            return {};
+         return MakeLayout(format->tag == WaveFormatFloat, format->bits,
+            format->channels, format->blockAlign, false,
+            body, std::min(len - 24, available));
+      }
+      // Chunks are aligned to 8 bytes
+      if (len > size)
+         return {};
+      pos += (len + 7) & ~uint64_t{ 7 };
+   }
+   return {};
+}
+
+std::optional<PCMFileLayout> ParseAiff(const uint8_t *data, uint64_t size)
+{
+   if (size < 12 || !Is(data, "FORM"))
+      return {};
+   const auto aifc = Is(data + 8, "AIFC");
+   if (!aifc && !Is(data + 8, "AIFF"))
+      return {};
+
+   bool haveComm = false;
+   unsigned channels = 0, bits = 0;
+   uint64_t frames = 0;
+   bool isFloat = false, bigEndian = true;
+   for (uint64_t pos = 12; pos + 8 <= size;) {
+      const auto id = data + pos;
+      const uint64_t len = BE32(id + 4);
+      const auto body = pos + 8;
+      const auto available = size - body;
+      if (Is(id, "COMM")) {
+         if (len < 18 || available < 18)
+            return {};
+         const auto p = data + body;
+         channels = BE16(p);
+         frames = BE32(p + 2);
+         bits = BE16(p + 6);
+         if (aifc) {
+            if (len < 22 || available < 22)
+               return {};
+            const auto compression = p + 18;
+            if (Is(compression, "sowt"))
+               bigEndian = false;
+            else if (Is(compression, "fl32") || Is(compression, "FL32"))
+               isFloat = true;
+            else if (!Is(compression, "NONE") && !Is(compression, "twos"))
+               return {};
+         }
+         haveComm = true;
+      }
+      else if (Is(id, "SSND")) {
+         if (!haveComm || len < 8 || available < 8)
+            return {};
+         const uint64_t offset = BE32(data + body);
+         const auto start = body + 8 + offset;
+         if (start > size || 8 + offset > len)
+            return {};
+         const auto bytes = std::min(len - 8 - offset, size - start);
+         const auto sampleBytes = bits / 8;
+         return MakeLayout(isFloat, bits, channels, channels * sampleBytes,
+            bigEndian, start, bytes, frames);
+      }
+      pos = body + len + (len & 1);
+   }
+   return {};
+}
+
+template<typename Assemble>
+void DecodeLoop(const uint8_t *p, size_t stride, size_t len, Assemble assemble)
+{
+   for (size_t ii = 0; ii < len; ++ii, p += stride)
+      assemble(ii, p);
+}
+
+}
+
+std::optional<PCMFileLayout>
+PCMFileLayout::Parse(const uint8_t *data, uint64_t size)
+{
+   if (auto result = ParseWav(data, size))
+      return result;
+   if (auto result = ParseW64(data, size))
+      return result;
+   return ParseAiff(data, size);
+}
+
+size_t PCMFileLayout::BytesPerSample() const
+{
+   switch (encoding) {
+   case Encoding::Int16:
+      return 2;
+   case Encoding::Int24:
+      return 3;
+   case Encoding::Float32:
+   default:
+      return 4;
+   }
+}
+
+bool PCMFileLayout::IsNative() const
+{
+   return encoding != Encoding::Int24 && bigEndian == HostIsBigEndian;
+}
+
+sampleFormat PCMFileLayout::GetSampleFormat() const
+{
+   switch (encoding) {
+   case Encoding::Int16:
+      return int16Sample;
+   case Encoding::Int24:
+      return int24Sample;
+   case Encoding::Float32:
+   default:
+      return floatSample;
+   }
+}
+
+void PCMFileLayout::Decode(const uint8_t *file, size_t iChannel,
+   uint64_t start, size_t len, samplePtr dst) const
+{
+   const auto stride = BytesPerFrame();
+   const auto p = file + dataOffset + start * stride
+      + iChannel * BytesPerSample();
+   switch (encoding) {
+   case Encoding::Int16: {
+      const auto d = reinterpret_cast<short*>(dst);
+      if (bigEndian)
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            d[ii] = static_cast<short>(BE16(q)); });
+      else
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            d[ii] = static_cast<short>(LE16(q)); });
+      break;
+   }
+   case Encoding::Int24: {
+      // Assemble in the high bytes, then shift to extend the sign
+      const auto d = reinterpret_cast<int*>(dst);
+      if (bigEndian)
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            d[ii] = static_cast<int32_t>(uint32_t(q[0]) << 24
+               | uint32_t(q[1]) << 16 | uint32_t(q[2]) << 8) >> 8; });
+      else
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            d[ii] = static_cast<int32_t>(uint32_t(q[2]) << 24
+               | uint32_t(q[1]) << 16 | uint32_t(q[0]) << 8) >> 8; });
+      break;
+   }
+   case Encoding::Float32: {
+      const auto d = reinterpret_cast<float*>(dst);
+      if (bigEndian)
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            const auto bits = BE32(q);
+            memcpy(&d[ii], &bits, sizeof(float)); });
+      else
+         DecodeLoop(p, stride, len, [d](size_t ii, const uint8_t *q) {
+            const auto bits = LE32(q);
+            memcpy(&d[ii], &bits, sizeof(float)); });
+      break;
+   }
+   }
+}
@@ -0,0 +1,61 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file PCMFileLayout.h
+  @brief Location and encoding of the samples of uncompressed WAV, W64 and
+  AIFF files, found without decoding
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PCM_FILE_LAYOUT__
+#define __AUDACITY_PCM_FILE_LAYOUT__
+
+#include "SampleFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+//! Interleaved samples of a file, stored as one contiguous range of bytes
+struct PCMFileLayout
+{
+   enum class Encoding { Int16, Int24, Float32 };
+
+   /*!
+    Recognizes WAV (also RF64 and WAVE_FORMAT_EXTENSIBLE), W64, AIFF and
+    AIFC files of 16 or 24 bit integer or 32 bit float samples.  Frames are
+    limited to those actually present, if the file is truncated.
+
+    @param data the start of the file
+    @param size the size of the file
+    @return nothing if the file is of another kind, or malformed
+    */
+   static std::optional<PCMFileLayout> Parse(const uint8_t *data, uint64_t size);
+
+   size_t BytesPerSample() const;
+   size_t BytesPerFrame() const { return BytesPerSample() * channels; }
+
+   //! Whether samples can be read in place, as if they were
+   //! `GetSampleFormat()` samples
+   bool IsNative() const;
+   //! Format that samples decode to
+   sampleFormat GetSampleFormat() const;
+
+   //! Decode `len` samples of channel `iChannel`, starting at frame `start`
+   /*!
+    @pre `start + len <= frames`
+    @pre `dst` has room for `len` samples of `GetSampleFormat()`
+    */
+   void Decode(const uint8_t *file, size_t iChannel,
+      uint64_t start, size_t len, samplePtr dst) const;
+
+   Encoding encoding{ Encoding::Int16 };
+   bool bigEndian{ false };
+   unsigned channels{ 0 };
+   //! Offset of the first sample in the file
+   uint64_t dataOffset{ 0 };
+   uint64_t frames{ 0 };
+};
+
+#endif
@@ -0,0 +1,389 @@
+/*  SPDX-License-Identifier: GPL-2.0-or-later */
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PCMFileLayoutTest.cpp
+
+**********************************************************************/
+#include <catch2/catch.hpp>
+
+#include "PCMFileLayout.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+//! Appends fields of headers
+struct Writer
+{
+   Bytes bytes;
+
+   Writer &Id(const char *id, size_t len = 4)
+   {
+      bytes.insert(bytes.end(), id, id + len);
+      return *this;
+   }
+   Writer &LE(uint64_t value, size_t len)
+   {
+      for (size_t ii = 0; ii < len; ++ii)
+         bytes.push_back(uint8_t(value >> 8 * ii));
+      return *this;
+   }
+   Writer &BE(uint64_t value, size_t len)
+   {
+      for (size_t ii = len; ii--;)
+         bytes.push_back(uint8_t(value >> 8 * ii));
+      return *this;
+   }
+   Writer &Zeros(size_t len)
+   {
+      bytes.insert(bytes.end(), len, 0);
+      return *this;
+   }
+};
+
+//! Body of a "fmt " chunk
+Writer WaveFormat(unsigned tag, unsigned channels, unsigned bits,
+   unsigned blockAlign = 0)
+{
+   if (blockAlign == 0)
+      blockAlign = channels * bits / 8;
+   Writer w;
+   w.LE(tag, 2).LE(channels, 2).LE(44100, 4).LE(44100 * blockAlign, 4)
+      .LE(blockAlign, 2).LE(bits, 2);
+   return w;
+}
+
+Writer ExtensibleFormat(unsigned subTag, unsigned channels, unsigned bits,
+   unsigned validBits)
+{
+   auto w = WaveFormat(0xFFFE, channels, bits);
+   w.LE(22, 2).LE(validBits, 2).LE(0, 4)
+      // The rest of the sub-format GUID
+      .LE(subTag, 2)
+      .Id("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71", 14);
+   return w;
+}
+
+Bytes Wav(const Writer &format, uint64_t dataBytes,
+   const Bytes &before = {})
+{
+   Writer w;
+   const auto riffBytes =
+      4 + 8 + format.bytes.size() + before.size() + 8 + dataBytes;
+   w.Id("RIFF").LE(riffBytes, 4).Id("WAVE")
+      .Id("fmt ").LE(format.bytes.size(), 4);
+   w.bytes.insert(w.bytes.end(), format.bytes.begin(), format.bytes.end());
+   w.bytes.insert(w.bytes.end(), before.begin(), before.end());
+   w.Id("data").LE(dataBytes, 4).Zeros(dataBytes);
+   return w.bytes;
+}
+
+const char W64Riff[] = "riff\x2E\x91\xCF\x11\xA5\xD6\x28\xDB\x04\xC1\x00\x00";
+const char W64Wave[] = "wave\xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+const char W64Fmt[] = "fmt \xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+const char W64Data[] = "data\xF3\xAC\xD3\x11\x8C\xD1\x00\xC0\x4F\x8E\xDB\x8A";
+
+Bytes W64(const Writer &format, uint64_t dataBytes)
+{
+   const auto fmtLen = 24 + format.bytes.size();
+   const auto fmtPadded = (fmtLen + 7) & ~uint64_t{ 7 };
+   Writer w;
+   w.Id(W64Riff, 16).LE(40 + fmtPadded + 24 + dataBytes, 8).Id(W64Wave, 16)
+      .Id(W64Fmt, 16).LE(fmtLen, 8);
+   w.bytes.insert(w.bytes.end(), format.bytes.begin(), format.bytes.end());
+   w.Zeros(fmtPadded - fmtLen)
+      .Id(W64Data, 16).LE(24 + dataBytes, 8).Zeros(dataBytes);
+   return w.bytes;
+}
+
+//! @param compression null for AIFF, else AIFC
+Bytes Aiff(unsigned channels, unsigned bits, uint64_t frames,
+   const char *compression = nullptr, unsigned offset = 0)
+{
+   const auto dataBytes = frames * channels * bits / 8;
+   const unsigned commLen = compression ? 24 : 18;
+   Writer w;
+   w.Id("FORM").BE(4 + 8 + commLen + 8 + 8 + offset + dataBytes, 4)
+      .Id(compression ? "AIFC" : "AIFF")
+      .Id("COMM").BE(commLen, 4)
+      .BE(channels, 2).BE(frames, 4).BE(bits, 2)
+      // 44100 as an 80 bit float
+      .BE(0x400EAC44, 4).Zeros(6);
+   if (compression)
+      // Followed by an empty name, padded to even length
+      w.Id(compression).Zeros(2);
+   w.Id("SSND").BE(8 + offset + dataBytes, 4).BE(offset, 4).Zeros(4)
+      .Zeros(offset + dataBytes);
+   return w.bytes;
+}
+
+//! Parse a copy of exactly `size` bytes, so that the address sanitizer would
+//! catch reads beyond them
+std::optional<PCMFileLayout> Parse(const Bytes &file, size_t size)
+{
+   const std::unique_ptr<uint8_t[]> copy{ new uint8_t[size ? size : 1] };
+   if (size > 0)
+      std::memcpy(copy.get(), file.data(), size);
+   return PCMFileLayout::Parse(copy.get(), size);
+}
+
+std::optional<PCMFileLayout> Parse(const Bytes &file)
+{
+   return Parse(file, file.size());
+}
+
+//! Samples of the layout lie within the file
+bool IsWithin(const PCMFileLayout &layout, uint64_t size)
+{
+   return layout.dataOffset <= size &&
+      layout.frames <= (size - layout.dataOffset) / layout.BytesPerFrame();
+}
+
+void SetLE32(Bytes &file, size_t pos, uint32_t value)
+{
+   for (size_t ii = 0; ii < 4; ++ii)
+      file[pos + ii] = uint8_t(value >> 8 * ii);
+}
+}
+
+TEST_CASE("PCMFileLayout recognizes plain PCM headers")
+{
+   using Encoding = PCMFileLayout::Encoding;
+
+   SECTION("WAV")
+   {
+      const auto file = Wav(WaveFormat(1, 2, 16), 400);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->encoding == Encoding::Int16);
+      REQUIRE(!layout->bigEndian);
+      REQUIRE(layout->channels == 2);
+      REQUIRE(layout->dataOffset == 44);
+      REQUIRE(layout->frames == 100);
+   }
+
+   SECTION("WAV with an odd sized chunk before the data")
+   {
+      Writer list;
+      list.Id("LIST").LE(3, 4).Zeros(4);
+      const auto file = Wav(WaveFormat(3, 1, 32), 40, list.bytes);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->encoding == Encoding::Float32);
+      REQUIRE(layout->dataOffset == 56);
+      REQUIRE(layout->frames == 10);
+   }
+
+   SECTION("WAVE_FORMAT_EXTENSIBLE")
+   {
+      const auto file = Wav(ExtensibleFormat(1, 3, 24, 24), 90);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->encoding == Encoding::Int24);
+      REQUIRE(layout->channels == 3);
+      REQUIRE(layout->frames == 10);
+   }
+
+   SECTION("RF64 takes the size of the data from ds64")
+   {
+      Writer ds64;
+      ds64.Id("ds64").LE(28, 4).LE(0, 8).LE(80, 8).LE(20, 8).LE(0, 4);
+      auto file = Wav(WaveFormat(1, 2, 16), 80, ds64.bytes);
+      std::memcpy(file.data(), "RF64", 4);
+      SetLE32(file, file.size() - 80 - 4, 0xFFFFFFFF);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->frames == 20);
+   }
+
+   SECTION("W64")
+   {
+      const auto file = W64(WaveFormat(3, 2, 32), 80);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->encoding == Encoding::Float32);
+      REQUIRE(layout->channels == 2);
+      REQUIRE(layout->dataOffset == file.size() - 80);
+      REQUIRE(layout->frames == 10);
+   }
+
+   SECTION("AIFF")
+   {
+      const auto file = Aiff(2, 16, 10, nullptr, 6);
+      const auto layout = Parse(file);
+      REQUIRE(layout);
+      REQUIRE(layout->encoding == Encoding::Int16);
+      REQUIRE(layout->bigEndian);
+      REQUIRE(layout->dataOffset == file.size() - 40);
+      REQUIRE(layout->frames == 10);
+   }
+
+   SECTION("AIFC")
+   {
+      const auto sowt = Parse(Aiff(1, 16, 10, "sowt"));
+      REQUIRE(sowt);
+      REQUIRE(!sowt->bigEndian);
+      const auto fl32 = Parse(Aiff(1, 32, 10, "fl32"));
+      REQUIRE(fl32);
+      REQUIRE(fl32->encoding == Encoding::Float32);
+      REQUIRE(fl32->bigEndian);
+   }
+}
+
+TEST_CASE("PCMFileLayout limits frames to those in the file")
+{
+   auto file = Wav(WaveFormat(1, 2, 16), 400);
+   SECTION("when the file is truncated")
+   {
+      const auto layout = Parse(file, file.size() - 9);
+      REQUIRE(layout);
+      REQUIRE(layout->frames == 97);
+   }
+   SECTION("when AIFF claims more frames than there are")
+   {
+      file = Aiff(2, 16, 100);
+      const auto layout = Parse(file, file.size() - 4);
+      REQUIRE(layout);
+      REQUIRE(layout->frames == 99);
+   }
+   SECTION("when the header is complete, but there are no samples")
+   {
+      const auto layout = Parse(file, 44);
+      REQUIRE(layout);
+      REQUIRE(layout->frames == 0);
+   }
+}
+
+TEST_CASE("PCMFileLayout rejects short headers")
+{
+   const auto file = GENERATE(
+      Wav(WaveFormat(1, 2, 16), 40),
+      Wav(ExtensibleFormat(3, 2, 32, 32), 40),
+      W64(WaveFormat(1, 1, 24), 30),
+      Aiff(1, 16, 10),
+      Aiff(1, 16, 10, "sowt", 4));
+   const auto layout = Parse(file);
+   REQUIRE(layout);
+   // Every cut before the first sample loses part of the header
+   for (size_t size = 0; size < layout->dataOffset; ++size) {
+      INFO("size " << size);
+      REQUIRE(!Parse(file, size));
+   }
+}
+
+TEST_CASE("PCMFileLayout rejects what it does not read in place")
+{
+   SECTION("8 bit samples")
+   {
+      REQUIRE(!Parse(Wav(WaveFormat(1, 1, 8), 40)));
+      REQUIRE(!Parse(Aiff(1, 8, 10)));
+   }
+   SECTION("32 bit integer and 64 bit float samples")
+   {
+      REQUIRE(!Parse(Wav(WaveFormat(1, 1, 32), 40)));
+      REQUIRE(!Parse(Wav(WaveFormat(3, 1, 64), 40)));
+   }
+   SECTION("compressed formats")
+   {
+      REQUIRE(!Parse(Wav(WaveFormat(2, 1, 4, 256), 512)));
+      REQUIRE(!Parse(Aiff(1, 16, 10, "ulaw")));
+   }
+   SECTION("padded containers")
+   {
+      REQUIRE(!Parse(Wav(ExtensibleFormat(1, 2, 24, 20), 60)));
+   }
+   SECTION("frames of a size not implied by the format")
+   {
+      REQUIRE(!Parse(Wav(WaveFormat(1, 2, 16, 6), 60)));
+   }
+   SECTION("no channels")
+   {
+      REQUIRE(!Parse(Wav(WaveFormat(1, 0, 16), 40)));
+      REQUIRE(!Parse(Aiff(0, 16, 10)));
+   }
+}
+
+TEST_CASE("PCMFileLayout rejects malformed headers")
+{
+   SECTION("data before fmt")
+   {
+      Writer w;
+      w.Id("RIFF").LE(4 + 8 + 16 + 8 + 16, 4).Id("WAVE")
+         .Id("data").LE(16, 4).Zeros(16)
+         .Id("fmt ").LE(16, 4);
+      const auto format = WaveFormat(1, 1, 16);
+      w.bytes.insert(w.bytes.end(), format.bytes.begin(), format.bytes.end());
+      REQUIRE(!Parse(w.bytes));
+   }
+   SECTION("fmt too short")
+   {
+      auto format = WaveFormat(1, 1, 16);
+      format.bytes.resize(14);
+      REQUIRE(!Parse(Wav(format, 40)));
+   }
+   SECTION("a chunk longer than the file hides the data")
+   {
+      Writer junk;
+      junk.Id("junk").LE(0xFFFFFFF0, 4);
+      REQUIRE(!Parse(Wav(WaveFormat(1, 1, 16), 40, junk.bytes)));
+   }
+   SECTION("W64 chunk shorter than its header")
+   {
+      auto file = W64(WaveFormat(1, 1, 16), 40);
+      // The size of the fmt chunk
+      file[40 + 16] = 8;
+      REQUIRE(!Parse(file));
+   }
+   SECTION("W64 chunk longer than the file")
+   {
+      auto file = W64(WaveFormat(1, 1, 16), 40);
+      file[40 + 16 + 7] = 0x80;
+      REQUIRE(!Parse(file));
+   }
+   SECTION("AIFF sound data offset beyond the chunk")
+   {
+      auto file = Aiff(1, 16, 10);
+      // The offset field of SSND
+      const auto ssnd = file.size() - 20 - 16;
+      file[ssnd + 8 + 3] = 100;
+      REQUIRE(!Parse(file));
+   }
+   SECTION("other kinds of files")
+   {
+      REQUIRE(!Parse(Bytes{}));
+      REQUIRE(!Parse(Bytes(64, 0)));
+      Writer w;
+      w.Id("RIFF").LE(4, 4).Id("AVI ");
+      REQUIRE(!Parse(w.bytes));
+   }
+}
+
+TEST_CASE("PCMFileLayout never places samples outside of damaged files")
+{
+   const auto original = GENERATE(
+      Wav(WaveFormat(1, 2, 16), 64),
+      Wav(ExtensibleFormat(1, 3, 24, 24), 36),
+      W64(WaveFormat(3, 1, 32), 32),
+      Aiff(2, 16, 16),
+      Aiff(1, 32, 8, "fl32", 2));
+   std::mt19937 random{ 1 };
+   for (int ii = 0; ii < 2000; ++ii) {
+      auto file = original;
+      // Damage a few bytes of the header, and maybe cut the file
+      const auto header = file.size() - 32;
+      for (int jj = 0; jj < 3; ++jj)
+         file[random() % header] = uint8_t(random());
+      const auto size = random() % 2 ? file.size() : random() % file.size();
+      if (const auto layout = Parse(file, size)) {
+         INFO("iteration " << ii);
+         REQUIRE(IsWithin(*layout, size));
+      }
+   }
+}
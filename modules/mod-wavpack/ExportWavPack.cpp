@@ -233,6 +233,7 @@ struct WriteId final
    uint32_t bytesWritten {};
    uint32_t firstBlockSize {};
    std::unique_ptr<wxFile> file;
+   std::shared_ptr<ExportOutputStream> stream;
 };
 
 class WavPackExportProcessor final : public ExportProcessor
@@ -253,10 +254,13 @@ class WavPackExportProcessor final : public ExportProcessor
       std::unique_ptr<Mixer> mixer;
       std::unique_ptr<Tags> metadata;
    } context;
+   std::shared_ptr<ExportOutputStream> mOutputStream;
 public:
 
    ~WavPackExportProcessor();
 
+   bool SetOutputStream(std::shared_ptr<ExportOutputStream> stream) override;
+
    bool Initialize(AudacityProject& project,
       const Parameters& parameters,
       const wxFileNameWrapper& filename,
@@ -282,6 +286,8 @@ public:
 
    std::vector<std::string> GetMimeTypes(int) const override;
 
+   bool SupportsOutputStream(int) const override;
+
    bool ParseConfig(int formatIndex, const rapidjson::Value& document, ExportProcessor::Parameters& parameters) const override;
 
    std::unique_ptr<ExportOptionsEditor>
@@ -309,6 +315,13 @@ std::vector<std::string> ExportWavPack::GetMimeTypes(int) const
    return { "audio/x-wavpack" };
 }
 
+bool ExportWavPack::SupportsOutputStream(int) const
+{
+   // WavPack blocks are written sequentially, the sample count in the
+   // first block may be left unknown
+   return true;
+}
+
 bool ExportWavPack::ParseConfig(int formatIndex, const rapidjson::Value& config, ExportProcessor::Parameters& parameters) const
 {
    if(!config.IsObject() || 
@@ -370,6 +383,12 @@ WavPackExportProcessor::~WavPackExportProcessor()
       WavpackCloseFile(context.wpc);
 }
 
+bool WavPackExportProcessor::SetOutputStream(std::shared_ptr<ExportOutputStream> stream)
+{
+   mOutputStream = std::move(stream);
+   return true;
+}
+
 bool WavPackExportProcessor::Initialize(AudacityProject& project,
    const Parameters& parameters,
    const wxFileNameWrapper& fName,
@@ -386,10 +405,15 @@ bool WavPackExportProcessor::Initialize(AudacityProject& project,
    WavpackConfig config = {};
    auto& outWvFile = context.outWvFile;
    auto& outWvcFile = context.outWvcFile;
-   outWvFile.file = std::make_unique< wxFile >();
+   if (mOutputStream)
+      outWvFile.stream = mOutputStream;
+   else
+   {
+      outWvFile.file = std::make_unique< wxFile >();
 
-   if (!outWvFile.file->Create(fName.GetFullPath(), true) || !outWvFile.file->IsOpened()) {
-      throw ExportException(_("Unable to open target file for writing"));
+      if (!outWvFile.file->Create(fName.GetFullPath(), true) || !outWvFile.file->IsOpened()) {
+         throw ExportException(_("Unable to open target file for writing"));
+      }
    }
    
    const auto &tracks = TrackList::Get( project );
@@ -402,10 +426,12 @@ bool WavPackExportProcessor::Initialize(AudacityProject& project,
       parameters,
       OptionIDHybridMode,
       false);
-   const auto createCorrectionFile = ExportPluginHelpers::GetParameterValue<bool>(
-      parameters,
-      OptionIDCreateCorrection,
-      false);
+   // There is no place for a correction file when streaming
+   const auto createCorrectionFile = !mOutputStream &&
+      ExportPluginHelpers::GetParameterValue<bool>(
+         parameters,
+         OptionIDCreateCorrection,
+         false);
    const auto bitRate = ExportPluginHelpers::GetParameterValue<int>(
       parameters,
       OptionIDBitRate,
@@ -461,7 +487,7 @@ bool WavPackExportProcessor::Initialize(AudacityProject& project,
    // If we're not creating a correction file now, any one that currently exists with this name
    // will become obsolete now, so delete it if it happens to exist (although it usually won't)
 
-   if (!hybridMode || !createCorrectionFile)
+   if (!mOutputStream && (!hybridMode || !createCorrectionFile))
       wxRemoveFile(fName.GetFullPath().Append("c"));
 
    context.wpc = WavpackOpenFileOutput(WriteBlock, &outWvFile, createCorrectionFile ? &outWvcFile : nullptr);
@@ -549,6 +575,11 @@ ExportResult WavPackExportProcessor::Process(ExportProcessorDelegate& delegate)
       }
    }
 
+   // The stream consumer receives the blocks as they are produced, so the
+   // first block keeps the unknown sample count
+   if (mOutputStream)
+      return exportResult;
+
    if ( !context.outWvFile.file.get()->Close()
       || ( context.outWvcFile.file && context.outWvcFile.file.get() && !context.outWvcFile.file.get()->Close())) {
       return ExportResult::Error;
@@ -584,13 +615,20 @@ int WavPackExportProcessor::WriteBlock(void *id, void *data, int32_t length)
 
     WriteId *outId = static_cast<WriteId*>(id);
 
-    if (!outId->file)
+    if (outId->stream)
+    {
+        if (!outId->stream->Write(data, length)) {
+            outId->stream.reset();
+            return false;
+        }
+    }
+    else if (!outId->file)
         // This does not match the wavpack.c but in our case if file is nullptr - 
         // the stream error has occured
         return false; 
 
    //  if (!outId->file->Write(data, length).IsOk()) {
-    if (outId->file->Write(data, length) != length) {
+    else if (outId->file->Write(data, length) != length) {
         outId->file.reset();
         return false;
     }
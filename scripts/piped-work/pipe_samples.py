@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Moves samples of tracks in and out of Audacity in binary frames.
+
+Make sure Audacity is running first, that mod-script-pipe is enabled, and
+that the project has at least one wave track.
+
+The samples do not go through the pipes of commands.  GetSamples and
+SetSamples name a file, which is read or written whole, one frame per channel:
+a header of 32 bytes, then 32 bit floats, all in native byte order.  A file
+in /dev/shm stays in memory.
+
+"""
+
+import os
+import struct
+import sys
+
+import pipeclient
+
+HEADER = struct.Struct('=4sIIIqq')
+MAGIC = b'ASMP'
+
+
+def read_frames(path):
+    """Return a list of (track, channel, start, samples) from the file."""
+    frames = []
+    with open(path, 'rb') as data:
+        while True:
+            header = data.read(HEADER.size)
+            if len(header) < HEADER.size:
+                return frames
+            magic, track, channel, _, start, length = HEADER.unpack(header)
+            assert magic == MAGIC
+            samples = struct.unpack('=%df' % length, data.read(4 * length))
+            frames.append((track, channel, start, samples))
+
+
+def write_frames(path, frames):
+    """Write a list of (track, channel, start, samples) to the file."""
+    with open(path, 'wb') as data:
+        for track, channel, start, samples in frames:
+            data.write(HEADER.pack(MAGIC, track, channel, 0, start, len(samples)))
+            data.write(struct.pack('=%df' % len(samples), *samples))
+
+
+def do_command(client, command):
+    """Send one command, and return the reply once it arrives."""
+    client.write(command)
+    pipeclient.PipeClient.reply_ready.wait(60)
+    return client.read()
+
+
+def main():
+    """Halve the first second of the first track."""
+    shm = '/dev/shm' if os.path.isdir('/dev/shm') else '.'
+    path = os.path.join(shm, 'audacity_samples.%d' % os.getpid())
+    client = pipeclient.PipeClient()
+
+    print(do_command(
+        client, 'GetSamples: Filename="%s" Track=0 Start=0 Length=44100' % path))
+    frames = read_frames(path)
+    for track, channel, start, samples in frames:
+        print('track %d channel %d: %d samples from %d, peak %f' % (
+            track, channel, len(samples), start,
+            max((abs(s) for s in samples), default=0)))
+
+    write_frames(path, [(track, channel, start, [s / 2 for s in samples])
+                        for track, channel, start, samples in frames])
+    # One command applies all of the frames as one undoable change
+    print(do_command(client, 'SetSamples: Filename="%s"' % path))
+    os.remove(path)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
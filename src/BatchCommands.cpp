@@ -27,8 +27,15 @@ processing.  See also MacrosWindow and ApplyMacroDialog.
 #include <wx/textfile.h>
 #include <wx/time.h>
 
+#include <algorithm>
+#include <thread>
+
+#include "Clipboard.h"
 #include "Project.h"
+#include "ProjectFileIO.h"
+#include "ProjectFileManager.h"
 #include "ProjectHistory.h"
+#include "ProjectManager.h"
 #include "ProjectSettings.h"
 #include "ProjectWindow.h"
 #include "commands/CommandManager.h"
@@ -41,8 +48,10 @@ processing.  See also MacrosWindow and ApplyMacroDialog.
 #include "SelectFile.h"
 #include "SelectUtilities.h"
 #include "SettingsVisitor.h"
+#include "Tags.h"
 #include "Track.h"
 #include "UndoManager.h"
+#include "WaveTrack.h"
 
 #include "AllThemeResources.h"
 
@@ -734,6 +743,155 @@ void MacroCommands::AbortBatch()
    mAbort = true;
 }
 
+auto MacroCommands::ApplyMacroToFiles(const MacroCommandsCatalog &catalog,
+   const FilePaths &files, size_t concurrency,
+   const FileStartedFn &onStarted, const FileFinishedFn &onFinished)
+   -> FileResults
+{
+   using ImportResult = ImportProgressListener::ImportResult;
+   auto &project = mProject;
+   auto &projectFileManager = ProjectFileManager::Get(project);
+   auto &globalClipboard = Clipboard::Get();
+
+   if (concurrency == 0)
+      concurrency = std::max(1u, std::thread::hardware_concurrency());
+
+   // DV: Macro invocation on file will reset the project to the
+   // initial state. There is a possibility, that clipboard will contain
+   // references to the data removed
+   if (globalClipboard.Project().lock().get() == &project)
+      globalClipboard.Clear();
+
+   // Move global clipboard contents aside temporarily
+   Clipboard::Scope scope;
+
+   // Each file begins with these tags, and then adds its own
+   const auto pTags = Tags::Get(project).Duplicate();
+
+   FileResults results;
+   bool stop = false;
+
+   // Report the start of a file; false if stopped
+   const auto start = [&](size_t index) {
+      if (onStarted && !onStarted(index))
+         stop = true;
+      return !stop;
+   };
+   // Add the tracks of a file with `import`, which returns false if there
+   // were none, and then apply the macro
+   const auto apply = [&](FileResult &result,
+      const std::function<bool()> &import
+   ){
+      bool imported = false;
+      result.success = GuardedCall< bool >([&] {
+         if (!import())
+            return false;
+         imported = true;
+         if (const auto pWindow = ProjectWindow::Find(&project))
+            pWindow->ZoomAfterImport(nullptr);
+         SelectUtilities::DoSelectAll(project);
+         return ApplyMacro(catalog);
+      });
+      if (!imported)
+         result.message = XO("Nothing could be imported");
+      else if (!result.success) {
+         result.message = XO("The macro failed");
+         // Do not go on after an abort or a failure, as before
+         stop = true;
+      }
+   };
+   const auto finish = [&](FileResult result) {
+      results.push_back(std::move(result));
+      if (onFinished && !onFinished(results.back()))
+         stop = true;
+   };
+
+   size_t first = 0;
+   while (!stop && first < files.size()) {
+      if (!ProjectFileManager::IsAudioFile(files[first])) {
+         // Project files and lists of files can't be decoded in a batch;
+         // import them alone, as the one-file import does
+         const auto &fileName = files[first];
+         if (!start(first))
+            break;
+         FileResult result{ fileName };
+         apply(result, [&]{
+            // Import may return false even for a list of files that it
+            // imported, and it shows its own errors
+            projectFileManager.Import(fileName);
+            return !TrackList::Get(project).empty();
+         });
+         // Ensure project is completely reset
+         ProjectManager::Get(project).ResetProjectToEmpty();
+         // Bug2567
+         globalClipboard.Clear();
+         finish(std::move(result));
+         ++first;
+         continue;
+      }
+
+      // Decode a group of consecutive audio files at once
+      auto last = first + 1;
+      while (last < files.size() && last - first < concurrency &&
+             ProjectFileManager::IsAudioFile(files[last]))
+         ++last;
+      FilePaths group{ files.begin() + first, files.begin() + last };
+      // Decode into a hidden project, whose database owns the samples of the
+      // files not yet reached; this project, which the macros may save or
+      // compact, only ever holds the samples of the current file
+      InvisibleTemporaryProject staging;
+      auto items = projectFileManager.DecodeBatch(group, concurrency,
+         &WaveTrackFactory::Get(staging.Project()));
+
+      for (size_t ii = 0; !stop && ii < items.size(); ++ii) {
+         auto &item = items[ii];
+         if (!start(first + ii))
+            break;
+
+         FileResult result{ item.fileName };
+         if (item.result == ImportResult::Cancelled) {
+            result.message = XO("Import was cancelled");
+            stop = true;
+         }
+         else if (!(item.result == ImportResult::Success ||
+               item.result == ImportResult::Stopped) || item.tracks.empty())
+            result.message = item.errorMessage.empty()
+               ? XO("No audio could be imported") : item.errorMessage;
+         else
+            apply(result, [&]{
+               Tags::Set(project, item.tags);
+               // Copy the samples into this project just before the macro
+               TrackHolders tracks;
+               for (const auto &pGroup : item.tracks) {
+                  auto pList = TrackList::Create(nullptr);
+                  for (const auto pTrack : *pGroup)
+                     pTrack->PasteInto(project, *pList);
+                  tracks.push_back(std::move(pList));
+               }
+               item.tracks.clear();
+               projectFileManager.AddImportedTracks(
+                  item.fileName, std::move(tracks));
+               return true;
+            });
+         item.tracks.clear();
+
+         // Ensure project is completely reset
+         ProjectManager::Get(project).ResetProjectToEmpty();
+         Tags::Set(project, pTags->Duplicate());
+         // Bug2567
+         globalClipboard.Clear();
+
+         finish(std::move(result));
+      }
+
+      // Free the samples of files not reached, before the staging project
+      // closes
+      items.clear();
+      first = last;
+   }
+   return results;
+}
+
 void MacroCommands::AddToMacro(const CommandID &command, int before)
 {
    AddToMacro(command, GetCurrentParamsFor(command), before);
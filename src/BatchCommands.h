@@ -14,6 +14,9 @@
 
 #include <wx/defs.h>
 
+#include <functional>
+#include <vector>
+
 #include "Export.h"
 #include "ComponentInterface.h" // for ComponentInterfaceSymbol
 #include "PluginProvider.h" // for PluginID
@@ -74,6 +77,39 @@ class MacroCommands final {
    bool ReportAndSkip( const TranslatableString & friendlyCommand, const wxString & params );
    void AbortBatch();
 
+   //! Outcome of applying the macro to one file
+   struct FileResult {
+      FilePath fileName;
+      bool success{ false };
+      //! Why the file failed, if it did and the reason is known
+      TranslatableString message;
+   };
+   using FileResults = std::vector<FileResult>;
+   //! Called before each file, with its index; return false to stop
+   using FileStartedFn = std::function<bool(size_t)>;
+   //! Called after each file; return false to stop
+   using FileFinishedFn = std::function<bool(const FileResult &)>;
+
+   /*!
+    Apply the macro to each of the files in turn, in the project, which must
+    be empty, and is emptied again after each file.
+
+    The files are taken in groups of up to `concurrency`, and all of a group
+    are decoded concurrently (where the importers allow it) before the macro
+    is applied to any of them.  They are decoded into a hidden temporary
+    project, and the tracks of each file are copied into the project just
+    before its macro runs.  Macros themselves run on the calling thread.
+
+    @param concurrency maximum number of files decoded at once; 0 for the
+    hardware concurrency
+    @return results for the files attempted, in order; fewer than the files
+    if stopped
+    */
+   FileResults ApplyMacroToFiles( const MacroCommandsCatalog &catalog,
+      const FilePaths &files, size_t concurrency,
+      const FileStartedFn &onStarted = {},
+      const FileFinishedFn &onFinished = {} );
+
    // These commands do not depend on the command list.
    static void MigrateLegacyChains();
    static wxArrayString GetNames();
@@ -32,6 +32,7 @@
 #include <wx/textctrl.h>
 #include <wx/listctrl.h>
 #include <wx/button.h>
+#include <wx/filename.h>
 #include <wx/imaglist.h>
 #include <wx/settings.h>
 
@@ -393,7 +394,7 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
          fileList = S.Id(CommandsListID)
             .Style(wxSUNKEN_BORDER | wxLC_REPORT | wxLC_HRULES | wxLC_VRULES |
                 wxLC_SINGLE_SEL)
-            .AddListControlReportMode( { XO("File") } );
+            .AddListControlReportMode( { XO("File"), XO("Result") } );
          // AssignImageList takes ownership
          fileList->AssignImageList(imageList.release(), wxIMAGE_LIST_SMALL);
       }
@@ -440,54 +441,45 @@ void ApplyMacroDialog::OnApplyToFiles(wxCommandEvent & WXUNUSED(event))
    Hide();
 
    mMacroCommands.ReadMacro(name); 
+   MacroCommands::FileResults failures;
    {
-      auto &globalClipboard = Clipboard::Get();
-
-      // DV: Macro invocation on file will reset the project to the
-      // initial state. There is a possibility, that clipboard will contain
-      // references to the data removed
-      if (globalClipboard.Project().lock().get() == project)
-         globalClipboard.Clear();
-
-      // Move global clipboard contents aside temporarily
-      Clipboard::Scope scope;
-
       wxWindowDisabler wd(&activityWin);
-      for (i = 0; i < (int)files.size(); i++) {
-         if (i > 0) {
-            //Clear the arrow in previous item.
-            fileList->SetItemImage(i - 1, 0, 0);
-         }
-         fileList->SetItemImage(i, 1, 1);
-         fileList->EnsureVisible(i);
-
-         auto success = GuardedCall< bool >([&] {
-            ProjectFileManager::Get(*project).Import(files[i]);
-            ProjectWindow::Get(*project).ZoomAfterImport(nullptr);
-            SelectUtilities::DoSelectAll(*project);
-            if (!mMacroCommands.ApplyMacro(mCatalog))
-               return false;
-
-            if (!activityWin.IsShown() || mAbort)
-               return false;
-
+      size_t nFinished = 0;
+      mMacroCommands.ApplyMacroToFiles(mCatalog, files, 0,
+         [&](size_t index) {
+            if (index > 0) {
+               //Clear the arrow in previous item.
+               fileList->SetItemImage(index - 1, 0, 0);
+            }
+            fileList->SetItemImage(index, 1, 1);
+            fileList->EnsureVisible(index);
             return true;
+         },
+         [&](const MacroCommands::FileResult &result) {
+            fileList->SetItem(nFinished++, 1, result.success
+               ? XO("Done").Translation()
+               : result.message.Translation());
+            if (!result.success)
+               failures.push_back(result);
+            return activityWin.IsShown() && !mAbort;
          });
-
-         // Ensure project is completely reset
-         ProjectManager::Get(*project).ResetProjectToEmpty();
-         // Bug2567:
-         // Must also destroy the clipboard, to be sure sample blocks are
-         // all freed and their ids can be reused safely in the next pass
-         globalClipboard.Clear();
-
-         if (!success)
-            break;
-      }
    }
 
    Show();
    Raise();
+
+   if (!failures.empty()) {
+      auto message =
+         XO("The macro could not be applied to %d of %d files:")
+            .Format(static_cast<int>(failures.size()),
+               static_cast<int>(files.size()));
+      for (const auto &failure : failures)
+         message.Join(Verbatim("%s: %s")
+            .Format(wxFileName{ failure.fileName }.GetFullName(),
+               failure.message), "\n");
+      AudacityMessageBox(message, XO("Apply Macro"),
+         wxOK | wxICON_WARNING, this);
+   }
 }
 
 void ApplyMacroDialog::OnCancel(wxCommandEvent & WXUNUSED(event))
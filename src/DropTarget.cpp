@@ -167,14 +167,25 @@ public:
             ProjectWindow::Get( *mProject ).HandleResize(); // Adjust scrollers for NEW track sizes.
          } );
 
+         // Import consecutive audio files together, so that they are
+         // decoded concurrently
+         FilePaths names;
+         const auto flush = [&]{
+            if (!names.empty())
+               ProjectFileManager::Get( *mProject ).Import(names);
+            names.clear();
+         };
          for (const auto &name : sortednames) {
 #ifdef USE_MIDI
-            if (FileNames::IsMidi(name))
+            if (FileNames::IsMidi(name)) {
+               flush();
                DoImportMIDI( *mProject, name );
+            }
             else
 #endif
-               ProjectFileManager::Get( *mProject ).Import(name);
+               names.push_back(name);
          }
+         flush();
 
          auto &window = ProjectWindow::Get( *mProject );
          window.ZoomAfterImport(nullptr);
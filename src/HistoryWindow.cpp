@@ -46,6 +46,7 @@ undo memory so as to free up space.
 
 #include <unordered_set>
 #include "SampleBlock.h"
+#include "UndoBlockUsage.h"
 #include "WaveTrack.h"
 
 namespace {
@@ -68,10 +69,8 @@ struct SpaceUsageCalculator {
    SpaceArray space;
    Type clipboardSpaceUsage;
 
-   void Calculate( UndoManager &manager )
+   void Calculate( AudacityProject &project, UndoManager &manager )
    {
-      SampleBlockIDSet seen;
-
       // After copies and pastes, a block file may be used in more than
       // one place in one undo history state, and it may be used in more than
       // one undo history state.  It might even be used in two states, but not
@@ -87,18 +86,18 @@ struct SpaceUsageCalculator {
       // contribution to space usage should be counted only in that latest
       // state.
 
+      // UndoBlockUsage maintains exactly that as states come and go
+      const auto &usage = UndoBlockUsage::Get(project);
       manager.VisitStates(
-         [this, &seen](const UndoStackElem &elem) {
-            // Scan all tracks at current level
-            if (auto pTracks = TrackList::FindUndoTracks(elem))
-               space.push_back(CalculateUsage(*pTracks, seen));
+         [this, &usage](const UndoStackElem &elem) {
+            space.push_back(usage.GetAttributedUsage(elem));
          },
          true // newest state first
       );
 
       // Count the usage of the clipboard separately, using another set.  Do not
       // multiple-count any block occurring multiple times within the clipboard.
-      seen.clear();
+      SampleBlockIDSet seen;
       clipboardSpaceUsage = CalculateUsage(
          Clipboard::Get().GetTracks(), seen);
 
@@ -283,7 +282,7 @@ void HistoryDialog::DoUpdate()
    int i = 0;
 
    SpaceUsageCalculator calculator;
-   calculator.Calculate( *mManager );
+   calculator.Calculate( *mProject, *mManager );
 
    // point to size for oldest state
    auto iter = calculator.space.rbegin();
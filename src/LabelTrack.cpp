@@ -32,6 +32,8 @@ for drawing different aspects of the label and its text box.
 #include "LabelTrack.h"
 
 #include <algorithm>
+#include <atomic>
+#include <numeric>
 #include <limits.h>
 #include <float.h>
 
@@ -95,6 +97,7 @@ LabelTrack::LabelTrack()
 
 LabelTrack::LabelTrack(const LabelTrack &orig, ProtectedCreationArg &&a)
    : UniqueChannelTrack{ orig, std::move(a) }
+   , mGeneration{ orig.mGeneration }
    , mClipLen{ 0.0 }
 {
    for (auto &original: orig.mLabels) {
@@ -156,7 +159,11 @@ void LabelTrack::SetLabel( size_t iLabel, const LabelStruct &newLabel )
       wxASSERT( false );
       mLabels.resize( iLabel + 1 );
    }
+   const bool retitled = mLabels[ iLabel ].title != newLabel.title;
    mLabels[ iLabel ] = newLabel;
+   if (retitled)
+      mLabels[ iLabel ].width = -1;
+   InvalidateIndex();
 }
 
 LabelTrack::~LabelTrack()
@@ -165,6 +172,7 @@ LabelTrack::~LabelTrack()
 
 void LabelTrack::MoveTo(double origin)
 {
+   InvalidateIndex();
    if (!mLabels.empty()) {
       const auto offset = origin - mLabels[0].selectedRegion.t0();
       for (auto &labelStruct: mLabels) {
@@ -180,6 +188,7 @@ void LabelTrack::DoOnProjectTempoChange(
    if (!oldTempo.has_value())
       return;
    const auto ratio = *oldTempo / newTempo;
+   InvalidateIndex();
    for (auto& label : mLabels)
       label.selectedRegion.setTimes(
          label.getT0() * ratio, label.getT1() * ratio);
@@ -188,6 +197,7 @@ void LabelTrack::DoOnProjectTempoChange(
 void LabelTrack::Clear(double b, double e)
 {
    assert(IsLeader());
+   InvalidateIndex();
    // May DELETE labels, so use subscripts to iterate
    for (size_t i = 0; i < mLabels.size(); ++i) {
       auto &labelStruct = mLabels[i];
@@ -237,6 +247,7 @@ bool LabelTrack::SplitDelete(double b, double e)
 
 void LabelTrack::ShiftLabelsOnInsert(double length, double pt)
 {
+   InvalidateIndex();
    for (auto &labelStruct: mLabels) {
       LabelStruct::TimeRelations relation =
                         labelStruct.RegionRelation(pt, pt, this);
@@ -250,6 +261,7 @@ void LabelTrack::ShiftLabelsOnInsert(double length, double pt)
 
 void LabelTrack::ChangeLabelsOnReverse(double b, double e)
 {
+   InvalidateIndex();
    for (auto &labelStruct: mLabels) {
       if (labelStruct.RegionRelation(b, e, this) ==
                                     LabelStruct::SURROUNDS_LABEL)
@@ -265,6 +277,7 @@ void LabelTrack::ChangeLabelsOnReverse(double b, double e)
 
 void LabelTrack::ScaleLabels(double b, double e, double change)
 {
+   InvalidateIndex();
    for (auto &labelStruct: mLabels) {
       labelStruct.selectedRegion.setTimes(
          AdjustTimeStampOnScale(labelStruct.getT0(), b, e, change),
@@ -292,6 +305,7 @@ double LabelTrack::AdjustTimeStampOnScale(double t, double b, double e, double c
 // (If necessary this could be optimised by ignoring labels that occur before a
 // specified time, as in most cases they don't need to move.)
 void LabelTrack::WarpLabels(const TimeWarper &warper) {
+   InvalidateIndex();
    for (auto &labelStruct: mLabels) {
       labelStruct.selectedRegion.setTimes(
          warper.Warp(labelStruct.getT0()),
@@ -309,7 +323,7 @@ LabelStruct::LabelStruct(const SelectedRegion &region,
 , title(aTitle)
 {
    updated = false;
-   width = 0;
+   width = -1;
    x = 0;
    x1 = 0;
    xText = 0;
@@ -326,7 +340,7 @@ LabelStruct::LabelStruct(const SelectedRegion &region,
    selectedRegion.setTimes(t0, t1);
 
    updated = false;
-   width = 0;
+   width = -1;
    x = 0;
    x1 = 0;
    xText = 0;
@@ -571,7 +585,13 @@ void LabelTrack::Import(wxTextFile & in)
    }
    if (error)
       ::AudacityMessageBox( XO("One or more saved labels could not be read.") );
-   SortLabels();
+
+   // Sort all at once:  SortLabels() would take quadratic time for a file
+   // out of order, and no one yet has indices of these labels to update
+   std::stable_sort(mLabels.begin(), mLabels.end(),
+      [](const LabelStruct &a, const LabelStruct &b){
+         return a.getT0() < b.getT0(); });
+   InvalidateIndex();
 }
 
 bool LabelTrack::HandleXMLTag(const std::string_view& tag, const AttributesList &attrs)
@@ -605,6 +625,7 @@ bool LabelTrack::HandleXMLTag(const std::string_view& tag, const AttributesList
 
       LabelStruct l { selectedRegion, title };
       mLabels.push_back(l);
+      InvalidateIndex();
 
       return true;
    }
@@ -626,6 +647,7 @@ bool LabelTrack::HandleXMLTag(const std::string_view& tag, const AttributesList
             }
             mLabels.clear();
             mLabels.reserve(nValue);
+            InvalidateIndex();
          }
       }
 
@@ -742,6 +764,7 @@ TrackListHolder LabelTrack::Copy(double t0, double t1, bool) const
 bool LabelTrack::PasteOver(double t, const Track &src)
 {
    auto result = src.TypeSwitch<bool>([&](const LabelTrack &sl) {
+      InvalidateIndex();
       int len = mLabels.size();
       int pos = 0;
 
@@ -795,6 +818,7 @@ bool LabelTrack::Repeat(double t0, double t1, int n)
 
    // Insert space for the repetitions
    ShiftLabelsOnInsert(tLen * n, t1);
+   InvalidateIndex();
 
    // mLabels may resize as we iterate, so use subscripting
    for (unsigned int i = 0; i < mLabels.size(); ++i)
@@ -859,6 +883,7 @@ void LabelTrack::SyncLockAdjust(double oldT1, double newT1)
 void LabelTrack::Silence(double t0, double t1)
 {
    assert(IsLeader());
+   InvalidateIndex();
    int len = mLabels.size();
 
    // mLabels may resize as we iterate, so use subscripting
@@ -906,6 +931,7 @@ void LabelTrack::Silence(double t0, double t1)
 void LabelTrack::InsertSilence(double t, double len)
 {
    assert(IsLeader());
+   InvalidateIndex();
    for (auto &labelStruct: mLabels) {
       double t0 = labelStruct.getT0();
       double t1 = labelStruct.getT1();
@@ -933,13 +959,14 @@ int LabelTrack::AddLabel(const SelectedRegion &selectedRegion,
 {
    LabelStruct l { selectedRegion, title };
 
-   int len = mLabels.size();
-   int pos = 0;
-
-   while (pos < len && mLabels[pos].getT0() < selectedRegion.t0())
-      pos++;
+   // Labels are sorted by start time; insert before any that start as late
+   const auto iter = std::lower_bound(mLabels.begin(), mLabels.end(),
+      selectedRegion.t0(), [](const LabelStruct &label, double t0){
+         return label.getT0() < t0; });
+   const int pos = iter - mLabels.begin();
 
-   mLabels.insert(mLabels.begin() + pos, l);
+   mLabels.insert(iter, l);
+   InvalidateIndex();
 
    Publish({ LabelTrackEvent::Addition,
       this->SharedPointer<LabelTrack>(), title, -1, pos });
@@ -953,6 +980,7 @@ void LabelTrack::DeleteLabel(int index)
    auto iter = mLabels.begin() + index;
    const auto title = iter->title;
    mLabels.erase(iter);
+   InvalidateIndex();
 
    Publish({ LabelTrackEvent::Deletion,
       this->SharedPointer<LabelTrack>(), title, index, -1 });
@@ -982,6 +1010,7 @@ void LabelTrack::SortLabels()
       ++j;
 
       // Now fix the disorder
+      InvalidateIndex();
       std::rotate(
          begin + j,
          begin + i,
@@ -994,6 +1023,34 @@ void LabelTrack::SortLabels()
    }
 }
 
+void LabelTrack::InvalidateIndex()
+{
+   // Generations are unique among all tracks
+   static std::atomic<size_t> sGeneration{ 0 };
+   mIndexValid = false;
+   mGeneration = ++sGeneration;
+}
+
+void LabelTrack::FindLabelsInRange(
+   double t0, double t1, std::vector<size_t> &result) const
+{
+   result.clear();
+   if (!mIndexValid) {
+      mIndex.clear();
+      mIndex.reserve(mLabels.size());
+      for (const auto &label : mLabels)
+         if (!mIndex.Append(label.getT0(), label.getT1())) {
+            // Not sorted, as during some drags; then nothing can be excluded
+            mIndex.clear();
+            result.resize(mLabels.size());
+            std::iota(result.begin(), result.end(), 0);
+            return;
+         }
+      mIndexValid = true;
+   }
+   mIndex.Find(t0, t1, result);
+}
+
 wxString LabelTrack::GetTextOfLabels(double t0, double t1) const
 {
    bool firstLabel = true;
@@ -13,6 +13,7 @@
 #ifndef _LABELTRACK_
 #define _LABELTRACK_
 
+#include "IntervalIndex.h"
 #include "SelectedRegion.h"
 #include "Track.h"
 
@@ -68,7 +69,7 @@ public:
 public:
    SelectedRegion selectedRegion;
    wxString title; /// Text of the label.
-   mutable int width{}; /// width of the text in pixels.
+   mutable int width{ -1 }; /// width of the text in pixels, or -1 if not yet measured.
 
 // Working storage for on-screen layout.
    mutable int x{};     /// Pixel position of left hand glyph
@@ -144,6 +145,17 @@ public:
    const LabelStruct *GetLabel(int index) const;
    const LabelArray &GetLabels() const { return mLabels; }
 
+   //! Replace `result` with the indices, in increasing order, of the labels
+   //! that meet the times from t0 to t1, found in logarithmic time
+   /*!
+    While labels are out of order, as during some drags, that is all labels
+    */
+   void FindLabelsInRange(
+      double t0, double t1, std::vector<size_t> &result) const;
+
+   //! Changes whenever labels do; copied tracks share it until they change
+   size_t GetGeneration() const { return mGeneration; }
+
    void OnLabelAdded( const wxString &title, int pos );
    //This returns the index of the label we just added.
    int AddLabel(const SelectedRegion &region, const wxString &title);
@@ -199,7 +211,14 @@ private:
    std::shared_ptr<WideChannelGroupInterval> DoGetInterval(size_t iInterval)
       override;
 
+   //! Call whenever times of labels change, or labels are added or removed
+   void InvalidateIndex();
+
    LabelArray mLabels;
+   //! Of the times of mLabels, made again when needed after changes
+   mutable IntervalIndex mIndex;
+   mutable bool mIndexValid{ false };
+   size_t mGeneration{ 0 };
 
    // Set in copied label tracks
    double mClipLen;
@@ -527,137 +527,24 @@ void MixerTrackCluster::UpdateMeter(const double t0, const double t1)
       return;
    }
 
-   // Vaughan, 2010-11-27:
-   // This commented out code is flawed. Mistaken understanding of "frame" vs "window".
-   // Caused me to override MeterPanel::UpdateDisplay().
-   // But I think it's got a good idea, of calling WaveTracks' GetMinMax and GetRMS
-   // instead of passing in all the data and asking the meter to derive peak and rms.
-   // May be worth revisiting as I think it should perform better, because it uses the min/max/rms
-   // stored in sample blocks, rather than calculating them, but for now, changing it to use the
-   // original MeterPanel::UpdateDisplay(). New code is below the previous (now commented out).
-   //
-   //const size_t kFramesPerBuffer = 4;
-   //float min; // dummy, since it's not shown in meters
-   //Floats maxLeft{kFramesPerBuffer};
-   //Floats rmsLeft{kFramesPerBuffer};
-   //Floats maxRight{kFramesPerBuffer};
-   //Floats rmsRight{kFramesPerBuffer};
-   //
-   //#ifdef EXPERIMENTAL_MIDI_OUT
-   //   bool bSuccess = (GetWave() != nullptr);
-   //#else
-   //   bool bSuccess = true;
-   //#endif
-
-   //const double dFrameInterval = (t1 - t0) / (double)kFramesPerBuffer;
-   //double dFrameT0 = t0;
-   //double dFrameT1 = t0 + dFrameInterval;
-   //int i = 0;
-   //while (bSuccess && (i < kFramesPerBuffer))
-   //{
-   //   bSuccess &=
-   //      mTrack->GetMinMax(&min, &(maxLeft[i]), dFrameT0, dFrameT1) &&
-   //      mTrack->GetRMS(&(rmsLeft[i]), dFrameT0, dFrameT1);
-   //   if (bSuccess && mRightTrack)
-   //      bSuccess &=
-   //         mRightTrack->GetMinMax(&min, &(maxRight[i]), dFrameT0, dFrameT1) &&
-   //         mRightTrack->GetRMS(&(rmsRight[i]), dFrameT0, dFrameT1);
-   //   else
-   //   {
-   //      // Mono: Start with raw values same as left.
-   //      // To be modified by bWantPostFadeValues and channel pan/gain.
-   //      maxRight[i] = maxLeft[i];
-   //      rmsRight[i] = rmsLeft[i];
-   //   }
-   //   dFrameT0 += dFrameInterval;
-   //   dFrameT1 += dFrameInterval;
-   //   i++;
-   //}
-   //
-   //const bool bWantPostFadeValues = true; //v Turn this into a checkbox on MixerBoard? For now, always true.
-   //if (bSuccess && bWantPostFadeValues)
-   //if (bSuccess)
-   //{
-   //   for (i = 0; i < kFramesPerBuffer; i++)
-   //   {
-   //      float gain = mTrack->GetChannelGain(0);
-   //      maxLeft[i] *= gain;
-   //      rmsLeft[i] *= gain;
-   //      if (mRightTrack)
-   //         gain = mRightTrack->GetChannelGain(1);
-   //      maxRight[i] *= gain;
-   //      rmsRight[i] *= gain;
-   //   }
-   //   if ( mMeter ) mMeter->UpdateDisplay(
-   //      2, // If mono, show left track values in both meters, as in MeterToolBar, rather than nChannels.
-   //      kFramesPerBuffer,
-   //      maxLeft, rmsLeft,
-   //      maxRight, rmsRight,
-   //      mTrack->TimeToLongSamples(t1 - t0));
-   //}
-   //
-
-   // PRL: TODO:  don't fetch from wave tracks at calculated times, for update
-   // of the meter display, but instead consult PlaybackPolicy
-
-   const auto pTrack = GetWave();
-   auto startSample = (sampleCount)((pTrack->GetRate() * t0) + 0.5);
-   auto scnFrames = (sampleCount)((pTrack->GetRate() * (t1 - t0)) + 0.5);
-
-   // Expect that the difference of t1 and t0 is the part of a track played
-   // in about 1/20 second (ticks of TrackPanel timer), so this won't overflow
-   auto nFrames = scnFrames.as_size_t();
-
-   Floats tempFloatsArray{ nFrames };
-   decltype(tempFloatsArray) meterFloatsArray;
-   // Don't throw on read error in this drawing update routine
-   bool bSuccess = pTrack->GetFloats(tempFloatsArray.get(),
-      startSample, nFrames, FillFormat::fillZero, false);
-   if (bSuccess)
-   {
-      // We always pass a stereo sample array to the meter, as it shows 2 channels.
-      // Mono shows same in both meters.
-      // Since we're not mixing, need to duplicate same signal for "right" channel in mono case.
-      meterFloatsArray = Floats{ 2 * nFrames };
-
-      // Interleave for stereo. Left/mono first.
-      for (unsigned int index = 0; index < nFrames; index++)
-         meterFloatsArray[2 * index] = tempFloatsArray[index];
-
-      if (GetRight())
-         // Again, don't throw
-         bSuccess = GetRight()->GetFloats(tempFloatsArray.get(),
-            startSample, nFrames, FillFormat::fillZero, false);
-
-      if (bSuccess)
-         // Interleave right channel, or duplicate same signal for "right" channel in mono case.
-         for (unsigned int index = 0; index < nFrames; index++)
-            meterFloatsArray[(2 * index) + 1] = tempFloatsArray[index];
-   }
+   // Levels come from the audio callback, which measured the samples of
+   // this track as they were played, after realtime effects, gain and pan
+   const auto pLevels = AudioIO::Get()->GetSequenceLevels(*GetWave());
+   if (!pLevels)
+      // Nothing played since the last update
+      return;
 
-   //const bool bWantPostFadeValues = true; //v Turn this into a checkbox on MixerBoard? For now, always true.
-   //if (bSuccess && bWantPostFadeValues)
-   if (bSuccess)
-   {
-      //vvv Need to apply envelope, too? See Mixer::MixSameRate.
-      float gain = pTrack->GetChannelGain(0);
-      for (unsigned int index = 0; index < nFrames; index++)
-         meterFloatsArray[2 * index] *= gain;
-      gain = pTrack->GetChannelGain(1);
-      for (unsigned int index = 0; index < nFrames; index++)
-         meterFloatsArray[(2 * index) + 1] *= gain;
+   // We always pass two channels to the meter; mono shows the same in both
+   float peak[SequenceMeterTap::MaxChannels];
+   float rms[SequenceMeterTap::MaxChannels];
+   for (unsigned chan = 0; chan < SequenceMeterTap::MaxChannels; ++chan) {
       // Clip to [-1.0, 1.0] range.
-      for (unsigned int index = 0; index < 2 * nFrames; index++)
-         if (meterFloatsArray[index] < -1.0)
-            meterFloatsArray[index] = -1.0;
-         else if (meterFloatsArray[index] > 1.0)
-            meterFloatsArray[index] = 1.0;
-
-      if (mMeter)
-         mMeter->UpdateDisplay(2, nFrames, meterFloatsArray.get());
+      peak[chan] = std::min(pLevels->peak[chan], 1.0f);
+      rms[chan] = std::min(1.0, sqrt(pLevels->sumSquares[chan] / pLevels->frames));
    }
-   else
-      this->ResetMeter(false);
+   if (mMeter)
+      mMeter->UpdateLevels(SequenceMeterTap::MaxChannels,
+         static_cast<int>(pLevels->frames), peak, rms, pLevels->fullScaleRun);
 }
 
 // private
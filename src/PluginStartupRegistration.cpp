@@ -10,6 +10,8 @@
 
 #include "PluginStartupRegistration.h"
 
+#include <algorithm>
+#include <optional>
 #include <thread>
 
 #include <wx/log.h>
@@ -22,6 +24,7 @@
 
 #include "PluginManager.h"
 #include "PluginDescriptor.h"
+#include "Prefs.h"
 #include "wxPanelWrapper.h"
 
 namespace
@@ -30,6 +33,10 @@ namespace
       OnPluginScanTimeout = wxID_HIGHEST + 1,
    };
 
+   //! Number of plugin host processes used for validation, 0 for default
+   IntSetting PluginValidationProcesses{ L"/Plugins/ValidationProcesses", 0 };
+   constexpr size_t MaxDefaultValidationProcesses = 4;
+
    class PluginScanDialog : public wxDialogWrapper
    {
       wxStaticText* mText{nullptr};
@@ -127,29 +134,67 @@ namespace
    };
 }
 
+///Talks to one host process, validating one plugin at a time
+class PluginStartupRegistration::ValidatorSlot final :
+   public AsyncPluginValidator::Delegate
+{
+   PluginStartupRegistration& mOwner;
+public:
+   std::unique_ptr<AsyncPluginValidator> validator;
+   ///Index of the plugin being validated, if any
+   std::optional<size_t> pluginIndex;
+   std::chrono::system_clock::time_point requestStartTime{};
+
+   explicit ValidatorSlot(PluginStartupRegistration& owner) : mOwner(owner) { }
+
+   void OnInternalError(const wxString& error) override
+   {
+      mOwner.OnInternalError(*this, error);
+   }
+
+   void OnPluginFound(const PluginDescriptor& desc) override
+   {
+      mOwner.OnPluginFound(*this, desc);
+   }
+
+   void OnPluginValidationFailed(const wxString& providerId, const wxString& path) override
+   {
+      mOwner.OnPluginValidationFailed(*this, providerId, path);
+   }
+
+   void OnValidationFinished() override
+   {
+      mOwner.OnValidationFinished(*this);
+   }
+};
+
 PluginStartupRegistration::PluginStartupRegistration(const std::map<wxString, std::vector<wxString>>& pluginsToProcess)
 {
    for(auto& p : pluginsToProcess)
       mPluginsToProcess.push_back(p);
+   mJobs.resize(mPluginsToProcess.size());
 }
 
-void PluginStartupRegistration::OnInternalError(const wxString& error)
+PluginStartupRegistration::~PluginStartupRegistration() = default;
+
+void PluginStartupRegistration::OnInternalError(ValidatorSlot&, const wxString& error)
 {
    StopWithError(error);
 }
 
-void PluginStartupRegistration::OnPluginFound(const PluginDescriptor& desc)
+void PluginStartupRegistration::OnPluginFound(ValidatorSlot& slot, const PluginDescriptor& desc)
 {
-   if(!mValidProviderFound)
-      mFailedPluginsCache.clear();
+   auto& job = mJobs[*slot.pluginIndex];
+   if(!job.validProviderFound)
+      job.failedCache.clear();
 
-   mValidProviderFound = true;
+   job.validProviderFound = true;
    if(!desc.IsValid())
-      mFailedPluginsCache.push_back(desc);
-   PluginManager::Get().RegisterPlugin(PluginDescriptor { desc });
+      job.failedCache.push_back(desc);
+   job.descriptors.push_back(desc);
 }
 
-void PluginStartupRegistration::OnPluginValidationFailed(const wxString& providerId, const wxString& path)
+void PluginStartupRegistration::OnPluginValidationFailed(ValidatorSlot& slot, const wxString& providerId, const wxString& path)
 {
    PluginID ID = providerId + wxT("_") + path;
    PluginDescriptor pluginDescriptor;
@@ -162,44 +207,48 @@ void PluginStartupRegistration::OnPluginValidationFailed(const wxString& provide
 
    //Multiple providers can report same module paths
    //do not register until all associated providers have tried to load the module
-   mFailedPluginsCache.push_back(std::move(pluginDescriptor));
+   mJobs[*slot.pluginIndex].failedCache.push_back(std::move(pluginDescriptor));
 }
 
 
-void PluginStartupRegistration::OnValidationFinished()
+void PluginStartupRegistration::OnValidationFinished(ValidatorSlot& slot)
 {
-   ++mCurrentPluginProviderIndex;
-   if(mValidProviderFound ||
-      mPluginsToProcess[mCurrentPluginIndex].second.size() == mCurrentPluginProviderIndex)
+   const auto pluginIndex = *slot.pluginIndex;
+   auto& job = mJobs[pluginIndex];
+
+   ++job.providerIndex;
+   if(job.validProviderFound ||
+      mPluginsToProcess[pluginIndex].second.size() == job.providerIndex)
    {
-      if(!mFailedPluginsCache.empty())
+      if(!job.failedCache.empty())
       {
          //we've tried all providers associated with same module path...
-         if(!mValidProviderFound)
+         if(!job.validProviderFound)
          {
             //...but none of them succeeded
-            mFailedPluginsPaths.push_back(mFailedPluginsCache[0].GetPath());
+            job.failedPaths.push_back(job.failedCache[0].GetPath());
 
             //Same plugin path, but different providers, we need to register all of them
-            for(auto& desc : mFailedPluginsCache)
-               PluginManager::Get().RegisterPlugin(std::move(desc));
+            for(auto& desc : job.failedCache)
+               job.descriptors.push_back(std::move(desc));
          }
          //plugin type was detected, but plugin instance validation has failed
          else
          {
-            for(auto& desc : mFailedPluginsCache)
+            for(auto& desc : job.failedCache)
             {
                if(desc.GetPluginType() != PluginTypeStub)
-                  mFailedPluginsPaths.push_back(desc.GetPath());
+                  job.failedPaths.push_back(desc.GetPath());
             }
          }
       }
-      ++mCurrentPluginIndex;
-      mCurrentPluginProviderIndex = 0;
-      mValidProviderFound = false;
-      mFailedPluginsCache.clear();
+      job.failedCache.clear();
+      job.finished = true;
+      slot.pluginIndex.reset();
+
+      Commit();
    }
-   ProcessNext();
+   ProcessNext(slot);
 }
 
 const std::vector<wxString>& PluginStartupRegistration::GetFailedPluginsPaths() const noexcept
@@ -207,40 +256,59 @@ const std::vector<wxString>& PluginStartupRegistration::GetFailedPluginsPaths()
    return mFailedPluginsPaths;
 }
 
-void PluginStartupRegistration::Run(std::chrono::seconds timeout)
+void PluginStartupRegistration::Run(std::chrono::seconds timeout, size_t processCount)
 {
+   if(processCount == 0)
+   {
+      processCount = static_cast<size_t>(
+         std::max(0, PluginValidationProcesses.Read()));
+      if(processCount == 0)
+         processCount = std::clamp<size_t>(
+            std::thread::hardware_concurrency(), 1, MaxDefaultValidationProcesses);
+   }
+   processCount = std::max<size_t>(
+      1, std::min(processCount, mPluginsToProcess.size()));
+
    PluginScanDialog dialog(nullptr, wxID_ANY, XO("Searching for plugins"));
    wxTimer timeoutTimer(&dialog, OnPluginScanTimeout);
    mScanDialog = &dialog;
-   mTimeoutTimer = &timeoutTimer;
    mTimeout = timeout;
 
    dialog.Bind(wxEVT_BUTTON, [this](wxCommandEvent& evt) {
       evt.Skip();
       if(evt.GetId() == wxID_IGNORE)
-         Skip();
+         SkipOldest();
    });
    dialog.Bind(wxEVT_TIMER, [this](wxTimerEvent& evt) {
       if(evt.GetId() == OnPluginScanTimeout)
-      {
-         if(mValidator && mValidator->InactiveSince() < mRequestStartTime)
-            Skip();
-         //else
-         //   wxMessageBox("Please check for plugin popups!");
-      }
+         CheckTimeouts();
       else
          evt.Skip();
    });
    dialog.Bind(wxEVT_CLOSE_WINDOW, [this](wxCloseEvent& evt) {
       evt.Skip();
-      mValidator.reset();
+      for(auto& slot : mSlots)
+         slot->validator.reset();
+      //Keep results of the plugins that were validated, even
+      //if some plugins before them weren't
+      Commit(true);
       PluginManager::Get().Save();
       PluginManager::Get().NotifyPluginsChanged();
    });
 
    dialog.CenterOnScreen();
-   ProcessNext();
+   if(timeout.count() > 0)
+      //Timeouts of all slots are checked periodically
+      timeoutTimer.Start(std::min<long>(1000, std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count()));
+
+   for(size_t i = 0; i < processCount; ++i)
+      mSlots.push_back(std::make_unique<ValidatorSlot>(*this));
+   for(size_t i = 0; i < mSlots.size(); ++i)
+      ProcessNext(*mSlots[i]);
+   UpdateProgress();
+
    dialog.ShowModal();
+   mSlots.clear();
 }
 
 void PluginStartupRegistration::Stop()
@@ -249,34 +317,71 @@ void PluginStartupRegistration::Stop()
       dialog->Close();
 }
 
-void PluginStartupRegistration::Skip()
+void PluginStartupRegistration::Skip(ValidatorSlot& slot)
 {
+   if(!slot.pluginIndex)
+      return;
+
+   const auto pluginIndex = *slot.pluginIndex;
+   auto& job = mJobs[pluginIndex];
+
    //Drop current validator, no more callbacks will be received from now
-   mValidator->SetDelegate(nullptr);
+   slot.validator->SetDelegate(nullptr);
    //While on Linux and MacOS socket `shutdown()` wakes up `select()` almost
    //immediately, on Windows it sometimes get delayed on unspecified amount
    //of time. As we do not expect any data we can safely move remaining
    //operations to another thread.
-   std::thread([validator = std::shared_ptr<AsyncPluginValidator>(std::move(mValidator))]{ }).detach();
+   std::thread([validator = std::shared_ptr<AsyncPluginValidator>(std::move(slot.validator))]{ }).detach();
 
-   if(!mValidProviderFound)
+   if(!job.validProviderFound)
    {
       // Validator didn't report anything yet or it tried
       // one or more providers that didn't recognize the plugin.
       // In that case we assume that none of the remaining providers
       // can recognize that plugin.
       // Note: create stub `PluginDescriptors` for each associated provider
-      for(;mCurrentPluginProviderIndex < mPluginsToProcess[mCurrentPluginIndex].second.size(); ++mCurrentPluginProviderIndex)
+      for(;job.providerIndex < mPluginsToProcess[pluginIndex].second.size(); ++job.providerIndex)
          OnPluginValidationFailed(
-            mPluginsToProcess[mCurrentPluginIndex].second[mCurrentPluginProviderIndex],
-            mPluginsToProcess[mCurrentPluginIndex].first);
-      mCurrentPluginProviderIndex = mPluginsToProcess[mCurrentPluginIndex].second.size() - 1;
+            slot,
+            mPluginsToProcess[pluginIndex].second[job.providerIndex],
+            mPluginsToProcess[pluginIndex].first);
+      job.providerIndex = mPluginsToProcess[pluginIndex].second.size() - 1;
    }
    //else
    //    Don't assume that `OnValidationFinished()` and `OnPluginFound()`
    //    aren't deferred within run loop
 
-   OnValidationFinished();
+   OnValidationFinished(slot);
+}
+
+void PluginStartupRegistration::SkipOldest()
+{
+   //The plugin shown in the dialog is the one that was started first
+   ValidatorSlot* oldest{};
+   for(auto& slot : mSlots)
+   {
+      if(slot->pluginIndex &&
+         (oldest == nullptr || *slot->pluginIndex < *oldest->pluginIndex))
+         oldest = slot.get();
+   }
+   if(oldest != nullptr)
+      Skip(*oldest);
+}
+
+void PluginStartupRegistration::CheckTimeouts()
+{
+   const auto now = std::chrono::system_clock::now();
+   //Skip may start validation in the same slot again
+   for(size_t i = 0; i < mSlots.size(); ++i)
+   {
+      auto& slot = *mSlots[i];
+      if(slot.pluginIndex && slot.validator &&
+         now - slot.requestStartTime >= mTimeout &&
+         slot.validator->InactiveSince() < slot.requestStartTime)
+         Skip(slot);
+      //else
+      //   wxMessageBox("Please check for plugin popups!");
+   }
 }
 
 void PluginStartupRegistration::StopWithError(const wxString& msg)
@@ -286,33 +391,38 @@ void PluginStartupRegistration::StopWithError(const wxString& msg)
    Stop();
 }
 
-void PluginStartupRegistration::ProcessNext()
+void PluginStartupRegistration::ProcessNext(ValidatorSlot& slot)
 {
-   if(mCurrentPluginIndex == mPluginsToProcess.size())
+   if(!slot.pluginIndex)
    {
-      Stop();
-      return;
+      if(mNextPluginIndex == mPluginsToProcess.size())
+      {
+         //Finish when there is nothing left in the other slots as well
+         if(std::none_of(mSlots.begin(), mSlots.end(),
+            [](auto& slot) { return slot->pluginIndex.has_value(); }))
+            Stop();
+         UpdateProgress();
+         return;
+      }
+      slot.pluginIndex = mNextPluginIndex++;
    }
+   Validate(slot);
+   UpdateProgress();
+}
 
+void PluginStartupRegistration::Validate(ValidatorSlot& slot)
+{
    try
    {
-      if(auto dialog = static_cast<PluginScanDialog*>(mScanDialog.get()))
-      {
-         const auto progress = static_cast<float>(mCurrentPluginIndex) / static_cast<float>(mPluginsToProcess.size());
-         dialog->UpdateProgress(
-            mPluginsToProcess[mCurrentPluginIndex].first,
-            progress);
-      }
-      if(!mValidator)
-         mValidator = std::make_unique<AsyncPluginValidator>(*this);
+      const auto& [path, providers] = mPluginsToProcess[*slot.pluginIndex];
+      if(!slot.validator)
+         slot.validator = std::make_unique<AsyncPluginValidator>(slot);
 
-      mValidator->Validate(
-         mPluginsToProcess[mCurrentPluginIndex].second[mCurrentPluginProviderIndex],
-         mPluginsToProcess[mCurrentPluginIndex].first
+      slot.validator->Validate(
+         providers[mJobs[*slot.pluginIndex].providerIndex],
+         path
       );
-      mRequestStartTime = std::chrono::system_clock::now();
-      if(auto timer = mTimeoutTimer.get())
-         timer->StartOnce(std::chrono::duration_cast<std::chrono::milliseconds>(mTimeout).count());
+      slot.requestStartTime = std::chrono::system_clock::now();
    }
    catch(std::exception& e)
    {
@@ -324,3 +434,48 @@ void PluginStartupRegistration::ProcessNext()
    }
 }
 
+void PluginStartupRegistration::Commit(bool all)
+{
+   for(auto i = mNextCommitIndex; i < mJobs.size(); ++i)
+   {
+      auto& job = mJobs[i];
+      if(!job.finished)
+      {
+         if(!all)
+            break;
+         continue;
+      }
+      if(!job.committed)
+      {
+         for(auto& desc : job.descriptors)
+            PluginManager::Get().RegisterPlugin(std::move(desc));
+         for(auto& path : job.failedPaths)
+            mFailedPluginsPaths.push_back(std::move(path));
+         job.descriptors.clear();
+         job.failedPaths.clear();
+         job.committed = true;
+      }
+      if(i == mNextCommitIndex)
+         ++mNextCommitIndex;
+   }
+}
+
+void PluginStartupRegistration::UpdateProgress()
+{
+   auto dialog = static_cast<PluginScanDialog*>(mScanDialog.get());
+   if(dialog == nullptr || mPluginsToProcess.empty())
+      return;
+
+   //Show the plugin that was started first among those being validated
+   std::optional<size_t> oldest;
+   for(auto& slot : mSlots)
+   {
+      if(slot->pluginIndex && (!oldest || *slot->pluginIndex < *oldest))
+         oldest = slot->pluginIndex;
+   }
+   if(!oldest)
+      return;
+
+   const auto progress = static_cast<float>(mNextCommitIndex) / static_cast<float>(mPluginsToProcess.size());
+   dialog->UpdateProgress(mPluginsToProcess[*oldest].first, progress);
+}
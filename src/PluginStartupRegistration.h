@@ -17,47 +17,73 @@
 #include <wx/string.h>
 #include <wx/timer.h>
 #include "AsyncPluginValidator.h"
+#include "PluginDescriptor.h"
 #include "wxPanelWrapper.h"
 
 ///Helper class that passes plugins provided in constructor
-///to plugin validator, then "good" plugins are registered in
-///PluginManager. 
-class PluginStartupRegistration final :
-   public AsyncPluginValidator::Delegate
+///to plugin validators, then "good" plugins are registered in
+///PluginManager. Plugins are validated concurrently by a pool
+///of host processes, so that a plugin that hangs or crashes only
+///holds up its own process. Results are registered in the order
+///of plugins provided in constructor.
+class PluginStartupRegistration final
 {
-   std::unique_ptr<AsyncPluginValidator> mValidator;
+   class ValidatorSlot;
+
+   struct Job
+   {
+      size_t providerIndex{0};
+      bool validProviderFound{false};
+      bool finished{false};
+      bool committed{false};
+      ///Descriptors to register, in order of arrival
+      std::vector<PluginDescriptor> descriptors;
+      std::vector<PluginDescriptor> failedCache;
+      std::vector<wxString> failedPaths;
+   };
+
+   std::vector<std::unique_ptr<ValidatorSlot>> mSlots;
    std::vector<std::pair<wxString, std::vector<wxString>>> mPluginsToProcess;
-   size_t mCurrentPluginIndex{0};
-   size_t mCurrentPluginProviderIndex{0};
-   bool mValidProviderFound{false};
+   std::vector<Job> mJobs;
+   size_t mNextPluginIndex{0};
+   size_t mNextCommitIndex{0};
    std::vector<wxString> mFailedPluginsPaths;
-   std::vector<PluginDescriptor> mFailedPluginsCache;
    wxWeakRef<wxDialogWrapper> mScanDialog;
-   wxWeakRef<wxTimer> mTimeoutTimer;
    std::chrono::system_clock::duration mTimeout{};
-   std::chrono::system_clock::time_point mRequestStartTime{};
 public:
 
    PluginStartupRegistration(const std::map<wxString, std::vector<wxString>>& pluginsToProcess);
+   ~PluginStartupRegistration();
 
    ///Starts validation, showing dialog that blocks execution until
    ///process is complete or canceled
    ///@param timeout Time allowed to spend on a single plugin validation.
    ///Pass 0 to disable timeout.
-   void Run(std::chrono::seconds timeout = std::chrono::seconds(30));
+   ///@param processCount Number of host processes used for validation.
+   ///Pass 0 to use the "/Plugins/ValidationProcesses" preference, or
+   ///a default based on the number of CPU cores if it isn't set.
+   void Run(std::chrono::seconds timeout = std::chrono::seconds(30),
+      size_t processCount = 0);
 
    ///Returns list of paths of plugins that didn't pass validation for some reason
    const std::vector<wxString>& GetFailedPluginsPaths() const noexcept;
 
-   void OnInternalError(const wxString& error) override;
-   void OnPluginFound(const PluginDescriptor& desc) override;
-   void OnPluginValidationFailed(const wxString& providerId, const wxString& path) override;
-   void OnValidationFinished() override;
-
 private:
-   
+
+   void OnInternalError(ValidatorSlot& slot, const wxString& error);
+   void OnPluginFound(ValidatorSlot& slot, const PluginDescriptor& desc);
+   void OnPluginValidationFailed(ValidatorSlot& slot, const wxString& providerId, const wxString& path);
+   void OnValidationFinished(ValidatorSlot& slot);
+
    void Stop();
-   void Skip();
+   void Skip(ValidatorSlot& slot);
+   void SkipOldest();
+   void CheckTimeouts();
    void StopWithError(const wxString& msg);
-   void ProcessNext();
+   void ProcessNext(ValidatorSlot& slot);
+   void Validate(ValidatorSlot& slot);
+   ///Registers finished plugins. Unless all is true, stops at the
+   ///first unfinished one, to keep the order of registration
+   void Commit(bool all = false);
+   void UpdateProgress();
 };
@@ -14,6 +14,8 @@
 \brief A simple profiler to measure the average time lengths that a
 particular task/function takes.  Currently not thread-safe and not thread-smart,
 but it will probably work fine if you use it on a high level.
+Tasks are also recorded as zones of the calling thread by Tracing, when that
+is enabled; prefer TRACE_ZONE for new, and especially for threaded, code.
 
 \class TaskProfile
 \brief a simple class to keep track of one task that may be called multiple times.
@@ -22,6 +24,7 @@ but it will probably work fine if you use it on a high level.
 
 
 #include "Profiler.h"
+#include "Tracing.h"
 
 #include <string.h>
 #include <wx/crt.h>
@@ -62,6 +65,7 @@ Profiler::~Profiler()
 ///start the task timer.
 void Profiler::Begin(const char* fileName, int lineNum, const char* taskDescription)
 {
+   Tracing::Begin("profiler", taskDescription);
    std::lock_guard<std::mutex> guard{ mTasksMutex };
    GetOrCreateTaskProfile(fileName,lineNum)->Begin(fileName,lineNum,taskDescription);
 }
@@ -69,6 +73,7 @@ void Profiler::Begin(const char* fileName, int lineNum, const char* taskDescript
 ///end the task timer.
 void Profiler::End(const char* fileName, int lineNum, const char* taskDescription)
 {
+   Tracing::End("profiler", taskDescription);
    std::lock_guard<std::mutex> guard{ mTasksMutex };
    TaskProfile* tp;
    tp=GetTaskProfileByDescription(taskDescription);
@@ -14,6 +14,8 @@
 \brief A simple profiler to measure the average time lengths that a
 particular task/function takes.  Currently not thread-safe and not thread-smart,
 but it will probably work fine if you use it on a high level.
+Tasks are also recorded as zones of the calling thread by Tracing, when that
+is enabled; prefer TRACE_ZONE for new, and especially for threaded, code.
 
 \class TaskProfile
 \brief a simple class to keep track of one task that may be called multiple times.
@@ -20,6 +20,7 @@ Paul Licameli split from ProjectManager.cpp
 #include "AudioIO.h"
 #include "BasicUI.h"
 #include "CommonCommandFlags.h"
+#include "DBConnection.h"
 #include "DefaultPlaybackPolicy.h"
 #include "Menus.h"
 #include "Meter.h"
@@ -737,7 +738,7 @@ void ProjectAudioManager::OnRecord(bool altAppearance)
             auto it = std::find_if(
                transportTracks.playbackSequences.begin(), end,
                [&wt](const auto& playbackSequence) {
-                  return &playbackSequence->GetDecorated() ==
+                  return &playbackSequence->GetSource() ==
                          &wt->GetDecorated();
                });
             if (it != end)
@@ -1211,6 +1212,15 @@ static ProjectAudioIO::DefaultOptions::Scope sScope {
    return options;
 } };
 
+//! Install an implementation in a library hook
+static DBConnection::RealtimeIOActive::Scope sRealtimeIOScope {
+[]{
+   // Called in a worker thread, so test only the stream token, which the
+   // main thread sets before starting the stream
+   auto gAudioIO = AudioIOBase::Get();
+   return gAudioIO && gAudioIO->IsBusy();
+} };
+
 AudioIOStartStreamOptions
 DefaultSpeedPlayOptions( AudacityProject &project )
 {
@@ -23,6 +23,7 @@ Paul Licameli split from AudacityProject.cpp
 #include "Legacy.h"
 #include "PlatformCompatibility.h"
 #include "Project.h"
+#include "ProjectAudioIO.h"
 #include "ProjectFileIO.h"
 #include "ProjectHistory.h"
 #include "ProjectNumericFormats.h"
@@ -32,6 +33,7 @@ Paul Licameli split from AudacityProject.cpp
 #include "ProjectSettings.h"
 #include "ProjectStatus.h"
 #include "ProjectWindow.h"
+#include "RealtimeEffectFreeze.h"
 #include "SelectFile.h"
 #include "SelectUtilities.h"
 #include "SelectionState.h"
@@ -39,6 +41,7 @@ Paul Licameli split from AudacityProject.cpp
 #include "TempDirectory.h"
 #include "TrackPanelAx.h"
 #include "TrackPanel.h"
+#include "UndoBlockUsage.h"
 #include "UndoManager.h"
 #include "WaveTrack.h"
 #include "WaveClip.h"
@@ -59,6 +62,7 @@ Paul Licameli split from AudacityProject.cpp
 
 #include "HelpText.h"
 
+#include <deque>
 #include <optional>
 
 static const AudacityProject::AttachedObjects::RegisteredFactory sFileManagerKey{
@@ -99,6 +103,14 @@ void ProjectFileManager::DiscardAutosave(const FilePath &filename)
 ProjectFileManager::ProjectFileManager( AudacityProject &project )
 : mProject{ project }
 {
+   mUndoSubscription = UndoManager::Get(mProject)
+      .Subscribe([this](UndoRedoMessage message){
+         // Edits push states, and leave small blocks behind
+         if (message.type == UndoRedoMessage::Pushed) {
+            mLastPush = std::chrono::steady_clock::now();
+            mCoalescePending = true;
+         }
+      });
 }
 
 ProjectFileManager::~ProjectFileManager() = default;
@@ -383,15 +395,7 @@ bool ProjectFileManager::DoSave(const FilePath & fileName, const bool fromSaveAs
    UndoManager::Get(proj).StateSaved();
    ProjectStatus::Get(proj).Set(XO("Saved %s").Format(fileName));
 
-   if (mLastSavedTracks)
-   {
-      mLastSavedTracks->Clear();
-   }
-   mLastSavedTracks = TrackList::Create(nullptr);
-
-   auto &tracks = TrackList::Get(proj);
-   for (auto t : tracks)
-      mLastSavedTracks->Append(std::move(*t->Duplicate()));
+   UpdateLastSavedTracks();
 
    // If we get here, saving the project was successful, so we can DELETE
    // any backup project.
@@ -746,6 +750,60 @@ bool ProjectFileManager::SaveFromTimerRecording(wxFileName fnFile)
    return success;
 }
 
+void ProjectFileManager::UpdateLastSavedTracks()
+{
+   if (mLastSavedTracks)
+   {
+      mLastSavedTracks->Clear();
+   }
+   mLastSavedTracks = TrackList::Create(nullptr);
+
+   auto &tracks = TrackList::Get(mProject);
+   for (auto t : tracks)
+      mLastSavedTracks->Append(std::move(*t->Duplicate()));
+}
+
+void ProjectFileManager::CoalesceWhenIdle()
+{
+   using namespace std::chrono_literals;
+   // Audio that is still being edited keeps its small blocks, which are the
+   // cheaper to rewrite
+   constexpr auto SettlingTime = 30s;
+   if (!mCoalescePending ||
+       std::chrono::steady_clock::now() - mLastPush < SettlingTime)
+      return;
+
+   auto &project = mProject;
+   // Not while the audio thread reads the tracks, nor while another
+   // operation yields to the event loop or shows a modal dialog
+   if (ProjectAudioIO::Get(project).IsAudioActive())
+      return;
+   const auto pLoop = wxEventLoopBase::GetActive();
+   if (!pLoop || !pLoop->IsMain() || pLoop->IsYielding())
+      return;
+   if (!ProjectFileIO::Get(project).HasConnection())
+      return;
+
+   // Coalescing the saved state would leave the saved document naming blocks
+   // that compaction could remove, with no unsaved changes to prompt a save;
+   // the next push tries again
+   auto &undoManager = UndoManager::Get(project);
+   if (!undoManager.UnsavedChanges()) {
+      mCoalescePending = false;
+      return;
+   }
+
+   // One track each time, so that no step keeps the user waiting long
+   for (auto pTrack : TrackList::Get(project).Any<WaveTrack>())
+      if (pTrack->Coalesce()) {
+         // Samples are the same; replace the state without a new undo item,
+         // and autosave, because the old blocks may now be deleted
+         ProjectHistory::Get(project).ModifyState(true);
+         return;
+      }
+   mCoalescePending = false;
+}
+
 void ProjectFileManager::CompactProjectOnClose()
 {
    auto &project = mProject;
@@ -804,6 +862,9 @@ void ProjectFileManager::CloseProject()
    auto &project = mProject;
    auto &projectFileIO = ProjectFileIO::Get(project);
 
+   // Renders of frozen tracks write to the project's sample blocks
+   RealtimeEffectFreeze::CancelRenders(project);
+
    projectFileIO.CloseProject();
 
    // Blocks were locked in CompactProjectOnClose, so DELETE the data structure so that
@@ -1085,17 +1146,27 @@ ProjectFileManager::AddImportedTracks(const FilePath &fileName,
    TrackHolders &&newTracks)
 {
    auto &project = mProject;
-   auto &history = ProjectHistory::Get( project );
-   auto &projectFileIO = ProjectFileIO::Get( project );
+
+   SelectUtilities::SelectNone( project );
+
+   bool initiallyEmpty = TrackList::Get( project ).empty();
+   const auto newRate = AppendImportedTracks(fileName, std::move(newTracks));
+
+   FinishImport(fileName, initiallyEmpty, newRate,
+      XO("Imported '%s'").Format( fileName ));
+}
+
+double
+ProjectFileManager::AppendImportedTracks(const FilePath &fileName,
+   TrackHolders &&newTracks)
+{
+   auto &project = mProject;
    auto &tracks = TrackList::Get( project );
 
    std::vector<Track*> results;
 
-   SelectUtilities::SelectNone( project );
-
    wxFileName fn(fileName);
 
-   bool initiallyEmpty = tracks.empty();
    double newRate = 0;
    wxString trackNameBase = fn.GetName();
    int i = -1;
@@ -1149,14 +1220,25 @@ ProjectFileManager::AddImportedTracks(const FilePath &fileName,
       });
    }
 
+   return newRate;
+}
+
+void ProjectFileManager::FinishImport(const FilePath &firstFileName,
+   bool initiallyEmpty, double newRate, const TranslatableString &description)
+{
+   auto &project = mProject;
+   auto &history = ProjectHistory::Get( project );
+   auto &projectFileIO = ProjectFileIO::Get( project );
+
+   wxFileName fn(firstFileName);
+
    // Automatically assign rate of imported file to whole project,
    // if this is the first file that is imported
    if (initiallyEmpty && newRate > 0) {
       ProjectRate::Get(project).SetRate( newRate );
    }
 
-   history.PushState(XO("Imported '%s'").Format( fileName ),
-       XO("Import"));
+   history.PushState(description, XO("Import"));
 
 #if defined(__WXGTK__)
    // See bug #1224
@@ -1211,7 +1293,6 @@ public:
    
    bool OnImportFileOpened(ImportFileHandle& importFileHandle) override
    {
-      mImportFileHandle = &importFileHandle;
       // File has more than one stream - display stream selector
       if (importFileHandle.GetStreamCount() > 1)
       {
@@ -1223,6 +1304,9 @@ public:
       // One stream - import it by default
       else
          importFileHandle.SetStreamUsage(0,TRUE);
+      // Results come in the same order as openings, which may be several in
+      // a batch import
+      mImportFileHandles.push_back(&importFileHandle);
       return true;
    }
    
@@ -1231,23 +1315,26 @@ public:
       constexpr double ProgressSteps { 1000.0 };
       if(!mProgressDialog)
       {
-         wxFileName ff( mImportFileHandle->GetFilename() );
-         auto title = XO("Importing %s").Format(  mImportFileHandle->GetFileDescription() );
+         wxFileName ff( mImportFileHandles.front()->GetFilename() );
+         auto title = XO("Importing %s").Format(
+            mImportFileHandles.front()->GetFileDescription() );
          mProgressDialog = BasicUI::MakeProgress(title, Verbatim(ff.GetFullName()));
       }
       auto result = mProgressDialog->Poll(progress * ProgressSteps, ProgressSteps);
       if(result == BasicUI::ProgressResult::Cancelled)
-         mImportFileHandle->Cancel();
+         mImportFileHandles.front()->Cancel();
       else if(result == BasicUI::ProgressResult::Stopped)
-         mImportFileHandle->Stop();
+         mImportFileHandles.front()->Stop();
    }
    
    void OnImportResult(ImportResult result) override
    {
       mProgressDialog.reset();
+      const auto pImportFileHandle = mImportFileHandles.front();
+      mImportFileHandles.pop_front();
       if(result == ImportResult::Error)
       {
-         auto message = mImportFileHandle->GetErrorMessage();
+         auto message = pImportFileHandle->GetErrorMessage();
          if(!message.empty())
          {
             AudacityMessageBox(message, XO("Import"), wxOK | wxCENTRE | wxICON_ERROR,
@@ -1258,7 +1345,7 @@ public:
    
 private:
    
-   ImportFileHandle* mImportFileHandle {nullptr};
+   std::deque<ImportFileHandle*> mImportFileHandles;
    std::unique_ptr<BasicUI::ProgressDialog> mProgressDialog;
 };
 
@@ -1393,6 +1480,123 @@ bool ProjectFileManager::Import(
    return true;
 }
 
+bool ProjectFileManager::IsAudioFile(const FilePath &fileName)
+{
+   // Project files and lists of files have their own semantics
+   const auto extension = fileName.AfterLast('.');
+   return !(extension.IsSameAs(wxT("aup3"), false) ||
+      extension.IsSameAs(wxT("aup"), false) ||
+      extension.IsSameAs(wxT("lof"), false));
+}
+
+bool ProjectFileManager::Import(
+   const FilePaths &fileNames,
+   bool addToHistory /* = true */)
+{
+   bool result = false;
+   FilePaths run;
+   const auto flush = [&]{
+      if (run.size() == 1)
+         result = Import(run[0], addToHistory) || result;
+      else if (!run.empty())
+         result = ImportBatch(run, addToHistory) || result;
+      run.clear();
+   };
+   for (const auto &fileName : fileNames) {
+      if (IsAudioFile(fileName))
+         run.push_back(fileName);
+      else {
+         flush();
+         result = Import(fileName, addToHistory) || result;
+      }
+   }
+   flush();
+
+   return result;
+}
+
+Importer::BatchItems ProjectFileManager::DecodeBatch(
+   const FilePaths &fileNames, size_t nThreads, WaveTrackFactory *pTrackFactory)
+{
+   auto &project = mProject;
+   ImportProgress importProgress(project);
+   std::unique_ptr<BasicUI::ProgressDialog> progressDialog;
+   const auto poll = [&](double progress) {
+      constexpr double ProgressSteps { 1000.0 };
+      if (!progressDialog)
+         progressDialog = BasicUI::MakeProgress(
+            XO("Importing %lld files").Format(
+               static_cast<long long>(fileNames.size())),
+            XO("Decoding audio..."));
+      return progressDialog->Poll(progress * ProgressSteps, ProgressSteps);
+   };
+   return Importer::Get().ImportBatch(project, fileNames,
+      &importProgress,
+      pTrackFactory ? pTrackFactory : &WaveTrackFactory::Get( project ),
+      Tags::Get( project ), poll, nThreads);
+}
+
+bool ProjectFileManager::ImportBatch(
+   const FilePaths &fileNames, bool addToHistory)
+{
+   auto &project = mProject;
+   auto &tags = Tags::Get( project );
+   bool initiallyEmpty = TrackList::Get(project).empty();
+
+   auto items = DecodeBatch(fileNames);
+
+   TranslatableString errorMessage;
+   for (const auto &item : items) {
+      if (item.errorMessage.empty())
+         continue;
+      if (!errorMessage.empty())
+         errorMessage += Verbatim("\n\n");
+      errorMessage += item.errorMessage;
+   }
+   if (!errorMessage.empty())
+      // Error messages derived from Importer::Import
+      // Additional help via a Help button links to the manual.
+      BasicUI::ShowErrorDialog( *ProjectFramePlacement(&project),
+         XO("Error Importing"), errorMessage, wxT("Importing_Audio"));
+
+   using ImportResult = ImportProgressListener::ImportResult;
+   auto newTags = tags.Duplicate();
+   FilePath firstFileName;
+   double newRate = 0;
+   size_t nImported = 0;
+   for (auto &item : items) {
+      if (!(item.result == ImportResult::Success ||
+            item.result == ImportResult::Stopped) || item.tracks.empty())
+         continue;
+
+      if (nImported == 0)
+         SelectUtilities::SelectNone( project );
+
+      newTags->Merge(*item.tags);
+      if (addToHistory)
+         FileHistory::Global().Append(item.fileName);
+
+      const auto rate =
+         AppendImportedTracks(item.fileName, std::move(item.tracks));
+      if (nImported++ == 0) {
+         firstFileName = item.fileName;
+         newRate = rate;
+      }
+   }
+   if (nImported == 0)
+      return false;
+
+   Tags::Set( project, newTags );
+
+   FinishImport(firstFileName, initiallyEmpty, newRate,
+      nImported == 1
+         ? XO("Imported '%s'").Format( firstFileName )
+         : XP("Imported %lld file", "Imported %lld files", 0)(
+            static_cast<long long>(nImported)));
+
+   return true;
+}
+
 #include "Clipboard.h"
 #include "ShuttleGui.h"
 #include "HelpSystem.h"
@@ -1464,17 +1668,16 @@ void ProjectFileManager::Compact()
    }
    const auto least = std::min<size_t>(savedState, currentState);
    const auto greatest = std::max<size_t>(savedState, currentState);
-   std::vector<const TrackList*> trackLists;
+   std::vector<const UndoStackElem*> states;
    auto fn = [&](const UndoStackElem& elem) {
-      if (auto pTracks = TrackList::FindUndoTracks(elem))
-         trackLists.push_back(pTracks);
+      states.push_back(&elem);
    };
    undoManager.VisitStates(fn, least, 1 + least);
    if (least != greatest)
       undoManager.VisitStates(fn, greatest, 1 + greatest);
 
    int64_t total = projectFileIO.GetTotalUsage();
-   int64_t used = projectFileIO.GetCurrentUsage(trackLists);
+   int64_t used = UndoBlockUsage::Get(mProject).GetUsage(states);
 
    auto before = wxFileName::GetSize(projectFileIO.GetFileName());
 
@@ -1491,16 +1694,6 @@ void ProjectFileManager::Compact()
                   Internat::FormatSize(total - used)));
    if (isBatch || dlg.ShowModal() == wxYES)
    {
-      // We can remove redo states, if they are after the saved state.
-      undoManager.RemoveStates(1 + greatest, undoManager.GetNumStates());
-
-      // We can remove all states between the current and the last saved.
-      if (least < greatest)
-         undoManager.RemoveStates(least + 1, greatest);
-
-      // We can remove all states before the current and the last saved.
-      undoManager.RemoveStates(0, least);
-
       // And clear the clipboard, if needed
       if (&mProject == clipboard.Project().lock().get())
          clipboard.Clear();
@@ -1509,7 +1702,9 @@ void ProjectFileManager::Compact()
       // above actions.
       auto before = wxFileName::GetSize(projectFileIO.GetFileName());
 
-      projectFileIO.Compact(trackLists, true);
+      if (projectFileIO.DiscardHistoryAndCompact())
+         // The saved document now refers to the coalesced blocks
+         UpdateLastSavedTracks();
 
       auto after = wxFileName::GetSize(projectFileIO.GetFileName());
 
@@ -11,19 +11,24 @@ Paul Licameli split from AudacityProject.h
 #ifndef __AUDACITY_PROJECT_FILE_MANAGER__
 #define __AUDACITY_PROJECT_FILE_MANAGER__
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <vector>
 
 #include "ClientData.h" // to inherit
 #include "FileNames.h" // for FileType
+#include "Import.h" // for Importer::BatchItems
+#include "Observer.h"
 
 class wxString;
 class wxFileName;
+class TranslatableString;
 class AudacityProject;
 class Track;
 class TrackList;
 class WaveTrack;
+class WaveTrackFactory;
 class XMLTagHandler;
 
 using TrackHolders = std::vector<std::shared_ptr<TrackList>>;
@@ -97,11 +102,41 @@ public:
    bool Import(const FilePath &fileName,
                bool addToHistory = true);
 
+   /*!
+    Import several files, decoding audio files concurrently where the importers
+    allow it, and push one undo state for each consecutive run of audio files.
+    Project files and lists of files are imported as by the one-file overload,
+    in their place in the sequence.
+    @return whether anything was imported
+    */
+   bool Import(const FilePaths &fileNames,
+               bool addToHistory = true);
+
+   //! False for project files and lists of files, which DecodeBatch can't
+   //! import; they must go through the one-file overload of Import
+   static bool IsAudioFile(const FilePath &fileName);
+
    void Compact();
 
+   //! Coalesce the small sample blocks of one wave track, if editing has
+   //! settled, there are unsaved changes, and nothing else reads the tracks
+   /*! ProjectManager calls this periodically, so that the work is spread out */
+   void CoalesceWhenIdle();
+
    void AddImportedTracks(const FilePath &fileName,
                      TrackHolders &&newTracks);
 
+   /*!
+    Decode audio files through Importer::ImportBatch, with progress and
+    stream selection shown to the user, but adding no tracks to the project
+    and reporting no errors
+    @param nThreads as for Importer::ImportBatch
+    @param pTrackFactory makes the tracks, and so owns their samples; if
+    null, that of the project
+    */
+   Importer::BatchItems DecodeBatch(const FilePaths &fileNames,
+      size_t nThreads = 0, WaveTrackFactory *pTrackFactory = nullptr);
+
    bool GetMenuClose() const { return mMenuClose; }
    void SetMenuClose(bool value) { mMenuClose = value; }
 
@@ -126,9 +161,32 @@ private:
 
    bool DoSave(const FilePath & fileName, bool fromSaveAs);
 
+   //! Import audio files through Importer::ImportBatch, with one undo state
+   bool ImportBatch(const FilePaths &fileNames, bool addToHistory);
+
+   //! Append the tracks of one imported file, naming and selecting them
+   //! @return the rate of the first wave track, or 0 if there is none
+   double AppendImportedTracks(const FilePath &fileName,
+                     TrackHolders &&newTracks);
+
+   //! Push an undo state, and set the project rate and name from the first
+   //! imported file if the project was initially empty
+   void FinishImport(const FilePath &firstFileName, bool initiallyEmpty,
+      double newRate, const TranslatableString &description);
+
+   //! Hold duplicates of the current tracks, sharing their sample blocks, as
+   //! those of the last save
+   void UpdateLastSavedTracks();
+
    AudacityProject &mProject;
 
    std::shared_ptr<TrackList> mLastSavedTracks;
+
+   Observer::Subscription mUndoSubscription;
+   //! When the last undo state was pushed
+   std::chrono::steady_clock::time_point mLastPush;
+   //! Whether some track may have blocks to coalesce since that push
+   bool mCoalescePending{ false };
    
    // Are we currently closing as the result of a menu command?
    bool mMenuClose{ false };
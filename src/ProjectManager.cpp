@@ -801,6 +801,8 @@ void ProjectManager::OnTimer(wxTimerEvent& WXUNUSED(event))
       }
    }
 
+   ProjectFileManager::Get( project ).CoalesceWhenIdle();
+
    // As also with the TrackPanel timer:  wxTimer may be unreliable without
    // some restarts
    RestartTimer();
@@ -16,6 +16,7 @@
 #include <wx/statbmp.h>
 #include <wx/stattext.h>
 #include <wx/menu.h>
+#include <wx/timer.h>
 #include <wx/wupdlock.h>
 #include <wx/hyperlink.h>
 
@@ -314,6 +315,11 @@ namespace
       ThemedAButtonWrapper<AButton>* mChangeButton{nullptr};
       AButton* mEnableButton{nullptr};
       ThemedAButtonWrapper<AButton>* mOptionsButton{};
+      wxStaticText* mLoadText{};
+
+      //! Polls the processing time statistics of the effect
+      wxTimer mLoadTimer;
+      RealtimeEffectLoad::Snapshot mLastLoad;
 
       Observer::Subscription mSubscription;
 
@@ -379,12 +385,27 @@ namespace
          changeButton->SetBackgroundColorIndex(clrEffectListItemBackground);
          changeButton->SetTranslatableLabel(XO("Replace effect"));
          changeButton->Bind(wxEVT_BUTTON, &RealtimeEffectControl::OnChangeButtonClicked, this);
+
+         //Share of the buffer duration spent in the effect during playback
+         auto loadText = safenew wxStaticText(this, wxID_ANY, wxEmptyString,
+            wxDefaultPosition, wxDefaultSize,
+            wxALIGN_RIGHT | wxST_NO_AUTORESIZE);
+         loadText->SetMinSize({ GetTextExtent(wxT("000%")).x, -1 });
+         loadText->SetForegroundColour(theTheme.Colour(clrTrackPanelText));
+         loadText->SetBackgroundColour(
+            theTheme.Colour(clrEffectListItemBackground));
+         mLoadText = loadText;
+
+         mLoadTimer.SetOwner(this);
+         Bind(wxEVT_TIMER, &RealtimeEffectControl::OnLoadTimer, this);
+         mLoadTimer.Start(500);
          
          auto dragArea = safenew wxStaticBitmap(this, wxID_ANY, theTheme.Bitmap(bmpDragArea));
          dragArea->Disable();
          sizer->Add(dragArea, 0, wxLEFT | wxCENTER, 5);
          sizer->Add(enableButton, 0, wxLEFT | wxCENTER, 5);
          sizer->Add(optionsButton, 1, wxLEFT | wxCENTER, 5);
+         sizer->Add(loadText, 0, wxLEFT | wxCENTER, 5);
          sizer->Add(changeButton, 0, wxLEFT | wxRIGHT | wxCENTER, 5);
          mChangeButton = changeButton;
          mOptionsButton = optionsButton;
@@ -541,6 +562,40 @@ namespace
          }
       }
 
+      void OnLoadTimer(wxTimerEvent&)
+      {
+         if (!mLoadText)
+            return;
+         if (!mEffectState) {
+            mLoadText->SetLabel({});
+            return;
+         }
+
+         const auto load = mEffectState->GetLoad().GetSnapshot();
+         if (load.count == mLastLoad.count) {
+            // Not processing now
+            if (!mLoadText->GetLabel().empty())
+               mLoadText->SetLabel({});
+            return;
+         }
+
+         const auto mean = load.Mean(&mLastLoad);
+         mLastLoad = load;
+
+         mLoadText->SetLabel(wxString::Format(wxT("%.0f%%"), mean));
+         mLoadText->SetToolTip(
+            /* i18n-hint: statistics of the time a realtime effect takes,
+             relative to the duration of the audio it processes.
+             first parameter - average load in percent,
+             second parameter - load not exceeded by 95% of the buffers,
+             third parameter - greatest load in percent,
+             fourth parameter - how many buffers took too long */
+            XO("Average load: %.1f%%\nLoad of 95%% of buffers at most: %.0f%%\nPeak load: %.1f%%\nBuffers over deadline: %llu")
+               .Format(load.Mean(), load.Percentile(0.95), load.Peak(),
+                  load.misses)
+               .Translation());
+      }
+
       void OnPaint(wxPaintEvent&)
       {
          wxBufferedPaintDC dc(this);
@@ -81,6 +81,7 @@ is time to refresh some aspect of the screen.
 #include "WaveTrack.h"
 
 #include "FrameStatistics.h"
+#include "Tracing.h"
 
 #include "tracks/ui/TrackControls.h"
 #include "tracks/ui/ChannelView.h"
@@ -471,6 +472,7 @@ void TrackPanel::OnUndoReset(UndoRedoMessage message)
 ///  completing a repaint operation.
 void TrackPanel::OnPaint(wxPaintEvent & /* event */)
 {
+   TRACE_ZONE("ui", "TrackPanel::OnPaint");
    mLastDrawnSelectedRegion = mViewInfo->selectedRegion;
 
    auto sw =
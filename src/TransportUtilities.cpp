@@ -23,6 +23,7 @@
 #include "ViewInfo.h"
 #include "toolbars/ControlToolBar.h"
 #include "ProgressDialog.h"
+#include "RealtimeEffectFreeze.h"
 #include "WaveTrack.h"
 
 void TransportUtilities::PlayCurrentRegionAndWait(
@@ -212,9 +213,15 @@ TransportSequences MakeTransportTracks(
    {
       const auto range = trackList.Any<WaveTrack>()
          + (selectedOnly ? &Track::IsSelected : &Track::Any);
-      for (auto pTrack : range)
-         result.playbackSequences.push_back(
-            StretchingSequence::Create(*pTrack, pTrack->GetClipInterfaces()));
+      for (auto pTrack : range) {
+         // Frozen tracks play their renders, without the realtime effects
+         if (auto pFrozen =
+            RealtimeEffectFreeze::Get(*pTrack).GetPlayableSequence(*pTrack))
+            result.playbackSequences.push_back(move(pFrozen));
+         else
+            result.playbackSequences.push_back(StretchingSequence::Create(
+               *pTrack, pTrack->GetClipInterfaces()));
+      }
    }
 #ifdef EXPERIMENTAL_MIDI_OUT
    if (nonWaveToo) {
@@ -17,6 +17,7 @@
 #include <wx/button.h>
 #include <wx/clipbrd.h>
 #include <wx/gauge.h>
+#include <wx/log.h>
 #include <wx/stattext.h>
 #include <wx/statline.h>
 #include <wx/textctrl.h>
@@ -41,6 +42,7 @@
 #include "UserImage.h"
 
 #include "CodeConversions.h"
+#include "StreamingPayload.h"
 
 #include "Export.h"
 #include "export/ExportProgressUI.h"
@@ -119,7 +121,7 @@ public:
    
    void Cancel()
    {
-      mCancelled.store(std::memory_order_release);
+      mCancelled.store(true, std::memory_order_release);
    }
    
    ExportResult GetResult() const
@@ -148,7 +150,7 @@ public:
    
    void OnProgress(double value) override
    {
-      mProgress.store(std::memory_order_release);
+      mProgress.store(value, std::memory_order_release);
    }
 
    void UpdateUI()
@@ -163,7 +165,7 @@ private:
    ShareAudioDialog& mParent;
 
    std::atomic<bool> mCancelled{false};
-   std::atomic<double> mProgress;
+   std::atomic<double> mProgress{0.0};
    ExportResult mResult;
 };
 
@@ -284,6 +286,8 @@ void ShareAudioDialog::OnCancel()
       // If export has started, notify it that it should be canceled
       if (mExportProgressUpdater)
          mExportProgressUpdater->Cancel();
+
+      mInProgress = false;
    }
 
    
@@ -309,6 +313,25 @@ int CalculateChannels(const TrackList& trackList)
       return IsMono(*track) && track->GetPan() == 0;
    }) ? 1 : 2;
 }
+
+// Feeds the encoder output directly to the upload
+class PayloadOutputStream final : public ExportOutputStream
+{
+public:
+   explicit PayloadOutputStream(
+      std::shared_ptr<audacity::network_manager::StreamingPayload> payload)
+       : mPayload(std::move(payload))
+   {
+   }
+
+   bool Write(const void* data, size_t size) override
+   {
+      return mPayload->Write(data, size);
+   }
+
+private:
+   std::shared_ptr<audacity::network_manager::StreamingPayload> mPayload;
+};
 }
 
 wxString ShareAudioDialog::ExportProject()
@@ -386,6 +409,152 @@ wxString ShareAudioDialog::ExportProject()
    return {};
 }
 
+bool ShareAudioDialog::StreamProject()
+{
+   using namespace audacity::network_manager;
+
+   auto& tracks = TrackList::Get(mProject);
+
+   const double t0 = 0.0;
+   const double t1 = tracks.GetEndTime();
+
+   const int nChannels = CalculateChannels(tracks);
+
+   auto hasMimeType = [](const auto&& mimeTypes, const std::string& mimeType)
+   {
+      return std::find(mimeTypes.begin(), mimeTypes.end(), mimeType) != mimeTypes.end();
+   };
+
+   const auto& registry = ExportPluginRegistry::Get();
+
+   for(const auto& preferredMimeType : GetServiceConfig().GetPreferredAudioFormats())
+   {
+      auto config = GetServiceConfig().GetExportConfig(preferredMimeType);
+      ExportProcessor::Parameters parameters;
+      auto pluginIt = std::find_if(registry.begin(), registry.end(), [&](auto t)
+      {
+         auto [plugin, formatIndex] = t;
+         parameters.clear();
+         return hasMimeType(plugin->GetMimeTypes(formatIndex), preferredMimeType) &&
+            plugin->SupportsOutputStream(formatIndex) &&
+            plugin->ParseConfig(formatIndex, config, parameters);
+      });
+
+      if(pluginIt == registry.end())
+         continue;
+
+      const auto [plugin, formatIndex] = *pluginIt;
+
+      // No file is created, the name is used to deduce the mime type only
+      const auto formatInfo = plugin->GetFormatInfo(formatIndex);
+      const auto projectName = mProject.GetProjectName();
+      const auto fileName = wxFileName(
+         wxString {}, projectName.empty() ? wxString("audio") : projectName,
+         formatInfo.extensions[0]);
+
+      auto payload = std::make_shared<StreamingPayload>();
+
+      // Upload is started first: audio.com consumes the encoder output
+      // as soon as the upload policy is received, and the encoder
+      // is paused while the payload is full
+      mProgressPanel.title->SetLabel(XO("Uploading audio...").Translation());
+
+      mExportProgressUpdater = std::make_unique<ExportProgressUpdater>(*this);
+      mStreamRejected = false;
+
+      mServices->uploadPromise = mServices->uploadService.UploadStream(
+         payload,
+         fileName.GetFullName(),
+         mInitialStatePanel.GetTrackTitle(),
+         false,
+         [this](const auto& result)
+         {
+            CallAfter([this, result]() { HandleStreamCompleted(result); });
+         },
+         [this](auto, auto)
+         {
+            // The total is unknown, but the encoder is paced by the upload,
+            // so its progress is that of the upload
+            CallAfter(
+               [this]()
+               {
+                  if (mExportProgressUpdater)
+                     mExportProgressUpdater->UpdateUI();
+               });
+         });
+
+      auto builder = ExportTaskBuilder{}
+         .SetParameters(parameters)
+         .SetNumChannels(nChannels)
+         .SetSampleRate(ProjectRate::Get(mProject).GetRate())
+         .SetPlugin(plugin, formatIndex)
+         .SetFileName(fileName)
+         .SetOutputStream(std::make_shared<PayloadOutputStream>(payload))
+         .SetRange(t0, t1, false);
+
+      auto result = ExportResult::Error;
+      mStreaming = true;
+      ExportProgressUI::ExceptionWrappedCall([&]
+      {
+         auto exportTask = builder.Build(mProject);
+
+         auto f = exportTask.get_future();
+         std::thread(std::move(exportTask), std::ref(*mExportProgressUpdater)).detach();
+
+         // Export lasts as long as the upload, keep the dialog responsive
+         while(f.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready)
+         {
+            mExportProgressUpdater->UpdateUI();
+            BasicUI::Yield();
+         }
+
+         try
+         {
+            result = f.get();
+         }
+         catch(...)
+         {
+            // Encoder fails once the upload is over. Upload errors
+            // are reported by the upload callback
+            if(!mServices->uploadPromise->IsCompleted())
+               throw;
+         }
+      });
+
+      mStreaming = false;
+
+      mExportProgressUpdater->SetResult(result);
+
+      // The encoder failed on the aborted payload; try again with a file
+      if(mStreamRejected)
+      {
+         wxLogMessage(wxT("audio.com refused the streamed upload; uploading a file"));
+         return false;
+      }
+
+      if(result == ExportResult::Success)
+      {
+         payload->Finish();
+         // Only what remains in the payload is still to be sent
+         UpdateProgress(1, 1);
+         return true;
+      }
+
+      payload->Abort();
+
+      if(result == ExportResult::Cancelled ||
+         mServices->uploadPromise->IsCompleted())
+         return true;
+
+      mServices->uploadPromise->DiscardResult();
+      HandleExportFailure();
+
+      return true;
+   }
+
+   return false;
+}
+
 void ShareAudioDialog::StartUploadProcess()
 {
    mInProgress = true;
@@ -402,6 +571,20 @@ void ShareAudioDialog::StartUploadProcess()
 
    ResetProgress();
 
+   if(StreamProject())
+      return;
+
+   UploadExportedFile();
+}
+
+void ShareAudioDialog::UploadExportedFile()
+{
+   mProgressPanel.title->SetLabel(XO("Preparing audio...").Translation());
+   // Hidden if the streamed upload seemed to be finishing
+   mProgressPanel.timePanel->Show();
+   Layout();
+   ResetProgress();
+
    mFilePath = ExportProject();
 
    if(mFilePath.empty())
@@ -424,35 +607,7 @@ void ShareAudioDialog::StartUploadProcess()
       false,
       [this](const auto& result)
       {
-         CallAfter(
-            [this, result]()
-            {
-               mInProgress = false;
-               
-               if (result.result == UploadOperationCompleted::Result::Success)
-               {
-                  // Success indicates that UploadSuccessfulPayload is in the payload
-                  assert(std::holds_alternative<UploadSuccessfulPayload>(result.payload));
-
-                  if (
-                     auto payload =
-                        std::get_if<UploadSuccessfulPayload>(&result.payload))
-                     HandleUploadSucceeded(*payload);
-                  else
-                     HandleUploadSucceeded({});
-                  
-               }
-               else if (
-                  result.result != UploadOperationCompleted::Result::Aborted)
-               {
-                  if (
-                     auto payload =
-                        std::get_if<UploadFailedPayload>(&result.payload))
-                     HandleUploadFailed(*payload);
-                  else
-                     HandleUploadFailed({});
-               }
-            });
+         CallAfter([this, result]() { HandleUploadCompleted(result); });
       },
       [this](auto current, auto total)
       {
@@ -464,6 +619,50 @@ void ShareAudioDialog::StartUploadProcess()
       });
 }
 
+void ShareAudioDialog::HandleStreamCompleted(
+   const UploadOperationCompleted& result)
+{
+   if (!mInProgress)
+      // Cancelled
+      return;
+
+   if (!MayRetryWithFile(result))
+      HandleUploadCompleted(result);
+   else if (mStreaming)
+      // StreamProject returns false when the encoder stops
+      mStreamRejected = true;
+   else
+   {
+      // Perhaps the server wanted the size, known only once encoding ended
+      wxLogMessage(wxT("audio.com refused the streamed upload; uploading a file"));
+      UploadExportedFile();
+   }
+}
+
+void ShareAudioDialog::HandleUploadCompleted(
+   const UploadOperationCompleted& result)
+{
+   mInProgress = false;
+
+   if (result.result == UploadOperationCompleted::Result::Success)
+   {
+      // Success indicates that UploadSuccessfulPayload is in the payload
+      assert(std::holds_alternative<UploadSuccessfulPayload>(result.payload));
+
+      if (auto payload = std::get_if<UploadSuccessfulPayload>(&result.payload))
+         HandleUploadSucceeded(*payload);
+      else
+         HandleUploadSucceeded({});
+   }
+   else if (result.result != UploadOperationCompleted::Result::Aborted)
+   {
+      if (auto payload = std::get_if<UploadFailedPayload>(&result.payload))
+         HandleUploadFailed(*payload);
+      else
+         HandleUploadFailed({});
+   }
+}
+
 void ShareAudioDialog::HandleUploadSucceeded(
    const UploadSuccessfulPayload& payload)
 {
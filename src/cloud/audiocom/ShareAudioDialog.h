@@ -35,6 +35,7 @@ class UserImage;
 
 struct UploadFailedPayload;
 struct UploadSuccessfulPayload;
+struct UploadOperationCompleted;
 
 class ShareAudioDialog final :
     public wxDialogWrapper
@@ -50,8 +51,17 @@ private:
    void OnContinue();
    
    wxString ExportProject();
+   //! Uploads the audio while it is being encoded, if the preferred format allows it
+   //! @return false if no suitable format was found, or if the server refused
+   //! the stream, and the upload is to be tried again from a file
+   bool StreamProject();
+   //! Exports to a temporary file, and uploads the file
+   void UploadExportedFile();
    
    void StartUploadProcess();
+   //! Falls back to UploadExportedFile if the server refused the stream
+   void HandleStreamCompleted(const UploadOperationCompleted& result);
+   void HandleUploadCompleted(const UploadOperationCompleted& result);
    void HandleUploadSucceeded(const UploadSuccessfulPayload& payload);
    void HandleUploadFailed(const UploadFailedPayload& payload);
    void HandleExportFailure();
@@ -127,5 +137,9 @@ private:
 
    bool mIsAuthorised { false };
    bool mInProgress { false };
+   //! Whether StreamProject is waiting for the encoder
+   bool mStreaming { false };
+   //! Whether the server refused the stream while StreamProject waited
+   bool mStreamRejected { false };
 };
 } // namespace cloud::audiocom
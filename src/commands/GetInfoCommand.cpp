@@ -17,6 +17,7 @@ This class now lists
 - Clips
 - Labels
 - Boxes
+- Effect load
 
 *//*******************************************************************/
 
@@ -35,6 +36,9 @@ This class now lists
 #include "../widgets/Overlay.h"
 #include "../TrackPanelAx.h"
 #include "../TrackPanel.h"
+#include "AudioIO.h"
+#include "RealtimeEffectList.h"
+#include "RealtimeEffectState.h"
 #include "WaveClip.h"
 #include "ViewInfo.h"
 #include "WaveTrack.h"
@@ -72,6 +76,7 @@ enum {
    kEnvelopes,
    kLabels,
    kBoxes,
+   kEffectLoad,
    nTypes
 };
 
@@ -86,6 +91,7 @@ static const EnumValueSymbol kTypes[nTypes] =
    { XO("Envelopes") },
    { XO("Labels") },
    { XO("Boxes") },
+   { wxT("EffectLoad"), XO("Effect Load") },
 };
 
 enum {
@@ -171,6 +177,7 @@ bool GetInfoCommand::ApplyInner(const CommandContext &context)
       case kEnvelopes    : return SendEnvelopes( context );
       case kLabels       : return SendLabels( context );
       case kBoxes        : return SendBoxes( context );
+      case kEffectLoad   : return SendEffectLoad( context );
       default:
          context.Status( "Command options not recognised" );
    }
@@ -582,6 +589,58 @@ bool GetInfoCommand::SendEnvelopes(const CommandContext &context)
 }
 
 
+bool GetInfoCommand::SendEffectLoad(const CommandContext &context)
+{
+   auto SendStates = [&](const RealtimeEffectList &list, double track) {
+      for (size_t ii = 0, nn = list.GetStatesCount(); ii < nn; ++ii) {
+         const auto pState = list.GetStateAt(ii);
+         const auto load = pState->GetLoad().GetSnapshot();
+         context.StartStruct();
+         context.AddItem( track, "track" );
+         context.AddItem( (double)ii, "position" );
+         context.AddItem( PluginManager::GetEffectNameFromID(
+            pState->GetID()).GET(), "name" );
+         context.AddBool( pState->IsEnabled(), "enabled" );
+         context.AddItem( (double)load.count, "buffers" );
+         context.AddItem( (double)load.misses, "overDeadline" );
+         context.AddItem( load.Mean(), "mean" );
+         context.AddItem( load.Percentile(0.95), "p95" );
+         context.AddItem( load.Peak(), "peak" );
+         // Counts of buffers by load, in bins of BinWidth percent
+         context.StartField( "histogram" );
+         context.StartArray();
+         for (const auto bin : load.bins)
+            context.AddItem( (double)bin );
+         context.EndArray();
+         context.EndField();
+         context.EndStruct();
+      }
+   };
+
+   const auto underruns = AudioIO::Get()->GetPlaybackUnderruns();
+   context.StartStruct();
+   context.AddItem( (double)underruns.device, "deviceUnderruns" );
+   context.AddItem( (double)underruns.starved, "starvedBuffers" );
+   context.StartField( "effects" );
+   context.StartArray();
+   // The master effects are given track number -1
+   SendStates( RealtimeEffectList::Get( context.project ), -1 );
+   auto &tracks = TrackList::Get( context.project );
+   int i=0;
+   for (auto t : tracks) {
+      t->TypeSwitch([&](const WaveTrack &waveTrack) {
+         SendStates( RealtimeEffectList::Get( waveTrack ), i );
+      });
+      // Per track numbering counts all tracks
+      i++;
+   }
+   context.EndArray();
+   context.EndField();
+   context.EndStruct();
+
+   return true;
+}
+
 bool GetInfoCommand::SendLabels(const CommandContext &context)
 {
    auto &tracks = TrackList::Get( context.project );
@@ -21,6 +21,7 @@
 #include "CommandManager.h"
 #include "../CommonCommandFlags.h"
 #include "LoadCommands.h"
+#include "../BatchCommands.h"
 #include "../ProjectFileManager.h"
 #include "ViewInfo.h"
 #include "Export.h"
@@ -158,6 +159,77 @@ bool ExportCommand::Apply(const CommandContext & context)
    return false;
 }
 
+template<bool Const>
+bool ApplyMacroToFilesCommand::VisitSettings( SettingsVisitorBase<Const> & S ){
+   S.Define( mMacroName, wxT("Macro"), wxString{} );
+   S.Define( mFileNames, wxT("Filenames"), wxString{} );
+   S.Define( mConcurrency, wxT("Concurrency"), 0, 0, 256 );
+   return true;
+}
+
+bool ApplyMacroToFilesCommand::VisitSettings( SettingsVisitor & S )
+   { return VisitSettings<false>(S); }
+
+bool ApplyMacroToFilesCommand::VisitSettings( ConstSettingsVisitor & S )
+   { return VisitSettings<true>(S); }
+
+const ComponentInterfaceSymbol ApplyMacroToFilesCommand::Symbol
+{ XO("Apply Macro To Files") };
+
+namespace{ BuiltinCommandsModule::Registration< ApplyMacroToFilesCommand > reg3; }
+
+void ApplyMacroToFilesCommand::PopulateOrExchange(ShuttleGui & S)
+{
+   S.AddSpace(0, 5);
+
+   S.StartMultiColumn(2, wxALIGN_CENTER);
+   {
+      S.TieTextBox(XXO("Macro:"),mMacroName);
+      S.TieTextBox(XXO("File Names:"),mFileNames);
+      S.TieTextBox(XXO("Concurrency:"),mConcurrency);
+   }
+   S.EndMultiColumn();
+}
+
+bool ApplyMacroToFilesCommand::Apply(const CommandContext & context)
+{
+   auto &project = context.project;
+   if (!TrackList::Get(project).empty()) {
+      context.Error(wxT("The project must be empty"));
+      return false;
+   }
+   if (MacroCommands::GetNames().Index(mMacroName) == wxNOT_FOUND) {
+      context.Error(wxString::Format(wxT("No macro named %s"), mMacroName));
+      return false;
+   }
+
+   FilePaths files;
+   for (const auto &fileName : wxSplit(mFileNames, '|', '\0'))
+      if (!fileName.empty())
+         files.push_back(fileName);
+
+   MacroCommandsCatalog catalog(&project);
+   MacroCommands macro{ project };
+   macro.ReadMacro(mMacroName);
+   const auto results = macro.ApplyMacroToFiles(
+      catalog, files, std::max(0, mConcurrency));
+
+   // Report each file, so that scripts can retry failures
+   bool success = results.size() == files.size();
+   context.StartArray();
+   for (const auto &result : results) {
+      context.StartStruct();
+      context.AddItem(result.fileName, wxT("file"));
+      context.AddBool(result.success, wxT("success"));
+      if (!result.message.empty())
+         context.AddItem(result.message.Translation(), wxT("message"));
+      context.EndStruct();
+      success = success && result.success;
+   }
+   context.EndArray();
+   return success;
+}
+
 namespace {
 using namespace MenuTable;
 
@@ -173,6 +245,8 @@ AttachedItem sAttachment{
       Command( wxT("Import2"), XXO("Import..."),
          CommandDispatch::OnAudacityCommand, AudioIONotBusyFlag() ),
       Command( wxT("Export2"), XXO("Export..."),
+         CommandDispatch::OnAudacityCommand, AudioIONotBusyFlag() ),
+      Command( wxT("ApplyMacroToFiles"), XXO("Apply Macro to Files..."),
          CommandDispatch::OnAudacityCommand, AudioIONotBusyFlag() )
    )
 };
@@ -16,6 +16,9 @@
 \class ExportCommand
 \brief Command for exporting audio
 
+\class ApplyMacroToFilesCommand
+\brief Command for applying a macro to many files, decoding several at once
+
 *//*******************************************************************/
 
 #include "Command.h"
@@ -63,3 +66,27 @@ public:
    wxString mFileName;
    int mnChannels;
 };
+
+class ApplyMacroToFilesCommand : public AudacityCommand
+{
+public:
+   static const ComponentInterfaceSymbol Symbol;
+
+   // ComponentInterface overrides
+   ComponentInterfaceSymbol GetSymbol() const override {return Symbol;};
+   TranslatableString GetDescription() const override {return XO("Applies a macro to each of several files.");};
+   template<bool Const> bool VisitSettings( SettingsVisitorBase<Const> &S );
+   bool VisitSettings( SettingsVisitor & S ) override;
+   bool VisitSettings( ConstSettingsVisitor & S ) override;
+   void PopulateOrExchange(ShuttleGui & S) override;
+   bool Apply(const CommandContext & context) override;
+
+   // AudacityCommand overrides
+   ManualPageID ManualPage() override {return L"Extra_Menu:_Scriptables_II#apply_macro_to_files";}
+public:
+   wxString mMacroName;
+   //! Paths separated by '|'
+   wxString mFileNames;
+   //! Files decoded at once; 0 for the number of processors
+   int mConcurrency;
+};
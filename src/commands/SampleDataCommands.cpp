@@ -0,0 +1,294 @@
+/**********************************************************************
+
+   Audacity: A Digital Audio Editor
+   Audacity(R) is copyright (c) 1999-2018 Audacity Team.
+   File License: wxwidgets
+
+   SampleDataCommands.cpp
+
+******************************************************************//**
+
+\file SampleDataCommands.cpp
+\brief Contains definitions for the GetSamplesCommand and SetSamplesCommand
+classes
+
+The samples go through a file or pipe that the script names, not through the
+text of the response, so a script may move much audio with few commands.  A
+file in a memory file system such as /dev/shm serves as shared memory.  A
+script that names a FIFO must open its other end while it awaits the response.
+
+*//*******************************************************************/
+
+
+#include "SampleDataCommands.h"
+
+#include "CommandDispatch.h"
+#include "CommandManager.h"
+#include "../CommonCommandFlags.h"
+#include "LoadCommands.h"
+#include "ProjectHistory.h"
+#include "SettingsVisitor.h"
+#include "ShuttleGui.h"
+#include "WaveTrack.h"
+#include "CommandContext.h"
+
+#include <wx/ffile.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+//! Find a channel by the indices that GetInfo reports
+WaveTrack *FindChannel(TrackList &tracks, size_t iTrack, size_t iChannel)
+{
+   size_t index = 0;
+   for (auto t : tracks) {
+      if (index++ != iTrack)
+         continue;
+      if (auto pTrack = track_cast<WaveTrack*>(t)) {
+         for (auto pChannel : TrackList::Channels(pTrack))
+            if (iChannel-- == 0)
+               return pChannel;
+      }
+      break;
+   }
+   return nullptr;
+}
+}
+
+const ComponentInterfaceSymbol GetSamplesCommand::Symbol
+{ XO("Get Samples") };
+
+namespace{ BuiltinCommandsModule::Registration< GetSamplesCommand > reg; }
+
+template<bool Const>
+bool GetSamplesCommand::VisitSettings( SettingsVisitorBase<Const> & S ){
+   S.Define( mFileName,    wxT("Filename"),   wxString{} );
+   S.Define( mFirstTrack,  wxT("Track"),      0, 0, 1000000 );
+   S.Define( mNumTracks,   wxT("TrackCount"), 1, 1, 1000000 );
+   S.Define( mStart,       wxT("Start"),      0.0, 0.0, 1.0e15 );
+   S.Define( mLength,      wxT("Length"),     0.0, 0.0, 1.0e15 );
+   return true;
+}
+
+bool GetSamplesCommand::VisitSettings( SettingsVisitor & S )
+   { return VisitSettings<false>(S); }
+
+bool GetSamplesCommand::VisitSettings( ConstSettingsVisitor & S )
+   { return VisitSettings<true>(S); }
+
+void GetSamplesCommand::PopulateOrExchange(ShuttleGui & S)
+{
+   S.AddSpace(0, 5);
+
+   S.StartMultiColumn(2, wxALIGN_CENTER);
+   {
+      S.TieTextBox(XXO("File Name:"), mFileName);
+      S.TieNumericTextBox(XXO("First Track:"), mFirstTrack);
+      S.TieNumericTextBox(XXO("Track Count:"), mNumTracks);
+      S.TieNumericTextBox(XXO("Start Sample:"), mStart);
+      S.TieNumericTextBox(XXO("Length:"), mLength);
+   }
+   S.EndMultiColumn();
+}
+
+bool GetSamplesCommand::Apply(const CommandContext & context)
+{
+   // Decide all frames first, to report progress over all of them
+   struct Frame {
+      const WaveTrack *pChannel;
+      SampleFrameHeader header;
+   };
+   std::vector<Frame> frames;
+   sampleCount total = 0;
+   size_t index = 0;
+   for (auto t : TrackList::Get(context.project)) {
+      const auto iTrack = index++;
+      if (iTrack < size_t(mFirstTrack) ||
+          iTrack >= size_t(mFirstTrack) + mNumTracks)
+         continue;
+      t->TypeSwitch([&](const WaveTrack &track) {
+         uint32_t iChannel = 0;
+         for (auto pChannel : TrackList::Channels(&track)) {
+            const sampleCount start{ mStart };
+            const auto length = mLength > 0
+               ? sampleCount{ mLength }
+               : std::max<sampleCount>(0,
+                  pChannel->TimeToLongSamples(pChannel->GetEndTime()) - start);
+            SampleFrameHeader header{};
+            std::copy(std::begin(SampleFrameHeader::Magic),
+               std::end(SampleFrameHeader::Magic), header.magic);
+            header.track = static_cast<uint32_t>(iTrack);
+            header.channel = iChannel++;
+            header.start = start.as_long_long();
+            header.length = length.as_long_long();
+            frames.push_back({ pChannel, header });
+            total += length;
+         }
+      });
+   }
+
+   wxFFile file{ mFileName, wxT("wb") };
+   if (!file.IsOpened()) {
+      context.Error(wxT("Could not open file for samples: ") + mFileName);
+      return false;
+   }
+
+   sampleCount done = 0;
+   Floats buffer;
+   size_t bufferSize = 0;
+   for (auto &frame : frames) {
+      auto &header = frame.header;
+      if (file.Write(&header, sizeof(header)) != sizeof(header)) {
+         context.Error(wxT("Could not write samples to ") + mFileName);
+         return false;
+      }
+      const auto pChannel = frame.pChannel;
+      if (bufferSize < pChannel->GetMaxBlockSize())
+         buffer.reinit(bufferSize = pChannel->GetMaxBlockSize());
+      sampleCount position = header.start;
+      const sampleCount end = header.start + header.length;
+      while (position < end) {
+         const auto block = limitSampleBufferSize(
+            pChannel->GetBestBlockSize(position), end - position);
+         pChannel->GetFloats(buffer.get(), position, block);
+         const auto bytes = block * sizeof(float);
+         if (file.Write(buffer.get(), bytes) != bytes) {
+            context.Error(wxT("Could not write samples to ") + mFileName);
+            return false;
+         }
+         position += block;
+         done += block;
+         if (total > 0)
+            context.Progress(done.as_double() / total.as_double());
+      }
+   }
+
+   context.Status(wxString::Format(wxT("Wrote %lld samples in %lld frames"),
+      done.as_long_long(), static_cast<long long>(frames.size())));
+   return true;
+}
+
+const ComponentInterfaceSymbol SetSamplesCommand::Symbol
+{ XO("Set Samples") };
+
+namespace{ BuiltinCommandsModule::Registration< SetSamplesCommand > reg2; }
+
+template<bool Const>
+bool SetSamplesCommand::VisitSettings( SettingsVisitorBase<Const> & S ){
+   S.Define( mFileName, wxT("Filename"), wxString{} );
+   return true;
+}
+
+bool SetSamplesCommand::VisitSettings( SettingsVisitor & S )
+   { return VisitSettings<false>(S); }
+
+bool SetSamplesCommand::VisitSettings( ConstSettingsVisitor & S )
+   { return VisitSettings<true>(S); }
+
+void SetSamplesCommand::PopulateOrExchange(ShuttleGui & S)
+{
+   S.AddSpace(0, 5);
+
+   S.StartMultiColumn(2, wxALIGN_CENTER);
+   {
+      S.TieTextBox(XXO("File Name:"), mFileName);
+   }
+   S.EndMultiColumn();
+}
+
+bool SetSamplesCommand::Apply(const CommandContext & context)
+{
+   wxFFile file{ mFileName, wxT("rb") };
+   if (!file.IsOpened()) {
+      context.Error(wxT("Could not open file for samples: ") + mFileName);
+      return false;
+   }
+
+   auto &tracks = TrackList::Get(context.project);
+   auto &history = ProjectHistory::Get(context.project);
+   bool success = true;
+   size_t nFrames = 0;
+   sampleCount done = 0;
+   Floats buffer;
+   size_t bufferSize = 0;
+   // The file may be a pipe, which can't be validated before writing; so
+   // undo all frames written if a later one is bad, or if writing throws
+   bool committed = false;
+   auto cleanup = finally([&]{
+      if (!committed && done > 0)
+         history.RollbackState();
+   });
+   // Any number of frames, for any tracks, make one undoable change
+   SampleFrameHeader header;
+   while (success) {
+      const auto headerBytes = file.Read(&header, sizeof(header));
+      if (headerBytes == 0)
+         break;
+      if (headerBytes != sizeof(header) ||
+          memcmp(header.magic, SampleFrameHeader::Magic, sizeof(header.magic))
+          || header.length < 0) {
+         context.Error(wxT("Not a frame of samples"));
+         success = false;
+         break;
+      }
+      const auto pChannel = FindChannel(tracks, header.track, header.channel);
+      if (!pChannel) {
+         context.Error(wxString::Format(
+            wxT("No channel %u of a wave track %u"),
+            header.channel, header.track));
+         success = false;
+         break;
+      }
+      if (bufferSize < pChannel->GetMaxBlockSize())
+         buffer.reinit(bufferSize = pChannel->GetMaxBlockSize());
+      sampleCount position = header.start;
+      const sampleCount end = header.start + header.length;
+      while (position < end) {
+         const auto block = limitSampleBufferSize(bufferSize, end - position);
+         const auto bytes = block * sizeof(float);
+         if (file.Read(buffer.get(), bytes) != bytes) {
+            context.Error(wxT("Frame of samples is incomplete"));
+            success = false;
+            break;
+         }
+         // Samples outside of clips are not written
+         pChannel->Set(reinterpret_cast<constSamplePtr>(buffer.get()),
+            floatSample, position, block);
+         position += block;
+         done += block;
+      }
+      ++nFrames;
+   }
+
+   if (!success) {
+      context.Status(wxString::Format(
+         wxT("Read %lld samples in %lld frames, and changed nothing"),
+         done.as_long_long(), static_cast<long long>(nFrames)));
+      return false;
+   }
+   if (done > 0)
+      history.PushState(XO("Set Samples"), XO("Set Samples"));
+   committed = true;
+   context.Status(wxString::Format(wxT("Read %lld samples in %lld frames"),
+      done.as_long_long(), static_cast<long long>(nFrames)));
+   return true;
+}
+
+namespace {
+using namespace MenuTable;
+
+// Register menu items
+
+AttachedItem sAttachment{
+   wxT("Optional/Extra/Part2/Scriptables2"),
+   Items( wxT(""),
+      // Note that the PLUGIN_SYMBOL must have a space between words,
+      // whereas the short-form used here must not.
+      Command( wxT("GetSamples"), XXO("Get Samples..."),
+         CommandDispatch::OnAudacityCommand, AudioIONotBusyFlag() ),
+      Command( wxT("SetSamples"), XXO("Set Samples..."),
+         CommandDispatch::OnAudacityCommand, AudioIONotBusyFlag() )
+   )
+};
+}
@@ -0,0 +1,98 @@
+/**********************************************************************
+
+   Audacity: A Digital Audio Editor
+   Audacity(R) is copyright (c) 1999-2018 Audacity Team.
+   File License: wxwidgets
+
+   SampleDataCommands.h
+
+******************************************************************//**
+
+\class GetSamplesCommand
+\brief Command that writes samples of tracks, as binary frames, to a file or
+pipe named by the script
+
+\class SetSamplesCommand
+\brief Command that reads binary frames from a file or pipe named by the
+script, and writes their samples into tracks, as one undoable change; if
+any frame is bad, none of the frames changes the tracks
+
+*//*******************************************************************/
+
+#ifndef __SAMPLE_DATA_COMMANDS__
+#define __SAMPLE_DATA_COMMANDS__
+
+#include "Command.h"
+#include "CommandType.h"
+
+#include <cstdint>
+
+//! Layout of the binary frames exchanged by GetSamples and SetSamples
+/*!
+ Each frame is this header, then `length` samples of 32 bit float, all in the
+ byte order of the machine running Audacity.  A file or pipe may hold any
+ number of frames, one after another.
+ */
+struct SampleFrameHeader {
+   static constexpr char Magic[4]{ 'A', 'S', 'M', 'P' };
+
+   char magic[4];
+   //! Index of the track, counting as GetInfo: Type=Tracks does
+   uint32_t track;
+   //! Index of the channel within the track
+   uint32_t channel;
+   uint32_t reserved;
+   //! Index of the first sample, counted from time zero
+   int64_t start;
+   //! Number of samples that follow
+   int64_t length;
+};
+static_assert(sizeof(SampleFrameHeader) == 32);
+
+class GetSamplesCommand : public AudacityCommand
+{
+public:
+   static const ComponentInterfaceSymbol Symbol;
+
+   // ComponentInterface overrides
+   ComponentInterfaceSymbol GetSymbol() const override {return Symbol;};
+   TranslatableString GetDescription() const override {return XO("Writes samples of tracks to a file or pipe.");};
+   template<bool Const> bool VisitSettings( SettingsVisitorBase<Const> &S );
+   bool VisitSettings( SettingsVisitor & S ) override;
+   bool VisitSettings( ConstSettingsVisitor & S ) override;
+   void PopulateOrExchange(ShuttleGui & S) override;
+   bool Apply(const CommandContext & context) override;
+
+   // AudacityCommand overrides
+   ManualPageID ManualPage() override {return L"Extra_Menu:_Scriptables_II#get_samples";}
+public:
+   wxString mFileName;
+   int mFirstTrack;
+   int mNumTracks;
+   //! Sample positions are doubles, which count exactly past any track length
+   double mStart;
+   //! Zero means to the end of each track
+   double mLength;
+};
+
+class SetSamplesCommand : public AudacityCommand
+{
+public:
+   static const ComponentInterfaceSymbol Symbol;
+
+   // ComponentInterface overrides
+   ComponentInterfaceSymbol GetSymbol() const override {return Symbol;};
+   TranslatableString GetDescription() const override {return XO("Reads samples of tracks from a file or pipe.");};
+   template<bool Const> bool VisitSettings( SettingsVisitorBase<Const> &S );
+   bool VisitSettings( SettingsVisitor & S ) override;
+   bool VisitSettings( ConstSettingsVisitor & S ) override;
+   void PopulateOrExchange(ShuttleGui & S) override;
+   bool Apply(const CommandContext & context) override;
+
+   // AudacityCommand overrides
+   ManualPageID ManualPage() override {return L"Extra_Menu:_Scriptables_II#set_samples";}
+public:
+   wxString mFileName;
+};
+
+#endif
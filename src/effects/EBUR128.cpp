@@ -9,16 +9,130 @@ Max Maisel
 ***********************************************************************/
 
 #include "EBUR128.h"
+#include <algorithm>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// SSE2 is part of every x86-64 processor, so needs no run-time check
+#define EBUR128_SSE2 1
+#include <emmintrin.h>
+#else
+#define EBUR128_SSE2 0
+#endif
+
+namespace {
+
+// The two stages of the weighting filter of one channel, with the state
+// held in locals while a run of samples is filtered
+struct WeightingCoefficients
+{
+   explicit WeightingCoefficients(const ArrayOf<Biquad> &filter)
+      : hb0{ filter[0].fNumerCoeffs[Biquad::B0] }
+      , hb1{ filter[0].fNumerCoeffs[Biquad::B1] }
+      , hb2{ filter[0].fNumerCoeffs[Biquad::B2] }
+      , ha1{ filter[0].fDenomCoeffs[Biquad::A1] }
+      , ha2{ filter[0].fDenomCoeffs[Biquad::A2] }
+      , pb0{ filter[1].fNumerCoeffs[Biquad::B0] }
+      , pb1{ filter[1].fNumerCoeffs[Biquad::B1] }
+      , pb2{ filter[1].fNumerCoeffs[Biquad::B2] }
+      , pa1{ filter[1].fDenomCoeffs[Biquad::A1] }
+      , pa2{ filter[1].fDenomCoeffs[Biquad::A2] }
+   {}
+   const double hb0, hb1, hb2, ha1, ha2;
+   const double pb0, pb1, pb2, pa1, pa2;
+};
+
+// Returns the sum of squares of the weighted samples
+double FilterOne(ArrayOf<Biquad> &filter, const float *x, size_t len)
+{
+   const WeightingCoefficients c{ filter };
+   auto &hsf = filter[0];
+   auto &hpf = filter[1];
+   // The input of the second stage is the output of the first
+   double x1 = hsf.fPrevIn, x2 = hsf.fPrevPrevIn;
+   double y1 = hsf.fPrevOut, y2 = hsf.fPrevPrevOut;
+   double z1 = hpf.fPrevOut, z2 = hpf.fPrevPrevOut;
+   double power = 0;
+   for (size_t i = 0; i < len; ++i) {
+      const double x0 = x[i];
+      const double y0 =
+         x0 * c.hb0 + x1 * c.hb1 + x2 * c.hb2 - y1 * c.ha1 - y2 * c.ha2;
+      const double z0 =
+         y0 * c.pb0 + y1 * c.pb1 + y2 * c.pb2 - z1 * c.pa1 - z2 * c.pa2;
+      power += z0 * z0;
+      x2 = x1, x1 = x0;
+      y2 = y1, y1 = y0;
+      z2 = z1, z1 = z0;
+   }
+   hsf.fPrevIn = x1, hsf.fPrevPrevIn = x2;
+   hsf.fPrevOut = y1, hsf.fPrevPrevOut = y2;
+   hpf.fPrevIn = y1, hpf.fPrevPrevIn = y2;
+   hpf.fPrevOut = z1, hpf.fPrevPrevOut = z2;
+   return power;
+}
+
+#if EBUR128_SSE2
+// Filters two channels at once, one in each lane; the recursion allows no
+// parallelism along the samples of one channel
+double FilterTwo(ArrayOf<Biquad> &filterA, ArrayOf<Biquad> &filterB,
+   const float *a, const float *b, size_t len)
+{
+   // Channels of one meter share the coefficients
+   const WeightingCoefficients c{ filterA };
+   const auto hb0 = _mm_set1_pd(c.hb0), hb1 = _mm_set1_pd(c.hb1),
+      hb2 = _mm_set1_pd(c.hb2), ha1 = _mm_set1_pd(c.ha1),
+      ha2 = _mm_set1_pd(c.ha2);
+   const auto pb0 = _mm_set1_pd(c.pb0), pb1 = _mm_set1_pd(c.pb1),
+      pb2 = _mm_set1_pd(c.pb2), pa1 = _mm_set1_pd(c.pa1),
+      pa2 = _mm_set1_pd(c.pa2);
+   const auto load = [&](double Biquad::*member, size_t stage) {
+      return _mm_set_pd(filterB[stage].*member, filterA[stage].*member);
+   };
+   const auto store = [&](__m128d value, double Biquad::*member, size_t stage) {
+      _mm_storel_pd(&(filterA[stage].*member), value);
+      _mm_storeh_pd(&(filterB[stage].*member), value);
+   };
+   auto x1 = load(&Biquad::fPrevIn, 0), x2 = load(&Biquad::fPrevPrevIn, 0);
+   auto y1 = load(&Biquad::fPrevOut, 0), y2 = load(&Biquad::fPrevPrevOut, 0);
+   auto z1 = load(&Biquad::fPrevOut, 1), z2 = load(&Biquad::fPrevPrevOut, 1);
+   auto power = _mm_setzero_pd();
+   for (size_t i = 0; i < len; ++i) {
+      const auto x0 = _mm_set_pd(b[i], a[i]);
+      const auto y0 = _mm_sub_pd(
+         _mm_add_pd(_mm_add_pd(_mm_mul_pd(x0, hb0), _mm_mul_pd(x1, hb1)),
+            _mm_mul_pd(x2, hb2)),
+         _mm_add_pd(_mm_mul_pd(y1, ha1), _mm_mul_pd(y2, ha2)));
+      const auto z0 = _mm_sub_pd(
+         _mm_add_pd(_mm_add_pd(_mm_mul_pd(y0, pb0), _mm_mul_pd(y1, pb1)),
+            _mm_mul_pd(y2, pb2)),
+         _mm_add_pd(_mm_mul_pd(z1, pa1), _mm_mul_pd(z2, pa2)));
+      power = _mm_add_pd(power, _mm_mul_pd(z0, z0));
+      x2 = x1, x1 = x0;
+      y2 = y1, y1 = y0;
+      z2 = z1, z1 = z0;
+   }
+   store(x1, &Biquad::fPrevIn, 0), store(x2, &Biquad::fPrevPrevIn, 0);
+   store(y1, &Biquad::fPrevOut, 0), store(y2, &Biquad::fPrevPrevOut, 0);
+   store(y1, &Biquad::fPrevIn, 1), store(y2, &Biquad::fPrevPrevIn, 1);
+   store(z1, &Biquad::fPrevOut, 1), store(z2, &Biquad::fPrevPrevOut, 1);
+   double sums[2];
+   _mm_storeu_pd(sums, power);
+   return sums[0] + sums[1];
+}
+#endif
+
+}
+
 EBUR128::EBUR128(double rate, size_t channels)
    : mChannelCount{ channels }
    , mRate{ rate }
-   , mBlockSize( ceil(0.4 * mRate) ) // 400 ms blocks
    , mBlockOverlap( ceil(0.1 * mRate) ) // 100 ms overlap
+   // 400 ms blocks, longer by at most three samples when the rate is not
+   // a multiple of ten
+   , mBlockSize( STEPS_PER_BLOCK * mBlockOverlap )
 {
    mLoudnessHist.reinit(HIST_BIN_COUNT, false);
-   mBlockRingBuffer.reinit(mBlockSize);
    mWeightingFilter.reinit(mChannelCount, false);
    for(size_t channel = 0; channel < mChannelCount; ++channel)
       mWeightingFilter[channel] = CalcWeightingFilter(mRate);
@@ -80,36 +194,49 @@ ArrayOf<Biquad> EBUR128::CalcWeightingFilter(double fs)
    return pBiquad;
 }
 
-void EBUR128::ProcessSampleFromChannel(float x_in, size_t channel) const
+void EBUR128::ProcessSamples(const float *const channels[], size_t len)
 {
-   double value;
-   value = mWeightingFilter[channel][0].ProcessOne(x_in);
-   value = mWeightingFilter[channel][1].ProcessOne(value);
-   if(channel == 0)
-      mBlockRingBuffer[mBlockRingPos] = value * value;
-   else
-   {
-      // Add the power of additional channels to the power of first channel.
-      // As a result, stereo tracks appear about 3 LUFS louder, as specified.
-      mBlockRingBuffer[mBlockRingPos] += value * value;
+   // Accumulate the power of 100 ms steps, rather than of each sample, so
+   // that each block is the sum of the powers of its steps
+   size_t done = 0;
+   while (done < len) {
+      const auto count = std::min(len - done, mBlockOverlap - mStepFill);
+      mStepSum += FilterChannels(channels, done, count);
+      done += count;
+      mStepFill += count;
+      if (mStepFill < mBlockOverlap)
+         break;
+
+      mStepPower[mStepCount++ % STEPS_PER_BLOCK] = mStepSum;
+      mStepSum = 0;
+      mStepFill = 0;
+      if (mStepCount >= STEPS_PER_BLOCK) {
+         // A new full block of samples was submitted.
+         double blockPower = 0;
+         for (auto power : mStepPower)
+            blockPower += power;
+         AddBlockToHistogram(blockPower, mBlockSize);
+      }
    }
 }
 
-void EBUR128::NextSample()
+double EBUR128::FilterChannels(const float *const channels[],
+   size_t offset, size_t len)
 {
-   ++mBlockRingPos;
-   ++mBlockRingSize;
-
-   if(mBlockRingPos % mBlockOverlap == 0)
-   {
-      // A new full block of samples was submitted.
-      if(mBlockRingSize >= mBlockSize)
-         AddBlockToHistogram(mBlockSize);
-   }
-   // Close the ring.
-   if(mBlockRingPos == mBlockSize)
-      mBlockRingPos = 0;
-   ++mSampleCount;
+   // Add the power of additional channels to the power of first channel.
+   // As a result, stereo tracks appear about 3 LUFS louder, as specified.
+   double power = 0;
+   size_t channel = 0;
+#if EBUR128_SSE2
+   for (; channel + 1 < mChannelCount; channel += 2)
+      power += FilterTwo(
+         mWeightingFilter[channel], mWeightingFilter[channel + 1],
+         channels[channel] + offset, channels[channel + 1] + offset, len);
+#endif
+   for (; channel < mChannelCount; ++channel)
+      power += FilterOne(
+         mWeightingFilter[channel], channels[channel] + offset, len);
+   return power;
 }
 
 double EBUR128::IntegrativeLoudness()
@@ -124,7 +251,18 @@ double EBUR128::IntegrativeLoudness()
    // Handle incomplete block if no non-zero block was found.
    if(sum_c == 0)
    {
-      AddBlockToHistogram(mBlockRingSize);
+      // Take the incomplete step, and as many of the last whole steps
+      // as make less than one block
+      double power = mStepSum;
+      size_t len = mStepFill;
+      const auto steps = std::min(mStepCount, STEPS_PER_BLOCK - 1);
+      for(size_t i = 1; i <= steps; ++i)
+      {
+         power += mStepPower[(mStepCount - i) % STEPS_PER_BLOCK];
+         len += mBlockOverlap;
+      }
+      if(len > 0)
+         AddBlockToHistogram(power, len);
       HistogramSums(0, sum_v, sum_c);
    }
 
@@ -164,17 +302,10 @@ EBUR128::HistogramSums(size_t start_idx, double& sum_v, long int& sum_c) const
 /// to call this on the last block.
 /// However, allow to override the block size if the audio to be
 /// processed is shorter than one block.
-void EBUR128::AddBlockToHistogram(size_t validLen)
+void EBUR128::AddBlockToHistogram(double power, size_t validLen)
 {
-   // Reset mBlockRingSize to full state to avoid overflow.
-   // The actual value of mBlockRingSize does not matter
-   // since this is only used to detect if blocks are complete (>= mBlockSize).
-   mBlockRingSize = mBlockSize;
-
    size_t idx;
-   double blockVal = 0;
-   for(size_t i = 0; i < validLen; ++i)
-      blockVal += mBlockRingBuffer[i];
+   double blockVal = power;
 
    // Histogram values are simplified log10() immediate values
    // without -0.691 + 10*(...) to safe computing power. This is
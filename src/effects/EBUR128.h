@@ -27,28 +27,35 @@ public:
    ~EBUR128() = default;
 
    static ArrayOf<Biquad> CalcWeightingFilter(double fs);
-   void ProcessSampleFromChannel(float x_in, size_t channel) const;
-   void NextSample();
+   /// Filter the next len samples of all channels and accumulate their power.
+   /// channels must hold one pointer for each channel.
+   void ProcessSamples(const float *const channels[], size_t len);
    double IntegrativeLoudness();
    inline double IntegrativeLoudnessToLUFS(double loudness)
       { return 10 * log10(loudness); }
 
 private:
+   double FilterChannels(const float *const channels[],
+      size_t offset, size_t len);
    void HistogramSums(size_t start_idx, double& sum_v, long int& sum_c) const;
-   void AddBlockToHistogram(size_t validLen);
+   void AddBlockToHistogram(double power, size_t validLen);
 
    static constexpr size_t HIST_BIN_COUNT = 65536;
    /// EBU R128 absolute threshold
    static constexpr double GAMMA_A = (-70.0 + 0.691) / 10.0;
+   /// Blocks overlap by 75%, so each is made of four steps
+   static constexpr size_t STEPS_PER_BLOCK = 4;
    ArrayOf<long int> mLoudnessHist;
-   Doubles mBlockRingBuffer;
-   size_t mSampleCount{ 0 };
-   size_t mBlockRingPos{ 0 };
-   size_t mBlockRingSize{ 0 };
+   /// Power of the last STEPS_PER_BLOCK complete steps, as a ring
+   double mStepPower[STEPS_PER_BLOCK]{};
+   /// Power of the incomplete step
+   double mStepSum{ 0 };
+   size_t mStepFill{ 0 };
+   size_t mStepCount{ 0 };
    const size_t mChannelCount;
    const double mRate;
-   const size_t mBlockSize;
    const size_t mBlockOverlap;
+   const size_t mBlockSize;
 
    /// This is be an array of arrays of the type
    /// mWeightingFilter[CHANNEL][FILTER] with
@@ -18,6 +18,13 @@
 #include "EffectOutputTracks.h"
 
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <list>
+#include <optional>
+#include <thread>
 
 #include <wx/simplebook.h>
 #include <wx/valgen.h>
@@ -26,6 +33,9 @@
 #include "Prefs.h"
 #include "../ProjectFileManager.h"
 #include "ShuttleGui.h"
+#include "Sequence.h"
+#include "SampleBlock.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 #include "../widgets/valnum.h"
 #include "ProgressDialog.h"
@@ -93,6 +103,18 @@ EffectType EffectLoudness::GetType() const
 
 // Effect implementation
 
+//! Tracks, or single channels if stereo channels are normalized
+//! independently
+struct EffectLoudness::Unit
+{
+   WaveTrack *pTrack;
+   size_t nChannels;
+   double curT0;
+   double curT1;
+   //! Integrative loudness, when normalizing to it
+   double loudness{ 0 };
+};
+
 bool EffectLoudness::Process(EffectInstance &, EffectSettings &)
 {
    const float ratio = DB_TO_LINEAR(
@@ -109,9 +131,7 @@ bool EffectLoudness::Process(EffectInstance &, EffectSettings &)
    bool bGoodResult = true;
    auto topMsg = XO("Normalizing Loudness...\n");
 
-   AllocBuffers(outputs.Get());
-   mProgressVal = 0;
-
+   std::vector<Unit> units;
    for (auto pTrack : outputs.Get().Selected<WaveTrack>()) {
       // Get start and end times from track
       double trackStart = pTrack->GetStartTime();
@@ -122,95 +142,82 @@ bool EffectLoudness::Process(EffectInstance &, EffectSettings &)
       const double curT0 = std::max(trackStart, mT0);
       const double curT1 = std::min(trackEnd, mT1);
 
-      // Get the track rate
-      mCurRate = pTrack->GetRate();
-
-      wxString msg;
-      auto trackName = pTrack->GetName();
-      // This affects only the progress indicator update during ProcessOne
-      mSteps = (mNormalizeTo == kLoudness) ? 2 : 1;
+      const auto channels = TrackList::Channels(pTrack);
+      if (mStereoInd)
+         for (const auto pChannel : channels)
+            units.push_back({ pChannel, 1, curT0, curT1 });
+      else
+         units.push_back({ pTrack, channels.size(), curT0, curT1 });
+   }
 
-      mProgressMsg =
-         topMsg + XO("Analyzing: %s").Format(trackName);
+   AllocBuffers(outputs.Get());
+   mProgressVal = 0;
+   // This affects only the progress indicator update during ProcessOne
+   mSteps = (mNormalizeTo == kLoudness) ? 2 : 1;
+
+   // Measure all tracks at once, before changing any
+   if (mNormalizeTo == kLoudness) {
+      if (!AnalyseLoudness(units, topMsg)) {
+         FreeBuffers();
+         return false;
+      }
+      mProgressVal = 1.0 / mSteps;
+   }
 
-      const auto channels = TrackList::Channels(pTrack);
-      auto nChannels = mStereoInd ? 1 : channels.size();
+   for (const auto &unit : units) {
+      auto &track = *unit.pTrack;
+      const auto nChannels = unit.nChannels;
       mProcStereo = nChannels > 1;
 
-      const auto processOne = [&](WaveTrack &track){
-         std::optional<EBUR128> loudnessProcessor;
-         float RMS[2];
+      // Get the track rate
+      mCurRate = track.GetRate();
 
-         if (mNormalizeTo == kLoudness) {
-            loudnessProcessor.emplace(mCurRate, nChannels);
-            if (!ProcessOne(track, nChannels,
-               curT0, curT1, 0, &*loudnessProcessor))
-               // Processing failed -> abort
-               return false;
-         }
-         else {
-            // RMS
-            if (mProcStereo) {
-               size_t idx = 0;
-               for (const auto pChannel : channels) {
-                  if (!GetTrackRMS(*pChannel, curT0, curT1, RMS[idx]))
-                     return false;
-                  ++idx;
-               }
-            }
-            else {
-               if (!GetTrackRMS(track, curT0, curT1, RMS[0]))
-                  return false;
+      // Calculate normalization values the analysis results
+      float extent;
+      if (mNormalizeTo == kLoudness)
+         extent = unit.loudness;
+      else {
+         // RMS
+         float RMS[2];
+         if (mProcStereo) {
+            size_t idx = 0;
+            for (const auto pChannel : TrackList::Channels(&track)) {
+               if (!GetTrackRMS(*pChannel, unit.curT0, unit.curT1, RMS[idx]))
+                  goto done;
+               ++idx;
             }
          }
-
-         // Calculate normalization values the analysis results
-         float extent;
-         if (mNormalizeTo == kLoudness)
-            extent = loudnessProcessor->IntegrativeLoudness();
          else {
-            // RMS
-            extent = RMS[0];
-            if (mProcStereo)
-               // RMS: use average RMS, average must be calculated in quadratic
-               // domain.
-               extent = sqrt((RMS[0] * RMS[0] + RMS[1] * RMS[1]) / 2.0);
+            if (!GetTrackRMS(track, unit.curT0, unit.curT1, RMS[0]))
+               goto done;
          }
+         extent = RMS[0];
+         if (mProcStereo)
+            // RMS: use average RMS, average must be calculated in quadratic
+            // domain.
+            extent = sqrt((RMS[0] * RMS[0] + RMS[1] * RMS[1]) / 2.0);
+      }
 
-         if (extent == 0.0) {
-            FreeBuffers();
-            return false;
-         }
-         float mult = ratio / extent;
-
-         if (mNormalizeTo == kLoudness) {
-            // Target half the LUFS value if mono (or independent processed
-            // stereo) shall be treated as dual mono.
-            if (nChannels == 1 &&
-               (mDualMono || !IsMono(track)))
-               mult /= 2.0;
-
-            // LUFS are related to square values so the multiplier must be the
-            // xroot.
-            mult = sqrt(mult);
-         }
+      if (extent == 0.0)
+         break;
+      float mult = ratio / extent;
 
-         mProgressMsg = topMsg + XO("Processing: %s").Format( trackName );
-         if (!ProcessOne(track, nChannels, curT0, curT1, mult, nullptr)) {
-            // Processing failed -> abort
-            return false;
-         }
-         return true;
-      };
+      if (mNormalizeTo == kLoudness) {
+         // Target half the LUFS value if mono (or independent processed
+         // stereo) shall be treated as dual mono.
+         if (nChannels == 1 &&
+            (mDualMono || !IsMono(track)))
+            mult /= 2.0;
 
-      if (mStereoInd) {
-         for (const auto pChannel : channels)
-            if (!processOne(*pChannel))
-               goto done;
+         // LUFS are related to square values so the multiplier must be the
+         // xroot.
+         mult = sqrt(mult);
       }
-      else {
-         if (!processOne(*pTrack))
-            break;
+
+      mProgressMsg = topMsg + XO("Processing: %s").Format( track.GetName() );
+      if (!ProcessOne(track, nChannels, unit.curT0, unit.curT1, mult)) {
+         // Processing failed -> abort
+         break;
       }
    }
 done:
@@ -387,15 +394,247 @@ bool EffectLoudness::GetTrackRMS(WaveTrack &track,
    return true;
 }
 
+namespace {
+
+using LoudnessKey = std::vector<long long>;
+
+//! Identifies the samples of some channels within bounds
+/*! Sample blocks are never changed, nor their ids reused, within one factory,
+ so equal keys of tracks made by one factory mean equal samples */
+LoudnessKey MakeLoudnessKey(const std::vector<WaveTrack*> &channels,
+   sampleCount start, sampleCount end)
+{
+   LoudnessKey key{ llrint(channels[0]->GetRate()),
+      static_cast<long long>(channels.size()),
+      start.as_long_long(), end.as_long_long() };
+   for (const auto pChannel : channels) {
+      const auto clips = pChannel->SortedClipArray();
+      key.push_back(clips.size());
+      for (const auto pClip : clips) {
+         key.push_back(pClip->GetPlayStartSample().as_long_long());
+         key.push_back(pClip->GetPlayEndSample().as_long_long());
+         key.push_back(pChannel->TimeToLongSamples(
+            pClip->GetSequenceStartTime()).as_long_long());
+         const auto &blocks = pClip->GetSequence(0)->GetBlockArray();
+         key.push_back(blocks.size());
+         for (const auto &block : blocks) {
+            key.push_back(block.start.as_long_long());
+            key.push_back(block.sb->GetBlockID());
+         }
+      }
+   }
+   return key;
+}
+
+//! Remembers the loudness of recently measured tracks, so that normalizing
+//! again, or after undoing, needs no second pass over unchanged samples
+class LoudnessCache
+{
+public:
+   static LoudnessCache &Get()
+   {
+      static LoudnessCache cache;
+      return cache;
+   }
+
+   std::optional<double> Find(
+      const SampleBlockFactoryPtr &pFactory, const LoudnessKey &key)
+   {
+      Prune();
+      const auto end = mEntries.end();
+      const auto iter = std::find_if(mEntries.begin(), end,
+         [&](const Entry &entry){
+            return SameFactory(entry, pFactory) && entry.key == key; });
+      if (iter == end)
+         return {};
+      // Most recently used first
+      mEntries.splice(mEntries.begin(), mEntries, iter);
+      return iter->loudness;
+   }
+
+   void Store(const SampleBlockFactoryPtr &pFactory,
+      LoudnessKey key, double loudness)
+   {
+      mEntries.push_front({ pFactory, std::move(key), loudness });
+      if (mEntries.size() > MaxEntries)
+         mEntries.pop_back();
+   }
+
+private:
+   static constexpr size_t MaxEntries = 64;
+
+   struct Entry {
+      //! Ids of blocks are unique only within their factory
+      std::weak_ptr<SampleBlockFactory> wFactory;
+      LoudnessKey key;
+      double loudness;
+   };
+
+   static bool SameFactory(
+      const Entry &entry, const SampleBlockFactoryPtr &pFactory)
+   {
+      // Comparing owners, not addresses, which a later factory might reuse
+      return !entry.wFactory.owner_before(pFactory) &&
+         !pFactory.owner_before(entry.wFactory);
+   }
+
+   //! Forget the entries of closed projects
+   void Prune()
+   {
+      mEntries.remove_if([](const Entry &entry){
+         return entry.wFactory.expired(); });
+   }
+
+   std::list<Entry> mEntries;
+};
+
+//! Measure on a worker thread
+/*!
+ @param done incremented by the numbers of frames measured
+ @return nothing if stopped
+ */
+std::optional<double> MeasureLoudness(const std::vector<WaveTrack*> &channels,
+   sampleCount start, sampleCount end,
+   std::atomic<long long> &done, const std::atomic<bool> &stop)
+{
+   const WaveTrack &first = *channels[0];
+   EBUR128 processor{ first.GetRate(), channels.size() };
+   const auto capacity = first.GetMaxBlockSize();
+   std::vector<Floats> buffers;
+   std::vector<const float *> pointers;
+   for (size_t ii = 0; ii < channels.size(); ++ii) {
+      buffers.emplace_back(capacity);
+      pointers.push_back(buffers.back().get());
+   }
+
+   for (auto s = start; s < end;) {
+      if (stop)
+         return {};
+      const auto blockLen = limitSampleBufferSize(
+         std::min(first.GetBestBlockSize(s), capacity), end - s);
+      for (size_t ii = 0; ii < channels.size(); ++ii)
+         channels[ii]->GetFloats(buffers[ii].get(), s, blockLen);
+      processor.ProcessSamples(pointers.data(), blockLen);
+      s += blockLen;
+      done += blockLen;
+   }
+   return processor.IntegrativeLoudness();
+}
+
+}
+
+/// Measures the units on worker threads, or finds their loudness in the
+/// cache
+bool EffectLoudness::AnalyseLoudness(std::vector<Unit> &units,
+   const TranslatableString &topMsg)
+{
+   struct Job {
+      Unit *pUnit;
+      std::vector<WaveTrack*> channels;
+      sampleCount start, end;
+      SampleBlockFactoryPtr pFactory;
+      LoudnessKey key;
+      std::atomic<long long> done{ 0 };
+      std::optional<double> loudness;
+      std::exception_ptr exception;
+   };
+
+   auto &cache = LoudnessCache::Get();
+   std::vector<std::unique_ptr<Job>> jobs;
+   double total = 0;
+   for (auto &unit : units) {
+      // ProcessOne() will stop at such a unit
+      if (unit.curT1 <= unit.curT0)
+         continue;
+      auto pJob = std::make_unique<Job>();
+      pJob->pUnit = &unit;
+      if (unit.nChannels == 1)
+         pJob->channels.push_back(unit.pTrack);
+      else for (const auto pChannel : TrackList::Channels(unit.pTrack))
+         pJob->channels.push_back(pChannel);
+      pJob->start = unit.pTrack->TimeToLongSamples(unit.curT0);
+      pJob->end = unit.pTrack->TimeToLongSamples(unit.curT1);
+
+      // Only clips of one factory may be compared
+      for (const auto pChannel : pJob->channels)
+         for (const auto &pClip : pChannel->GetClips()) {
+            const auto &pFactory = pClip->GetFactory();
+            if (!pJob->pFactory)
+               pJob->pFactory = pFactory;
+            else if (pFactory != pJob->pFactory)
+               pJob->pFactory.reset();
+         }
+      if (pJob->pFactory) {
+         pJob->key = MakeLoudnessKey(pJob->channels, pJob->start, pJob->end);
+         if (const auto loudness = cache.Find(pJob->pFactory, pJob->key)) {
+            unit.loudness = *loudness;
+            continue;
+         }
+      }
+      total += (pJob->end - pJob->start).as_double() * unit.nChannels;
+      jobs.push_back(std::move(pJob));
+   }
+   if (jobs.empty())
+      return true;
+
+   mProgressMsg = topMsg + ((jobs.size() == 1)
+      ? XO("Analyzing: %s").Format(jobs[0]->pUnit->pTrack->GetName())
+      : XO("Analyzing %d tracks").Format(static_cast<int>(jobs.size())));
+
+   std::atomic<size_t> next{ 0 };
+   std::atomic<size_t> finished{ 0 };
+   std::atomic<bool> stop{ false };
+   const auto work = [&]{
+      for (size_t jj; (jj = next++) < jobs.size(); ++finished) {
+         auto &job = *jobs[jj];
+         try {
+            job.loudness = MeasureLoudness(
+               job.channels, job.start, job.end, job.done, stop);
+         }
+         catch (...) {
+            job.exception = std::current_exception();
+            stop = true;
+         }
+      }
+   };
+
+   const auto nThreads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+   std::vector<std::thread> workers;
+   for (size_t ii = 0; ii < nThreads; ++ii)
+      workers.emplace_back(work);
+
+   using namespace std::chrono_literals;
+   while (finished < jobs.size()) {
+      std::this_thread::sleep_for(50ms);
+      double measured = 0;
+      for (const auto &pJob : jobs)
+         measured += double(pJob->done) * pJob->pUnit->nChannels;
+      if (!stop && TotalProgress(measured / total / mSteps, mProgressMsg))
+         stop = true;
+   }
+   for (auto &worker : workers)
+      worker.join();
+
+   for (const auto &pJob : jobs)
+      if (pJob->exception)
+         std::rethrow_exception(pJob->exception);
+   if (stop)
+      return false;
+
+   for (const auto &pJob : jobs) {
+      pJob->pUnit->loudness = *pJob->loudness;
+      if (pJob->pFactory)
+         cache.Store(pJob->pFactory, std::move(pJob->key), *pJob->loudness);
+   }
+   return true;
+}
+
 /// ProcessOne() takes a track, transforms it to bunch of buffer-blocks,
 /// and executes ProcessData, on it...
-///  uses mMult to normalize a track.
-///  mMult must be set before this is called
-/// In analyse mode, it executes the selected analyse operation on it...
-///  mMult does not have to be set before this is called
+///  uses mult to normalize a track.
 bool EffectLoudness::ProcessOne(WaveTrack &track, size_t nChannels,
-   const double curT0, const double curT1, const float mult,
-   EBUR128 *pLoudnessProcessor)
+   const double curT0, const double curT1, const float mult)
 {
    // Transform the marker timepoints to samples
    auto start = track.TimeToLongSamples(curT0);
@@ -425,15 +664,9 @@ bool EffectLoudness::ProcessOne(WaveTrack &track, size_t nChannels,
       LoadBufferBlock(track, nChannels, s, blockLen);
 
       // Process the buffer.
-      if (pLoudnessProcessor) {
-         if (!AnalyseBufferBlock(*pLoudnessProcessor))
-            return false;
-      }
-      else {
-         if (!ProcessBufferBlock(mult))
-            return false;
-         StoreBufferBlock(track, nChannels, s, blockLen);
-      }
+      if (!ProcessBufferBlock(mult))
+         return false;
+      StoreBufferBlock(track, nChannels, s, blockLen);
 
       // Increment s one blockfull of samples
       s += blockLen;
@@ -462,23 +695,6 @@ void EffectLoudness::LoadBufferBlock(WaveTrack &track, size_t nChannels,
    mTrackBufferLen = len;
 }
 
-/// Calculates sample sum (for DC) and EBU R128 weighted square sum
-/// (for loudness).
-bool EffectLoudness::AnalyseBufferBlock(EBUR128 &loudnessProcessor)
-{
-   for(size_t i = 0; i < mTrackBufferLen; i++)
-   {
-      loudnessProcessor.ProcessSampleFromChannel(mTrackBuffer[0][i], 0);
-      if (mProcStereo)
-         loudnessProcessor.ProcessSampleFromChannel(mTrackBuffer[1][i], 1);
-      loudnessProcessor.NextSample();
-   }
-
-   if (!UpdateProgress())
-      return false;
-   return true;
-}
-
 bool EffectLoudness::ProcessBufferBlock(const float mult)
 {
    for(size_t i = 0; i < mTrackBufferLen; i++)
@@ -22,9 +22,10 @@
 #include "ShuttleAutomation.h"
 #include "Track.h"
 
+#include <vector>
+
 class wxChoice;
 class wxSimplebook;
-class EBUR128;
 class ShuttleGui;
 using Floats = ArrayOf<float>;
 
@@ -67,15 +68,18 @@ public:
 private:
    // EffectLoudness implementation
 
+   struct Unit;
+
    void AllocBuffers(TrackList &outputs);
    void FreeBuffers();
    static bool GetTrackRMS(WaveTrack &track,
       double curT0, double curT1, float &rms);
+   bool AnalyseLoudness(std::vector<Unit> &units,
+      const TranslatableString &topMsg);
    bool ProcessOne(WaveTrack &track, size_t nChannels,
-      double curT0, double curT1, float mult, EBUR128 *pLoudnessProcessor);
+      double curT0, double curT1, float mult);
    void LoadBufferBlock(WaveTrack &track, size_t nChannels,
       sampleCount pos, size_t len);
-   bool AnalyseBufferBlock(EBUR128 &loudnessProcessor);
    bool ProcessBufferBlock(float mult);
    void StoreBufferBlock(WaveTrack &track, size_t nChannels,
       sampleCount pos, size_t len);
@@ -177,10 +177,12 @@ void DoImport(const CommandContext &context, bool isRaw)
                .AddImportedTracks(fileName, std::move(newTracks));
          }
       }
-      else {
-         ProjectFileManager::Get( project ).Import(fileName);
-      }
    }
+
+   if (!isRaw)
+      // Decode the files concurrently
+      ProjectFileManager::Get( project ).Import(
+         FilePaths{ selectedFiles.begin(), selectedFiles.end() });
 }
 
 // Menu handler functions
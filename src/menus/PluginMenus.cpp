@@ -15,12 +15,14 @@
 #include "../ProjectWindows.h"
 #include "../ProjectSelectionManager.h"
 #include "RealtimeEffectPanel.h"
+#include "SelectFile.h"
 #include "SampleTrack.h"
 #include "SyncLock.h"
 #include "../toolbars/ToolManager.h"
 #include "../toolbars/SelectionBar.h"
 #include "../TrackPanelAx.h"
 #include "TempDirectory.h"
+#include "Tracing.h"
 #include "UndoManager.h"
 #include "../commands/CommandContext.h"
 #include "../commands/CommandManager.h"
@@ -32,6 +34,8 @@
 #include "MenuHelper.h"
 #include "prefs/EffectsPrefs.h"
 
+#include <fstream>
+
 
 // private helper classes and functions
 namespace {
@@ -210,6 +214,44 @@ void OnBenchmark(const CommandContext &context)
    ::RunBenchmark( &window, project);
 }
 
+void OnTracePerformance(const CommandContext &context)
+{
+   auto &project = context.project;
+   auto &commandManager = CommandManager::Get( project );
+
+   const bool enable = !Tracing::IsEnabled();
+   if (enable)
+      // Start a fresh trace
+      Tracing::Clear();
+   Tracing::SetEnabled(enable);
+   commandManager.Check(wxT("TracePerformance"), enable);
+}
+
+void OnSavePerformanceTrace(const CommandContext &context)
+{
+   auto &project = context.project;
+   auto &window = GetProjectFrame( project );
+
+   const auto title = XO("Save Performance Trace");
+   const auto fName = SelectFile(FileNames::Operation::Export,
+      title,
+      wxEmptyString,
+      wxT("trace.json"),
+      wxT("json"),
+      { { XO("Trace event files"), { wxT("json") }, true } },
+      wxFD_SAVE | wxFD_OVERWRITE_PROMPT | wxRESIZE_BORDER,
+      &window);
+   if (fName.empty())
+      return;
+
+   std::ofstream stream{ fName.fn_str(), std::ios::binary };
+   if (stream)
+      Tracing::WriteChromeTrace(stream);
+   if (!stream)
+      AudacityMessageBox(
+         XO("Unable to save the trace to %s").Format( fName ), title);
+}
+
 void OnSimulateRecordingErrors(const CommandContext &context)
 {
    auto &project = context.project;
@@ -500,8 +542,17 @@ BaseItemSharedPtr ToolsMenu()
          // TODO: What should we do here?  Make benchmark a plug-in?
          // Easy enough to do.  We'd call it mod-self-test.
          Command( wxT("Benchmark"), XXO("&Run Benchmark..."),
-            OnBenchmark, AudioIONotBusyFlag() )
+            OnBenchmark, AudioIONotBusyFlag() ),
    //#endif
+         // Timing of audio, disk and drawing activity in all threads, for
+         // viewing in chrome://tracing or Perfetto
+         Command( wxT("TracePerformance"), XXO("&Trace Performance"),
+            OnTracePerformance, AlwaysEnabledFlag,
+            Options{}.CheckTest(
+               [](AudacityProject&){ return Tracing::IsEnabled(); } ) ),
+         Command( wxT("SavePerformanceTrace"),
+            XXO("Save Performance Tra&ce..."),
+            OnSavePerformanceTrace, AlwaysEnabledFlag )
       ),
 
       Section( "Tools",
@@ -34,6 +34,7 @@
 #include "AudacityMessageBox.h"
 #include "ReadOnlyText.h"
 #include "FileNames.h"
+#include "WaveTrack.h"
 
 using namespace FileNames;
 using namespace TempDirectory;
@@ -260,6 +261,17 @@ void DirectoriesPrefs::PopulateOrExchange(ShuttleGui &S)
    }
    S.EndStatic();
 
+   S.StartStatic(XO("Storage of new projects"));
+   {
+      S.StartMultiColumn(2);
+      {
+         /* i18n-hint: Audio in a project is stored in blocks of samples */
+         S.TieChoice(XXO("Sample &block size:"), SampleBlockSizeSetting);
+      }
+      S.EndMultiColumn();
+   }
+   S.EndStatic();
+
    S.EndScroller();
 }
 
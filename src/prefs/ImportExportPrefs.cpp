@@ -20,6 +20,7 @@
 
 #include <wx/defs.h>
 
+#include "Import.h"
 #include "Prefs.h"
 #include "ShuttleGui.h"
 
@@ -111,6 +112,14 @@ void ImportExportPrefs::PopulateOrExchange(ShuttleGui & S)
    }
    S.EndStatic();
 
+   S.StartStatic(XO("Importing"));
+   {
+      S.TieCheckBox(
+         XXO("Import uncompressed audio &on demand, copying it in the background"),
+         OnDemandImport);
+   }
+   S.EndStatic();
+
 #ifdef USE_MIDI
    S.StartStatic(XO("Exported Allegro (.gro) files save time as:"));
    {
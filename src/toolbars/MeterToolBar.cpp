@@ -31,6 +31,7 @@
 #endif
 
 #include <wx/gbsizer.h>
+#include <cmath>
 
 #include "AllThemeResources.h"
 #include "Decibels.h"
@@ -81,6 +82,10 @@ public:
             else
                *name += wxT(" ") + wxString::Format(_(" Peak %.2f "), panel->GetPeakHold());
 
+            const auto loudness = panel->GetShortTermLoudness();
+            if (std::isfinite(loudness))
+               *name += wxT(" ") + wxString::Format(_(" Loudness %.1f LUFS "), loudness);
+
             if(panel->IsClipping())
                *name += wxT(" ") + _(" Clipped ");
          }
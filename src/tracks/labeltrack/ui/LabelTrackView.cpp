@@ -40,6 +40,10 @@ Paul Licameli split from TrackPanel.cpp
 #include "AudacityTextEntryDialog.h"
 #include "wxWidgetsWindowPlacement.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
 #include <wx/clipbrd.h>
 #include <wx/dcclient.h>
 #include <wx/font.h>
@@ -199,6 +203,7 @@ std::vector<UIHandlePtr> LabelTrackView::DetailedHitTest
 bool LabelTrackView::mbGlyphsReady=false;
 
 wxFont LabelTrackView::msFont;
+unsigned LabelTrackView::msFontGeneration = 0;
 
 /// We have several variants of the icons (highlighting).
 /// The icons are draggable, and you can drag one boundary
@@ -258,6 +263,7 @@ void LabelTrackView::ResetFont()
    wxString facename = gPrefs->Read(wxT("/GUI/LabelFontFacename"), wxT(""));
    int size = gPrefs->Read(wxT("/GUI/LabelFontSize"), DefaultFontSize);
    msFont = GetFont(facename, size);
+   ++msFontGeneration;
 }
 
 /// ComputeTextPosition is 'smart' about where to display
@@ -417,17 +423,32 @@ void LabelTrackView::ComputeTextPosition(const wxRect & r, int index) const
    labelStruct.xText = xText;
 }
 
-/// ComputeLayout determines which row each label
+/// ComputeRows determines which row each label
 /// should be placed on, and reserves space for it.
+/// It places all labels, at positions that do not depend on scrolling,
+/// so that labels keep their rows while the view moves.
 /// Function assumes that the labels are sorted.
-void LabelTrackView::ComputeLayout(const wxRect & r, const ZoomInfo &zoomInfo) const
-{
-   int xUsed[MAX_NUM_ROWS];
+void LabelTrackView::ComputeRows(wxDC &dc, const LabelTrack &track,
+   int nRows, bool avoidName, double zoom) const
+{
+   const auto &mLabels = track.GetLabels();
+   const bool fontChanged = (mRows.fontGeneration != msFontGeneration);
+   if (!fontChanged &&
+       mRows.generation == track.GetGeneration() &&
+       mRows.zoom == zoom &&
+       mRows.nRows == nRows &&
+       mRows.avoidName == avoidName &&
+       mRows.rows.size() == mLabels.size())
+      return;
+
+   // Measure the labels not measured since they last changed
+   for (const auto &labelStruct : mLabels)
+      if (fontChanged || labelStruct.width < 0) {
+         wxCoord textWidth, textHeight;
+         dc.GetTextExtent(labelStruct.title, &textWidth, &textHeight);
+         labelStruct.width = textWidth;
+      }
 
-   int iRow;
-   // Rows are the 'same' height as icons or as the text,
-   // whichever is taller.
-   const int yRowHeight = wxMax(mTextHeight,mIconHeight)+3;// pixels.
    // Extra space at end of rows.
    // We allow space for one half icon at the start and two
    // half icon widths for extra x for the text frame.
@@ -435,33 +456,25 @@ void LabelTrackView::ComputeLayout(const wxRect & r, const ZoomInfo &zoomInfo) c
    // allowed to be obscured by the text].
    const int xExtra= (3 * mIconWidth)/2;
 
-   bool bAvoidName = false;
-   const int nRows = wxMin((r.height / yRowHeight) + 1, MAX_NUM_ROWS);
-   if( nRows > 2 )
-      bAvoidName = gPrefs->ReadBool(wxT("/GUI/ShowTrackNameInWaveform"), false);
    // Initially none of the rows have been used.
    // So set a value that is less than any valid value.
-   {
-      // Bug 502: With dragging left of zeros, labels can be in 
-      // negative space.  So set least possible value as starting point.
-      const int xStart = INT_MIN;
-      for (auto &x : xUsed)
-         x = xStart;
-   }
+   // Bug 502: With dragging left of zeros, labels can be in
+   // negative space.  So set least possible value as starting point.
+   double xUsed[MAX_NUM_ROWS];
+   std::fill(std::begin(xUsed), std::end(xUsed),
+      std::numeric_limits<double>::lowest());
    int nRowsUsed=0;
 
-   const auto pTrack = FindLabelTrack();
-   const auto &mLabels = pTrack->GetLabels();
+   auto &rows = mRows.rows;
+   rows.resize(mLabels.size());
+   for (size_t i = 0; i < mLabels.size(); ++i) {
+      const auto &labelStruct = mLabels[i];
+      // Pixel positions measured from time zero
+      const double x = labelStruct.getT0() * zoom;
+      const double x1 = labelStruct.getT1() * zoom;
 
-   { int i = -1; for (const auto &labelStruct : mLabels) { ++i;
-      const int x = zoomInfo.TimeToPosition(labelStruct.getT0(), r.x);
-      const int x1 = zoomInfo.TimeToPosition(labelStruct.getT1(), r.x);
-      int y = r.y;
-
-      labelStruct.x=x;
-      labelStruct.x1=x1;
-      labelStruct.y=-1;// -ve indicates nothing doing.
-      iRow=0;
+      rows[i] = -1;// -ve indicates nothing doing.
+      int iRow=0;
       // Our first preference is a row that ends where we start.
       // (This is to encourage merging of adjacent label boundaries).
       while( (iRow<nRowsUsed) && (xUsed[iRow] != x ))
@@ -483,10 +496,10 @@ void LabelTrackView::ComputeLayout(const wxRect & r, const ZoomInfo &zoomInfo) c
          // as we can scroll left or right and/or zoom.
          // A possible alternative idea would be to (instead) increase the 
          // translucency of the track name, when the mouse is inside it.
-         if( (i==0 ) && (iRow==0) && bAvoidName ){
+         if( (i==0 ) && (iRow==0) && avoidName ){
             // reserve some space in first row.
             // reserve max of 200px or t1, or text box right edge.
-            const int x2 = zoomInfo.TimeToPosition(0.0, r.x) + 200;
+            const double x2 = 200;
             xUsed[iRow]=x+labelStruct.width+xExtra;
             if( xUsed[iRow] < x1 ) xUsed[iRow]=x1;
             if( xUsed[iRow] < x2 ) xUsed[iRow]=x2;
@@ -496,17 +509,65 @@ void LabelTrackView::ComputeLayout(const wxRect & r, const ZoomInfo &zoomInfo) c
          // Possibly update the number of rows actually used.
          if( iRow >= nRowsUsed )
             nRowsUsed=iRow+1;
-         // Record the position for this label
-         y= r.y + iRow * yRowHeight +(yRowHeight/2)+1;
-         labelStruct.y=y;
+         rows[i] = iRow;
          // On this row we have used up to max of end marker and width.
          // Plus also allow space to show the start icon and
          // some space for the text frame.
          xUsed[iRow]=x+labelStruct.width+xExtra;
          if( xUsed[iRow] < x1 ) xUsed[iRow]=x1;
+      }
+   }
+
+   mRows.generation = track.GetGeneration();
+   mRows.fontGeneration = msFontGeneration;
+   mRows.zoom = zoom;
+   mRows.nRows = nRows;
+   mRows.avoidName = avoidName;
+}
+
+/// ComputeLayout measures the labels that Draw found, and
+/// positions them in their rows.
+void LabelTrackView::ComputeLayout(
+   wxDC &dc, const wxRect & r, const ZoomInfo &zoomInfo) const
+{
+   // Rows are the 'same' height as icons or as the text,
+   // whichever is taller.
+   const int yRowHeight = wxMax(mTextHeight,mIconHeight)+3;// pixels.
+
+   bool bAvoidName = false;
+   const int nRows = wxMin((r.height / yRowHeight) + 1, MAX_NUM_ROWS);
+   if( nRows > 2 )
+      bAvoidName = gPrefs->ReadBool(wxT("/GUI/ShowTrackNameInWaveform"), false);
+
+   const auto pTrack = FindLabelTrack();
+   const auto &mLabels = pTrack->GetLabels();
+
+   // Get the text widths, which might have changed without notice
+   for (const auto i : LaidOutLabels(*pTrack)) {
+      const auto &labelStruct = mLabels[i];
+      wxCoord textWidth, textHeight;
+      dc.GetTextExtent(labelStruct.title, &textWidth, &textHeight);
+      if (labelStruct.width >= 0 && labelStruct.width != textWidth)
+         // Rows depend on widths
+         mRows.rows.clear();
+      labelStruct.width = textWidth;
+   }
+
+   ComputeRows(dc, *pTrack, nRows, bAvoidName, zoomInfo.GetZoom());
+
+   for (const auto i : LaidOutLabels(*pTrack)) {
+      const auto &labelStruct = mLabels[i];
+      labelStruct.x = zoomInfo.TimeToPosition(labelStruct.getT0(), r.x);
+      labelStruct.x1 = zoomInfo.TimeToPosition(labelStruct.getT1(), r.x);
+      const int iRow = mRows.rows[i];
+      if (iRow < 0)
+         labelStruct.y = -1;// -ve indicates nothing doing.
+      else {
+         // Record the position for this label
+         labelStruct.y = r.y + iRow * yRowHeight +(yRowHeight/2)+1;
          ComputeTextPosition( r, i );
       }
-   }}
+   }
 }
 
 /// Draw vertical lines that go exactly through the position
@@ -799,15 +860,15 @@ void LabelTrackView::Draw
       AColor::labelSelectedBrush, AColor::labelUnselectedBrush,
       SyncLock::IsSelectedOrSyncLockSelected(pTrack.get()) );
 
-   wxCoord textWidth, textHeight;
-
-   // Get the text widths.
-   // TODO: Make more efficient by only re-computing when a
-   // text label title changes.
-   for (const auto &labelStruct : mLabels) {
-      dc.GetTextExtent(labelStruct.title, &textWidth, &textHeight);
-      labelStruct.width = textWidth;
+   // Find the labels that may show.  Allow a screen width to the left,
+   // for text that runs past the end of its label, and an icon width to
+   // the right, for the glyphs
+   {
+      const auto t0 = zoomInfo.PositionToTime(r.x - r.width, r.x);
+      const auto t1 = zoomInfo.PositionToTime(r.x + r.width + mIconWidth, r.x);
+      pTrack->FindLabelsInRange(t0, t1, mLayout);
    }
+   const auto &layout = mLayout;
 
    // TODO: And this only needs to be done once, but we
    // do need the dc to do it.
@@ -818,7 +879,7 @@ void LabelTrackView::Draw
    mTextHeight = dc.GetFontMetrics().ascent + dc.GetFontMetrics().descent;
    const int yFrameHeight = mTextHeight + TextFramePadding * 2;
 
-   ComputeLayout( r, zoomInfo );
+   ComputeLayout( dc, r, zoomInfo );
    dc.SetTextForeground(theTheme.Colour( clrLabelTrackText));
    dc.SetBackgroundMode(wxTRANSPARENT);
    dc.SetBrush(AColor::labelTextNormalBrush);
@@ -828,12 +889,18 @@ void LabelTrackView::Draw
    // Now we draw the various items in this order,
    // so that the correct things overpaint each other.
 
+   const auto isLaidOut = [&](int i) {
+      return i >= 0 &&
+         std::binary_search(layout.begin(), layout.end(), size_t(i));
+   };
+
    // Draw vertical lines that show where the end positions are.
-   for (const auto &labelStruct : mLabels)
-      DrawLines( dc, labelStruct, r );
+   for (const auto i : layout)
+      DrawLines( dc, mLabels[i], r );
 
    // Draw the end glyphs.
-   { int i = -1; for (const auto &labelStruct : mLabels) { ++i;
+   for (const int i : layout) {
+      const auto &labelStruct = mLabels[i];
       GlyphLeft=0;
       GlyphRight=1;
       if( pHit && i == pHit->mMouseOverLabelLeft )
@@ -841,7 +908,7 @@ void LabelTrackView::Draw
       if( pHit && i == pHit->mMouseOverLabelRight )
          GlyphRight = (pHit->mEdge & 4) ? 7:4;
       DrawGlyphs( dc, labelStruct, r, GlyphLeft, GlyphRight );
-   }}
+   }
 
    auto &project = *artist->parent->GetProject();
 
@@ -852,7 +919,8 @@ void LabelTrackView::Draw
       auto target = dynamic_cast<LabelTextHandle*>(context.target.get());
       highlightTrack = target && target->GetTrack().get() == this;
 #endif
-      int i = -1; for (const auto &labelStruct : mLabels) { ++i;
+      for (const int i : layout) {
+         const auto &labelStruct = mLabels[i];
          bool highlight = false;
 #ifdef EXPERIMENTAL_TRACK_PANEL_HIGHLIGHTING
          highlight = highlightTrack && target->GetLabelNum() == i;
@@ -877,7 +945,8 @@ void LabelTrackView::Draw
    }
 
    // Draw highlights
-   if ( (mInitialCursorPos != mCurrentCursorPos) && IsValidIndex(mTextEditIndex, project))
+   if ( (mInitialCursorPos != mCurrentCursorPos) && IsValidIndex(mTextEditIndex, project)
+       && isLaidOut(mTextEditIndex))
    {
       int xpos1, xpos2;
       CalcHighlightXs(&xpos1, &xpos2);
@@ -886,16 +955,18 @@ void LabelTrackView::Draw
    }
 
    // Draw the text and the label boxes.
-   { int i = -1; for (const auto &labelStruct : mLabels) { ++i;
+   for (const int i : layout) {
+      const auto &labelStruct = mLabels[i];
       if(mTextEditIndex == i )
          dc.SetBrush(AColor::labelTextEditBrush);
       DrawText( dc, labelStruct, r );
       if(mTextEditIndex == i )
          dc.SetBrush(AColor::labelTextNormalBrush);
-   }}
+   }
 
    // Draw the cursor, if there is one.
-   if(mInitialCursorPos == mCurrentCursorPos && IsValidIndex(mTextEditIndex, project))
+   if(mInitialCursorPos == mCurrentCursorPos && IsValidIndex(mTextEditIndex, project)
+      && isLaidOut(mTextEditIndex))
    {
       const auto &labelStruct = mLabels[mTextEditIndex];
       int xPos = labelStruct.xText;
@@ -1233,7 +1304,8 @@ void LabelTrackView::OverGlyph(
 
    const auto pTrack = &track;
    const auto &mLabels = pTrack->GetLabels();
-   { int i = -1; for (const auto &labelStruct : mLabels) { ++i;
+   for (const int i : LaidOutLabels(track)) {
+      const auto &labelStruct = mLabels[i];
       // give text box better priority for selecting
       // reset selection state
       if (OverTextBox(&labelStruct, x, y))
@@ -1281,7 +1353,7 @@ void LabelTrackView::OverGlyph(
          hit.mMouseOverLabel = i;
          result = 3;
       }
-   }}
+   }
    hit.mEdge = result;
 }
 
@@ -1289,7 +1361,9 @@ int LabelTrackView::OverATextBox( const LabelTrack &track, int xx, int yy )
 {
    const auto pTrack = &track;
    const auto &mLabels = pTrack->GetLabels();
-   for (int nn = (int)mLabels.size(); nn--;) {
+   const auto laidOut = LaidOutLabels(track);
+   for (auto iter = laidOut.rbegin(); iter != laidOut.rend(); ++iter) {
+      const int nn = *iter;
       const auto &labelStruct = mLabels[nn];
       if ( OverTextBox( &labelStruct, xx, yy ) )
          return nn;
@@ -1298,6 +1372,16 @@ int LabelTrackView::OverATextBox( const LabelTrack &track, int xx, int yy )
    return -1;
 }
 
+std::vector<size_t> LabelTrackView::LaidOutLabels(const LabelTrack &track)
+{
+   auto result = Get(track).mLayout;
+   const auto size = track.GetLabels().size();
+   // Indices are increasing, so those out of range are at the end
+   result.erase(std::lower_bound(result.begin(), result.end(), size),
+      result.end());
+   return result;
+}
+
 // return true if the mouse is over text box, false otherwise
 bool LabelTrackView::OverTextBox(const LabelStruct *pLabel, int x, int y)
 {
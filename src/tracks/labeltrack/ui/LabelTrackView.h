@@ -14,6 +14,8 @@ Paul Licameli split from class LabelTrack
 #include "../../ui/CommonChannelView.h"
 #include "Observer.h"
 
+#include <vector>
+
 class LabelGlyphHandle;
 class LabelTextHandle;
 class LabelDefaultClickHandle;
@@ -206,8 +208,29 @@ private:
    int mRestoreFocus{-2};                          /// Restore focus to this track
                                                    /// when done editing
 
+   /// Indices, in increasing order, of the labels measured and laid out by
+   /// the last Draw; others are off screen, and their positions are out of date
+   mutable std::vector<size_t> mLayout;
+   //! mLayout, without indices no longer in the track
+   static std::vector<size_t> LaidOutLabels(const LabelTrack &track);
+
+   /// Rows of all labels, so that scrolling does not move labels between
+   /// rows; computed again only when what they depend on changes
+   struct LabelRows {
+      size_t generation{};
+      unsigned fontGeneration{};
+      double zoom{};
+      int nRows{};
+      bool avoidName{};
+      std::vector<int> rows; //!< -1 for labels that fit in no row
+   };
+   mutable LabelRows mRows;
+
    void ComputeTextPosition(const wxRect & r, int index) const;
-   void ComputeLayout(const wxRect & r, const ZoomInfo &zoomInfo) const;
+   void ComputeRows(wxDC &dc, const LabelTrack &track,
+      int nRows, bool avoidName, double zoom) const;
+   void ComputeLayout(
+      wxDC &dc, const wxRect & r, const ZoomInfo &zoomInfo) const;
    static void DrawLines( wxDC & dc, const LabelStruct &ls, const wxRect & r);
    static void DrawGlyphs( wxDC & dc, const LabelStruct &ls, const wxRect & r,
       int GlyphLeft, int GlyphRight);
@@ -262,6 +285,8 @@ private:
    std::weak_ptr<LabelTextHandle> mTextHandle;
 
    static wxFont msFont;
+   //! Incremented when msFont changes, so that labels are measured again
+   static unsigned msFontGeneration;
 
    // Bug #2571: See explanation in ShowContextMenu()
    int mEditIndex;
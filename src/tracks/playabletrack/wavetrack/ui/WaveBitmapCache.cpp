@@ -0,0 +1,450 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file WaveBitmapCache.cpp
+
+**********************************************************************/
+
+#include "WaveBitmapCache.h"
+
+#include "WaveformCache.h"
+#include "Envelope.h"
+#include "FrameStatistics.h"
+#include "LRUList.h"
+#include "../../../../TrackArt.h"
+
+#include <wx/bitmap.h>
+#include <wx/dc.h>
+#include <wx/image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+//! Inputs and outputs of the rendering of one tile
+/*! The mutex guards rendering, which either thread may do */
+struct WaveBitmapTile
+{
+   ~WaveBitmapTile();
+
+   std::mutex mutex;
+
+   WaveClipBitmapCache::Key key;
+   int width{ 0 };
+   //! Whether the arrays begin with the column before the tile, for
+   //! continuity with the previous tile
+   bool hasPrevious{ false };
+   //! Already multiplied by the envelope; kept, so that the tile can be
+   //! rendered again if its bitmap is released
+   std::vector<float> min, max, rms;
+
+   bool rendered{ false };
+   std::vector<unsigned char> rgb, alpha;
+
+   //! Made from rgb and alpha by the main thread only
+   std::optional<wxBitmap> bitmap;
+};
+
+namespace {
+
+// Tiles of one channel of a clip that are kept; those farthest from view
+// are forgotten first, but never those in view
+constexpr size_t MaxTiles = 32;
+
+// Bitmaps of all clips that are kept, because they may use scarce resources
+// of the windowing system
+constexpr size_t MaxBitmaps = 512;
+
+//! Rasterize min, max and rms as DrawMinMaxRMS in WaveformView.cpp does,
+//! but into memory and without wx, so that any thread may do it
+void Render(WaveBitmapTile &tile)
+{
+   const auto &key = tile.key;
+   const auto width = tile.width;
+   const auto height = key.height;
+   tile.rgb.assign(size_t(width) * height * 3, 0);
+   tile.alpha.assign(size_t(width) * height, 0);
+
+   // Paint the column from y0 to y1 inclusive
+   const auto paint = [&](int x, int y0, int y1, uint32_t colour) {
+      y0 = std::max(y0, 0);
+      y1 = std::min(y1, height - 1);
+      for (auto y = y0; y <= y1; ++y) {
+         const auto pixel = size_t(y) * width + x;
+         // wxColour::GetRGB() puts red in the low byte
+         const auto pRgb = &tile.rgb[3 * pixel];
+         pRgb[0] = colour & 0xFF;
+         pRgb[1] = (colour >> 8) & 0xFF;
+         pRgb[2] = (colour >> 16) & 0xFF;
+         tile.alpha[pixel] = 0xFF;
+      }
+   };
+   const auto yPos = [&](float value) {
+      return GetWaveYPos(value, key.zoomMin, key.zoomMax,
+         height, key.dB, true, key.dBRange, true);
+   };
+
+   const size_t offset = tile.hasPrevious ? 1 : 0;
+   int lasth1 = 0, lasth2 = 0;
+   if (tile.hasPrevious) {
+      lasth1 = yPos(tile.min[0]);
+      lasth2 = yPos(tile.max[0]);
+   }
+   for (int x = 0; x < width; ++x) {
+      const auto min = tile.min[x + offset];
+      const auto max = tile.max[x + offset];
+      const auto rms = tile.rms[x + offset];
+
+      auto h1 = yPos(min);
+      auto h2 = yPos(max);
+      // JKC: This adjustment to h1 and h2 ensures that the drawn
+      // waveform is continuous.
+      if (x > 0 || tile.hasPrevious) {
+         if (h1 < lasth2)
+            h1 = lasth2 - 1;
+         if (h2 > lasth1)
+            h2 = lasth1 + 1;
+      }
+      lasth1 = h1;
+      lasth2 = h2;
+
+      auto r1 = yPos(-rms);
+      auto r2 = yPos(rms);
+      // Make sure the rms isn't larger than the waveform min/max
+      r1 = std::min(r1, h1 - 1);
+      r2 = std::max(r2, h2 + 1);
+      r2 = std::min(r2, r1);
+
+      paint(x, std::min(h1, h2), std::max(h1, h2), key.sampleColour);
+      if (r1 != r2)
+         paint(x, r2, r1, key.rmsColour);
+      if (key.showClipping && (min <= -MAX_AUDIO || max >= MAX_AUDIO))
+         paint(x, 0, height, key.clippedColour);
+   }
+
+   tile.rendered = true;
+}
+
+//! One thread rendering tiles that are not yet visible
+class Renderer
+{
+public:
+   static Renderer &Get()
+   {
+      static Renderer instance;
+      return instance;
+   }
+
+   ~Renderer()
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mStop = true;
+      }
+      mCondition.notify_one();
+      if (mThread.joinable())
+         mThread.join();
+   }
+
+   void Enqueue(const std::shared_ptr<WaveBitmapTile> &pTile)
+   {
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         if (!mThread.joinable())
+            mThread = std::thread{ [this]{ Run(); } };
+         mJobs.push_back(pTile);
+      }
+      mCondition.notify_one();
+   }
+
+private:
+   void Run()
+   {
+      while (true) {
+         std::weak_ptr<WaveBitmapTile> wTile;
+         {
+            std::unique_lock<std::mutex> lock{ mMutex };
+            mCondition.wait(lock, [this]{ return mStop || !mJobs.empty(); });
+            if (mStop)
+               return;
+            wTile = std::move(mJobs.front());
+            mJobs.pop_front();
+         }
+         // The tile may have been forgotten already
+         if (auto pTile = wTile.lock()) {
+            std::lock_guard<std::mutex> lock{ pTile->mutex };
+            if (!pTile->rendered)
+               Render(*pTile);
+         }
+      }
+   }
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque<std::weak_ptr<WaveBitmapTile>> mJobs;
+   bool mStop{ false };
+   std::thread mThread;
+};
+
+//! The tiles of all clips that have bitmaps, in order of drawing
+class Bitmaps
+{
+public:
+   static Bitmaps &Get()
+   {
+      static Bitmaps instance;
+      return instance;
+   }
+
+   //! Called by the main thread after drawing a tile; releases the bitmaps
+   //! least recently drawn, beyond MaxBitmaps
+   void Use(WaveBitmapTile &tile)
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mTiles.Touch(&tile);
+      while (mTiles.size() > MaxBitmaps) {
+         auto &old = *mTiles.PopOldest();
+         // The background thread might render the tile, if it is still queued
+         std::lock_guard<std::mutex> tileLock{ old.mutex };
+         old.bitmap.reset();
+         old.rendered = false;
+      }
+   }
+
+   //! Called as a tile is destroyed, by either thread
+   void Forget(WaveBitmapTile &tile)
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mTiles.Erase(&tile);
+   }
+
+private:
+   std::mutex mMutex;
+   LRUList<WaveBitmapTile*> mTiles;
+};
+
+//! Summarizes what else changes the mapping of columns to drawn values:
+//! the envelope, trimming and rate
+size_t Fingerprint(const WaveClip &clip)
+{
+   const auto &envelope = *clip.GetEnvelope();
+   const std::hash<double> hash;
+   size_t result = envelope.GetExponential();
+   const auto combine = [&](double value){ result = result * 31 + hash(value); };
+   combine(clip.GetRate());
+   combine(clip.GetPlayStartTime() - envelope.GetOffset());
+   combine(envelope.GetValue(envelope.GetOffset()));
+   for (size_t ii = 0, nn = envelope.GetNumberOfPoints(); ii < nn; ++ii) {
+      combine(envelope[ii].GetT());
+      combine(envelope[ii].GetVal());
+   }
+   return result;
+}
+
+}
+
+WaveBitmapTile::~WaveBitmapTile()
+{
+   Bitmaps::Get().Forget(*this);
+}
+
+bool WaveClipBitmapCache::Key::operator == (const Key &other) const
+{
+   return pixelsPerSecond == other.pixelsPerSecond &&
+      height == other.height &&
+      zoomMin == other.zoomMin &&
+      zoomMax == other.zoomMax &&
+      dB == other.dB &&
+      dBRange == other.dBRange &&
+      showClipping == other.showClipping &&
+      sampleColour == other.sampleColour &&
+      rmsColour == other.rmsColour &&
+      clippedColour == other.clippedColour;
+}
+
+WaveClipBitmapCache::WaveClipBitmapCache(size_t nChannels)
+   : mChannels(nChannels)
+{
+}
+
+WaveClipBitmapCache::~WaveClipBitmapCache()
+{
+}
+
+static WaveClip::Caches::RegisteredFactory sKeyB{ [](WaveClip &clip) {
+   return std::make_unique<WaveClipBitmapCache>(clip.GetWidth());
+} };
+
+WaveClipBitmapCache &WaveClipBitmapCache::Get( const WaveClip &clip )
+{
+   return const_cast< WaveClip& >( clip ) // Consider it mutable data
+      .Caches::Get< WaveClipBitmapCache >( sKeyB );
+}
+
+void WaveClipBitmapCache::MarkChanged()
+{
+   ++mDirty;
+}
+
+void WaveClipBitmapCache::MarkAppended()
+{
+   // Draw() finds that the clip is wider, and makes only the last tiles again
+}
+
+void WaveClipBitmapCache::Invalidate()
+{
+   for (auto &tiles : mChannels) {
+      tiles.tiles.clear();
+      tiles.dirty = -1;
+   }
+}
+
+bool WaveClipBitmapCache::MakeTiles(const WaveClip &clip, size_t channel,
+   Tiles &tiles, long long first, long long last, long long numColumns)
+{
+   auto sw = FrameStatistics::CreateStopwatch(
+      FrameStatistics::SectionID::WaveBitmapCachePreprocess);
+
+   const auto pps = tiles.key.pixelsPerSecond;
+   // Include the column before the first tile
+   const auto c0 = std::max(0LL, first * TileWidth - 1);
+   const auto c1 = std::min(numColumns, (last + 1) * TileWidth);
+   const auto len = c1 - c0;
+
+   WaveDisplay display(len);
+   if (!WaveClipWaveformCache::Get(clip).GetWaveDisplay(
+      clip, channel, display, c0 / pps, pps))
+      return false;
+
+   std::vector<double> env(len);
+   clip.GetEnvelope()->GetValues(env.data(), len,
+      clip.GetPlayStartTime() + c0 / pps, 1.0 / pps);
+
+   for (auto ii = first; ii <= last; ++ii) {
+      auto &pTile = tiles.tiles[ii];
+      if (pTile)
+         continue;
+      pTile = std::make_shared<WaveBitmapTile>();
+      auto &tile = *pTile;
+      tile.key = tiles.key;
+      const auto begin = ii * TileWidth;
+      tile.width = std::min(numColumns, begin + TileWidth) - begin;
+      tile.hasPrevious = begin > 0;
+      const auto from = begin - tile.hasPrevious - c0;
+      const auto to = begin + tile.width - c0;
+      tile.min.reserve(to - from);
+      tile.max.reserve(to - from);
+      tile.rms.reserve(to - from);
+      for (auto jj = from; jj < to; ++jj) {
+         tile.min.push_back(display.min[jj] * env[jj]);
+         tile.max.push_back(display.max[jj] * env[jj]);
+         tile.rms.push_back(display.rms[jj] * env[jj]);
+      }
+   }
+   return true;
+}
+
+bool WaveClipBitmapCache::Draw(wxDC &dc, const WaveClip &clip, size_t channel,
+   const wxRect &rect, long long firstColumn, const Key &key)
+{
+   auto sw = FrameStatistics::CreateStopwatch(
+      FrameStatistics::SectionID::WaveBitmapCache);
+
+   if (rect.height <= 0 || key.pixelsPerSecond <= 0)
+      return true;
+
+   const auto numColumns = static_cast<long long>(ceil(
+      clip.GetPlaySamplesCount().as_double() / clip.GetRate()
+         * key.pixelsPerSecond));
+
+   auto &tiles = mChannels[channel];
+   const auto fingerprint = Fingerprint(clip);
+   if (tiles.key != key || tiles.dirty != mDirty ||
+       tiles.fingerprint != fingerprint) {
+      tiles.tiles.clear();
+      tiles.key = key;
+      tiles.dirty = mDirty;
+      tiles.fingerprint = fingerprint;
+      tiles.numColumns = numColumns;
+   }
+   else if (tiles.numColumns != numColumns) {
+      // Samples were appended, or the right edge moved:  the last column that
+      // was made, and those after it, are stale
+      const auto stale =
+         std::max(0LL, std::min(tiles.numColumns, numColumns) - 1) / TileWidth;
+      tiles.tiles.erase(tiles.tiles.lower_bound(stale), tiles.tiles.end());
+      tiles.numColumns = numColumns;
+   }
+   const auto endColumn = std::min(numColumns, firstColumn + rect.width);
+   if (endColumn <= std::max(0LL, firstColumn))
+      return true;
+
+   const auto firstTile = std::max(0LL, firstColumn) / TileWidth;
+   const auto lastTile = (endColumn - 1) / TileWidth;
+   // Also prepare the neighbors that scrolling exposes next
+   const auto lowTile = std::max(0LL, firstTile - 1);
+   const auto highTile = std::min((numColumns - 1) / TileWidth, lastTile + 1);
+
+   auto firstMissing = highTile + 1, lastMissing = lowTile - 1;
+   for (auto ii = lowTile; ii <= highTile; ++ii)
+      if (!tiles.tiles.count(ii)) {
+         firstMissing = std::min(firstMissing, ii);
+         lastMissing = std::max(lastMissing, ii);
+      }
+   if (firstMissing <= lastMissing) {
+      if (!MakeTiles(clip, channel, tiles, firstMissing, lastMissing,
+         numColumns))
+         return false;
+      for (auto ii = firstMissing; ii <= lastMissing; ++ii)
+         if (ii < firstTile || ii > lastTile)
+            Renderer::Get().Enqueue(tiles.tiles[ii]);
+   }
+
+   // Forget the tiles farthest from view, but keep all in view, even if
+   // they are more than MaxTiles
+   while (tiles.tiles.size() > MaxTiles) {
+      const auto front = tiles.tiles.begin();
+      const auto back = std::prev(tiles.tiles.end());
+      const auto before = firstTile - front->first;
+      const auto after = back->first - lastTile;
+      if (before <= 0 && after <= 0)
+         break;
+      if (before > after)
+         tiles.tiles.erase(front);
+      else
+         tiles.tiles.erase(back);
+   }
+
+   wxDCClipper clipper(dc, rect);
+   for (auto ii = firstTile; ii <= lastTile; ++ii) {
+      // Made above, and not forgotten
+      auto &tile = *tiles.tiles.at(ii);
+      {
+         // Might wait for the other thread to finish the tile
+         std::lock_guard<std::mutex> lock{ tile.mutex };
+         if (!tile.rendered)
+            Render(tile);
+      }
+      if (!tile.bitmap) {
+         wxImage image(tile.width, key.height, false);
+         image.SetAlpha();
+         memcpy(image.GetData(), tile.rgb.data(), tile.rgb.size());
+         memcpy(image.GetAlpha(), tile.alpha.data(), tile.alpha.size());
+         tile.bitmap.emplace(image);
+         tile.rgb = {};
+         tile.alpha = {};
+      }
+      dc.DrawBitmap(*tile.bitmap,
+         rect.x + static_cast<int>(ii * TileWidth - firstColumn), rect.y,
+         true);
+      Bitmaps::Get().Use(tile);
+   }
+   return true;
+}
@@ -0,0 +1,94 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file WaveBitmapCache.h
+  @brief Tiles of rendered waveforms of clips, kept across repaints
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WAVE_BITMAP_CACHE__
+#define __AUDACITY_WAVE_BITMAP_CACHE__
+
+#include "WaveClip.h"
+
+#include <cstdint>
+#include <map>
+
+class wxDC;
+class wxRect;
+struct WaveBitmapTile;
+
+//! Caches min, max and rms of clips as drawn, in tiles of fixed width
+/*!
+ Columns are counted from the play start of the clip at a given zoom, so
+ that horizontal scrolling reuses tiles and only renders newly exposed
+ columns.  Tiles next to those visible are rendered by a background thread.
+ Appending samples, as in recording, renders again only the last tiles.
+
+ The bitmaps of all clips are limited in number; those least recently drawn
+ are released first, and rendered again if drawn again.
+ */
+struct WaveClipBitmapCache final : WaveClipListener
+{
+   //! Width of tiles in pixels
+   static constexpr int TileWidth = 256;
+
+   //! All that determines the appearance of tiles besides the clip contents
+   struct Key {
+      double pixelsPerSecond{ 0 };
+      int height{ 0 };
+      float zoomMin{ -1 };
+      float zoomMax{ 1 };
+      bool dB{ false };
+      float dBRange{ 0 };
+      bool showClipping{ false };
+      // Colours as by wxColour::GetRGB(), because wxColour is not safe to
+      // share with the rendering thread
+      uint32_t sampleColour{ 0 };
+      uint32_t rmsColour{ 0 };
+      uint32_t clippedColour{ 0 };
+
+      bool operator == (const Key &other) const;
+      bool operator != (const Key &other) const { return !(*this == other); }
+   };
+
+   explicit WaveClipBitmapCache(size_t nChannels);
+   ~WaveClipBitmapCache() override;
+
+   static WaveClipBitmapCache &Get( const WaveClip &clip );
+
+   void MarkChanged() override; // NOFAIL-GUARANTEE
+   void MarkAppended() override; // NOFAIL-GUARANTEE
+   void Invalidate() override; // NOFAIL-GUARANTEE
+
+   //! Draw the min, max and rms of one channel, the envelope applied
+   /*!
+    Tiles that are not yet rendered are rendered now, if visible
+
+    @param rect where to draw; its left edge shows column `firstColumn`
+    @return false if waveform data could not be loaded
+    */
+   bool Draw(wxDC &dc, const WaveClip &clip, size_t channel,
+      const wxRect &rect, long long firstColumn, const Key &key);
+
+private:
+   struct Tiles {
+      Key key;
+      int dirty{ -1 };
+      //! Of the envelope, trimming and rate
+      size_t fingerprint{ 0 };
+      //! Width of the clip when the tiles were made
+      long long numColumns{ 0 };
+      std::map<long long, std::shared_ptr<WaveBitmapTile>> tiles;
+   };
+
+   //! Make tiles for the given range of tile indices, where missing
+   bool MakeTiles(const WaveClip &clip, size_t channel, Tiles &tiles,
+      long long first, long long last, long long numColumns);
+
+   std::vector<Tiles> mChannels;
+   int mDirty{ 0 };
+};
+
+#endif
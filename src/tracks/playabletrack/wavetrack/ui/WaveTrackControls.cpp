@@ -30,6 +30,7 @@ Paul Licameli split from TrackPanel.cpp
 #include "../../../../TrackPanelAx.h"
 #include "../../../../TrackPanelMouseEvent.h"
 #include "WaveTrack.h"
+#include "RealtimeEffectFreeze.h"
 #include "RealtimeEffectManager.h"
 #include "../../../../prefs/PrefsDialog.h"
 #include "../../../../prefs/ThemePrefs.h"
@@ -131,6 +132,8 @@ enum {
    OnSplitStereoID,
    OnSplitStereoMonoID,
 
+   OnFreezeEffectsID,
+
    ChannelMenuID,
 
    // Range of ids for registered items -- keep this last!
@@ -519,6 +522,8 @@ struct WaveTrackMenuTable : WaveTrackPopupMenuTable
    void OnSwapChannels(wxCommandEvent & event);
    void OnSplitStereo(wxCommandEvent & event);
    void OnSplitStereoMono(wxCommandEvent & event);
+
+   void OnFreezeEffects(wxCommandEvent & event);
 };
 
 WaveTrackMenuTable &WaveTrackMenuTable::Instance()
@@ -677,6 +682,17 @@ BEGIN_POPUP_MENU(WaveTrackMenuTable)
    #endif
    EndSection();
 
+   BeginSection( "Effects" );
+      AppendCheckItem( "FreezeEffects", OnFreezeEffectsID,
+         XXO("&Freeze Realtime Effects"), POPUP_MENU_FN( OnFreezeEffects ),
+         []( PopupMenuHandler &handler, wxMenu &menu, int id ){
+            auto &track =
+               static_cast< WaveTrackMenuTable& >( handler ).FindWaveTrack();
+            menu.Check( id, RealtimeEffectFreeze::Get(track).IsFrozen() );
+         }
+      );
+   EndSection();
+
    BeginSection( "Format" );
       POPUP_MENU_SUB_MENU( "Format", FormatMenuTable, mpData )
    EndSection();
@@ -868,6 +884,27 @@ void WaveTrackMenuTable::OnSwapChannels(wxCommandEvent &)
    mpData->result = RefreshCode::RefreshAll;
 }
 
+/// Play a render of the track through its realtime effects, or stop doing so
+void WaveTrackMenuTable::OnFreezeEffects(wxCommandEvent &)
+{
+   AudacityProject *const project = &mpData->project;
+   WaveTrack *const pTrack = static_cast<WaveTrack*>(mpData->pTrack);
+
+   auto &freeze = RealtimeEffectFreeze::Get(*pTrack);
+   const bool frozen = !freeze.IsFrozen();
+   freeze.SetFrozen(*pTrack, frozen);
+
+   ProjectHistory::Get( *project ).PushState(
+      frozen
+         /* i18n-hint: The string names a track  */
+         ? XO("Froze realtime effects of '%s'").Format( pTrack->GetName() )
+         /* i18n-hint: The string names a track  */
+         : XO("Unfroze realtime effects of '%s'").Format( pTrack->GetName() ),
+      frozen ? XO("Freeze Effects") : XO("Unfreeze Effects"));
+
+   mpData->result = RefreshCode::RefreshNone;
+}
+
 /// Split a stereo track into two tracks...
 void WaveTrackMenuTable::OnSplitStereo(wxCommandEvent &)
 {
@@ -11,6 +11,7 @@ Paul Licameli split from WaveChannelView.cpp
 
 #include "WaveformView.h"
 
+#include "WaveBitmapCache.h"
 #include "WaveformCache.h"
 #include "WaveformVRulerControls.h"
 #include "WaveChannelView.h"
@@ -752,7 +753,35 @@ void DrawClipWaveform(TrackPanelDrawingContext &context, size_t channel,
 
    auto &clipCache = WaveClipWaveformCache::Get(*clip);
 
-   {
+   // Without fisheye, min, max and rms are drawn from tiles rendered once for
+   // the zoom, so that repainting and scrolling are mostly blits
+   const bool useTiles = nPortions == 1 &&
+      !portions[0].inFisheye && !(portions[0].averageZoom > threshold1);
+   if (useTiles) {
+      wxRect rectPortion = portions[0].rect;
+      rectPortion.Intersect(mid);
+      WaveClipBitmapCache::Key key;
+      key.pixelsPerSecond = pps;
+      key.height = rectPortion.height;
+      key.zoomMin = zoomMin;
+      key.zoomMax = zoomMax;
+      key.dB = dB;
+      key.dBRange = dBRange;
+      key.showClipping = artist->mShowClipping;
+      key.sampleColour =
+         (muted ? artist->muteSamplePen : artist->samplePen).GetColour().GetRGB();
+      key.rmsColour =
+         (muted ? artist->muteRmsPen : artist->rmsPen).GetColour().GetRGB();
+      key.clippedColour =
+         (muted ? artist->muteClippedPen : artist->clippedPen).GetColour().GetRGB();
+      // As for the display of hiddenMid, which begins at t0
+      const auto firstColumn =
+         llrint(t0 * pps) + (rectPortion.x - hiddenMid.x);
+      if (rectPortion.width > 0 && !WaveClipBitmapCache::Get(*clip).Draw(
+         dc, *clip, channel, rectPortion, firstColumn, key))
+         return;
+   }
+   else {
       bool showIndividualSamples = false;
       for (unsigned ii = 0; !showIndividualSamples && ii < nPortions; ++ii) {
          const WavePortion &portion = portions[ii];
@@ -779,7 +808,7 @@ void DrawClipWaveform(TrackPanelDrawingContext &context, size_t channel,
 
    // TODO Add a comment to say what this loop does.
    // Possibly make it into a subroutine.
-   for (unsigned ii = 0; ii < nPortions; ++ii) {
+   for (unsigned ii = 0; !useTiles && ii < nPortions; ++ii) {
       WavePortion &portion = portions[ii];
       const bool showIndividualSamples = portion.averageZoom > threshold1;
       const bool showPoints = portion.averageZoom > threshold2;
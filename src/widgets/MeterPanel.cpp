@@ -41,6 +41,7 @@
 #include "MeterPanel.h"
 
 #include <algorithm>
+#include <limits>
 #include <wx/setup.h> // for wxUSE_* macros
 #include <wx/wxcrtvararg.h>
 #include <wx/defs.h>
@@ -163,7 +164,8 @@ output = wxString::Format(wxT("Meter update msg: %i channels, %i samples\n"), \
       kMaxMeterBars, numFrames);
 for (int i = 0; i<kMaxMeterBars; i++)
    {  // for each channel of the meters
-   output += wxString::Format(wxT("%f peak, %f rms "), peak[i], rms[i]);
+   output += wxString::Format(wxT("%f peak, %f rms, %f true peak "),
+      peak[i], rms[i], truePeak[i]);
    if (clipping[i])
       output += wxString::Format(wxT("clipped "));
    else
@@ -316,6 +318,8 @@ MeterPanel::MeterPanel(AudacityProject *project,
    mMonitoring(false),
    mActive(false),
    mNumBars(0),
+   mMomentaryLoudness(-std::numeric_limits<double>::infinity()),
+   mShortTermLoudness(-std::numeric_limits<double>::infinity()),
    mLayoutValid(false),
    mBitmap{},
    mRuler{ LinearUpdater::Instance(), LinearDBFormat::Instance() }
@@ -904,10 +908,13 @@ void MeterPanel::Reset(double sampleRate, bool resetClipping)
 {
    mT = 0;
    mRate = sampleRate;
+   mResetAnalyzer.store(true, std::memory_order_release);
    for (int j = 0; j < kMaxMeterBars; j++)
    {
       ResetBar(&mBar[j], resetClipping);
    }
+   mMomentaryLoudness = mShortTermLoudness =
+      -std::numeric_limits<double>::infinity();
 
    // wxTimers seem to be a little unreliable - sometimes they stop for
    // no good reason, so this "primes" it every now and then...
@@ -963,84 +970,68 @@ static float ToDB(float v, float range)
 void MeterPanel::UpdateDisplay(
    unsigned numChannels, int numFrames, const float *sampleData)
 {
-   auto sptr = sampleData;
-   auto num = std::min(numChannels, mNumBars);
+   if (numChannels == 0 || numFrames <= 0)
+      return;
+
+   if (mResetAnalyzer.exchange(false, std::memory_order_acquire) ||
+       !mAnalyzer || mAnalyzer->NumChannels() != numChannels) {
+      mAnalyzer = std::make_unique<MeterAnalyzer>(
+         mRate > 0 ? mRate : 44100.0, numChannels, mNumPeakSamplesToClip);
+      mChannelLevels.resize(numChannels);
+   }
+   mAnalyzer->Process(sampleData, numFrames, mChannelLevels.data());
+
+   const auto num = std::min(numChannels, mNumBars);
    MeterUpdateMsg msg;
 
    memset(&msg, 0, sizeof(msg));
    msg.numFrames = numFrames;
+   msg.momentaryLoudness = mAnalyzer->GetMomentaryLoudness();
+   msg.shortTermLoudness = mAnalyzer->GetShortTermLoudness();
 
-   for(int i=0; i<numFrames; i++) {
-      for(unsigned int j=0; j<num; j++) {
-         msg.peak[j] = floatMax(msg.peak[j], fabs(sptr[j]));
-         msg.rms[j] += sptr[j]*sptr[j];
-
-         // In addition to looking for mNumPeakSamplesToClip peaked
-         // samples in a row, also send the number of peaked samples
-         // at the head and tail, in case there's a run of peaked samples
-         // that crosses block boundaries
-         if (fabs(sptr[j])>=MAX_AUDIO) {
-            if (msg.headPeakCount[j]==i)
-               msg.headPeakCount[j]++;
-            msg.tailPeakCount[j]++;
-            if (msg.tailPeakCount[j] > mNumPeakSamplesToClip)
-               msg.clipping[j] = true;
-         }
-         else
-            msg.tailPeakCount[j] = 0;
-      }
-      sptr += numChannels;
+   if (num == 0) {
+      mQueue.Put(msg);
+      return;
+   }
+
+   // Each bar stands for a run of neighbouring channels, and shows the
+   // highest of their levels
+   for (unsigned int c = 0; c < numChannels; ++c) {
+      const auto &levels = mChannelLevels[c];
+      const auto j = c * num / numChannels;
+      msg.peak[j] = floatMax(msg.peak[j], levels.peak);
+      msg.rms[j] = floatMax(msg.rms[j], levels.rms);
+      msg.truePeak[j] = floatMax(msg.truePeak[j], levels.truePeak);
+      msg.clipping[j] = msg.clipping[j] || levels.clipping;
+      msg.headPeakCount[j] = intmax(msg.headPeakCount[j], levels.headPeakCount);
+      msg.tailPeakCount[j] = intmax(msg.tailPeakCount[j], levels.tailPeakCount);
    }
-   for(unsigned int j=0; j<mNumBars; j++)
-      msg.rms[j] = sqrt(msg.rms[j]/numFrames);
 
    mQueue.Put(msg);
 }
 
-// Vaughan, 2010-11-29: This not currently used. See comments in MixerTrackCluster::UpdateMeter().
-//void MeterPanel::UpdateDisplay(int numChannels, int numFrames,
-//                           // Need to make these double-indexed arrays if we handle more than 2 channels.
-//                           float* maxLeft, float* rmsLeft,
-//                           float* maxRight, float* rmsRight,
-//                           const size_t kSampleCount)
-//{
-//   int i, j;
-//   int num = intmin(numChannels, mNumBars);
-//   MeterUpdateMsg msg;
-//
-//   msg.numFrames = kSampleCount;
-//   for(j=0; j<mNumBars; j++) {
-//      msg.peak[j] = 0.0;
-//      msg.rms[j] = 0.0;
-//      msg.clipping[j] = false;
-//      msg.headPeakCount[j] = 0;
-//      msg.tailPeakCount[j] = 0;
-//   }
-//
-//   for(i=0; i<numFrames; i++) {
-//      for(j=0; j<num; j++) {
-//         msg.peak[j] = floatMax(msg.peak[j], ((j == 0) ? maxLeft[i] : maxRight[i]));
-//         msg.rms[j] = floatMax(msg.rms[j], ((j == 0) ? rmsLeft[i] : rmsRight[i]));
-//
-//         // In addition to looking for mNumPeakSamplesToClip peaked
-//         // samples in a row, also send the number of peaked samples
-//         // at the head and tail, in case there's a run
-//         // of peaked samples that crosses block boundaries.
-//         if (fabs((j == 0) ? maxLeft[i] : maxRight[i]) >= MAX_AUDIO)
-//         {
-//            if (msg.headPeakCount[j]==i)
-//               msg.headPeakCount[j]++;
-//            msg.tailPeakCount[j]++;
-//            if (msg.tailPeakCount[j] > mNumPeakSamplesToClip)
-//               msg.clipping[j] = true;
-//         }
-//         else
-//            msg.tailPeakCount[j] = 0;
-//      }
-//   }
-//
-//   mQueue.Put(msg);
-//}
+void MeterPanel::UpdateLevels(unsigned numChannels, int numFrames,
+   const float peak[], const float rms[], const size_t fullScaleRun[])
+{
+   auto num = std::min(numChannels, mNumBars);
+   MeterUpdateMsg msg;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.numFrames = numFrames;
+
+   // The runs may cross boundaries of the levels that were measured, but
+   // that was already taken into account, so head and tail counts stay zero
+   for(unsigned int j=0; j<num; j++) {
+      msg.peak[j] = peak[j];
+      msg.rms[j] = rms[j];
+      msg.truePeak[j] = peak[j];
+      msg.clipping[j] = fullScaleRun[j] > size_t(mNumPeakSamplesToClip);
+   }
+   msg.momentaryLoudness = msg.shortTermLoudness =
+      -std::numeric_limits<double>::infinity();
+
+   mQueue.Put(msg);
+}
 
 void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
 {
@@ -1068,6 +1059,8 @@ void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
       double deltaT = msg.numFrames / mRate;
 
       mT += deltaT;
+      mMomentaryLoudness = msg.momentaryLoudness;
+      mShortTermLoudness = msg.shortTermLoudness;
       for(unsigned int j=0; j<mNumBars; j++) {
          mBar[j].isclipping = false;
 
@@ -1075,6 +1068,7 @@ void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
          if (mDB) {
             msg.peak[j] = ToDB(msg.peak[j], mDBRange);
             msg.rms[j] = ToDB(msg.rms[j], mDBRange);
+            msg.truePeak[j] = ToDB(msg.truePeak[j], mDBRange);
          }
 
          if (mDecay) {
@@ -1103,8 +1097,11 @@ void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
             mBar[j].peakHoldTime = mT;
          }
 
-         if (mBar[j].peak > mBar[j].peakPeakHold )
-            mBar[j].peakPeakHold = mBar[j].peak;
+         // The maximum shown is of the reconstructed signal, which may
+         // exceed the samples
+         mBar[j].peakPeakHold = std::max(
+            { mBar[j].peakPeakHold, mBar[j].peak,
+              ClipZeroToOne(msg.truePeak[j]) });
 
          if (msg.clipping[j] ||
              mBar[j].tailPeakCount+msg.headPeakCount[j] >=
@@ -23,6 +23,7 @@
 #include <wx/timer.h> // member variable
 
 #include "ASlider.h"
+#include "MeterAnalyzer.h" // member variable
 #include "SampleFormat.h"
 #include "Prefs.h"
 #include "MeterPanelBase.h" // to inherit
@@ -60,6 +61,10 @@ class MeterUpdateMsg
    bool clipping[kMaxMeterBars];
    int headPeakCount[kMaxMeterBars];
    int tailPeakCount[kMaxMeterBars];
+   float truePeak[kMaxMeterBars];
+   //! In LUFS, or negative infinity if not measured
+   double momentaryLoudness;
+   double shortTermLoudness;
 
    /* neither constructor nor destructor do anything */
    MeterUpdateMsg() { }
@@ -142,13 +147,17 @@ class AUDACITY_DLL_API MeterPanel final
 
    /** \brief Update the meters with a block of audio data
     *
-    * Process the supplied block of audio data, extracting the peak and RMS
-    * levels to send to the meter. Also record runs of clipped samples to detect
-    * clipping that lies on block boundaries.
+    * Process the supplied block of audio data, extracting the peak, RMS and
+    * true peak levels and the loudness to send to the meter. Also record runs
+    * of clipped samples to detect clipping that lies on block boundaries.
+    * When there are more channels than bars, each bar stands for a run of
+    * neighbouring channels and shows the highest levels among them: with two
+    * bars, the first half of the channels in the first bar, the rest in the
+    * second.  Loudness is of all channels together.
     * This method is thread-safe!  Feel free to call from a different thread
-    * (like from an audio I/O callback).
+    * (like the audio thread), but always the same one, because the analysis
+    * continues from one call to the next.
     *
-    * First overload:
     * \param numChannels The number of channels of audio being played back or
     * recorded.
     * \param numFrames The number of frames (samples) in this data block. It is
@@ -159,18 +168,20 @@ class AUDACITY_DLL_API MeterPanel final
     * then the second sample of channel 1, second sample of channel 2, and so
     * to the second sample of channel (numChannels). The last sample in the
     * array will be the (numFrames) sample for channel (numChannels).
-    *
-    * The second overload is for ease of use in MixerBoard.
     */
    void UpdateDisplay(unsigned numChannels,
                       int numFrames, const float *sampleData) override;
 
-   // Vaughan, 2010-11-29: This not currently used. See comments in MixerTrackCluster::UpdateMeter().
-   //void UpdateDisplay(int numChannels, int numFrames,
-   //                     // Need to make these double-indexed max and min arrays if we handle more than 2 channels.
-   //                     float* maxLeft, float* rmsLeft,
-   //                     float* maxRight, float* rmsRight,
-   //                     const size_t kSampleCount);
+   /** \brief Update the meter with levels already measured elsewhere,
+    * such as by the audio callback for one sequence
+    *
+    * \param numFrames How many frames the levels summarize
+    * \param peak, rms One value for each channel
+    * \param fullScaleRun For each channel, the longest run of samples
+    * at or beyond full scale
+    */
+   void UpdateLevels(unsigned numChannels, int numFrames,
+      const float peak[], const float rms[], const size_t fullScaleRun[]);
 
    /** \brief Find out if the level meter is disabled or not.
     *
@@ -181,6 +192,9 @@ class AUDACITY_DLL_API MeterPanel final
 
    float GetMaxPeak() const override;
    float GetPeakHold() const;
+   //! In LUFS, or negative infinity if not measured
+   double GetMomentaryLoudness() const { return mMomentaryLoudness; }
+   double GetShortTermLoudness() const { return mShortTermLoudness; }
 
    bool IsMonitoring() const;
    bool IsActive() const;
@@ -284,6 +298,14 @@ class AUDACITY_DLL_API MeterPanel final
 
    unsigned  mNumBars;
    MeterBar  mBar[kMaxMeterBars]{};
+   double    mMomentaryLoudness;
+   double    mShortTermLoudness;
+
+   //! Used only by the thread that calls UpdateDisplay
+   std::unique_ptr<MeterAnalyzer> mAnalyzer;
+   std::vector<MeterAnalyzer::ChannelLevels> mChannelLevels;
+   //! Set by Reset, so that the analyzer starts again at the new rate
+   std::atomic<bool> mResetAnalyzer{ true };
 
    bool      mLayoutValid;
 